@@ -38,7 +38,7 @@ int main(int argc, char **argv)
         parser.addPositionalArgument("preview-chunks", "Mode: Render splited in to multiple files for timeline preview.");
         parser.addPositionalArgument("source", "Source file (usually MLT XML).");
         parser.addPositionalArgument("destination", "Destination directory.");
-        parser.addPositionalArgument("chunks", "Chunks to render.");
+        parser.addPositionalArgument("chunks", "Chunks to render, or - to read them from stdin.");
         parser.addPositionalArgument("chunk_size", "Chunks to render.");
         parser.addPositionalArgument("profile_path", "Path to profile.");
         parser.addPositionalArgument("file_extension", "Rendered file extension.");
@@ -82,6 +82,55 @@ int main(int argc, char **argv)
         const char *localename = prod.get_lcnumeric();
         QLocale::setDefault(QLocale(localename));
 
+        // Render one chunk, returns false if the consumer could not be created
+        auto renderChunk = [&](int frame) {
+            fprintf(stderr, "START:%d \n", frame);
+            QString fileName = QStringLiteral("%1.%2").arg(frame).arg(extension);
+            if (baseFolder.exists(fileName)) {
+                // Don't overwrite an existing file
+                fprintf(stderr, "DONE:%d \n", frame);
+                return true;
+            }
+            QScopedPointer<Mlt::Producer> playlst(prod.cut(frame, frame + chunkSize));
+            QScopedPointer<Mlt::Consumer> cons(
+                new Mlt::Consumer(profile, QString("avformat:%1").arg(baseFolder.absoluteFilePath(fileName)).toUtf8().constData()));
+            for (const QString &param : qAsConst(consumerParams)) {
+                if (param.contains(QLatin1Char('='))) {
+                    cons->set(param.section(QLatin1Char('='), 0, 0).toUtf8().constData(), param.section(QLatin1Char('='), 1).toUtf8().constData());
+                }
+            }
+            if (!cons->is_valid()) {
+                fprintf(stderr, " = =  = INVALID CONSUMER\n\n");
+                return false;
+            }
+            cons->set("terminate_on_pause", 1);
+            cons->connect(*playlst);
+            playlst.reset();
+            cons->run();
+            cons->stop();
+            cons->purge();
+            fprintf(stderr, "DONE:%d \n", frame);
+            return true;
+        };
+
+        if (chunks == QStringList{QStringLiteral("-")}) {
+            // Chunks are sent one per line on stdin by Kdenlive, which shares its queue between
+            // several render processes. An empty line or closing stdin ends the job.
+            char line[64];
+            while (fgets(line, sizeof(line), stdin) != nullptr) {
+                bool ok;
+                const int frame = QString::fromLatin1(line).simplified().toInt(&ok);
+                if (!ok) {
+                    break;
+                }
+                if (!renderChunk(frame)) {
+                    return 1;
+                }
+            }
+            fprintf(stderr, "+ + + RENDERING FINISHED + + + \n");
+            return 0;
+        }
+
         int currentFrame = 0;
         int rangeStart = 0;
         int rangeEnd = 0;
@@ -111,32 +160,9 @@ int main(int argc, char **argv)
                 // Frame will be processed, remove from stack
                 chunks.removeFirst();
             }
-            fprintf(stderr, "START:%d \n", frame.toInt());
-            QString fileName = QStringLiteral("%1.%2").arg(frame, extension);
-            if (baseFolder.exists(fileName)) {
-                // Don't overwrite an existing file
-                fprintf(stderr, "DONE:%d \n", frame.toInt());
-                continue;
-            }
-            QScopedPointer<Mlt::Producer> playlst(prod.cut(frame.toInt(), frame.toInt() + chunkSize));
-            QScopedPointer<Mlt::Consumer> cons(
-                new Mlt::Consumer(profile, QString("avformat:%1").arg(baseFolder.absoluteFilePath(fileName)).toUtf8().constData()));
-            for (const QString &param : qAsConst(consumerParams)) {
-                if (param.contains(QLatin1Char('='))) {
-                    cons->set(param.section(QLatin1Char('='), 0, 0).toUtf8().constData(), param.section(QLatin1Char('='), 1).toUtf8().constData());
-                }
-            }
-            if (!cons->is_valid()) {
-                fprintf(stderr, " = =  = INVALID CONSUMER\n\n");
+            if (!renderChunk(frame.toInt())) {
                 return 1;
             }
-            cons->set("terminate_on_pause", 1);
-            cons->connect(*playlst);
-            playlst.reset();
-            cons->run();
-            cons->stop();
-            cons->purge();
-            fprintf(stderr, "DONE:%d \n", frame.toInt());
         }
         // Mlt::Factory::close();
         fprintf(stderr, "+ + + RENDERING FINISHED + + + \n");
@@ -161,6 +187,13 @@ int main(int argc, char **argv)
         QCommandLineOption subtitleOption("subtitle", "Subtitle file.", "file");
         parser.addOption(subtitleOption);
 
+        QCommandLineOption segmentsOption("segments", "Comma separated in-out frame ranges whose video is encoded in parallel and joined afterwards.",
+                                          "ranges");
+        parser.addOption(segmentsOption);
+
+        QCommandLineOption workersOption("workers", "Number of processes encoding segments.", "count", QString::number(2));
+        parser.addOption(workersOption);
+
         parser.process(app);
         args = parser.positionalArguments();
 
@@ -232,6 +265,9 @@ int main(int argc, char **argv)
         QString subtitleFile = parser.value(subtitleOption);
 
         auto *rJob = new RenderJob(render, playlist, target, pid, in, out, subtitleFile, &app);
+        if (parser.isSet(segmentsOption)) {
+            rJob->setSegments(parser.value(segmentsOption), parser.value(workersOption).toInt());
+        }
         QObject::connect(rJob, &RenderJob::renderingFinished, rJob, [&]() {
             rJob->deleteLater();
             app.quit();
@@ -16,6 +16,7 @@
 #endif
 #include <QDebug>
 #include <QDir>
+#include <QDomDocument>
 #include <QElapsedTimer>
 #include <QStandardPaths>
 #include <utility>
@@ -27,9 +28,14 @@ public:
     static void msleep(unsigned long msecs) { QThread::msleep(msecs); }
 };
 
+// Share of the progress given to the segments, the rest is for joining them
+static const int SegmentsProgress = 90;
+
 RenderJob::RenderJob(const QString &render, const QString &scenelist, const QString &target, int pid, int in, int out, const QString &subtitleFile,
                      QObject *parent)
     : QObject(parent)
+    , m_segmentWorkers(1)
+    , m_aborted(false)
     , m_scenelist(scenelist)
     , m_dest(target)
     , m_progress(0)
@@ -118,7 +124,19 @@ void RenderJob::sendFinish(int status, const QString &error)
 
 void RenderJob::slotAbort()
 {
+    m_aborted = true;
     m_renderProcess->kill();
+    for (auto &segment : m_segments) {
+        if (segment.process) {
+            segment.process->kill();
+        }
+    }
+    if (m_concatProcess) {
+        // concatFinished() cleans up once the process is gone
+        m_concatProcess->kill();
+        m_concatProcess->waitForFinished();
+    }
+    removeSegments();
     sendFinish(-3, QString());
     if (m_erase) {
         QFile(m_scenelist).remove();
@@ -271,6 +289,17 @@ void RenderJob::start()
     }
 #endif
 
+    if (!m_segments.isEmpty()) {
+        if (prepareSegments()) {
+            m_logstream << "Rendering " << m_segments.count() << " segments with " << m_segmentWorkers << " processes\n";
+            m_logstream.flush();
+            startSegments();
+            m_looper.exec();
+            return;
+        }
+        m_segments.clear();
+    }
+
     // Because of the logging, we connect to stderr in all cases.
     connect(m_renderProcess, &QProcess::readyReadStandardError, this, &RenderJob::receivedStderr);
     m_renderProcess->start(m_prog, m_args);
@@ -430,3 +459,293 @@ void RenderJob::slotCheckSubtitleProcess(int exitCode, QProcess::ExitStatus exit
     Q_EMIT renderingFinished();
     m_looper.quit();
 }
+
+void RenderJob::setSegments(const QString &segments, int workers)
+{
+    m_segments.clear();
+    m_segmentWorkers = qMax(1, workers);
+    const QStringList ranges = segments.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &range : ranges) {
+        Segment segment;
+        bool okIn, okOut;
+        segment.in = range.section(QLatin1Char('-'), 0, 0).toInt(&okIn);
+        segment.out = range.section(QLatin1Char('-'), 1, 1).toInt(&okOut);
+        if (!okIn || !okOut || segment.out < segment.in) {
+            qWarning() << "Invalid render segment" << range;
+            m_segments.clear();
+            return;
+        }
+        segment.frame = segment.in;
+        m_segments << segment;
+    }
+    if (m_segments.count() < 2) {
+        m_segments.clear();
+    }
+}
+
+bool RenderJob::prepareSegments()
+{
+    m_ffmpeg = QStandardPaths::findExecutable(QStringLiteral("ffmpeg"));
+    if (m_ffmpeg.isEmpty()) {
+        qWarning() << "ffmpeg not found, cannot join segments, rendering in one process";
+        return false;
+    }
+    QString playlist = m_scenelist;
+    if (playlist.startsWith(QLatin1String("xml:"))) {
+        playlist.remove(0, 4);
+    }
+    QFile file(playlist);
+    QDomDocument doc;
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file, false)) {
+        qWarning() << "Cannot read" << playlist << "to split it in segments";
+        return false;
+    }
+    file.close();
+    QDomElement consumer = doc.documentElement().firstChildElement(QStringLiteral("consumer"));
+    if (consumer.isNull()) {
+        return false;
+    }
+    auto isSet = [&consumer](const QString &name) { return consumer.attribute(name) == QLatin1String("1"); };
+    if (isSet(QStringLiteral("vn")) || isSet(QStringLiteral("video_off"))) {
+        // Audio only, there is nothing to gain from segments
+        return false;
+    }
+    if (!isSet(QStringLiteral("an")) && !isSet(QStringLiteral("audio_off"))) {
+        // Audio encoders add priming samples at the start of each stream, joined audio segments would have gaps.
+        // The segments only get the video, the audio of the whole range is encoded once by an additional process,
+        // started first as it is the longest one.
+        Segment audio;
+        audio.in = m_segments.constFirst().in;
+        audio.out = m_segments.constLast().out;
+        audio.frame = audio.in;
+        audio.audio = true;
+        m_segments.prepend(audio);
+    }
+    // Segments are written next to the destination with the same extension, so that they use the same muxer
+    const QFileInfo info(m_dest);
+    const QString base = info.absoluteDir().absoluteFilePath(info.completeBaseName());
+    int videoSegments = 0;
+    for (int i = 0; i < m_segments.count(); ++i) {
+        Segment &segment = m_segments[i];
+        const QString name = segment.audio ? QStringLiteral("audio") : QStringLiteral("segment%1").arg(++videoSegments);
+        segment.output = QStringLiteral("%1.%2.%3").arg(base, name, info.suffix());
+        segment.playlist = QStringLiteral("%1-%2.mlt").arg(playlist.section(QLatin1Char('.'), 0, -2), name);
+        consumer.setAttribute(QStringLiteral("in"), segment.in);
+        consumer.setAttribute(QStringLiteral("out"), segment.out);
+        consumer.setAttribute(QStringLiteral("target"), segment.output);
+        consumer.setAttribute(segment.audio ? QStringLiteral("vn") : QStringLiteral("an"), 1);
+        consumer.removeAttribute(segment.audio ? QStringLiteral("an") : QStringLiteral("vn"));
+        QFile segmentFile(segment.playlist);
+        if (!segmentFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qWarning() << "Cannot write segment playlist" << segment.playlist;
+            removeSegments();
+            return false;
+        }
+        segmentFile.write(doc.toByteArray());
+        segmentFile.close();
+    }
+    return true;
+}
+
+void RenderJob::startSegments()
+{
+    int running = 0;
+    for (const auto &segment : qAsConst(m_segments)) {
+        if (segment.process) {
+            running++;
+        }
+    }
+    for (int i = 0; i < m_segments.count() && running < m_segmentWorkers; ++i) {
+        Segment &segment = m_segments[i];
+        if (segment.done || segment.process) {
+            continue;
+        }
+        segment.frame = segment.in;
+        segment.process = new QProcess(&m_looper);
+        segment.process->setReadChannel(QProcess::StandardError);
+        connect(segment.process, &QProcess::readyReadStandardError, this, [this, i]() { receivedSegmentStderr(i); });
+        connect(segment.process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+                [this, i](int exitCode, QProcess::ExitStatus status) { segmentFinished(i, exitCode, status); });
+        const QStringList args = {QStringLiteral("-progress"), segment.playlist};
+        segment.process->start(m_prog, args);
+        m_logstream << "Started segment " << QFileInfo(segment.output).fileName() << ": " << m_prog << ' ' << args.join(QLatin1Char(' ')) << "\n";
+        running++;
+    }
+    m_logstream.flush();
+}
+
+void RenderJob::receivedSegmentStderr(int index)
+{
+    Segment &segment = m_segments[index];
+    const QStringList lines = QString::fromLocal8Bit(segment.process->readAllStandardError()).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+    for (const QString &line : lines) {
+        const QString result = line.simplified();
+        if (!result.startsWith(QLatin1String("Current Frame"))) {
+            m_errorMessage.append(result + QStringLiteral("<br>"));
+            m_logstream << result;
+            continue;
+        }
+        const int frame = result.section(QLatin1Char(','), 0, 0).section(QLatin1Char(' '), -1).toInt();
+        segment.frame = qBound(segment.in, frame, segment.out);
+    }
+    // Combined progress of all segments
+    qint64 total = 0;
+    qint64 processed = 0;
+    for (const auto &s : qAsConst(m_segments)) {
+        total += s.out - s.in + 1;
+        processed += s.done ? s.out - s.in + 1 : s.frame - s.in;
+    }
+    const int progress = int(SegmentsProgress * processed / qMax(qint64(1), total));
+    if (progress <= m_progress || progress > 100) {
+        return;
+    }
+    m_progress = progress;
+    qint64 elapsedTime = m_startTime.secsTo(QDateTime::currentDateTime());
+    if (elapsedTime == m_seconds) {
+        return;
+    }
+    const int frame = m_framein + int(processed);
+    int speed = (frame - m_frame) / (elapsedTime - m_seconds);
+    m_seconds = elapsedTime;
+    m_frame = frame;
+    updateProgress(speed);
+}
+
+void RenderJob::segmentFinished(int index, int exitCode, QProcess::ExitStatus status)
+{
+    Segment &segment = m_segments[index];
+    segment.process->deleteLater();
+    segment.process = nullptr;
+    if (m_aborted) {
+        return;
+    }
+    if (status == QProcess::CrashExit || exitCode != 0 || !QFile::exists(segment.output)) {
+        // The melt errors of the segment are already in m_errorMessage and are reported with the failure
+        segmentsFailed(tr("Rendering of %1 aborted, segment %2 could not be encoded.").arg(m_dest, QFileInfo(segment.output).fileName()));
+        return;
+    }
+    segment.done = true;
+    for (const auto &s : qAsConst(m_segments)) {
+        if (!s.done) {
+            startSegments();
+            return;
+        }
+    }
+    concatSegments();
+}
+
+void RenderJob::concatSegments()
+{
+    // List for the ffmpeg concat demuxer, quotes in paths have to be escaped
+    const QString listFile = m_dest + QStringLiteral(".segments.txt");
+    QFile list(listFile);
+    if (!list.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        segmentsFailed(tr("Cannot write to %1, check permissions.").arg(listFile));
+        return;
+    }
+    QString audioFile;
+    for (const auto &segment : qAsConst(m_segments)) {
+        if (segment.audio) {
+            audioFile = segment.output;
+            continue;
+        }
+        QString path = segment.output;
+        path.replace(QLatin1Char('\''), QStringLiteral("'\\''"));
+        list.write(QStringLiteral("file '%1'\n").arg(path).toUtf8());
+    }
+    list.close();
+    m_logstream << "Joining segments into " << m_dest << "\n";
+    QStringList args = {QStringLiteral("-y"),    QStringLiteral("-v"), QStringLiteral("error"), QStringLiteral("-f"), QStringLiteral("concat"),
+                        QStringLiteral("-safe"), QStringLiteral("0"),  QStringLiteral("-i"),    listFile};
+    if (audioFile.isEmpty()) {
+        args << QStringLiteral("-map") << QStringLiteral("0");
+    } else {
+        args << QStringLiteral("-i") << audioFile << QStringLiteral("-map") << QStringLiteral("0:v") << QStringLiteral("-map") << QStringLiteral("1:a");
+    }
+    // Report the progress on stdout, errors come on stderr
+    args << QStringLiteral("-c") << QStringLiteral("copy") << QStringLiteral("-nostats") << QStringLiteral("-progress") << QStringLiteral("pipe:1") << m_dest;
+    m_concatProcess = new QProcess(&m_looper);
+    connect(m_concatProcess, &QProcess::readyReadStandardOutput, this, &RenderJob::receivedConcatProgress);
+    connect(m_concatProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &RenderJob::concatFinished);
+    connect(m_concatProcess, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            concatFinished(-1, QProcess::CrashExit);
+        }
+    });
+    m_concatProcess->start(m_ffmpeg, args);
+    m_logstream << "Started join process: " << m_ffmpeg << ' ' << args.join(QLatin1Char(' ')) << "\n";
+    m_logstream.flush();
+}
+
+void RenderJob::receivedConcatProgress()
+{
+    qint64 total = 0;
+    for (const auto &segment : qAsConst(m_segments)) {
+        if (!segment.audio) {
+            total += segment.out - segment.in + 1;
+        }
+    }
+    while (m_concatProcess->canReadLine()) {
+        const QString line = QString::fromLocal8Bit(m_concatProcess->readLine()).trimmed();
+        if (!line.startsWith(QLatin1String("frame="))) {
+            continue;
+        }
+        const qint64 frame = line.section(QLatin1Char('='), 1).toLongLong();
+        const int progress = SegmentsProgress + int((100 - SegmentsProgress) * qBound(qint64(0), frame, total) / qMax(qint64(1), total));
+        if (progress > m_progress && progress < 100) {
+            m_progress = progress;
+            updateProgress();
+        }
+    }
+}
+
+void RenderJob::concatFinished(int exitCode, QProcess::ExitStatus status)
+{
+    const QString output = QString::fromLocal8Bit(m_concatProcess->readAllStandardError());
+    m_concatProcess->deleteLater();
+    m_concatProcess = nullptr;
+    QFile::remove(m_dest + QStringLiteral(".segments.txt"));
+    if (m_aborted) {
+        return;
+    }
+    if (status == QProcess::CrashExit || exitCode != 0 || !QFile::exists(m_dest)) {
+        m_errorMessage.append(output);
+        segmentsFailed(tr("Rendering of %1 aborted, segments could not be joined.").arg(m_dest));
+        return;
+    }
+    removeSegments();
+    slotIsOver(QProcess::NormalExit);
+}
+
+void RenderJob::removeSegments()
+{
+    for (const auto &segment : qAsConst(m_segments)) {
+        QFile::remove(segment.playlist);
+        QFile::remove(segment.output);
+    }
+}
+
+void RenderJob::segmentsFailed(const QString &error)
+{
+    m_aborted = true;
+    for (auto &segment : m_segments) {
+        if (segment.process) {
+            segment.process->kill();
+        }
+    }
+    if (m_concatProcess) {
+        m_concatProcess->kill();
+        m_concatProcess->waitForFinished();
+    }
+    removeSegments();
+    if (m_erase) {
+        QFile(m_scenelist).remove();
+    }
+    m_errorMessage.append(error);
+    sendFinish(-2, m_errorMessage);
+    m_logstream << error << "\n";
+    m_logstream.flush();
+    QProcess::startDetached(QStringLiteral("kdialog"), {QStringLiteral("--error"), error});
+    Q_EMIT renderingFinished();
+    m_looper.quit();
+}
@@ -16,6 +16,7 @@
 #include <QFile>
 #include <QObject>
 #include <QProcess>
+#include <QVector>
 // Testing
 #include <QTextStream>
 
@@ -27,6 +28,9 @@ public:
     RenderJob(const QString &render, const QString &scenelist, const QString &target, int pid = -1, int in = -1, int out = -1,
               const QString &subtitleFile = QString(), QObject *parent = nullptr);
     ~RenderJob() override;
+    /** @brief Encode the video of the comma separated "in-out" @p segments with up to @p workers melt processes and the audio in one
+     *  additional process, then join them without re-encoding */
+    void setSegments(const QString &segments, int workers);
 
 public Q_SLOTS:
     void start();
@@ -41,6 +45,23 @@ private Q_SLOTS:
     void receivedSubtitleProgress();
 
 private:
+    /** @brief A part of the render range encoded by its own melt process */
+    struct Segment
+    {
+        int in = 0;
+        int out = 0;
+        QString playlist;
+        QString output;
+        QProcess *process = nullptr;
+        /** @brief Last frame reported by the process */
+        int frame = 0;
+        bool done = false;
+        /** @brief This is the audio of the whole range, muxed with the joined video segments */
+        bool audio = false;
+    };
+    QVector<Segment> m_segments;
+    int m_segmentWorkers;
+    bool m_aborted;
     QString m_scenelist;
     QString m_dest;
     int m_progress;
@@ -63,9 +84,13 @@ private:
     bool m_dualpass;
     QString m_subtitleFile;
     QString m_temporaryRenderFile;
+    /** @brief ffmpeg executable used to join segments */
+    QString m_ffmpeg;
     QProcess *m_renderProcess;
     QProcess *m_subsProcess;
     QEventLoop m_looper;
+    /** @brief The ffmpeg process joining the rendered segments */
+    QProcess *m_concatProcess = nullptr;
     QString m_errorMessage;
     QList<QVariant> m_dbusargs;
     QDateTime m_startTime;
@@ -80,6 +105,18 @@ private:
     void sendFinish(int status, const QString &error);
     void updateProgress(int speed = -1);
     void sendProgress();
+    /** @brief Write one playlist per segment, returns false if segmented rendering cannot be used */
+    bool prepareSegments();
+    /** @brief Start waiting segments until m_segmentWorkers processes are running */
+    void startSegments();
+    void receivedSegmentStderr(int index);
+    void segmentFinished(int index, int exitCode, QProcess::ExitStatus status);
+    /** @brief Join the rendered video segments and mux the audio into the destination file */
+    void concatSegments();
+    void receivedConcatProgress();
+    void concatFinished(int exitCode, QProcess::ExitStatus status);
+    void removeSegments();
+    void segmentsFailed(const QString &error);
 
 Q_SIGNALS:
     void renderingFinished();
@@ -14,11 +14,21 @@
 
 /** @class AbstractAssetsRepository
     @brief This class is the base class for assets (transitions or effets) repositories
+    The parsed assets are stored in a snapshot (see AssetCache) and restored at the next start if MLT and the custom
+    asset files did not change. Restored assets keep their description as text until it is first used.
  */
 template <typename AssetType> class AbstractAssetsRepository
 {
 
 public:
+    /** @brief Describes how the repository was built */
+    struct LoadStats
+    {
+        qint64 elapsed{0};
+        bool fromCache{false};
+        int count{0};
+    };
+
     AbstractAssetsRepository();
     virtual ~AbstractAssetsRepository() = default;
 
@@ -47,6 +57,8 @@ public:
     /** @brief Returns a DomElement representing the asset's properties */
     QDomElement getXml(const QString &assetId) const;
 
+    LoadStats loadStats() const;
+
 protected:
     struct Info
     {
@@ -54,7 +66,10 @@ protected:
         QString mltId; //"tag" of the asset, that is the name of the mlt service
         QString name, description, author, version_str;
         int version{};
-        QDomElement xml;
+        /** @brief Use assetXml() to read it, it is not parsed yet for assets restored from the cache */
+        mutable QDomElement xml;
+        /// Serialized xml of an asset restored from the cache
+        mutable QString xmlSource;
         AssetType type;
     };
 
@@ -64,6 +79,13 @@ protected:
     void init();
     virtual Mlt::Properties *retrieveListFromMlt() const = 0;
 
+    /** @brief Returns the xml description of @p info, parsing it if needed */
+    QDomElement assetXml(const Info &info) const;
+
+    /** @brief Restore the assets from the cached snapshot, if it was stored with @p key */
+    bool loadFromCache(const QByteArray &key);
+    void saveToCache(const QByteArray &key) const;
+
     /** @brief Parse some info from a mlt structure
        @param res Datastructure to fill
        @return true on success
@@ -96,11 +118,19 @@ protected:
     /** @brief Returns the path to the assets' preferred list*/
     virtual QString assetPreferredListPath() const = 0;
 
+    /** @brief Returns the name of the snapshot storing the assets*/
+    virtual QString assetCacheName() const = 0;
+
     std::unordered_map<QString, Info> m_assets;
 
     QSet<QString> m_blacklist;
 
     QSet<QString> m_preferred_list;
+
+    LoadStats m_loadStats;
+
+private:
+    mutable std::mutex m_xmlMutex;
 };
 
 #include "abstractassetsrepository.ipp"
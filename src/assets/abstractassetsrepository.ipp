@@ -4,10 +4,12 @@
  */
 
 #include "xml/xml.hpp"
+#include "assets/assetcache.h"
 #include "kdenlivesettings.h"
 #include "core.h"
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QStandardPaths>
 #include <QString>
@@ -23,12 +25,38 @@ template <typename AssetType> AbstractAssetsRepository<AssetType>::AbstractAsset
 
 template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
 {
+    QElapsedTimer timer;
+    timer.start();
+
     // Parse blacklist
     parseAssetList(assetBlackListPath(), m_blacklist);
 
     // Parse preferred list
     parseAssetList(assetPreferredListPath(), m_preferred_list);
 
+    // List all MLT services once, custom assets may depend on filters or transitions
+    QSet<QString> mltServices;
+    QScopedPointer<Mlt::Properties> filters(pCore->getMltRepository()->filters());
+    for (int i = 0; i < filters->count(); ++i) {
+        mltServices.insert(QString(filters->get_name(i)));
+    }
+    QScopedPointer<Mlt::Properties> transitions(pCore->getMltRepository()->transitions());
+    for (int i = 0; i < transitions->count(); ++i) {
+        mltServices.insert(QString(transitions->get_name(i)));
+    }
+
+    // Set the directories to look into for effects.
+    QStringList asset_dirs = assetDirs();
+
+    QStringList blacklist = m_blacklist.values();
+    blacklist.sort();
+    const QByteArray cacheKey = AssetCache::key(mltServices.values(), asset_dirs, blacklist);
+    if (loadFromCache(cacheKey)) {
+        m_loadStats = {timer.elapsed(), true, int(m_assets.size())};
+        qDebug() << "Restored" << m_assets.size() << assetCacheName() << "from the startup cache in" << m_loadStats.elapsed << "ms";
+        return;
+    }
+
     // Retrieve the list of MLT's available assets.
     QScopedPointer<Mlt::Properties> assets(retrieveListFromMlt());
     QStringList emptyMetaAssets;
@@ -57,9 +85,6 @@ template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
 
     // We now parse custom effect xml
 
-    // Set the directories to look into for effects.
-    QStringList asset_dirs = assetDirs();
-
     /* Parsing of custom xml works as follows: we parse all custom files.
        Each of them contains a tag, which is the corresponding mlt asset, and an id that is the name of the asset. Note that several custom files can correspond
        to the same tag, and in that case they must have different ids. We do the parsing in a map from ids to parse info, and then we add them to the asset
@@ -90,26 +115,7 @@ template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
 
         QString dependency = custom.second.xml.attribute(QStringLiteral("dependency"), QString());
         if(!dependency.isEmpty()) {
-            bool found = false;
-            QScopedPointer<Mlt::Properties> effects(pCore->getMltRepository()->filters());
-            for(int i = 0; i < effects->count(); ++i) {
-                if(effects->get_name(i) == dependency) {
-                    found = true;
-                    break;
-                }
-            }
-
-            if(!found) {
-                QScopedPointer<Mlt::Properties> transitions(pCore->getMltRepository()->transitions());
-                for(int i = 0; i < transitions->count(); ++i) {
-                    if(transitions->get_name(i) == dependency) {
-                        found = true;
-                        break;
-                    }
-                }
-            }
-
-            if(!found) {
+            if(!mltServices.contains(dependency)) {
                 // asset depends on another asset that is invalid so remove this asset too
                 missingDependency << custom.first;
                 qDebug() << "Asset" << custom.first << "has invalid dependency" << dependency << "and is going to be removed";
@@ -123,6 +129,77 @@ template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
     for (const auto &invalid : qAsConst(emptyMetaAssets)) {
         m_assets.erase(invalid);
     }
+    saveToCache(cacheKey);
+    m_loadStats = {timer.elapsed(), false, int(m_assets.size())};
+    qDebug() << "Loaded" << m_assets.size() << assetCacheName() << "from MLT in" << m_loadStats.elapsed << "ms";
+}
+
+template <typename AssetType> bool AbstractAssetsRepository<AssetType>::loadFromCache(const QByteArray &key)
+{
+    const AssetCache::Snapshot snapshot = AssetCache::take(assetCacheName());
+    if (snapshot.key != key || snapshot.entries.isEmpty()) {
+        return false;
+    }
+    m_assets.reserve(size_t(snapshot.entries.size()));
+    for (const AssetCache::Entry &entry : snapshot.entries) {
+        Info info;
+        info.id = entry.id;
+        info.mltId = entry.mltId;
+        info.name = entry.name;
+        info.description = entry.description;
+        info.author = entry.author;
+        info.version_str = entry.version_str;
+        info.version = entry.version;
+        info.type = AssetType(entry.type);
+        info.xmlSource = entry.xml;
+        m_assets[entry.id] = info;
+    }
+    return true;
+}
+
+template <typename AssetType> void AbstractAssetsRepository<AssetType>::saveToCache(const QByteArray &key) const
+{
+    AssetCache::Snapshot snapshot;
+    snapshot.key = key;
+    snapshot.entries.reserve(int(m_assets.size()));
+    for (const auto &asset : m_assets) {
+        const Info &info = asset.second;
+        AssetCache::Entry entry;
+        entry.id = asset.first;
+        entry.mltId = info.mltId;
+        entry.name = info.name;
+        entry.description = info.description;
+        entry.author = info.author;
+        entry.version_str = info.version_str;
+        entry.version = info.version;
+        entry.type = int(info.type);
+        const QDomElement xml = assetXml(info);
+        if (!xml.isNull()) {
+            QTextStream stream(&entry.xml);
+            xml.save(stream, -1);
+        }
+        snapshot.entries << entry;
+    }
+    if (!AssetCache::save(assetCacheName(), snapshot)) {
+        qWarning() << "Could not write the startup cache for" << assetCacheName();
+    }
+}
+
+template <typename AssetType> QDomElement AbstractAssetsRepository<AssetType>::assetXml(const Info &info) const
+{
+    std::lock_guard<std::mutex> lock(m_xmlMutex);
+    if (!info.xmlSource.isEmpty()) {
+        QDomDocument doc;
+        doc.setContent(info.xmlSource);
+        info.xml = doc.documentElement();
+        info.xmlSource.clear();
+    }
+    return info.xml;
+}
+
+template <typename AssetType> typename AbstractAssetsRepository<AssetType>::LoadStats AbstractAssetsRepository<AssetType>::loadStats() const
+{
+    return m_loadStats;
 }
 
 template <typename AssetType> void AbstractAssetsRepository<AssetType>::parseAssetList(const QString &filePath, QSet<QString> &destination)
@@ -309,7 +386,7 @@ template <typename AssetType> AssetType AbstractAssetsRepository<AssetType>::get
 template <typename AssetType> bool AbstractAssetsRepository<AssetType>::isUnique(const QString &assetId) const
 {
     if (m_assets.count(assetId) > 0) {
-        return m_assets.at(assetId).xml.hasAttribute(QStringLiteral("unique"));
+        return assetXml(m_assets.at(assetId)).hasAttribute(QStringLiteral("unique"));
     }
     return false;
 }
@@ -346,7 +423,7 @@ template <typename AssetType> bool AbstractAssetsRepository<AssetType>::parseInf
     }
 
     // Check if there is a maximal version set
-    if (currentAsset.hasAttribute(QStringLiteral("version")) && !m_assets.at(tag).xml.isNull()) {
+    if (currentAsset.hasAttribute(QStringLiteral("version")) && !assetXml(m_assets.at(tag)).isNull()) {
         // a specific version of the filter is required
         if (m_assets.at(tag).version < int(100 * currentAsset.attribute(QStringLiteral("version")).toDouble())) {
             qDebug() << "plugin version too low:" << tag;
@@ -355,6 +432,8 @@ template <typename AssetType> bool AbstractAssetsRepository<AssetType>::parseInf
     }
 
     res = m_assets.at(tag);
+    // The caller sets the custom xml
+    res.xmlSource.clear();
     res.id = id;
     res.mltId = tag;
 
@@ -378,5 +457,5 @@ template <typename AssetType> QDomElement AbstractAssetsRepository<AssetType>::g
         qWarning() << "Unknown transition" << assetId;
         return QDomElement();
     }
-    return m_assets.at(assetId).xml.cloneNode().toElement();
+    return assetXml(m_assets.at(assetId)).cloneNode().toElement();
 }
@@ -0,0 +1,136 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "assetcache.h"
+
+#include <config-kdenlive.h>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocale>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+#include <mlt++/Mlt.h>
+
+QMutex AssetCache::m_mutex;
+QHash<QString, QFuture<AssetCache::Snapshot>> AssetCache::m_preloads;
+
+namespace {
+constexpr quint32 CacheMagic = 0x4b414331; // "KAC1"
+} // namespace
+
+QString AssetCache::cacheFile(const QString &name)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/assets-%1").arg(name);
+}
+
+void AssetCache::preload(const QString &name)
+{
+    QMutexLocker lock(&m_mutex);
+    if (!m_preloads.contains(name)) {
+        m_preloads.insert(name, QtConcurrent::run([name]() { return read(name); }));
+    }
+}
+
+AssetCache::Snapshot AssetCache::take(const QString &name)
+{
+    QFuture<Snapshot> future;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (!m_preloads.contains(name)) {
+            lock.unlock();
+            return read(name);
+        }
+        future = m_preloads.take(name);
+    }
+    return future.result();
+}
+
+AssetCache::Snapshot AssetCache::read(const QString &name)
+{
+    Snapshot snapshot;
+    QFile file(cacheFile(name));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return snapshot;
+    }
+    QDataStream in(&file);
+    quint32 magic;
+    qint32 count;
+    in >> magic;
+    if (magic != CacheMagic) {
+        return snapshot;
+    }
+    in >> snapshot.key >> count;
+    if (in.status() != QDataStream::Ok || count < 0) {
+        return Snapshot();
+    }
+    snapshot.entries.resize(count);
+    for (Entry &entry : snapshot.entries) {
+        in >> entry.id >> entry.mltId >> entry.name >> entry.description >> entry.author >> entry.version_str >> entry.version >> entry.type >> entry.xml;
+    }
+    if (in.status() != QDataStream::Ok) {
+        // Truncated or corrupted file
+        return Snapshot();
+    }
+    return snapshot;
+}
+
+bool AssetCache::save(const QString &name, const Snapshot &snapshot)
+{
+    const QString path = cacheFile(name);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out << CacheMagic << snapshot.key << qint32(snapshot.entries.size());
+    for (const Entry &entry : snapshot.entries) {
+        out << entry.id << entry.mltId << entry.name << entry.description << entry.author << entry.version_str << entry.version << entry.type << entry.xml;
+    }
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+void AssetCache::remove(const QString &name)
+{
+    QFile::remove(cacheFile(name));
+}
+
+QByteArray AssetCache::key(const QStringList &services, const QStringList &assetDirs, const QStringList &values)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    auto add = [&hash](const QString &value) {
+        hash.addData(value.toUtf8());
+        hash.addData("\n", 1);
+    };
+    add(QStringLiteral(KDENLIVE_VERSION));
+    add(QString::fromUtf8(mlt_version_get_string()));
+    add(QString::fromUtf8(mlt_environment("MLT_REPOSITORY")));
+    // Names and descriptions are translated
+    add(QLocale().uiLanguages().join(QLatin1Char(',')));
+    add(qEnvironmentVariable("LANGUAGE"));
+    QStringList sorted = services;
+    sorted.sort();
+    add(sorted.join(QLatin1Char(',')));
+    for (const QString &dir : assetDirs) {
+        add(dir);
+        const QFileInfoList files = QDir(dir).entryInfoList({QStringLiteral("*.xml")}, QDir::Files, QDir::Name);
+        for (const QFileInfo &info : files) {
+            add(QStringLiteral("%1 %2 %3").arg(info.fileName()).arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch()));
+        }
+    }
+    for (const QString &value : values) {
+        add(value);
+    }
+    return hash.result();
+}
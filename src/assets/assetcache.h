@@ -0,0 +1,64 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/** @class AssetCache
+    @brief Snapshot of an assets repository, stored on disk so that the next start does not query
+    the metadata of every MLT service and parse all custom asset files again.
+    A snapshot is only used if it was written with the same key, which covers the MLT version and services,
+    the application version and language, and the custom asset files with their modification time.
+    The file can be read in a worker thread by preload(), started before MLT is initialized.
+ */
+class AssetCache
+{
+public:
+    struct Entry
+    {
+        QString id;
+        QString mltId;
+        QString name;
+        QString description;
+        QString author;
+        QString version_str;
+        int version{0};
+        int type{0};
+        /// Serialized asset description, parsed when it is first used
+        QString xml;
+    };
+    struct Snapshot
+    {
+        QByteArray key;
+        QVector<Entry> entries;
+    };
+
+    /** @brief Start reading the snapshot @p name in a worker thread */
+    static void preload(const QString &name);
+    /** @brief Returns the snapshot @p name, waiting for preload() if it was called. The snapshot is empty if there is none. */
+    static Snapshot take(const QString &name);
+    static bool save(const QString &name, const Snapshot &snapshot);
+    /** @brief Delete the snapshot @p name */
+    static void remove(const QString &name);
+
+    /** @brief Build a snapshot key from the available MLT @p services, the folders of custom assets and additional @p values */
+    static QByteArray key(const QStringList &services, const QStringList &assetDirs, const QStringList &values);
+
+private:
+    static QString cacheFile(const QString &name);
+    static Snapshot read(const QString &name);
+
+    static QMutex m_mutex;
+    static QHash<QString, QFuture<Snapshot>> m_preloads;
+};
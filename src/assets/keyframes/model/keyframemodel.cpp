@@ -17,6 +17,7 @@
 #include <QLineF>
 #include <QSize>
 #include <mlt++/Mlt.h>
+#include <algorithm>
 #include <utility>
 
 KeyframeModel::KeyframeModel(std::weak_ptr<AssetParameterModel> model, const QModelIndex &index, std::weak_ptr<DocUndoStack> undo_stack, int in, int out,
@@ -1103,6 +1104,137 @@ QVariant KeyframeModel::getNormalizedValue(double newVal) const
     return QVariant();
 }
 
+bool KeyframeModel::isNumeric() const
+{
+    return m_paramType == ParamType::KeyframeParam || m_paramType == ParamType::ColorWheel;
+}
+
+std::shared_ptr<KeyframeModel::CompiledAnimation> KeyframeModel::compiledAnimation() const
+{
+    auto ptr = m_model.lock();
+    if (!ptr) {
+        return nullptr;
+    }
+    const QString animData = ptr->data(m_index, AssetParameterModel::ValueRole).toString();
+    const int out = ptr->data(m_index, AssetParameterModel::ParentDurationRole).toInt();
+    if (animData.isEmpty()) {
+        return nullptr;
+    }
+    if (m_compiled && m_compiled->out == out && m_compiled->animData == animData) {
+        return m_compiled;
+    }
+    auto compiled = std::make_shared<CompiledAnimation>();
+    compiled->animData = animData;
+    compiled->out = out;
+    compiled->properties.reset(new Mlt::Properties());
+    ptr->passProperties(*compiled->properties.get());
+    compiled->properties->set("key", animData.toUtf8().constData());
+    // This is a fake query to force the animation to be parsed
+    (void)compiled->properties->anim_get_double("key", 0, out);
+    Mlt::Animation anim = compiled->properties->get_animation("key");
+    const bool numeric = isNumeric();
+    for (int i = 0; i < anim.key_count(); ++i) {
+        int frame;
+        mlt_keyframe_type type;
+        anim.key_get(i, frame, type);
+        compiled->frames.push_back(frame);
+        compiled->types.push_back(type);
+        if (numeric) {
+            compiled->values.push_back(compiled->properties->anim_get_double("key", frame));
+        }
+    }
+    m_compiled = compiled;
+    return compiled;
+}
+
+double KeyframeModel::CompiledAnimation::valueAt(int frame) const
+{
+    if (frames.empty()) {
+        return properties->anim_get_double("key", frame);
+    }
+    // Like MLT, the first and last keyframes hold their value before and after the animation
+    auto next = std::upper_bound(frames.cbegin(), frames.cend(), frame);
+    if (next == frames.cbegin()) {
+        return values.front();
+    }
+    if (next == frames.cend()) {
+        return values.back();
+    }
+    const size_t ix = size_t(next - frames.cbegin()) - 1;
+    switch (types[ix]) {
+    case mlt_keyframe_discrete:
+        return values[ix];
+    case mlt_keyframe_linear: {
+        const double progress = double(frame - frames[ix]) / double(frames[ix + 1] - frames[ix]);
+        return values[ix] + (values[ix + 1] - values[ix]) * progress;
+    }
+    default:
+        // Smooth and eased curves depend on the neighbour keyframes, let MLT compute them
+        return properties->anim_get_double("key", frame);
+    }
+}
+
+void KeyframeModel::CompiledAnimation::valuesInRange(int from, int to, double *output) const
+{
+    if (frames.empty()) {
+        for (int frame = from; frame <= to; ++frame) {
+            *output++ = properties->anim_get_double("key", frame);
+        }
+        return;
+    }
+    int frame = from;
+    // Before the first keyframe
+    for (; frame <= to && frame < frames.front(); ++frame) {
+        *output++ = values.front();
+    }
+    auto next = std::upper_bound(frames.cbegin(), frames.cend(), frame);
+    while (frame <= to && next != frames.cend()) {
+        const size_t ix = size_t(next - frames.cbegin()) - 1;
+        const int segmentEnd = qMin(to + 1, *next);
+        const double start = values[ix];
+        switch (types[ix]) {
+        case mlt_keyframe_discrete:
+            for (; frame < segmentEnd; ++frame) {
+                *output++ = start;
+            }
+            break;
+        case mlt_keyframe_linear: {
+            const double delta = values[ix + 1] - start;
+            const double length = double(frames[ix + 1] - frames[ix]);
+            for (; frame < segmentEnd; ++frame) {
+                *output++ = start + delta * (double(frame - frames[ix]) / length);
+            }
+            break;
+        }
+        default:
+            for (; frame < segmentEnd; ++frame) {
+                *output++ = properties->anim_get_double("key", frame);
+            }
+            break;
+        }
+        ++next;
+    }
+    // After the last keyframe
+    for (; frame <= to; ++frame) {
+        *output++ = values.back();
+    }
+}
+
+QVector<double> KeyframeModel::getInterpolatedValues(int from, int to) const
+{
+    QVector<double> result;
+    if (!isNumeric() || to < from) {
+        return result;
+    }
+    QMutexLocker lock(&m_compiledMutex);
+    std::shared_ptr<CompiledAnimation> compiled = compiledAnimation();
+    if (compiled) {
+        result.resize(to - from + 1);
+        compiled->valuesInRange(from, to, result.data());
+    }
+    return result;
+}
+
 QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
 {
     if (m_keyframeList.count(pos) > 0) {
@@ -1111,39 +1243,29 @@ QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
     if (m_keyframeList.size() == 0) {
         return QVariant();
     }
-    Mlt::Properties mlt_prop;
-    QString animData;
-    int out = 0;
-    bool useOpacity = false;
-    if (auto ptr = m_model.lock()) {
-        ptr->passProperties(mlt_prop);
-        out = ptr->data(m_index, AssetParameterModel::ParentDurationRole).toInt();
-        useOpacity = ptr->data(m_index, AssetParameterModel::OpacityRole).toBool();
-        animData = ptr->data(m_index, AssetParameterModel::ValueRole).toString();
-    }
-
-    if (!animData.isEmpty() && (m_paramType == ParamType::KeyframeParam || m_paramType == ParamType::ColorWheel)) {
-        mlt_prop.set("key", animData.toUtf8().constData());
-        // This is a fake query to force the animation to be parsed
-        (void)mlt_prop.anim_get_double("key", 0, out);
-        return QVariant(mlt_prop.anim_get_double("key", pos.frames(pCore->getCurrentFps())));
-    }
-    if (!animData.isEmpty() && m_paramType == ParamType::AnimatedRect) {
-        mlt_prop.set("key", animData.toUtf8().constData());
-        // This is a fake query to force the animation to be parsed
-        (void)mlt_prop.anim_get_double("key", 0, out);
-        mlt_rect rect = mlt_prop.anim_get_rect("key", pos.frames(pCore->getCurrentFps()));
-        QString res = QStringLiteral("%1 %2 %3 %4").arg(int(rect.x)).arg(int(rect.y)).arg(int(rect.w)).arg(int(rect.h));
-        if (useOpacity) {
-            res.append(QStringLiteral(" %1").arg(QString::number(rect.o, 'f')));
-        }
-        return QVariant(res);
-    }
-    if (!animData.isEmpty() && m_paramType == ParamType::Color) {
-        mlt_prop.set("key", animData.toUtf8().constData());
-        // This is a fake query to force the animation to be parsed
-        (void)mlt_prop.anim_get_double("key", 0, out);
-        mlt_color mltColor = mlt_prop.anim_get_color("key", pos.frames(pCore->getCurrentFps()));
+    if (isNumeric() || m_paramType == ParamType::AnimatedRect || m_paramType == ParamType::Color) {
+        bool useOpacity = false;
+        if (auto ptr = m_model.lock()) {
+            useOpacity = ptr->data(m_index, AssetParameterModel::OpacityRole).toBool();
+        }
+        QMutexLocker lock(&m_compiledMutex);
+        std::shared_ptr<CompiledAnimation> compiled = compiledAnimation();
+        if (!compiled) {
+            return QVariant();
+        }
+        const int frame = pos.frames(pCore->getCurrentFps());
+        if (isNumeric()) {
+            return QVariant(compiled->valueAt(frame));
+        }
+        if (m_paramType == ParamType::AnimatedRect) {
+            mlt_rect rect = compiled->properties->anim_get_rect("key", frame);
+            QString res = QStringLiteral("%1 %2 %3 %4").arg(int(rect.x)).arg(int(rect.y)).arg(int(rect.w)).arg(int(rect.h));
+            if (useOpacity) {
+                res.append(QStringLiteral(" %1").arg(QString::number(rect.o, 'f')));
+            }
+            return QVariant(res);
+        }
+        mlt_color mltColor = compiled->properties->anim_get_color("key", frame);
         QColor color(mltColor.r, mltColor.g, mltColor.b, mltColor.a);
         return QVariant(QColorUtils::colorToString(color, true));
     }
@@ -1198,6 +1320,11 @@ void KeyframeModel::sendModification()
         QString name = ptr->data(m_index, AssetParameterModel::NameRole).toString();
         if (AssetParameterModel::isAnimated(m_paramType)) {
             m_lastData = getAnimProperty();
+            {
+                // The parameter value changes, drop the parsed animation
+                QMutexLocker lock(&m_compiledMutex);
+                m_compiled.reset();
+            }
             ptr->setParameter(name, m_lastData, false, m_index);
         } else {
             Q_ASSERT(false); // Not implemented, TODO
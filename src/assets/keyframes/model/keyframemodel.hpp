@@ -11,10 +11,12 @@
 #include "utils/gentime.h"
 
 #include <QAbstractListModel>
+#include <QMutex>
 #include <QReadWriteLock>
 
 #include <map>
 #include <memory>
+#include <vector>
 
 class AssetParameterModel;
 class DocUndoStack;
@@ -142,6 +144,8 @@ public:
     /** @brief Return the interpolated value at given pos */
     QVariant getInterpolatedValue(int pos) const;
     QVariant getInterpolatedValue(const GenTime &pos) const;
+    /** @brief Return the interpolated values of a numeric parameter for each frame in [from, to], or an empty list for other parameter types */
+    QVector<double> getInterpolatedValues(int from, int to) const;
     QVariant updateInterpolated(const QVariant &interpValue, double val);
     /** @brief Return the real value from a normalized one */
     QVariant getNormalizedValue(double newVal) const;
@@ -203,6 +207,29 @@ private:
     mutable QReadWriteLock m_lock;
 
     std::map<GenTime, std::pair<KeyframeType, QVariant>> m_keyframeList;
+
+    /** @brief The parsed animation of the parameter, so that interpolating does not parse the animation string again */
+    struct CompiledAnimation
+    {
+        QString animData;
+        int out{0};
+        std::unique_ptr<Mlt::Properties> properties;
+        /** @brief Sorted keyframe frames, with their type and value (numeric parameters only) */
+        std::vector<int> frames;
+        std::vector<mlt_keyframe_type> types;
+        std::vector<double> values;
+        /** @brief Value of a numeric parameter at @p frame, looked up in O(log k) for linear and discrete keyframes */
+        double valueAt(int frame) const;
+        /** @brief Writes the values of a numeric parameter for each frame in [from, to] to @p output */
+        void valuesInRange(int from, int to, double *output) const;
+    };
+    /** @brief Protects m_compiled, MLT animations can not be queried concurrently */
+    mutable QMutex m_compiledMutex;
+    mutable std::shared_ptr<CompiledAnimation> m_compiled;
+    /** @brief Returns the parsed animation matching the current parameter value, rebuilding it if the value changed.
+     *  Must be called with m_compiledMutex locked */
+    std::shared_ptr<CompiledAnimation> compiledAnimation() const;
+    bool isNumeric() const;
     bool moveOneKeyframe(GenTime oldPos, GenTime pos, QVariant newVal, Fun &undo, Fun &redo, bool updateView = true);
 
 Q_SIGNALS:
@@ -8,38 +8,109 @@
 #include <KDirWatch>
 #include <QFileInfo>
 
+namespace {
+// Send the modified files once no event was received for this duration
+constexpr int QuietPeriod = 1500;
+// Do not postpone a burst of events for longer than this
+constexpr int MaxBurstDuration = 10000;
+// A file is only reloaded once it was not modified for this duration
+constexpr int SettleDelay = 2000;
+} // namespace
+
+FileWatcherBackend::FileWatcherBackend(QObject *parent)
+    : QObject(parent)
+{
+}
+
+FileWatcherBackend::~FileWatcherBackend() = default;
+
+void FileWatcherBackend::ensureWatcher()
+{
+    if (m_watcher) {
+        return;
+    }
+    // KDirWatch uses one internal instance per thread, so it has to be created here
+    m_watcher.reset(new KDirWatch);
+    connect(m_watcher.get(), &KDirWatch::dirty, this, &FileWatcherBackend::dirty);
+    connect(m_watcher.get(), &KDirWatch::created, this, &FileWatcherBackend::created);
+    connect(m_watcher.get(), &KDirWatch::deleted, this, &FileWatcherBackend::deleted);
+}
+
+void FileWatcherBackend::addFolders(const QStringList &folders)
+{
+    ensureWatcher();
+    m_watcher->stopScan();
+    for (const QString &folder : folders) {
+        m_watcher->addDir(folder, KDirWatch::WatchFiles);
+    }
+    m_watcher->startScan();
+}
+
+void FileWatcherBackend::removeFolders(const QStringList &folders)
+{
+    if (!m_watcher) {
+        return;
+    }
+    for (const QString &folder : folders) {
+        m_watcher->removeDir(folder);
+    }
+}
+
+void FileWatcherBackend::clear()
+{
+    // Dropping the instance removes all its watches at once
+    m_watcher.reset();
+}
+
 FileWatcher::FileWatcher(QObject *parent)
     : QObject(parent)
-    , m_fileWatcher(new KDirWatch)
+    , m_backend(new FileWatcherBackend)
 {
+    m_backend->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_backend, &QObject::deleteLater);
+    connect(m_backend, &FileWatcherBackend::dirty, this, &FileWatcher::slotUrlModified);
+    connect(m_backend, &FileWatcherBackend::deleted, this, &FileWatcher::slotUrlMissing);
+    connect(m_backend, &FileWatcherBackend::created, this, &FileWatcher::slotUrlAdded);
+    m_thread.start(QThread::LowPriority);
     // Init clip modification tracker
-    m_modifiedTimer.setInterval(2000);
-    connect(m_fileWatcher.get(), &KDirWatch::dirty, this, &FileWatcher::slotUrlModified);
-    connect(m_fileWatcher.get(), &KDirWatch::deleted, this, &FileWatcher::slotUrlMissing);
-    connect(m_fileWatcher.get(), &KDirWatch::created, this, &FileWatcher::slotUrlAdded);
+    m_modifiedTimer.setInterval(QuietPeriod);
+    m_modifiedTimer.setSingleShot(true);
     connect(&m_modifiedTimer, &QTimer::timeout, this, &FileWatcher::slotProcessModifiedUrls);
     m_queueTimer.setInterval(300);
     m_queueTimer.setSingleShot(true);
     connect(&m_queueTimer, &QTimer::timeout, this, &FileWatcher::slotProcessQueue);
 }
 
+FileWatcher::~FileWatcher()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
 void FileWatcher::slotProcessQueue()
 {
     if (m_pendingUrls.size() == 0) {
         return;
     }
-    auto iter = m_pendingUrls.begin();
-    doAddFile(iter->first, iter->second);
-    m_pendingUrls.erase(iter->first);
-    if (m_pendingUrls.size() > 0 && !m_queueTimer.isActive()) {
-        m_queueTimer.start();
+    QStringList folders;
+    for (const auto &pending : m_pendingUrls) {
+        const QString folder = doAddFile(pending.first, pending.second);
+        if (!folder.isEmpty()) {
+            folders << folder;
+        }
+    }
+    m_pendingUrls.clear();
+    if (!folders.isEmpty()) {
+        QMetaObject::invokeMethod(m_backend, "addFolders", Qt::QueuedConnection, Q_ARG(QStringList, folders));
     }
 }
 
 void FileWatcher::addFile(const QString &binId, const QString &url)
 {
     if (m_occurences.count(url) > 0) {
-        // Already queued
+        // Already watched
+        m_occurences[url].insert(binId);
+        m_binClipPaths[binId] = url;
         return;
     }
     m_pendingUrls[binId] = url;
@@ -48,21 +119,28 @@ void FileWatcher::addFile(const QString &binId, const QString &url)
     }
 }
 
-void FileWatcher::doAddFile(const QString &binId, const QString &url)
+QString FileWatcher::doAddFile(const QString &binId, const QString &url)
 {
     if (url.isEmpty()) {
-        return;
+        return QString();
     }
+    QString newFolder;
     if (m_occurences.count(url) == 0) {
-        // QtConcurrent::run([=] { KDirWatch::self()->addFile(url); });
-        m_fileWatcher->addFile(url);
+        const QString folder = QFileInfo(url).absolutePath();
+        if (m_folders.count(folder) == 0) {
+            newFolder = folder;
+            m_folderChecked[folder] = QDateTime::currentDateTime();
+        }
+        m_folders[folder].insert(url);
     }
     m_occurences[url].insert(binId);
     m_binClipPaths[binId] = url;
+    return newFolder;
 }
 
 void FileWatcher::removeFile(const QString &binId)
 {
+    m_pendingUrls.erase(binId);
     if (m_binClipPaths.count(binId) == 0) {
         return;
     }
@@ -70,66 +148,139 @@ void FileWatcher::removeFile(const QString &binId)
     m_occurences[url].erase(binId);
     m_binClipPaths.erase(binId);
     if (m_occurences[url].empty()) {
-        m_fileWatcher->removeFile(url);
         m_occurences.erase(url);
+        m_modifiedUrls.erase(url);
+        const QString folder = QFileInfo(url).absolutePath();
+        auto it = m_folders.find(folder);
+        if (it != m_folders.end()) {
+            it->second.erase(url);
+            if (it->second.empty()) {
+                m_folders.erase(it);
+                m_folderChecked.erase(folder);
+                QMetaObject::invokeMethod(m_backend, "removeFolders", Qt::QueuedConnection, Q_ARG(QStringList, QStringList{folder}));
+            }
+        }
     }
 }
 
-void FileWatcher::slotUrlModified(const QString &path)
+void FileWatcher::queueModified(const QString &path)
 {
+    if (m_modifiedUrls.empty()) {
+        m_burstStart = QDateTime::currentDateTime();
+    }
     if (m_modifiedUrls.insert(path).second) {
         for (const QString &id : m_occurences[path]) {
             Q_EMIT binClipWaiting(id);
         }
     }
-    if (!m_modifiedTimer.isActive()) {
+    // Wait for the end of the burst, but do not postpone the reload forever
+    if (m_burstStart.msecsTo(QDateTime::currentDateTime()) < MaxBurstDuration || !m_modifiedTimer.isActive()) {
         m_modifiedTimer.start();
     }
 }
 
+void FileWatcher::slotUrlModified(const QString &path)
+{
+    m_stats.received++;
+    if (m_occurences.count(path) > 0) {
+        queueModified(path);
+        return;
+    }
+    auto folder = m_folders.find(path);
+    if (folder == m_folders.end()) {
+        // Another file in a watched folder
+        return;
+    }
+    // Depending on the backend, changes to a file may only be reported on its folder
+    const QDateTime checked = m_folderChecked[path];
+    m_folderChecked[path] = QDateTime::currentDateTime();
+    for (const QString &url : folder->second) {
+        if (m_modifiedUrls.count(url) == 0 && QFileInfo(url).lastModified() >= checked) {
+            queueModified(url);
+        }
+    }
+}
+
 void FileWatcher::slotUrlAdded(const QString &path)
 {
-    for (const QString &id : m_occurences[path]) {
-        Q_EMIT binClipModified(id);
+    m_stats.received++;
+    if (m_occurences.count(path) > 0) {
+        // The file is probably still being copied, reload it once the burst is over
+        queueModified(path);
     }
 }
 
 void FileWatcher::slotUrlMissing(const QString &path)
 {
-    for (const QString &id : m_occurences[path]) {
+    m_stats.received++;
+    auto it = m_occurences.find(path);
+    if (it == m_occurences.end()) {
+        return;
+    }
+    m_modifiedUrls.erase(path);
+    for (const QString &id : it->second) {
         Q_EMIT binClipMissing(id);
     }
 }
 
 void FileWatcher::slotProcessModifiedUrls()
 {
-    auto checkList = m_modifiedUrls;
-    for (const QString &path : checkList) {
-        if (m_fileWatcher->ctime(path).msecsTo(QDateTime::currentDateTime()) > 2000) {
-            for (const QString &id : m_occurences[path]) {
-                Q_EMIT binClipModified(id);
-            }
-            m_modifiedUrls.erase(path);
+    const QDateTime now = QDateTime::currentDateTime();
+    QStringList ids;
+    for (auto it = m_modifiedUrls.begin(); it != m_modifiedUrls.end();) {
+        const QFileInfo info(*it);
+        if (info.exists() && info.lastModified().msecsTo(now) <= SettleDelay) {
+            // Still being written
+            ++it;
+            continue;
         }
+        m_stats.processed++;
+        for (const QString &id : m_occurences[*it]) {
+            ids << id;
+        }
+        it = m_modifiedUrls.erase(it);
     }
-    if (m_modifiedUrls.empty()) {
-        m_modifiedTimer.stop();
+    if (!ids.isEmpty()) {
+        m_stats.batches++;
+        Q_EMIT binClipsModified(ids);
+    }
+    if (!m_modifiedUrls.empty()) {
+        m_burstStart = now;
+        m_modifiedTimer.start();
     }
 }
 
 void FileWatcher::clear()
 {
-    m_fileWatcher->stopScan();
-    for (const auto &f : m_occurences) {
-        m_fileWatcher->removeFile(f.first);
-    }
+    m_queueTimer.stop();
+    m_modifiedTimer.stop();
     m_occurences.clear();
     m_modifiedUrls.clear();
     m_binClipPaths.clear();
-    m_fileWatcher->startScan();
+    m_pendingUrls.clear();
+    m_folders.clear();
+    m_folderChecked.clear();
+    QMetaObject::invokeMethod(m_backend, "clear", Qt::QueuedConnection);
 }
 
 bool FileWatcher::contains(const QString &path) const
 {
-    return m_fileWatcher->contains(path);
+    if (m_occurences.count(path) > 0) {
+        return true;
+    }
+    for (const auto &pending : m_pendingUrls) {
+        if (pending.second == path) {
+            return true;
+        }
+    }
+    return false;
+}
+
+FileWatcher::Stats FileWatcher::stats() const
+{
+    Stats result = m_stats;
+    result.pending = int(m_modifiedUrls.size() + m_pendingUrls.size());
+    result.folders = int(m_folders.size());
+    result.files = int(m_occurences.size());
+    return result;
 }
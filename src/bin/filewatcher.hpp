@@ -7,21 +7,71 @@
 
 #include "definitions.h"
 #include <KDirWatch>
+#include <QDateTime>
+#include <QThread>
 #include <QTimer>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 
+/** @class FileWatcherBackend
+    @brief Owns the KDirWatch instance. It lives in the watcher thread, so that registering folders
+    (which reads them and sets up the system watches) does not block the GUI.
+ */
+class FileWatcherBackend : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileWatcherBackend(QObject *parent = nullptr);
+    ~FileWatcherBackend() override;
+
+public Q_SLOTS:
+    /** @brief Start watching the files contained in @p folders */
+    void addFolders(const QStringList &folders);
+    void removeFolders(const QStringList &folders);
+    void clear();
+
+Q_SIGNALS:
+    void dirty(const QString &path);
+    void created(const QString &path);
+    void deleted(const QString &path);
+
+private:
+    /// Created on first use, from the watcher thread
+    std::unique_ptr<KDirWatch> m_watcher;
+    void ensureWatcher();
+};
+
 /** @class FileWatcher
     @brief This class is responsible for watching all files used in the project
     and triggers a reload notification when a file changes.
+    The folders containing the files are watched rather than each file, so a project with thousands of clips
+    only needs a few system watches. Events received in a burst are coalesced and sent as one batch.
  */
 class FileWatcher : public QObject
 {
     Q_OBJECT
 
 public:
+    /** @brief Counters describing the watcher activity */
+    struct Stats
+    {
+        /// Events received from the system watcher, including ones for files that are not clips
+        quint64 received{0};
+        /// Clip files that were reported as modified
+        quint64 processed{0};
+        /// Number of binClipsModified signals sent
+        quint64 batches{0};
+        /// Clip files waiting for the end of a burst of events, or to be registered
+        int pending{0};
+        int folders{0};
+        int files{0};
+    };
+
     // Constructor
     explicit FileWatcher(QObject *parent = nullptr);
+    ~FileWatcher() override;
     /** @brief Add a file to the queue for watched items */
     void addFile(const QString &binId, const QString &url);
     /** @brief Remove a binId from the list of watched items */
@@ -30,12 +80,14 @@ public:
     bool contains(const QString &path) const;
     /** @brief Reset all watched files */
     void clear();
+    Stats stats() const;
 
 Q_SIGNALS:
-    /** @brief This signal is triggered whenever the file corresponding to a bin clip has been modified and should be reloaded. Note that this signal is sent no
-     * more than every 1500 ms. We also make sure that at least 1000ms has passed since the last modification of the file. */
-    void binClipModified(const QString &binId);
-    /** @brief Same signal than binClipModified, but triggers immediately. Can be useful to refresh UI without actually reloading the file (yet)*/
+    /** @brief This signal is triggered whenever files corresponding to bin clips have been modified and should be reloaded. Modifications are
+     * collected until no event was received for 1500 ms (or at most 10 seconds), and a file is only reported once 2000ms have passed since its last
+     * modification. */
+    void binClipsModified(const QStringList &binIds);
+    /** @brief Triggers immediately when a clip file changes. Can be useful to refresh UI without actually reloading the file (yet)*/
     void binClipWaiting(const QString &binId);
     void binClipMissing(const QString &binId);
 
@@ -47,21 +99,31 @@ private Q_SLOTS:
     void slotProcessQueue();
 
 private:
-    /// This is a handle to the watcher singleton, not owned by this class.
-    std::unique_ptr<KDirWatch> m_fileWatcher;
+    QThread m_thread;
+    /// Lives in m_thread, deleted when it finishes
+    FileWatcherBackend *m_backend;
     /// A list with urls as keys, and the corresponding clip ids as value
     std::unordered_map<QString, std::unordered_set<QString>> m_occurences;
     /// keys are binId, keys are stored paths
     std::unordered_map<QString, QString> m_binClipPaths;
+    /// Watched folders, with the watched urls they contain
+    std::unordered_map<QString, std::unordered_set<QString>> m_folders;
+    /// Last time the files of a folder were compared against a folder event
+    std::unordered_map<QString, QDateTime> m_folderChecked;
 
     /// List of files for which we received an update since the last send
     std::unordered_set<QString> m_modifiedUrls;
+    /// Time of the first event of the current burst
+    QDateTime m_burstStart;
 
-    /// When loading a project or adding many clips, adding many files to the watcher causes a freeze, so queue them
+    /// Files added since the last registration, registered together. keys are binId
     std::unordered_map<QString, QString> m_pendingUrls;
 
     QTimer m_modifiedTimer;
     QTimer m_queueTimer;
-    /// Add a file to the list of watched items
-    void doAddFile(const QString &binId, const QString &url);
+    Stats m_stats;
+    /// Add a file to the list of watched items, returns its folder if it was not watched yet
+    QString doAddFile(const QString &binId, const QString &url);
+    /// Mark @p path as modified and postpone the end of the current burst
+    void queueModified(const QString &path);
 };
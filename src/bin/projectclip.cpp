@@ -30,6 +30,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "projectitemmodel.h"
 #include "projectsubclip.h"
 #include "timeline2/model/snapmodel.hpp"
+#include "utils/filehashcache.h"
 #include "utils/thumbnailcache.hpp"
 #include "utils/timecode.h"
 #include "xml/xml.hpp"
@@ -283,8 +284,12 @@ void ProjectClip::updateAudioThumbnail(bool cachedThumb)
                     st.next();
                     int channels = channelsList.value(st.key());
                     double channelHeight = double(streamHeight) / channels;
-                    const QVector<uint8_t> audioLevels = audioFrameCache(st.key());
-                    qreal indicesPrPixel = qreal(audioLevels.length()) / img.width();
+                    const AudioLevelsPtr audioLevels = audioFrameCache(st.key());
+                    if (!audioLevels) {
+                        streamCount++;
+                        continue;
+                    }
+                    qreal indicesPrPixel = qreal(audioLevels->size()) / img.width();
                     int idx;
                     for (int channel = 0; channel < channels; channel++) {
                         double y = (streamHeight * streamCount) + (channel * channelHeight) + channelHeight / 2;
@@ -292,10 +297,10 @@ void ProjectClip::updateAudioThumbnail(bool cachedThumb)
                             idx = int(ceil(i * indicesPrPixel));
                             idx += idx % channels;
                             idx += channel;
-                            if (idx >= audioLevels.length() || idx < 0) {
+                            if (idx >= audioLevels->size() || idx < 0) {
                                 break;
                             }
-                            double level = audioLevels.at(idx) * channelHeight / 510.; // divide height by 510 (2*255) to get height
+                            double level = audioLevels->at(idx) * channelHeight / 510.; // divide height by 510 (2*255) to get height
                             painter.drawLine(i, int(y - level), i, int(y + level));
                         }
                     }
@@ -1571,11 +1576,13 @@ const QByteArray ProjectClip::getFolderHash(const QDir &dir, QString fileName)
     fileName.append(files.join(QLatin1Char(',')));
     // Include file hash info in case we have several folders with same file names (can happen for image sequences)
     if (!files.isEmpty()) {
-        QPair<QByteArray, qint64> hashData = calculateHash(dir.absoluteFilePath(files.first()));
-        fileName.append(hashData.first);
-        fileName.append(QString::number(hashData.second));
+        QStringList hashedFiles = {dir.absoluteFilePath(files.first())};
         if (files.size() > 1) {
-            hashData = calculateHash(dir.absoluteFilePath(files.at(files.size() / 2)));
+            hashedFiles << dir.absoluteFilePath(files.at(files.size() / 2));
+        }
+        const auto hashes = FileHashCache::get()->hashFiles(hashedFiles);
+        for (const QString &file : qAsConst(hashedFiles)) {
+            const QPair<QByteArray, qint64> hashData = hashes.value(file);
             fileName.append(hashData.first);
             fileName.append(QString::number(hashData.second));
         }
@@ -1636,28 +1643,7 @@ const QString ProjectClip::getFileHash()
 
 const QPair<QByteArray, qint64> ProjectClip::calculateHash(const QString &path)
 {
-    QFile file(path);
-    QByteArray fileHash;
-    qint64 fSize = 0;
-    if (file.open(QIODevice::ReadOnly)) { // write size and hash only if resource points to a file
-        /*
-         * 1 MB = 1 second per 450 files (or faster)
-         * 10 MB = 9 seconds per 450 files (or faster)
-         */
-        QByteArray fileData;
-        fSize = file.size();
-        if (fSize > 2000000) {
-            fileData = file.read(1000000);
-            if (file.seek(file.size() - 1000000)) {
-                fileData.append(file.readAll());
-            }
-        } else {
-            fileData = file.readAll();
-        }
-        file.close();
-        fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-    }
-    return {fileHash, fSize};
+    return FileHashCache::get()->hash(path);
 }
 
 double ProjectClip::getOriginalFps() const
@@ -2055,14 +2041,15 @@ void ProjectClip::discardAudioThumb()
         audioThumbPath = getAudioThumbPath(st);
         if (!audioThumbPath.isEmpty()) {
             QFile::remove(audioThumbPath);
+            QFile::remove(AudioLevelsTask::checkpointPath(audioThumbPath));
         }
         // Clear audio cache
         QString key = QString("%1:%2").arg(m_binId).arg(st);
         pCore->audioThumbCache.insert(key, QByteArray("-"));
     }
-    // Delete thumbnail
+    // Delete thumbnail from older versions
     for (int &st : streams) {
-        audioThumbPath = getAudioThumbPath(st);
+        audioThumbPath = getAudioThumbPath(st, true);
         if (!audioThumbPath.isEmpty()) {
             QFile::remove(audioThumbPath);
         }
@@ -2085,7 +2072,7 @@ int ProjectClip::getAudioStreamFfmpegIndex(int mltStream)
     return -1;
 }
 
-const QString ProjectClip::getAudioThumbPath(int stream)
+const QString ProjectClip::getAudioThumbPath(int stream, bool legacyFormat)
 {
     if (audioInfo() == nullptr) {
         return QString();
@@ -2103,7 +2090,8 @@ const QString ProjectClip::getAudioThumbPath(int stream)
     QString audioPath = thumbFolder.absoluteFilePath(clipHash);
     audioPath.append(QLatin1Char('_') + QString::number(stream));
     int roundedFps = int(pCore->getCurrentFps());
-    audioPath.append(QStringLiteral("_%1_audio.png").arg(roundedFps));
+    audioPath.append(QStringLiteral("_%1_audio").arg(roundedFps));
+    audioPath.append(legacyFormat ? QStringLiteral(".png") : QStringLiteral(".peaks"));
     return audioPath;
 }
 
@@ -2522,6 +2510,9 @@ void ProjectClip::updateTimelineClips(const QVector<int> &roles)
         if (auto timeline = clip.second.lock()) {
             if (timeline->uuid() == pCore->currentTimelineId()) {
                 timeline->requestClipUpdate(clip.first, roles);
+            } else {
+                // Not displayed, just make sure the values are read again when it is
+                timeline->invalidateClipSnapshot(clip.first);
             }
         } else {
             qDebug() << "Error while reloading clip thumb: timeline unavailable";
@@ -2617,37 +2608,56 @@ int ProjectClip::getAudioMax(int stream)
         return m_masterProducer->get_int(key.toUtf8().constData());
     }
     // Process audio max for the stream
-    const QString key2 = QString("_kdenlive:audio%1").arg(stream);
-    if (!m_masterProducer->property_exists(key2.toUtf8().constData())) {
+    const AudioLevelsPtr levels = audioFrameCache(stream);
+    if (!levels || levels->isEmpty()) {
         return 0;
     }
-    const QVector<uint8_t> audioData = *static_cast<QVector<uint8_t> *>(m_masterProducer->get_data(key2.toUtf8().constData()));
-    if (audioData.isEmpty()) {
-        return 0;
+    int max = levels->maxLevel();
+    m_masterProducer->set(key.toUtf8().constData(), max);
+    return max;
+}
+
+static void deleteAudioLevels(AudioLevelsPtr *levels)
+{
+    delete levels;
+}
+
+void ProjectClip::setAudioLevels(int stream, const AudioLevelsPtr &levels, bool final)
+{
+    // The producer holds its own reference, released when the data is replaced or the producer deleted
+    auto *data = new AudioLevelsPtr(levels);
+    const QString key = QString("_kdenlive:audio%1").arg(stream);
+    m_masterProducer->lock();
+    if (final) {
+        const QString key2 = QString("kdenlive:audio_max%1").arg(stream);
+        m_masterProducer->set(key2.toUtf8().constData(), qMax(1, levels->maxLevel()));
     }
-    uint max = *std::max_element(audioData.constBegin(), audioData.constEnd());
-    m_masterProducer->set(key.toUtf8().constData(), int(max));
-    return int(max);
+    m_masterProducer->set(key.toUtf8().constData(), data, 0, (mlt_destructor)deleteAudioLevels);
+    m_masterProducer->unlock();
 }
 
-const QVector<uint8_t> ProjectClip::audioFrameCache(int stream)
+AudioLevelsPtr ProjectClip::audioFrameCache(int stream)
 {
-    QVector<uint8_t> audioLevels;
     if (stream == -1) {
         if (m_audioInfo) {
             stream = m_audioInfo->ffmpeg_audio_index();
         } else {
-            return audioLevels;
+            return nullptr;
         }
     }
     const QString key = QString("_kdenlive:audio%1").arg(stream);
-    if (m_masterProducer->get_data(key.toUtf8().constData())) {
-        const QVector<uint8_t> audioData = *static_cast<QVector<uint8_t> *>(m_masterProducer->get_data(key.toUtf8().constData()));
-        return audioData;
-    } else {
+    AudioLevelsPtr levels;
+    // Copy the reference while locked, the levels may be replaced at any time by the audio levels task
+    m_masterProducer->lock();
+    auto *data = static_cast<AudioLevelsPtr *>(m_masterProducer->get_data(key.toUtf8().constData()));
+    if (data) {
+        levels = *data;
+    }
+    m_masterProducer->unlock();
+    if (!levels) {
         qDebug() << "=== AUDIO NOT FOUND ";
     }
-    return QVector<uint8_t>();
+    return levels;
 
     // TODO
     /*QString key = QString("%1:%2").arg(m_binId).arg(stream);
@@ -10,6 +10,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include "abstractprojectitem.h"
 #include "definitions.h"
+#include "lib/audio/audioLevels.h"
 #include "mltcontroller/clipcontroller.h"
 #include "timeline2/model/timelinemodel.hpp"
 
@@ -185,8 +186,10 @@ public:
     QStringList subClipIds() const;
     /** @brief Delete cached audio thumb - needs to be recreated */
     void discardAudioThumb();
-    /** @brief Get path for this clip's audio thumbnail */
-    const QString getAudioThumbPath(int stream);
+    /** @brief Get path for this clip's audio thumbnail
+     *  @param legacyFormat if true, return the path of the PNG thumbnail used by older versions
+     */
+    const QString getAudioThumbPath(int stream, bool legacyFormat = false);
     /** @brief Returns true if this producer has audio and can be splitted on timeline*/
     bool isSplittable() const;
 
@@ -226,9 +229,13 @@ public:
     /** @brief Get the frame position used for Bin clip thumbnail
      */
     int getThumbFrame() const;
-    /** @brief Return audio cache for a stream
+    /** @brief Return audio cache for a stream, shared with the other users of the levels
+     */
+    AudioLevelsPtr audioFrameCache(int stream = -1);
+    /** @brief Publish new audio levels for a stream, readers holding the previous ones keep them
+     *  @param final If true, the levels are complete and the stream max level is updated
      */
-    const QVector <uint8_t> audioFrameCache(int stream = -1);
+    void setAudioLevels(int stream, const AudioLevelsPtr &levels, bool final);
     /** @brief Return FFmpeg's audio stream index for an MLT audio stream index
      */
     int getAudioStreamFfmpegIndex(int mltStream);
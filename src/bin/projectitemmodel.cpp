@@ -54,7 +54,7 @@ ProjectItemModel::ProjectItemModel(QObject *parent)
     QPixmap pix(QSize(160, 90));
     pix.fill(Qt::lightGray);
     m_blankThumb.addPixmap(pix);
-    connect(m_fileWatcher.get(), &FileWatcher::binClipModified, this, &ProjectItemModel::reloadClip);
+    connect(m_fileWatcher.get(), &FileWatcher::binClipsModified, this, &ProjectItemModel::reloadClips);
     connect(m_fileWatcher.get(), &FileWatcher::binClipWaiting, this, &ProjectItemModel::setClipWaiting);
     connect(m_fileWatcher.get(), &FileWatcher::binClipMissing, this, &ProjectItemModel::setClipInvalid);
 }
@@ -461,44 +461,44 @@ void ProjectItemModel::onItemUpdated(const QString &binId, int role)
     }
 }
 
+std::shared_ptr<AbstractProjectItem> ProjectItemModel::indexedItem(const QString &binId, AbstractProjectItem::PROJECTITEMTYPE type) const
+{
+    auto it = m_binIdIndex.find(binId);
+    if (it == m_binIdIndex.end()) {
+        return nullptr;
+    }
+    auto item = it->second.lock();
+    if (item && item->itemType() == type) {
+        return item;
+    }
+    return nullptr;
+}
+
 std::shared_ptr<ProjectClip> ProjectItemModel::getClipByBinID(const QString &binId)
 {
     READ_LOCK();
     if (binId.contains(QLatin1Char('_'))) {
         return getClipByBinID(binId.section(QLatin1Char('_'), 0, 0));
     }
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectClip>(c);
-        }
-    }
-    return nullptr;
+    return std::static_pointer_cast<ProjectClip>(indexedItem(binId, AbstractProjectItem::ClipItem));
 }
 
-const QVector<uint8_t> ProjectItemModel::getAudioLevelsByBinID(const QString &binId, int stream)
+AudioLevelsPtr ProjectItemModel::getAudioLevelsByBinID(const QString &binId, int stream)
 {
     READ_LOCK();
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectClip>(c)->audioFrameCache(stream);
-        }
+    auto clip = std::static_pointer_cast<ProjectClip>(indexedItem(binId, AbstractProjectItem::ClipItem));
+    if (clip) {
+        return clip->audioFrameCache(stream);
     }
-    return QVector<uint8_t>();
+    return nullptr;
 }
 
 double ProjectItemModel::getAudioMaxLevel(const QString &binId, int stream)
 {
     READ_LOCK();
-    for (const auto &item : m_allItems) {
-        auto i = std::static_pointer_cast<AbstractProjectItem>(item.second.lock());
-        if (i->itemType() == AbstractProjectItem::ClipItem && i->clipId() == binId) {
-            auto clip = std::static_pointer_cast<ProjectClip>(i);
-            if (clip) {
-                return clip->getAudioMax(stream);
-            }
-        }
+    auto clip = std::static_pointer_cast<ProjectClip>(indexedItem(binId, AbstractProjectItem::ClipItem));
+    if (clip) {
+        return clip->getAudioMax(stream);
     }
     return 0;
 }
@@ -512,13 +512,7 @@ bool ProjectItemModel::hasClip(const QString &binId)
 std::shared_ptr<ProjectFolder> ProjectItemModel::getFolderByBinId(const QString &binId)
 {
     READ_LOCK();
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::FolderItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectFolder>(c);
-        }
-    }
-    return nullptr;
+    return std::static_pointer_cast<ProjectFolder>(indexedItem(binId, AbstractProjectItem::FolderItem));
 }
 
 QList<std::shared_ptr<ProjectFolder>> ProjectItemModel::getFolders()
@@ -549,13 +543,42 @@ const QString ProjectItemModel::getFolderIdByName(const QString &folderName)
 std::shared_ptr<AbstractProjectItem> ProjectItemModel::getItemByBinId(const QString &binId)
 {
     READ_LOCK();
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->clipId() == binId) {
-            return c;
+    auto it = m_binIdIndex.find(binId);
+    return it == m_binIdIndex.end() ? nullptr : it->second.lock();
+}
+
+bool ProjectItemModel::checkIndexes() const
+{
+    READ_LOCK();
+    std::unordered_map<QString, QSet<QString>> urls;
+    size_t count = 0;
+    for (const auto &item : m_allItems) {
+        auto c = std::static_pointer_cast<AbstractProjectItem>(item.second.lock());
+        if (!c) {
+            continue;
+        }
+        count++;
+        auto it = m_binIdIndex.find(c->clipId());
+        if (it == m_binIdIndex.end() || it->second.lock() != c) {
+            qDebug() << "Error: item" << c->clipId() << "is not properly indexed";
+            return false;
+        }
+        if (c->itemType() == AbstractProjectItem::ClipItem) {
+            const QString url = std::static_pointer_cast<ProjectClip>(c)->clipUrl();
+            if (!url.isEmpty()) {
+                urls[urlKey(QFileInfo(url))].insert(c->clipId());
+            }
         }
     }
-    return nullptr;
+    if (count != m_binIdIndex.size()) {
+        qDebug() << "Error: the bin id index has" << m_binIdIndex.size() << "entries for" << count << "items";
+        return false;
+    }
+    if (urls != m_urlIndex) {
+        qDebug() << "Error: the url index does not match the clip urls";
+        return false;
+    }
+    return true;
 }
 
 void ProjectItemModel::setBinEffectsEnabled(bool enabled)
@@ -736,6 +759,7 @@ void ProjectItemModel::registerItem(const std::shared_ptr<TreeItem> &item)
     auto clip = std::static_pointer_cast<AbstractProjectItem>(item);
     m_binPlaylist->manageBinItemInsertion(clip);
     AbstractTreeModel::registerItem(item);
+    m_binIdIndex[clip->clipId()] = clip;
     if (clip->itemType() == AbstractProjectItem::ClipItem) {
         auto clipItem = std::static_pointer_cast<ProjectClip>(clip);
         updateWatcher(clipItem);
@@ -754,9 +778,14 @@ void ProjectItemModel::deregisterItem(int id, TreeItem *item)
     m_binPlaylist->manageBinItemDeletion(clip);
     // TODO : here, we should suspend jobs belonging to the item we delete. They can be restarted if the item is reinserted by undo
     AbstractTreeModel::deregisterItem(id, item);
+    auto indexed = m_binIdIndex.find(clip->clipId());
+    if (indexed != m_binIdIndex.end() && (indexed->second.expired() || indexed->second.lock().get() == clip)) {
+        m_binIdIndex.erase(indexed);
+    }
     if (clip->itemType() == AbstractProjectItem::ClipItem) {
         auto clipItem = static_cast<ProjectClip *>(clip);
         m_fileWatcher->removeFile(clipItem->clipId());
+        indexClipUrl(clipItem->clipId(), QString());
     }
 }
 
@@ -1058,6 +1087,39 @@ void ProjectItemModel::updateCacheThumbnail(std::unordered_map<QString, std::vec
     }
 }
 
+QString ProjectItemModel::urlKey(const QFileInfo &file)
+{
+    // Same rules as the QFileInfo comparison operator
+    QString key = file.canonicalFilePath();
+    if (key.isEmpty()) {
+        key = file.absoluteFilePath();
+    }
+#ifdef Q_OS_WIN
+    key = key.toLower();
+#endif
+    return key;
+}
+
+void ProjectItemModel::indexClipUrl(const QString &binId, const QString &url)
+{
+    auto previous = m_clipUrlKeys.find(binId);
+    if (previous != m_clipUrlKeys.end()) {
+        auto it = m_urlIndex.find(previous->second);
+        if (it != m_urlIndex.end()) {
+            it->second.remove(binId);
+            if (it->second.isEmpty()) {
+                m_urlIndex.erase(it);
+            }
+        }
+        m_clipUrlKeys.erase(previous);
+    }
+    if (!url.isEmpty()) {
+        const QString key = urlKey(QFileInfo(url));
+        m_urlIndex[key].insert(binId);
+        m_clipUrlKeys[binId] = key;
+    }
+}
+
 QStringList ProjectItemModel::getClipByUrl(const QFileInfo &url) const
 {
     READ_LOCK();
@@ -1066,13 +1128,9 @@ QStringList ProjectItemModel::getClipByUrl(const QFileInfo &url) const
         // Invalid url
         return result;
     }
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem) {
-            if (QFileInfo(std::static_pointer_cast<ProjectClip>(c)->clipUrl()) == url) {
-                result << c->clipId();
-            }
-        }
+    auto it = m_urlIndex.find(urlKey(url));
+    if (it != m_urlIndex.end()) {
+        result = it->second.values();
     }
     return result;
 }
@@ -1149,13 +1207,7 @@ bool ProjectItemModel::isIdFree(const QString &id) const
     if (id.isEmpty()) {
         return false;
     }
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->clipId() == id) {
-            return false;
-        }
-    }
-    return true;
+    return m_binIdIndex.count(id) == 0;
 }
 
 QList<QUuid> ProjectItemModel::loadBinPlaylist(Mlt::Service *documentTractor, std::unordered_map<QString, QString> &binIdCorresp, QStringList &expandedFolders,
@@ -1507,6 +1559,17 @@ void ProjectItemModel::reloadClip(const QString &binId)
     }
 }
 
+void ProjectItemModel::reloadClips(const QStringList &binIds)
+{
+    QWriteLocker locker(&m_lock);
+    for (const QString &binId : binIds) {
+        std::shared_ptr<ProjectClip> clip = getClipByBinID(binId);
+        if (clip) {
+            clip->reloadProducer();
+        }
+    }
+}
+
 void ProjectItemModel::setClipWaiting(const QString &binId)
 {
     QWriteLocker locker(&m_lock);
@@ -1529,6 +1592,9 @@ void ProjectItemModel::setClipInvalid(const QString &binId)
 void ProjectItemModel::updateWatcher(const std::shared_ptr<ProjectClip> &clipItem)
 {
     QWriteLocker locker(&m_lock);
+    if (getItemByBinId(clipItem->clipId()) == clipItem) {
+        indexClipUrl(clipItem->clipId(), clipItem->clipUrl());
+    }
     ClipType::ProducerType type = clipItem->clipType();
     if (type == ClipType::AV || type == ClipType::Audio || type == ClipType::Image || type == ClipType::Video || type == ClipType::Playlist ||
         type == ClipType::TextTemplate || type == ClipType::Animation) {
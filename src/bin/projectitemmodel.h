@@ -12,13 +12,16 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "abstractmodel/abstracttreemodel.hpp"
 #include "bin/abstractprojectitem.h"
 #include "definitions.h"
+#include "lib/audio/audioLevels.h"
 #include "undohelper.hpp"
 #include <QDomElement>
 #include <QFileInfo>
 #include <QIcon>
 #include <QReadWriteLock>
+#include <QSet>
 #include <QSize>
 #include <QUuid>
+#include <unordered_map>
 
 class BinPlaylist;
 class FileWatcher;
@@ -56,8 +59,8 @@ public:
 
     /** @brief Returns a clip from the hierarchy, given its id */
     std::shared_ptr<ProjectClip> getClipByBinID(const QString &binId);
-    /** @brief Returns audio levels for a clip from its id */
-    const QVector <uint8_t>getAudioLevelsByBinID(const QString &binId, int stream);
+    /** @brief Returns audio levels for a clip from its id, shared with the clip */
+    AudioLevelsPtr getAudioLevelsByBinID(const QString &binId, int stream);
     double getAudioMaxLevel(const QString &binId, int stream);
 
     /** @brief Returns a list of clips using the given url */
@@ -76,6 +79,9 @@ public:
     /** @brief Gets any item by its id. */
     std::shared_ptr<AbstractProjectItem> getItemByBinId(const QString &binId);
 
+    /** @brief Check that the bin id and url indexes match the registered items. This walks all items, use it in tests or debug code only */
+    bool checkIndexes() const;
+
     /** @brief This function change the global enabled state of the bin effects */
     void setBinEffectsEnabled(bool enabled);
 
@@ -202,6 +208,8 @@ public:
 
     /** @brief Request that the producer of a given clip is reloaded */
     void reloadClip(const QString &binId);
+    /** @brief Request that the producers of several clips are reloaded, for example after files were copied over */
+    void reloadClips(const QStringList &binIds);
 
     /** @brief Set the status of the clip to "waiting". This happens when the corresponding file has changed*/
     void setClipWaiting(const QString &binId);
@@ -278,6 +286,19 @@ private:
 
     mutable QReadWriteLock m_lock; // This is a lock that ensures safety in case of concurrent access
 
+    /** @brief Registered items by bin id, ids being unique among clips, folders and subclips */
+    std::unordered_map<QString, std::weak_ptr<AbstractProjectItem>> m_binIdIndex;
+    /** @brief Bin ids of the clips by file, keyed by urlKey() */
+    std::unordered_map<QString, QSet<QString>> m_urlIndex;
+    /** @brief The key under which each clip is stored in m_urlIndex */
+    std::unordered_map<QString, QString> m_clipUrlKeys;
+    /** @brief Key of a file in m_urlIndex: its canonical path, or its absolute path if it does not exist */
+    static QString urlKey(const QFileInfo &file);
+    /** @brief Returns the registered item with the given id and type */
+    std::shared_ptr<AbstractProjectItem> indexedItem(const QString &binId, AbstractProjectItem::PROJECTITEMTYPE type) const;
+    /** @brief Store the current url of a clip in m_urlIndex, or remove it if @param url is empty */
+    void indexClipUrl(const QString &binId, const QString &url);
+
     std::unique_ptr<BinPlaylist> m_binPlaylist;
 
     std::unique_ptr<FileWatcher> m_fileWatcher;
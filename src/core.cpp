@@ -29,6 +29,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "timeline2/model/timelineitemmodel.hpp"
 #include "timeline2/view/timelinecontroller.h"
 #include "timeline2/view/timelinewidget.h"
+#include "utils/filehashcache.h"
 #include <mlt++/MltRepository.h>
 
 #include "utils/KMessageBox_KdenliveCompat.h"
@@ -67,6 +68,7 @@ void Core::finishShutdown()
     if (m_projectManager) {
         delete m_projectManager;
     }
+    FileHashCache::get()->save();
     ClipController::mediaUnavailable.reset();
 }
 
@@ -20,6 +20,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "project/dialogs/profilewidget.h"
 #include "timeline2/view/timelinecontroller.h"
 #include "timeline2/view/timelinewidget.h"
+#include "utils/thumbnailcache.hpp"
 #include "wizard.h"
 
 #ifdef USE_V4L
@@ -1081,6 +1082,11 @@ void KdenliveSettingsDialog::updateSettings()
         }
     }
 
+    if (m_configEnv.kcfg_thumbcachememory->value() != KdenliveSettings::thumbcachememory()) {
+        KdenliveSettings::setThumbcachememory(m_configEnv.kcfg_thumbcachememory->value());
+        ThumbnailCache::get()->setMemoryBudget(qint64(KdenliveSettings::thumbcachememory()) * 1048576);
+    }
+
     if (m_configCapture.kcfg_v4l_format->currentIndex() != int(KdenliveSettings::v4l_format())) {
         saveCurrentV4lProfile();
         KdenliveSettings::setV4l_format(0);
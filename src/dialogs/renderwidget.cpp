@@ -51,11 +51,13 @@
 #include <QHeaderView>
 #include <QInputDialog>
 #include <QJsonArray>
+#include <QJsonDocument>
 #include <QJsonObject>
 #include <QKeyEvent>
 #include <QMenu>
 #include <QMimeDatabase>
 #include <QProcess>
+#include <QSaveFile>
 #include <QScreen>
 #include <QScrollBar>
 #include <QStandardPaths>
@@ -89,7 +91,9 @@ enum {
     LastTimeRole,
     LastFrameRole,
     OpenBrowserRole,
-    PlayAfterRole
+    PlayAfterRole,
+    CostRole,
+    RestoredRole
 };
 
 // Running job status
@@ -267,6 +271,8 @@ RenderWidget::RenderWidget(bool enableProxy, QWidget *parent)
     });
     connect(m_view.export_meta, &QCheckBox::stateChanged, this, &RenderWidget::refreshParams);
     connect(m_view.checkTwoPass, &QCheckBox::stateChanged, this, &RenderWidget::refreshParams);
+    m_view.segment_render->setChecked(KdenliveSettings::segmentrender());
+    connect(m_view.segment_render, &QCheckBox::toggled, this, &KdenliveSettings::setSegmentrender);
 
     connect(m_view.buttonRender, &QAbstractButton::clicked, this, [&]() { slotPrepareExport(); });
     connect(m_view.buttonGenerateScript, &QAbstractButton::clicked, this, [&]() { slotPrepareExport(true); });
@@ -336,6 +342,9 @@ RenderWidget::RenderWidget(bool enableProxy, QWidget *parent)
     focusItem();
     adjustSize();
     m_view.embed_subtitles->setToolTip(i18n("Only works for the matroska (mkv) format"));
+
+    // Jobs left in the queue when Kdenlive was closed
+    restoreRenderQueue();
 }
 
 void RenderWidget::slotShareActionFinished(const QJsonObject &output, int error, const QString &message)
@@ -379,6 +388,7 @@ void RenderWidget::saveConfig()
     KConfigGroup resourceConfig(config, "RenderWidget");
     resourceConfig.writeEntry(QStringLiteral("showoptions"), m_view.options->isChecked());
     config->sync();
+    saveRenderQueue();
 }
 
 void RenderWidget::loadConfig()
@@ -635,6 +645,9 @@ void RenderWidget::slotPrepareExport(bool delayedRendering)
     request->setEmbedSubtitles(m_view.embed_subtitles->isEnabled() && m_view.embed_subtitles->isChecked());
     request->setTwoPass(m_view.checkTwoPass->isChecked());
     request->setAudioFilePerTrack(m_view.stemAudioExport->isChecked() && m_view.stemAudioExport->isEnabled());
+    if (m_view.segment_render->isChecked() && !QStandardPaths::findExecutable(QStringLiteral("ffmpeg")).isEmpty()) {
+        request->setSegmentedRendering(int(KdenliveSettings::segmentrenderlength() * pCore->getCurrentFps()));
+    }
 
     bool guideMultiExport = m_view.guide_multi_box->isChecked();
     int guideCategory = m_view.guideCategoryChooser->currentCategory();
@@ -670,7 +683,7 @@ void RenderWidget::slotPrepareExport(bool delayedRendering)
 
     QList<RenderJobItem *> jobList;
     for (auto &job : jobs) {
-        RenderJobItem *renderItem = createRenderJob(job.playlistPath, job.outputPath, job.subtitlePath);
+        RenderJobItem *renderItem = createRenderJob(job.playlistPath, job.outputPath, job.subtitlePath, job.segments);
         if (renderItem != nullptr) {
             jobList << renderItem;
         }
@@ -683,7 +696,7 @@ void RenderWidget::slotPrepareExport(bool delayedRendering)
     checkRenderStatus();
 }
 
-RenderJobItem *RenderWidget::createRenderJob(const QString &playlist, const QString &outputFile, const QString &subtitleFile)
+RenderJobItem *RenderWidget::createRenderJob(const QString &playlist, const QString &outputFile, const QString &subtitleFile, const QString &segments)
 {
     QList<QTreeWidgetItem *> existing = m_view.running_jobs->findItems(outputFile, Qt::MatchExactly, 1);
     RenderJobItem *renderItem = nullptr;
@@ -713,7 +726,20 @@ RenderJobItem *RenderWidget::createRenderJob(const QString &playlist, const QStr
     if (!subtitleFile.isEmpty()) {
         argsJob << QStringLiteral("--subtitle") << subtitleFile;
     }
+    if (!segments.isEmpty()) {
+        int workers = KdenliveSettings::segmentrenderworkers();
+        if (workers <= 0) {
+            // Encoders are multi threaded too, don't start one process per core
+            workers = qBound(2, QThread::idealThreadCount() / 4, 8);
+        }
+        argsJob << QStringLiteral("--segments") << segments << QStringLiteral("--workers") << QString::number(workers);
+    }
     renderItem->setData(1, ParametersRole, argsJob);
+    int cost = m_params.encodingCost(pCore->getCurrentFrameSize(), QThread::idealThreadCount());
+    if (!segments.isEmpty()) {
+        cost *= argsJob.last().toInt();
+    }
+    renderItem->setData(1, CostRole, cost);
     qDebug() << "* CREATED JOB WITH ARGS: " << argsJob;
     renderItem->setData(1, OpenBrowserRole, m_view.open_browser->isChecked());
     renderItem->setData(1, PlayAfterRole, m_view.play_after->isChecked());
@@ -727,56 +753,178 @@ RenderJobItem *RenderWidget::createRenderJob(const QString &playlist, const QStr
     return renderItem;
 }
 
+int RenderWidget::jobCost(const QTreeWidgetItem *item)
+{
+    const int cores = qMax(1, QThread::idealThreadCount());
+    const QVariant cost = item->data(1, CostRole);
+    // Jobs we know nothing about are expected to use the whole machine
+    return cost.isValid() ? qBound(1, cost.toInt(), cores) : cores;
+}
+
 void RenderWidget::checkRenderStatus()
 {
+    saveRenderQueue();
     // check if we have a job waiting to render
     if (m_blockProcessing) {
         return;
     }
 
-    // Make sure no other rendering is running
-    if (runningJobsCount() > 0) {
-        return;
-    }
-
+    const int maxJobs = qMax(1, KdenliveSettings::renderjobs());
+    const int cores = qMax(1, QThread::idealThreadCount());
+    int running = 0;
+    int load = 0;
+    QStringList runningOutputs;
     auto *item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
+    while (item != nullptr) {
+        if (item->status() == RUNNINGJOB || item->status() == STARTINGJOB) {
+            running++;
+            load += jobCost(item);
+            runningOutputs << item->text(1);
+        }
+        item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
+    }
 
     bool waitingJob = false;
 
-    // Find first waiting job
-    while (item != nullptr) {
-        if (item->status() == WAITINGJOB) {
-            QDateTime t = QDateTime::currentDateTime();
-            item->setData(1, StartTimeRole, t);
-            item->setData(1, LastTimeRole, t);
-            waitingJob = true;
-            startRendering(item);
-            // Check for 2 pass encoding
-            QStringList jobData = item->data(1, ParametersRole).toStringList();
-            if (jobData.size() > 2 && jobData.at(1).endsWith(QStringLiteral("-pass2.mlt"))) {
-                // Find and remove 1st pass job
-                QTreeWidgetItem *above = m_view.running_jobs->itemAbove(item);
-                QString firstPassName = jobData.at(1).section(QLatin1Char('-'), 0, -2) + QStringLiteral(".mlt");
-                while (above) {
-                    QStringList aboveData = above->data(1, ParametersRole).toStringList();
-                    qDebug() << "// GOT  JOB: " << aboveData.at(1);
-                    if (aboveData.size() > 2 && aboveData.at(1) == firstPassName) {
-                        delete above;
-                        break;
-                    }
-                    above = m_view.running_jobs->itemAbove(above);
+    // Start waiting jobs in queue order while they fit in the free cores. A smaller job
+    // further in the queue may use the cores left by a job that does not fit yet.
+    item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
+    while (item != nullptr && running < maxJobs) {
+        if (item->status() != WAITINGJOB || item->data(1, RestoredRole).toBool()) {
+            item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
+            continue;
+        }
+        waitingJob = true;
+        const int cost = jobCost(item);
+        // Never write the same file twice at once (like both passes of a 2 pass encoding)
+        if ((load > 0 && load + cost > cores) || runningOutputs.contains(item->text(1))) {
+            item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
+            continue;
+        }
+        QDateTime t = QDateTime::currentDateTime();
+        item->setData(1, StartTimeRole, t);
+        item->setData(1, LastTimeRole, t);
+        item->setStatus(STARTINGJOB);
+        startRendering(item);
+        if (item->status() == STARTINGJOB) {
+            running++;
+            load += cost;
+            runningOutputs << item->text(1);
+        }
+        // Check for 2 pass encoding
+        QStringList jobData = item->data(1, ParametersRole).toStringList();
+        if (jobData.size() > 2 && jobData.at(1).endsWith(QStringLiteral("-pass2.mlt"))) {
+            // Find and remove 1st pass job
+            QTreeWidgetItem *above = m_view.running_jobs->itemAbove(item);
+            QString firstPassName = jobData.at(1).section(QLatin1Char('-'), 0, -2) + QStringLiteral(".mlt");
+            while (above) {
+                QStringList aboveData = above->data(1, ParametersRole).toStringList();
+                qDebug() << "// GOT  JOB: " << aboveData.at(1);
+                if (aboveData.size() > 2 && aboveData.at(1) == firstPassName) {
+                    delete above;
+                    break;
                 }
+                above = m_view.running_jobs->itemAbove(above);
             }
-            item->setStatus(STARTINGJOB);
-            break;
         }
         item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
     }
-    if (!waitingJob && m_view.shutdown->isChecked()) {
+    if (!waitingJob && running == 0 && m_view.shutdown->isChecked()) {
         Q_EMIT shutdown();
     }
 }
 
+QString RenderWidget::renderQueueFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/renderqueue.json");
+}
+
+void RenderWidget::saveRenderQueue()
+{
+    if (m_blockProcessing) {
+        // Waiting jobs were handed over to a script
+        return;
+    }
+    QJsonArray jobs;
+    auto *item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
+    while (item != nullptr) {
+        if (item->status() == WAITINGJOB && item->data(1, ParametersRole).isValid()) {
+            QJsonObject job;
+            job.insert(QLatin1String("output"), item->text(1));
+            job.insert(QLatin1String("parameters"), QJsonArray::fromStringList(item->data(1, ParametersRole).toStringList()));
+            if (item->data(1, CostRole).isValid()) {
+                job.insert(QLatin1String("cost"), item->data(1, CostRole).toInt());
+            }
+            job.insert(QLatin1String("openbrowser"), item->data(1, OpenBrowserRole).toBool());
+            job.insert(QLatin1String("playafter"), item->data(1, PlayAfterRole).toBool());
+            job.insert(QLatin1String("info"), item->data(1, ExtraInfoRole).toString());
+            jobs.append(job);
+        }
+        item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
+    }
+    const QString fileName = renderQueueFile();
+    if (jobs.isEmpty()) {
+        QFile::remove(fileName);
+        return;
+    }
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(KDENLIVE_LOG) << "Cannot save render queue to" << fileName;
+        return;
+    }
+    file.write(QJsonDocument(jobs).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+void RenderWidget::restoreRenderQueue()
+{
+    QFile file(renderQueueFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QJsonArray jobs = QJsonDocument::fromJson(file.readAll()).array();
+    file.close();
+    for (const auto &value : jobs) {
+        const QJsonObject job = value.toObject();
+        const QString output = job.value(QLatin1String("output")).toString();
+        QStringList parameters;
+        for (const auto &param : job.value(QLatin1String("parameters")).toArray()) {
+            parameters << param.toString();
+        }
+        // The playlist might have been in a temporary folder that was cleaned since
+        if (output.isEmpty() || parameters.size() < 3 || !QFile::exists(parameters.at(2)) ||
+            !m_view.running_jobs->findItems(output, Qt::MatchExactly, 1).isEmpty()) {
+            continue;
+        }
+        // Update the arguments bound to the previous session: progress goes to this process and the melt path may have changed
+        parameters[1] = KdenliveSettings::meltpath();
+        int ix = parameters.indexOf(QStringLiteral("--pid"));
+        if (ix > 0 && ix + 1 < parameters.size()) {
+            parameters[ix + 1] = QString::number(QCoreApplication::applicationPid());
+        }
+        ix = parameters.indexOf(QStringLiteral("--subtitle"));
+        if (ix > 0 && (ix + 1 >= parameters.size() || !QFile::exists(parameters.at(ix + 1)))) {
+            parameters.erase(parameters.begin() + ix, parameters.begin() + qMin(ix + 2, parameters.size()));
+        }
+        auto *renderItem = new RenderJobItem(m_view.running_jobs, QStringList() << QString() << output);
+        QDateTime t = QDateTime::currentDateTime();
+        renderItem->setData(1, StartTimeRole, t);
+        renderItem->setData(1, LastTimeRole, t);
+        renderItem->setData(1, LastFrameRole, 0);
+        renderItem->setData(1, ParametersRole, parameters);
+        if (job.contains(QLatin1String("cost"))) {
+            renderItem->setData(1, CostRole, job.value(QLatin1String("cost")).toInt());
+        }
+        renderItem->setData(1, OpenBrowserRole, job.value(QLatin1String("openbrowser")).toBool());
+        renderItem->setData(1, PlayAfterRole, job.value(QLatin1String("playafter")).toBool());
+        renderItem->setData(1, ExtraInfoRole, job.value(QLatin1String("info")).toString());
+        // Wait for the user to start the jobs of a previous session
+        renderItem->setData(1, RestoredRole, true);
+        renderItem->setData(1, Qt::UserRole, i18n("Restored from a previous session, start the job to render it"));
+    }
+}
+
 void RenderWidget::startRendering(RenderJobItem *item)
 {
     auto rendererArgs = item->data(1, ParametersRole).toStringList();
@@ -1286,6 +1434,7 @@ void RenderWidget::slotStartCurrentJob()
 {
     auto *current = static_cast<RenderJobItem *>(m_view.running_jobs->currentItem());
     if ((current != nullptr) && current->status() == WAITINGJOB) {
+        current->setData(1, RestoredRole, false);
         startRendering(current);
     }
     m_view.start_job->setEnabled(false);
@@ -1637,6 +1786,8 @@ bool RenderWidget::startWaitingRenderJobs()
     file.close();
     QFile::setPermissions(autoscriptFile, file.permissions() | QFile::ExeUser);
     QProcess::startDetached(autoscriptFile, QStringList());
+    // The script now owns these jobs
+    QFile::remove(renderQueueFile());
     return true;
 }
 
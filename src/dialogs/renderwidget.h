@@ -224,12 +224,19 @@ private:
     Purpose::Menu *m_shareMenu;
     void parseProfiles(const QString &selectedProfile = QString());
     QUrl filenameWithExtension(QUrl url, const QString &extension);
-    /** @brief Check if a job needs to be started. */
+    /** @brief Start waiting jobs as long as the renderjobs limit and the processor cores allow it. */
     void checkRenderStatus();
+    /** @brief Estimated number of processor cores used by the job of @param item */
+    static int jobCost(const QTreeWidgetItem *item);
+    /** @brief File storing the waiting jobs, so that they survive a restart */
+    static QString renderQueueFile();
+    void saveRenderQueue();
+    void restoreRenderQueue();
     void startRendering(RenderJobItem *item);
     /** @brief Create a rendering profile from MLT preset. */
     QTreeWidgetItem *loadFromMltPreset(const QString &groupName, const QString &path, QString profileName, bool codecInName = false);
-    RenderJobItem *createRenderJob(const QString &playlist, const QString &outputFile, const QString &subtitleFile = QString());
+    RenderJobItem *createRenderJob(const QString &playlist, const QString &outputFile, const QString &subtitleFile = QString(),
+                                   const QString &segments = QString());
 
 Q_SIGNALS:
     void abortProcess(const QString &url);
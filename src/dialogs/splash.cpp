@@ -42,7 +42,7 @@ void Splash::showProgressMessage(const QString &message, int progress, int max)
         m_pbStyle.maximum = max;
     }
     if (progress > 0) {
-        m_progress++;
+        m_progress += progress;
     }
     if (!message.isEmpty()) {
         showMessage(message, Qt::AlignRight | Qt::AlignBottom, Qt::white);
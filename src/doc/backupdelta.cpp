@@ -0,0 +1,294 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "backupdelta.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMultiHash>
+#include <QSaveFile>
+#include <QVector>
+
+namespace {
+const QByteArray Magic = QByteArrayLiteral("KDENLIVEDELTA 1\n");
+const QString ProjectExtension = QStringLiteral(".kdenlive");
+const QString DeltaExtension = QStringLiteral(".kdenlivedelta");
+// Only remember a few occurrences of lines that appear many times (closing tags, empty properties)
+constexpr int MaxCandidates = 8;
+// Do not look further than this when comparing candidate runs
+constexpr int MaxRunCheck = 64;
+
+/** @brief Returns the start offset of each line of @p data, followed by data.size() */
+QVector<int> lineStarts(const QByteArray &data)
+{
+    QVector<int> starts;
+    int pos = 0;
+    while (pos < data.size()) {
+        starts << pos;
+        const int end = data.indexOf('\n', pos);
+        pos = end < 0 ? data.size() : end + 1;
+    }
+    starts << data.size();
+    return starts;
+}
+
+QByteArray lineAt(const QByteArray &data, const QVector<int> &starts, int line)
+{
+    return QByteArray::fromRawData(data.constData() + starts.at(line), starts.at(line + 1) - starts.at(line));
+}
+
+bool readLine(const QByteArray &data, int &pos, QByteArray *line)
+{
+    const int end = data.indexOf('\n', pos);
+    if (end < 0) {
+        return false;
+    }
+    *line = data.mid(pos, end - pos);
+    pos = end + 1;
+    return true;
+}
+
+bool writeFile(const QString &path, const QByteArray &data)
+{
+    QSaveFile output(path);
+    return output.open(QIODevice::WriteOnly) && output.write(data) == data.size() && output.commit();
+}
+} // namespace
+
+QByteArray BackupDelta::create(const QByteArray &base, const QByteArray &target, const QString &baseName)
+{
+    const QVector<int> baseStarts = lineStarts(base);
+    const QVector<int> targetStarts = lineStarts(target);
+    const int baseCount = baseStarts.size() - 1;
+    const int targetCount = targetStarts.size() - 1;
+
+    QMultiHash<QByteArray, int> index;
+    index.reserve(baseCount);
+    for (int i = 0; i < baseCount; ++i) {
+        const QByteArray line = lineAt(base, baseStarts, i);
+        if (index.count(line) < MaxCandidates) {
+            index.insert(line, i);
+        }
+    }
+
+    QByteArray delta = Magic;
+    delta.append(baseName.toUtf8() + '\n');
+    delta.append(QCryptographicHash::hash(target, QCryptographicHash::Md5).toHex() + ' ' + QByteArray::number(target.size()) + '\n');
+
+    int copyStart = -1;
+    int copyEnd = -1;
+    int literalStart = -1;
+    int literalEnd = -1;
+    auto flushCopy = [&]() {
+        if (copyStart >= 0) {
+            delta.append("c " + QByteArray::number(copyStart) + ' ' + QByteArray::number(copyEnd - copyStart) + '\n');
+            copyStart = -1;
+        }
+    };
+    auto flushLiteral = [&]() {
+        if (literalStart >= 0) {
+            delta.append("i " + QByteArray::number(literalEnd - literalStart) + '\n');
+            delta.append(target.constData() + literalStart, literalEnd - literalStart);
+            literalStart = -1;
+        }
+    };
+
+    // Base line following the current copy run
+    int nextBase = -1;
+    for (int i = 0; i < targetCount; ++i) {
+        const QByteArray line = lineAt(target, targetStarts, i);
+        if (nextBase >= 0 && nextBase < baseCount && lineAt(base, baseStarts, nextBase) == line) {
+            copyEnd = baseStarts.at(nextBase + 1);
+            ++nextBase;
+            continue;
+        }
+        // Start a new copy run from the candidate matching the most following lines
+        int best = -1;
+        int bestRun = 0;
+        auto it = index.constFind(line);
+        while (it != index.constEnd() && it.key() == line) {
+            const int candidate = it.value();
+            int run = 1;
+            while (run < MaxRunCheck && candidate + run < baseCount && i + run < targetCount &&
+                   lineAt(base, baseStarts, candidate + run) == lineAt(target, targetStarts, i + run)) {
+                ++run;
+            }
+            if (run > bestRun) {
+                best = candidate;
+                bestRun = run;
+            }
+            ++it;
+        }
+        if (best >= 0) {
+            flushLiteral();
+            flushCopy();
+            copyStart = baseStarts.at(best);
+            copyEnd = baseStarts.at(best + 1);
+            nextBase = best + 1;
+        } else {
+            flushCopy();
+            nextBase = -1;
+            if (literalStart < 0) {
+                literalStart = targetStarts.at(i);
+            }
+            literalEnd = targetStarts.at(i + 1);
+        }
+    }
+    flushCopy();
+    flushLiteral();
+    return delta;
+}
+
+bool BackupDelta::isDelta(const QByteArray &data)
+{
+    return data.startsWith(Magic);
+}
+
+QString BackupDelta::baseName(const QByteArray &delta)
+{
+    if (!isDelta(delta)) {
+        return QString();
+    }
+    int pos = Magic.size();
+    QByteArray line;
+    return readLine(delta, pos, &line) ? QString::fromUtf8(line) : QString();
+}
+
+bool BackupDelta::apply(const QByteArray &base, const QByteArray &delta, QByteArray *result)
+{
+    result->clear();
+    if (!isDelta(delta)) {
+        return false;
+    }
+    int pos = Magic.size();
+    QByteArray line;
+    if (!readLine(delta, pos, &line) || !readLine(delta, pos, &line)) {
+        return false;
+    }
+    const QList<QByteArray> check = line.split(' ');
+    if (check.size() != 2) {
+        return false;
+    }
+    bool ok;
+    const int size = check.at(1).toInt(&ok);
+    if (!ok || size < 0) {
+        return false;
+    }
+    result->reserve(size);
+    while (pos < delta.size()) {
+        if (!readLine(delta, pos, &line)) {
+            return false;
+        }
+        const QList<QByteArray> op = line.split(' ');
+        if (op.size() == 3 && op.at(0) == "c") {
+            bool ok2;
+            const int offset = op.at(1).toInt(&ok);
+            const int length = op.at(2).toInt(&ok2);
+            if (!ok || !ok2 || offset < 0 || length < 0 || offset + length > base.size()) {
+                return false;
+            }
+            result->append(base.constData() + offset, length);
+        } else if (op.size() == 2 && op.at(0) == "i") {
+            const int length = op.at(1).toInt(&ok);
+            if (!ok || length < 0 || pos + length > delta.size()) {
+                return false;
+            }
+            result->append(delta.constData() + pos, length);
+            pos += length;
+        } else {
+            return false;
+        }
+    }
+    return result->size() == size && QCryptographicHash::hash(*result, QCryptographicHash::Md5).toHex() == check.at(0);
+}
+
+QString BackupDelta::deltaPath(const QString &backupFile)
+{
+    QString path = backupFile;
+    if (path.endsWith(ProjectExtension)) {
+        path.chop(ProjectExtension.size());
+    }
+    return path + DeltaExtension;
+}
+
+QString BackupDelta::save(const QByteArray &project, const QString &checkpoint, const QString &backupFile)
+{
+    if (!checkpoint.isEmpty()) {
+        QFile base(checkpoint);
+        if (base.open(QIODevice::ReadOnly)) {
+            const QByteArray delta = create(base.readAll(), project, QFileInfo(checkpoint).fileName());
+            // Keep a full backup once the changes become too large
+            if (delta.size() <= project.size() / 2) {
+                const QString path = deltaPath(backupFile);
+                return writeFile(path, delta) ? path : QString();
+            }
+        }
+    }
+    return writeFile(backupFile, project) ? backupFile : QString();
+}
+
+QString BackupDelta::checkpointFor(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.readLine() != Magic) {
+        return QString();
+    }
+    return QString::fromUtf8(file.readLine()).trimmed();
+}
+
+bool BackupDelta::setCheckpoint(const QString &path, const QString &baseName)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray delta = file.readAll();
+    file.close();
+    int pos = Magic.size();
+    QByteArray line;
+    if (!isDelta(delta) || !readLine(delta, pos, &line)) {
+        return false;
+    }
+    QByteArray updated = Magic;
+    updated.append(baseName.toUtf8() + '\n');
+    updated.append(delta.constData() + pos, delta.size() - pos);
+    return writeFile(path, updated);
+}
+
+QString BackupDelta::restore(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    const QByteArray delta = file.readAll();
+    if (!isDelta(delta)) {
+        return path;
+    }
+    const QFileInfo info(path);
+    QFile baseFile(info.dir().absoluteFilePath(baseName(delta)));
+    if (!baseFile.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    QByteArray project;
+    if (!apply(baseFile.readAll(), delta, &project)) {
+        return QString();
+    }
+    const QString restored = QDir::temp().absoluteFilePath(info.completeBaseName() + ProjectExtension);
+    if (!writeFile(restored, project)) {
+        return QString();
+    }
+    // The subtitles are stored next to the backup
+    const QString subtitles = path + QStringLiteral(".srt");
+    if (QFile::exists(subtitles)) {
+        QFile::remove(restored + QStringLiteral(".srt"));
+        QFile::copy(subtitles, restored + QStringLiteral(".srt"));
+    }
+    return restored;
+}
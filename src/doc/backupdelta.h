@@ -0,0 +1,52 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+/**
+  Line based delta between two versions of a project file, used to keep
+  the project backups small.
+
+  A delta starts with a header line, the file name of the full backup it
+  was computed against (the checkpoint, stored in the same folder) and the
+  md5 of the resulting file. It is followed by a list of operations:
+  "c offset length" copies a byte range of the checkpoint, "i length"
+  inserts the following raw bytes.
+
+  Deltas are not valid project files, they are stored with the
+  .kdenlivedelta extension while the checkpoints keep the .kdenlive
+  extension and can be opened directly.
+  */
+class BackupDelta
+{
+public:
+    /** @brief Returns the delta transforming @p base into @p target, @p baseName being the file name of @p base */
+    static QByteArray create(const QByteArray &base, const QByteArray &target, const QString &baseName);
+    /** @brief Returns true if @p data is a delta rather than a project file */
+    static bool isDelta(const QByteArray &data);
+    /** @brief Returns the file name of the checkpoint @p delta was computed against */
+    static QString baseName(const QByteArray &delta);
+    /** @brief Rebuild the target of @p delta in @p result. Returns false if @p delta does not apply to @p base */
+    static bool apply(const QByteArray &base, const QByteArray &delta, QByteArray *result);
+
+    /** @brief Returns the path of the delta for the backup @p backupFile, replacing its .kdenlive extension */
+    static QString deltaPath(const QString &backupFile);
+    /** @brief Store @p project as a backup: a delta against the full backup @p checkpoint next to @p backupFile if it is
+     *  small enough, @p project itself in @p backupFile otherwise. Returns the path written, or an empty string on failure. */
+    static QString save(const QByteArray &project, const QString &checkpoint, const QString &backupFile);
+
+    /** @brief Returns the checkpoint referenced by the backup file at @p path, or an empty string if it is a full backup */
+    static QString checkpointFor(const QString &path);
+    /** @brief Make the delta stored at @p path reference the checkpoint @p baseName, after the checkpoint was renamed */
+    static bool setCheckpoint(const QString &path, const QString &baseName);
+    /** @brief Returns a path to the full project stored in the backup file at @p path, rebuilding it in the temporary folder
+     *  if it is a delta. Returns an empty string if the delta cannot be applied. */
+    static QString restore(const QString &path);
+};
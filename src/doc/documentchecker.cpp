@@ -10,6 +10,7 @@
 #include "effects/effectsrepository.hpp"
 #include "kdenlivesettings.h"
 #include "kthumb.h"
+#include "mediasearchindex.h"
 #include "titler/titlewidget.h"
 #include "transitions/transitionsrepository.hpp"
 
@@ -19,12 +20,14 @@
 #include <KUrlRequesterDialog>
 
 #include "kdenlive_debug.h"
-#include <QCryptographicHash>
+#include <QEventLoop>
 #include <QFile>
 #include <QFileDialog>
 #include <QFontDatabase>
+#include <QFutureWatcher>
 #include <QStandardPaths>
 #include <QTreeWidgetItem>
+#include <QtConcurrent>
 #include <kurlrequester.h>
 #include <utility>
 
@@ -945,14 +948,96 @@ void DocumentChecker::slotCheckClips()
     }
 }
 
+bool DocumentChecker::buildSearchIndex(const QString &newpath, const QList<qint64> &sizes)
+{
+    const QString root = QDir(newpath).absolutePath();
+    // Searching the same folder again reuses its index, unless its content changed since
+    std::shared_ptr<MediaSearchIndex> previous = m_searchIndex && m_searchIndex->root() == root ? m_searchIndex : nullptr;
+    std::shared_ptr<MediaSearchIndex> index = std::make_shared<MediaSearchIndex>(root);
+    if (!previous) {
+        Q_EMIT showScanning(i18n("Scanning %1", root));
+    }
+    // Walk the folders and hash the files having the size of a missing clip in worker threads, keeping the dialog responsive
+    QFuture<bool> future = QtConcurrent::run([this, &index, previous, root, sizes]() {
+        if (previous && !previous->isStale()) {
+            index = previous;
+        } else {
+            if (previous) {
+                Q_EMIT showScanning(i18n("Scanning %1", root));
+            }
+            if (!index->build(m_abortSearch)) {
+                return false;
+            }
+        }
+        index->prefetchHashes(sizes);
+        return !m_abortSearch;
+    });
+    QFutureWatcher<bool> watcher;
+    QEventLoop loop;
+    connect(&watcher, &QFutureWatcher<bool>::finished, &loop, &QEventLoop::quit);
+    watcher.setFuture(future);
+    if (!watcher.isFinished()) {
+        loop.exec();
+    }
+    if (!future.result()) {
+        return false;
+    }
+    m_searchIndex = index;
+    return true;
+}
+
+QString DocumentChecker::searchFile(const QString &matchSize, const QString &matchHash, const QString &fileName) const
+{
+    if (matchSize.isEmpty() && matchHash.isEmpty()) {
+        return m_searchIndex->findByName(QUrl::fromLocalFile(fileName).fileName());
+    }
+    return m_searchIndex->findFile(matchSize.toLongLong(), matchHash);
+}
+
+QString DocumentChecker::searchFolder(const QString &matchHash, const QString &fullName)
+{
+    const QString fileName = QFileInfo(fullName).fileName();
+    for (const QString &folder : m_searchIndex->folders()) {
+        qApp->processEvents();
+        if (m_abortSearch) {
+            return QString();
+        }
+        const QDir dir(folder);
+        if (ProjectClip::getFolderHash(dir, fileName).toHex() == matchHash) {
+            return dir.absoluteFilePath(fileName);
+        }
+    }
+    return QString();
+}
+
 void DocumentChecker::slotSearchClips(const QString &newpath)
 {
     int ix = 0;
     bool fixed = false;
-    QTreeWidgetItem *child = m_ui.treeWidget->topLevelItem(ix);
-    QDir searchDir(newpath);
     QDomNodeList producers = m_doc.elementsByTagName(QStringLiteral("producer"));
     QDomNodeList chains = m_doc.elementsByTagName(QStringLiteral("chain"));
+    // Collect the sizes of the missing clips, so that all candidates are hashed in one go
+    QList<qint64> sizes;
+    for (int i = 0; i < m_ui.treeWidget->topLevelItemCount(); ++i) {
+        QTreeWidgetItem *item = m_ui.treeWidget->topLevelItem(i);
+        const int status = item->data(0, statusRole).toInt();
+        auto addSize = [&sizes](QTreeWidgetItem *clipItem) {
+            bool ok;
+            const qint64 size = clipItem->data(0, sizeRole).toString().toLongLong(&ok);
+            if (ok) {
+                sizes << size;
+            }
+        };
+        if (status == SOURCEMISSING) {
+            for (int j = 0; j < item->childCount(); ++j) {
+                addSize(item->child(j));
+            }
+        } else if (status == CLIPMISSING && ClipType::ProducerType(item->data(0, clipTypeRole).toInt()) != ClipType::SlideShow) {
+            addSize(item);
+        }
+    }
+    bool indexed = buildSearchIndex(newpath, sizes);
+    QTreeWidgetItem *child = indexed ? m_ui.treeWidget->topLevelItem(ix) : nullptr;
     while (child != nullptr) {
         if (m_abortSearch) {
             break;
@@ -961,8 +1046,7 @@ void DocumentChecker::slotSearchClips(const QString &newpath)
         if (child->data(0, statusRole).toInt() == SOURCEMISSING) {
             for (int j = 0; j < child->childCount(); ++j) {
                 QTreeWidgetItem *subchild = child->child(j);
-                QString clipPath =
-                    searchFileRecursively(searchDir, subchild->data(0, sizeRole).toString(), subchild->data(0, hashRole).toString(), subchild->text(1));
+                QString clipPath = searchFile(subchild->data(0, sizeRole).toString(), subchild->data(0, hashRole).toString(), subchild->text(1));
                 if (!clipPath.isEmpty()) {
                     fixed = true;
                     subchild->setText(1, clipPath);
@@ -980,12 +1064,12 @@ void DocumentChecker::slotSearchClips(const QString &newpath)
             QString clipPath;
             if (type != ClipType::SlideShow) {
                 // Slideshows cannot be found with hash / size
-                clipPath = searchFileRecursively(searchDir, child->data(0, sizeRole).toString(), child->data(0, hashRole).toString(), child->text(1));
+                clipPath = searchFile(child->data(0, sizeRole).toString(), child->data(0, hashRole).toString(), child->text(1));
             } else {
-                clipPath = searchDirRecursively(searchDir, child->data(0, hashRole).toString(), child->text(1));
+                clipPath = searchFolder(child->data(0, hashRole).toString(), child->text(1));
             }
             if (clipPath.isEmpty() && type != ClipType::SlideShow) {
-                clipPath = searchPathRecursively(searchDir, QUrl::fromLocalFile(child->text(1)).fileName(), type);
+                clipPath = m_searchIndex->findByName(QUrl::fromLocalFile(child->text(1)).fileName());
                 perfectMatch = false;
             }
             if (!clipPath.isEmpty()) {
@@ -996,7 +1080,7 @@ void DocumentChecker::slotSearchClips(const QString &newpath)
                 child->setData(0, statusRole, CLIPOK);
             }
         } else if (child->data(0, statusRole).toInt() == LUMAMISSING) {
-            QString fileName = searchLuma(searchDir, child->data(0, idRole).toString());
+            QString fileName = searchLuma(*m_searchIndex.get(), child->data(0, idRole).toString());
             if (!fileName.isEmpty()) {
                 fixed = true;
                 child->setText(1, fileName);
@@ -1005,7 +1089,7 @@ void DocumentChecker::slotSearchClips(const QString &newpath)
                 child->setToolTip(0, i18n("Recovered item"));
             }
         } else if (child->data(0, statusRole).toInt() == ASSETMISSING) {
-            QString fileName = searchPathRecursively(searchDir, QFileInfo(child->data(0, idRole).toString()).fileName());
+            QString fileName = m_searchIndex->findByName(QFileInfo(child->data(0, idRole).toString()).fileName());
             if (!fileName.isEmpty()) {
                 fixed = true;
                 child->setText(1, fileName);
@@ -1016,7 +1100,7 @@ void DocumentChecker::slotSearchClips(const QString &newpath)
         } else if (child->data(0, typeRole).toInt() == TITLE_IMAGE_ELEMENT && child->data(0, statusRole).toInt() == CLIPPLACEHOLDER) {
             // Search missing title images
             QString missingFileName = QUrl::fromLocalFile(child->text(1)).fileName();
-            QString newPath = searchPathRecursively(searchDir, missingFileName);
+            QString newPath = m_searchIndex->findByName(missingFileName);
             if (!newPath.isEmpty()) {
                 // File found
                 fixed = true;
@@ -1091,149 +1175,11 @@ QString DocumentChecker::fixLuma(const QString &file)
     return QString();
 }
 
-QString DocumentChecker::searchLuma(const QDir &dir, const QString &file)
+QString DocumentChecker::searchLuma(const MediaSearchIndex &index, const QString &file)
 {
     // Try in user's chosen folder
     QString result = fixLuma(file);
-    return result.isEmpty() ? searchPathRecursively(dir, QFileInfo(file).fileName()) : result;
-}
-
-QString DocumentChecker::searchPathRecursively(const QDir &dir, const QString &fileName, ClipType::ProducerType type)
-{
-    QString foundFileName;
-    bool patternSlideshow = true;
-    QDir searchDir(dir);
-    QStringList filesAndDirs;
-    qApp->processEvents();
-    if (m_abortSearch) {
-        return QString();
-    }
-    if (type == ClipType::SlideShow) {
-        if (fileName.contains(QLatin1Char('%'))) {
-            searchDir.setNameFilters({fileName.section(QLatin1Char('%'), 0, -2) + QLatin1Char('*')});
-            filesAndDirs = searchDir.entryList(QDir::Files | QDir::Readable);
-
-        } else {
-            patternSlideshow = false;
-            QString slideDirName = QFileInfo(fileName).dir().dirName();
-            searchDir.setNameFilters({slideDirName});
-            filesAndDirs = searchDir.entryList(QDir::Dirs | QDir::Readable);
-        }
-    } else {
-        searchDir.setNameFilters({fileName});
-        filesAndDirs = searchDir.entryList(QDir::Files | QDir::Readable);
-    }
-    if (!filesAndDirs.isEmpty()) {
-        // File Found
-        if (type == ClipType::SlideShow) {
-            if (patternSlideshow) {
-                return searchDir.absoluteFilePath(fileName);
-            } else {
-                // mime type slideshow
-                searchDir.cd(filesAndDirs.first());
-                return searchDir.absoluteFilePath(QFileInfo(fileName).fileName());
-            }
-        } else {
-            return searchDir.absoluteFilePath(filesAndDirs.first());
-        }
-    }
-    searchDir.setNameFilters(QStringList());
-    filesAndDirs = searchDir.entryList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        foundFileName = searchPathRecursively(searchDir.absoluteFilePath(filesAndDirs.at(i)), fileName, type);
-        if (!foundFileName.isEmpty()) {
-            break;
-        }
-    }
-    return foundFileName;
-}
-
-QString DocumentChecker::searchDirRecursively(const QDir &dir, const QString &matchHash, const QString &fullName)
-{
-    qApp->processEvents();
-    if (m_abortSearch) {
-        return QString();
-    }
-    Q_EMIT showScanning(i18n("Scanning %1", dir.absolutePath()));
-    QString fileName = QFileInfo(fullName).fileName();
-    // Check main dir
-    QString fileHash = ProjectClip::getFolderHash(dir, fileName).toHex();
-    if (fileHash == matchHash) {
-        return dir.absoluteFilePath(fileName);
-    }
-    // Search subfolders
-    const QStringList subDirs = dir.entryList(QDir::AllDirs | QDir::NoDot | QDir::NoDotDot);
-    for (const QString &sub : subDirs) {
-        QDir subFolder(dir.absoluteFilePath(sub));
-        fileHash = ProjectClip::getFolderHash(subFolder, fileName).toHex();
-        if (fileHash == matchHash) {
-            return subFolder.absoluteFilePath(fileName);
-        }
-    }
-    if (m_abortSearch) {
-        return QString();
-    }
-    // Search inside subfolders
-    for (const QString &sub : subDirs) {
-        QDir subFolder(dir.absoluteFilePath(sub));
-        const QStringList subSubDirs = subFolder.entryList(QDir::AllDirs | QDir::NoDot | QDir::NoDotDot);
-        for (const QString &subsub : subSubDirs) {
-            QDir subDir(subFolder.absoluteFilePath(subsub));
-            QString result = searchDirRecursively(subDir, matchHash, fullName);
-            if (!result.isEmpty()) {
-                return result;
-            }
-        }
-    }
-    return QString();
-}
-
-QString DocumentChecker::searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash, const QString &fileName)
-{
-    if (matchSize.isEmpty() && matchHash.isEmpty()) {
-        return searchPathRecursively(dir, QUrl::fromLocalFile(fileName).fileName());
-    }
-    QString foundFileName;
-    QByteArray fileData;
-    QByteArray fileHash;
-    QStringList filesAndDirs = dir.entryList(QDir::Files | QDir::Readable);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        qApp->processEvents();
-        if (m_abortSearch) {
-            return QString();
-        }
-        QFile file(dir.absoluteFilePath(filesAndDirs.at(i)));
-        if (QString::number(file.size()) == matchSize) {
-            if (file.open(QIODevice::ReadOnly)) {
-                /*
-                 * 1 MB = 1 second per 450 files (or faster)
-                 * 10 MB = 9 seconds per 450 files (or faster)
-                 */
-                if (file.size() > 1000000 * 2) {
-                    fileData = file.read(1000000);
-                    if (file.seek(file.size() - 1000000)) {
-                        fileData.append(file.readAll());
-                    }
-                } else {
-                    fileData = file.readAll();
-                }
-                file.close();
-                fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-                if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
-                    return file.fileName();
-                }
-            }
-        }
-        ////qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << file.size() << fileHash.toHex();
-    }
-    filesAndDirs = dir.entryList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        foundFileName = searchFileRecursively(dir.absoluteFilePath(filesAndDirs.at(i)), matchSize, matchHash, fileName);
-        if (!foundFileName.isEmpty()) {
-            break;
-        }
-    }
-    return foundFileName;
+    return result.isEmpty() ? index.findByName(QFileInfo(file).fileName()) : result;
 }
 
 QString DocumentChecker::ensureAbsoultePath(const QString &root, QString filepath)
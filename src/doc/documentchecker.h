@@ -12,6 +12,10 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QDir>
 #include <QDomElement>
 #include <QUrl>
+#include <atomic>
+#include <memory>
+
+class MediaSearchIndex;
 
 class DocumentChecker : public QObject
 {
@@ -29,7 +33,7 @@ public:
      */
     bool hasErrorInClips();
     QString fixLuma(const QString &file);
-    QString searchLuma(const QDir &dir, const QString &file);
+    QString searchLuma(const MediaSearchIndex &index, const QString &file);
 
 private Q_SLOTS:
     void acceptDialog();
@@ -49,9 +53,14 @@ private:
     Ui::MissingClips_UI m_ui;
     QDialog *m_dialog;
     QPair<QString, QString> m_rootReplacement;
-    QString searchPathRecursively(const QDir &dir, const QString &fileName, ClipType::ProducerType type = ClipType::Unknown);
-    QString searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash, const QString &fileName);
-    QString searchDirRecursively(const QDir &dir, const QString &matchHash, const QString &fullName);
+    /** @brief Index of the last searched folder, reused when searching it again */
+    std::shared_ptr<MediaSearchIndex> m_searchIndex;
+    /** @brief Index the files below @p newpath and hash the ones having one of the @p sizes. Returns false if aborted */
+    bool buildSearchIndex(const QString &newpath, const QList<qint64> &sizes);
+    /** @brief Find a file by size and hash, or by name if they are unknown */
+    QString searchFile(const QString &matchSize, const QString &matchHash, const QString &fileName) const;
+    /** @brief Find the slideshow folder whose hash is @p matchHash */
+    QString searchFolder(const QString &matchHash, const QString &fullName);
     void checkStatus();
     QMap<QString, QString> m_missingTitleImages;
     QMap<QString, QString> m_missingTitleFonts;
@@ -72,7 +81,7 @@ private:
     QList<QDomElement> m_missingProxies;
     // List clips who have a working proxy but no source clip
     QList<QDomElement> m_missingSources;
-    bool m_abortSearch;
+    std::atomic<bool> m_abortSearch;
     bool m_checkRunning;
 
     static QString ensureAbsoultePath(const QString &root, QString filepath);
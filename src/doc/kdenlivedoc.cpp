@@ -15,6 +15,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "bin/model/subtitlemodel.hpp"
 #include "bin/projectclip.h"
 #include "bin/projectitemmodel.h"
+#include "backupdelta.h"
 #include "core.h"
 #include "dialogs/profilesdialog.h"
 #include "documentchecker.h"
@@ -28,6 +29,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "profiles/profilerepository.hpp"
 #include "timeline2/model/timelineitemmodel.hpp"
 #include "titler/titlewidget.h"
+#include "utils/filehashcache.h"
 #include "transitions/transitionsrepository.hpp"
 #include <config-kdenlive.h>
 
@@ -47,8 +49,10 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QFileDialog>
 #include <QSaveFile>
 #include <QStandardPaths>
+#include <QTextStream>
 #include <QUndoGroup>
 #include <QUndoStack>
+#include <QtConcurrent>
 #include <memory>
 #include <mlt++/Mlt.h>
 
@@ -320,6 +324,7 @@ KdenliveDoc::~KdenliveDoc()
     m_commandStack->clear();
     m_timelines.clear();
     // qCDebug(KDENLIVE_LOG) << "// DEL CLP MAN done";
+    waitForAutoSave();
     if (m_autosave) {
         if (!m_autosave->fileName().isEmpty()) {
             m_autosave->remove();
@@ -554,28 +559,73 @@ bool KdenliveDoc::autoGenerateImageProxy(int width) const
            (width < 0 || width > m_documentProperties.value(QStringLiteral("proxyimageminsize")).toInt());
 }
 
-void KdenliveDoc::slotAutoSave(const QString &scene)
+void KdenliveDoc::slotAutoSave(const QString &scene, const QMap<QString, QString> &replacements)
 {
-    if (m_autosave != nullptr) {
+    if (m_autosave == nullptr) {
+        return;
+    }
+    if (scene.isEmpty()) {
+        // Make sure we don't save if scenelist is corrupted
+        KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1, scene list is corrupted.", m_autosave->fileName()));
+        return;
+    }
+    QMutexLocker lock(&m_autoSaveMutex);
+    m_pendingAutoSave = scene;
+    m_pendingReplacements = replacements;
+    if (!m_autoSaveRunning) {
+        m_autoSaveRunning = true;
+        m_autoSaveJob = QtConcurrent::run([this]() { writeAutoSave(); });
+    }
+}
+
+void KdenliveDoc::writeAutoSave()
+{
+    // m_autosave is only opened, replaced or deleted by the GUI after waitForAutoSave(), so this thread owns it
+    const QString fileName = m_autosave->fileName();
+    auto showError = [this](const QString &message) {
+        QMetaObject::invokeMethod(this, [message]() { pCore->displayMessage(message, ErrorMessage); }, Qt::QueuedConnection);
+    };
+    while (true) {
+        QString scene;
+        QMap<QString, QString> replacements;
+        {
+            QMutexLocker lock(&m_autoSaveMutex);
+            if (m_pendingAutoSave.isEmpty()) {
+                m_autoSaveRunning = false;
+                return;
+            }
+            scene.swap(m_pendingAutoSave);
+            replacements.swap(m_pendingReplacements);
+        }
         if (!m_autosave->isOpen() && !m_autosave->open(QIODevice::ReadWrite)) {
-            // show error: could not open the autosave file
             qCDebug(KDENLIVE_LOG) << "ERROR; CANNOT CREATE AUTOSAVE FILE";
-            pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
-            return;
+            showError(i18n("Cannot create autosave file %1", fileName));
+            continue;
         }
-        if (scene.isEmpty()) {
-            // Make sure we don't save if scenelist is corrupted
-            KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1, scene list is corrupted.", m_autosave->fileName()));
-            return;
+        QMapIterator<QString, QString> i(replacements);
+        while (i.hasNext()) {
+            i.next();
+            scene.replace(i.key(), i.value());
+        }
+        if (!scene.contains(QLatin1String("<track "))) {
+            // In some unexplained cases, the MLT playlist is corrupted and all tracks are deleted. Don't save in that case.
+            showError(i18n("Project was corrupted, cannot backup. Please close and reopen your project file to recover last backup"));
+            continue;
         }
+        const QByteArray data = scene.toUtf8();
         m_autosave->resize(0);
-        if (m_autosave->write(scene.toUtf8()) < 0) {
-            pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
+        if (m_autosave->write(data) < 0) {
+            showError(i18n("Cannot create autosave file %1", fileName));
         }
         m_autosave->flush();
     }
 }
 
+void KdenliveDoc::waitForAutoSave()
+{
+    m_autoSaveJob.waitForFinished();
+}
+
 void KdenliveDoc::setZoom(const QUuid &uuid, int horizontal, int vertical)
 {
     setSequenceProperty(uuid, QStringLiteral("zoom"), horizontal);
@@ -746,9 +796,13 @@ bool KdenliveDoc::saveSceneList(const QString &path, const QString &scene)
         return false;
     }
 
-    const QByteArray sceneData = sceneList.toString().toUtf8();
-
-    file.write(sceneData);
+    // Stream the document to the file instead of building the whole string in memory
+    QTextStream out(&file);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    out.setCodec("UTF-8");
+#endif
+    sceneList.save(out, 1);
+    out.flush();
     if (!file.commit()) {
         KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1", path));
         return false;
@@ -1046,34 +1100,22 @@ const QString KdenliveDoc::description(const QString suffix) const
 QString KdenliveDoc::searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash) const
 {
     QString foundFileName;
-    QByteArray fileData;
-    QByteArray fileHash;
     QStringList filesAndDirs = dir.entryList(QDir::Files | QDir::Readable);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        QFile file(dir.absoluteFilePath(filesAndDirs.at(i)));
-        if (file.open(QIODevice::ReadOnly)) {
-            if (QString::number(file.size()) == matchSize) {
-                /*
-                 * 1 MB = 1 second per 450 files (or faster)
-                 * 10 MB = 9 seconds per 450 files (or faster)
-                 */
-                if (file.size() > 1000000 * 2) {
-                    fileData = file.read(1000000);
-                    if (file.seek(file.size() - 1000000)) {
-                        fileData.append(file.readAll());
-                    }
-                } else {
-                    fileData = file.readAll();
-                }
-                file.close();
-                fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-                if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
-                    return file.fileName();
-                }
-                qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << "size match but not hash";
+    QStringList candidates;
+    for (const QString &fileName : qAsConst(filesAndDirs)) {
+        const QString path = dir.absoluteFilePath(fileName);
+        if (QString::number(QFileInfo(path).size()) == matchSize) {
+            candidates << path;
+        }
+    }
+    if (!candidates.isEmpty()) {
+        const auto hashes = FileHashCache::get()->hashFiles(candidates);
+        for (const QString &path : qAsConst(candidates)) {
+            if (QString::fromLatin1(hashes.value(path).first.toHex()) == matchHash) {
+                return path;
             }
+            qCDebug(KDENLIVE_LOG) << path << "size match but not hash";
         }
-        ////qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << file.size() << fileHash.toHex();
     }
     filesAndDirs = dir.entryList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot);
     for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
@@ -1341,10 +1383,11 @@ void KdenliveDoc::backupLastSavedVersion(const QString &path)
     fileName.append(QStringLiteral(".kdenlive"));
     QString backupFile = backupFolder.absoluteFilePath(fileName);
     if (file.exists()) {
-        // delete previous backup if it was done less than 60 seconds ago
-        QFile::remove(backupFile);
-        if (!QFile::copy(path, backupFile)) {
+        const QString written = writeBackup(path, backupFile);
+        if (written.isEmpty()) {
             KMessageBox::information(QApplication::activeWindow(), i18n("Cannot create backup copy:\n%1", backupFile));
+        } else {
+            backupFile = written;
         }
         // backup subitle file in case we have one
         QString subpath(path + QStringLiteral(".srt"));
@@ -1358,22 +1401,80 @@ void KdenliveDoc::backupLastSavedVersion(const QString &path)
     }
 }
 
-void KdenliveDoc::cleanupBackupFiles()
+QString KdenliveDoc::writeBackup(const QString &path, const QString &backupFile)
 {
-    QDir backupFolder(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/.backup"));
-    QString projectFile = url().fileName().section(QLatin1Char('.'), 0, -2);
+    if (QFile::exists(backupFile)) {
+        const QFileInfo previous(backupFile);
+        // A full backup was done less than 60 seconds ago, move it aside for the backups depending on it
+        QStringList dependents;
+        const QFileInfoList backups = backupFiles(previous.dir(), path);
+        for (const QFileInfo &info : backups) {
+            if (BackupDelta::checkpointFor(info.absoluteFilePath()) == previous.fileName()) {
+                dependents << info.absoluteFilePath();
+            }
+        }
+        if (!dependents.isEmpty()) {
+            const QString renamed =
+                previous.dir().absoluteFilePath(QStringLiteral("%1-%2.checkpoint").arg(previous.completeBaseName()).arg(QDateTime::currentMSecsSinceEpoch()));
+            if (!QFile::rename(backupFile, renamed)) {
+                return QString();
+            }
+            for (const QString &dependent : qAsConst(dependents)) {
+                if (!BackupDelta::setCheckpoint(dependent, QFileInfo(renamed).fileName())) {
+                    return QString();
+                }
+            }
+        }
+    }
+    // delete previous backup if it was done less than 60 seconds ago
+    const QString deltaFile = BackupDelta::deltaPath(backupFile);
+    for (const QString &previous : {backupFile, deltaFile}) {
+        if (QFile::exists(previous) && !QFile::remove(previous)) {
+            return QString();
+        }
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    const QByteArray data = file.readAll();
+    file.close();
+    // Store a delta against the most recent full backup. Start a new full backup every hour so that
+    // each slot kept by cleanupBackupFiles() has a project that can be opened directly
+    QString checkpoint;
+    const QFileInfoList backups = backupFiles(QFileInfo(backupFile).dir(), path);
+    for (const QFileInfo &info : backups) {
+        if (info.fileName().endsWith(QStringLiteral(".kdenlive"))) {
+            if (info.lastModified().secsTo(QDateTime::currentDateTime()) < 3600) {
+                checkpoint = info.absoluteFilePath();
+            }
+            break;
+        }
+    }
+    return BackupDelta::save(data, checkpoint, backupFile);
+}
+
+QFileInfoList KdenliveDoc::backupFiles(QDir backupFolder, const QString &path) const
+{
+    QString projectFile = QUrl::fromLocalFile(path).fileName().section(QLatin1Char('.'), 0, -2);
     projectFile.append(QLatin1Char('-') + m_documentProperties.value(QStringLiteral("documentid")));
     projectFile.append(QStringLiteral("-??"));
     projectFile.append(QStringLiteral("??"));
     projectFile.append(QStringLiteral("-??"));
     projectFile.append(QStringLiteral("-??"));
     projectFile.append(QStringLiteral("-??"));
-    projectFile.append(QStringLiteral("-??.kdenlive"));
+    projectFile.append(QStringLiteral("-??"));
 
     QStringList filter;
-    filter << projectFile;
+    filter << projectFile + QStringLiteral(".kdenlive") << projectFile + QStringLiteral(".kdenlivedelta");
     backupFolder.setNameFilters(filter);
-    QFileInfoList resultList = backupFolder.entryInfoList(QDir::Files, QDir::Time);
+    return backupFolder.entryInfoList(QDir::Files, QDir::Time);
+}
+
+void KdenliveDoc::cleanupBackupFiles()
+{
+    QDir backupFolder(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/.backup"));
+    QFileInfoList resultList = backupFiles(backupFolder, url().toLocalFile());
 
     QDateTime d = QDateTime::currentDateTime();
     QStringList hourList;
@@ -1433,30 +1534,35 @@ void KdenliveDoc::cleanupBackupFiles()
         oldList.clear();
     }
 
-    QString f;
-    while (hourList.count() > 0) {
-        f = hourList.takeFirst();
-        QFile::remove(f);
-        QFile::remove(f + QStringLiteral(".png"));
-        QFile::remove(f + QStringLiteral(".srt"));
-    }
-    while (dayList.count() > 0) {
-        f = dayList.takeFirst();
-        QFile::remove(f);
-        QFile::remove(f + QStringLiteral(".png"));
-        QFile::remove(f + QStringLiteral(".srt"));
-    }
-    while (weekList.count() > 0) {
-        f = weekList.takeFirst();
-        QFile::remove(f);
-        QFile::remove(f + QStringLiteral(".png"));
-        QFile::remove(f + QStringLiteral(".srt"));
+    QStringList removeList = hourList + dayList + weekList + oldList;
+    // Keep the full backups still needed by the remaining deltas
+    QSet<QString> checkpoints;
+    for (const QFileInfo &info : qAsConst(resultList)) {
+        if (!removeList.contains(info.absoluteFilePath())) {
+            const QString checkpoint = BackupDelta::checkpointFor(info.absoluteFilePath());
+            if (!checkpoint.isEmpty()) {
+                checkpoints.insert(backupFolder.absoluteFilePath(checkpoint));
+            }
+        }
     }
-    while (oldList.count() > 0) {
-        f = oldList.takeFirst();
+    for (const QString &f : qAsConst(removeList)) {
+        if (checkpoints.contains(f)) {
+            continue;
+        }
         QFile::remove(f);
-        QFile::remove(f + QStringLiteral(".png"));
         QFile::remove(f + QStringLiteral(".srt"));
+        // The timeline preview is named after the project backup, also for deltas
+        const QString preview = f.endsWith(QStringLiteral(".kdenlivedelta")) ? f.chopped(5) : f;
+        QFile::remove(preview + QStringLiteral(".png"));
+    }
+    // Drop the checkpoints moved aside by writeBackup() once no backup uses them anymore
+    const QString projectFile = QUrl::fromLocalFile(url().toLocalFile()).fileName().section(QLatin1Char('.'), 0, -2);
+    const QString checkpointFilter = QStringLiteral("%1-%2-*.checkpoint").arg(projectFile, m_documentProperties.value(QStringLiteral("documentid")));
+    const QFileInfoList movedCheckpoints = backupFolder.entryInfoList({checkpointFilter}, QDir::Files);
+    for (const QFileInfo &info : movedCheckpoints) {
+        if (!checkpoints.contains(info.absoluteFilePath())) {
+            QFile::remove(info.absoluteFilePath());
+        }
     }
 }
 
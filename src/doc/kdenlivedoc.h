@@ -15,8 +15,10 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <KJob>
 #include <QAction>
 #include <QDir>
+#include <QFuture>
 #include <QList>
 #include <QMap>
+#include <QMutex>
 #include <QObject>
 #include <QUuid>
 #include <memory>
@@ -112,6 +114,8 @@ public:
     int height() const;
     QUrl url() const;
     KAutoSaveFile *m_autosave;
+    /** @brief Blocks until the autosave worker is done, must be called before touching m_autosave */
+    void waitForAutoSave();
     /** @brief Whether the project folder should be in the same folder as the project file (var is only used for new projects)*/
     bool m_sameProjectFolder;
     Timecode timecode() const;
@@ -357,6 +361,16 @@ private:
     QMap<QUuid, std::shared_ptr<TimelineItemModel>> m_timelines;
     QString searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash) const;
 
+    /** @brief Protects the pending autosave data shared with the worker */
+    QMutex m_autoSaveMutex;
+    /** @brief Scene waiting to be written by the autosave worker */
+    QString m_pendingAutoSave;
+    QMap<QString, QString> m_pendingReplacements;
+    bool m_autoSaveRunning{false};
+    QFuture<void> m_autoSaveJob;
+    /** @brief Writes the pending autosave scenes, runs in a worker thread and is the only user of m_autosave while running */
+    void writeAutoSave();
+
     /** @brief Creates a new project. */
     QDomDocument createEmptyDocument(const QList<TrackInfo> &tracks, bool disableProfile);
 
@@ -364,6 +378,11 @@ private:
     void updateProjectFolderPlacesEntry();
     /** @brief Only keep some backup files, delete some */
     void cleanupBackupFiles();
+    /** @brief Backup the project file at @p path to @p backupFile, or to a .kdenlivedelta file next to it when a delta against
+     *  the last full backup is possible. Returns the path written, or an empty string on failure. */
+    QString writeBackup(const QString &path, const QString &backupFile);
+    /** @brief Returns the backups of the project file @p path in @p backupFolder, most recent first. */
+    QFileInfoList backupFiles(QDir backupFolder, const QString &path) const;
     /** @brief Load document properties from the xml file */
     void loadDocumentProperties();
     /** @brief update document properties to reflect a change in the current profile */
@@ -386,8 +405,10 @@ public Q_SLOTS:
                               QUndoCommand *masterCommand = nullptr);
     /** @brief Saves the current project at the autosave location.
      *
-     * The autosave files are in ~/.kde/data/stalefiles/kdenlive/ */
-    void slotAutoSave(const QString &scene);
+     * The autosave files are in ~/.kde/data/stalefiles/kdenlive/ \n
+     * The file is opened and written from a worker thread, @p replacements are applied to the scene there.
+     * If a save is still running, only the latest scene is kept for the next write. */
+    void slotAutoSave(const QString &scene, const QMap<QString, QString> &replacements = QMap<QString, QString>());
     void switchProfile(ProfileParam* pf, const QString &clipName);
 
 private Q_SLOTS:
@@ -0,0 +1,160 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "mediasearchindex.h"
+#include "utils/filehashcache.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QtConcurrent>
+#include <algorithm>
+
+MediaSearchIndex::MediaSearchIndex(const QString &root)
+    : m_root(QDir(root).absolutePath())
+{
+}
+
+bool MediaSearchIndex::build(const std::atomic<bool> &abort)
+{
+    struct Listing
+    {
+        QString folder;
+        QDateTime modified;
+        QVector<File> files;
+        QStringList subFolders;
+        QStringList canonicalSubFolders;
+    };
+    m_files.clear();
+    m_bySize.clear();
+    m_byName.clear();
+    m_folders.clear();
+    m_folderTimes.clear();
+    // Symbolic links may point to a parent folder, only visit each folder once
+    QSet<QString> visited{QDir(m_root).canonicalPath()};
+    QStringList level{m_root};
+    while (!level.isEmpty()) {
+        if (abort) {
+            return false;
+        }
+        QVector<Listing> listings(level.size());
+        for (int i = 0; i < level.size(); ++i) {
+            listings[i].folder = level.at(i);
+        }
+        QtConcurrent::blockingMap(listings, [](Listing &listing) {
+            // Read before listing, so that a file added meanwhile makes the index stale
+            listing.modified = QFileInfo(listing.folder).lastModified();
+            const QDir dir(listing.folder);
+            const QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::Readable);
+            listing.files.reserve(files.size());
+            for (const QFileInfo &info : files) {
+                listing.files.append({info.absoluteFilePath(), info.fileName(), info.size()});
+            }
+            const QFileInfoList subFolders = dir.entryInfoList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot);
+            for (const QFileInfo &info : subFolders) {
+                listing.subFolders << info.absoluteFilePath();
+                listing.canonicalSubFolders << info.canonicalFilePath();
+            }
+        });
+        level.clear();
+        for (const Listing &listing : qAsConst(listings)) {
+            m_folders << listing.folder;
+            m_folderTimes << listing.modified;
+            for (const File &file : listing.files) {
+                m_bySize.insert(file.size, m_files.size());
+                m_byName.insert(file.name, m_files.size());
+                m_files.append(file);
+            }
+            for (int i = 0; i < listing.subFolders.size(); ++i) {
+                if (!visited.contains(listing.canonicalSubFolders.at(i))) {
+                    visited.insert(listing.canonicalSubFolders.at(i));
+                    level << listing.subFolders.at(i);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+const QString &MediaSearchIndex::root() const
+{
+    return m_root;
+}
+
+int MediaSearchIndex::fileCount() const
+{
+    return m_files.size();
+}
+
+bool MediaSearchIndex::isStale() const
+{
+    if (m_folders.isEmpty()) {
+        return true;
+    }
+    for (int i = 0; i < m_folders.size(); ++i) {
+        const QFileInfo info(m_folders.at(i));
+        if (!info.isDir() || info.lastModified() != m_folderTimes.at(i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int MediaSearchIndex::first(const QList<int> &candidates)
+{
+    if (candidates.isEmpty()) {
+        return -1;
+    }
+    return *std::min_element(candidates.cbegin(), candidates.cend());
+}
+
+void MediaSearchIndex::prefetchHashes(const QList<qint64> &sizes) const
+{
+    QStringList paths;
+    for (qint64 size : sizes) {
+        auto it = m_bySize.constFind(size);
+        while (it != m_bySize.constEnd() && it.key() == size) {
+            paths << m_files.at(it.value()).path;
+            ++it;
+        }
+    }
+    paths.removeDuplicates();
+    if (!paths.isEmpty()) {
+        FileHashCache::get()->hashFiles(paths);
+    }
+}
+
+QString MediaSearchIndex::findFile(qint64 size, const QString &hash) const
+{
+    QList<int> candidates = m_bySize.values(size);
+    if (candidates.isEmpty()) {
+        return QString();
+    }
+    std::sort(candidates.begin(), candidates.end());
+    QStringList paths;
+    for (int ix : qAsConst(candidates)) {
+        paths << m_files.at(ix).path;
+    }
+    const auto hashes = FileHashCache::get()->hashFiles(paths);
+    for (const QString &path : qAsConst(paths)) {
+        if (QString::fromLatin1(hashes.value(path).first.toHex()) == hash) {
+            return path;
+        }
+    }
+    return QString();
+}
+
+QString MediaSearchIndex::findByName(const QString &fileName) const
+{
+    const int ix = first(m_byName.values(fileName));
+    return ix < 0 ? QString() : m_files.at(ix).path;
+}
+
+const QStringList &MediaSearchIndex::folders() const
+{
+    return m_folders;
+}
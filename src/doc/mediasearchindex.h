@@ -0,0 +1,65 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QDateTime>
+#include <QMultiHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+
+/** @class MediaSearchIndex
+    @brief Index of all files below a folder, used to relocate missing clips.
+    The folder tree is walked once, listing the folders of each depth in parallel. Missing files are then
+    looked up by size and hash or by name without touching the disk again, except to hash
+    files having the requested size. Hashes go through FileHashCache, so they are only computed once.
+    When several files match, the one closest to the root folder is returned.
+    The modification time of each folder is recorded, so that an index reused for a later search can be
+    rebuilt when files were added, removed or renamed since.
+ */
+class MediaSearchIndex
+{
+public:
+    explicit MediaSearchIndex(const QString &root);
+
+    /** @brief Walk the folder tree. Returns false if @p abort was set before the walk finished. */
+    bool build(const std::atomic<bool> &abort);
+    const QString &root() const;
+    int fileCount() const;
+    /** @brief Returns true if a folder of the index was modified or removed since it was built */
+    bool isStale() const;
+
+    /** @brief Hash all files of the given @p sizes in parallel, so that later findFile() calls are cache lookups */
+    void prefetchHashes(const QList<qint64> &sizes) const;
+    /** @brief Returns a file of @p size whose hash is @p hash (hex encoded) */
+    QString findFile(qint64 size, const QString &hash) const;
+    /** @brief Returns a file named @p fileName */
+    QString findByName(const QString &fileName) const;
+    /** @brief All indexed folders, closest to the root first */
+    const QStringList &folders() const;
+
+private:
+    struct File
+    {
+        QString path;
+        QString name;
+        qint64 size;
+    };
+    QString m_root;
+    /** @brief Files in breadth first order, so a lower index means closer to the root */
+    QVector<File> m_files;
+    QMultiHash<qint64, int> m_bySize;
+    QMultiHash<QString, int> m_byName;
+    QStringList m_folders;
+    /** @brief Modification time of each folder of m_folders when it was listed */
+    QVector<QDateTime> m_folderTimes;
+
+    /** @brief Returns the candidate of @p candidates closest to the root */
+    static int first(const QList<int> &candidates);
+};
@@ -4,6 +4,7 @@
 */
 
 #include "effectsrepository.hpp"
+#include "assets/assetcache.h"
 #include "core.h"
 #include "kdenlivesettings.h"
 #include "profiles/profilemodel.hpp"
@@ -174,6 +175,16 @@ std::unique_ptr<EffectsRepository> &EffectsRepository::get()
     return instance;
 }
 
+void EffectsRepository::preloadCache()
+{
+    AssetCache::preload(QStringLiteral("effects"));
+}
+
+QString EffectsRepository::assetCacheName() const
+{
+    return QStringLiteral("effects");
+}
+
 QStringList EffectsRepository::assetDirs() const
 {
     QStringList dirs = QStandardPaths::locateAll(QStandardPaths::AppDataLocation, QStringLiteral("effect-templates"), QStandardPaths::LocateDirectory);
@@ -253,7 +264,7 @@ QPair<QString, QString> EffectsRepository::reloadCustom(const QString &path)
 bool EffectsRepository::isGroup(const QString &assetId) const
 {
     if (m_assets.count(assetId) > 0) {
-        QDomElement xml = m_assets.at(assetId).xml;
+        QDomElement xml = assetXml(m_assets.at(assetId));
         if (xml.tagName() == QLatin1String("effectgroup")) {
             return true;
         }
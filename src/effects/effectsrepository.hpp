@@ -22,6 +22,8 @@ class EffectsRepository : public AbstractAssetsRepository<AssetListType::AssetTy
 public:
     /** @brief Returns the instance of the Singleton */
     static std::unique_ptr<EffectsRepository> &get();
+    /** @brief Start reading the startup cache in a worker thread, to be called before MLT is initialized */
+    static void preloadCache();
 
     /** @brief returns a fresh instance of the given effect */
     std::unique_ptr<Mlt::Filter> getEffect(const QString &effectId) const;
@@ -64,6 +66,8 @@ protected:
 
     QStringList assetDirs() const override;
 
+    QString assetCacheName() const override;
+
     void parseType(Mlt::Properties *metadata, Info &res) override;
 
     /** @brief Returns the metadata associated with the given asset*/
@@ -6,6 +6,8 @@
 */
 
 #include "audiolevelstask.h"
+#include "audio/audioLevels.h"
+#include "audio/audioPeakFile.h"
 #include "audio/audioStreamInfo.h"
 #include "bin/projectclip.h"
 #include "bin/projectitemmodel.h"
@@ -15,29 +17,159 @@
 #include <KMessageWidget>
 #include <QElapsedTimer>
 #include <QFile>
-#include <QImage>
+#include <QFileInfo>
 #include <QList>
+#include <QDataStream>
 #include <QMutex>
-#include <QRgb>
+#include <QSaveFile>
 #include <QString>
+#include <QThread>
 #include <QThreadPool>
 #include <QTime>
 #include <QVariantList>
+#include <atomic>
+#include <cstring>
+#include <vector>
 
 static QList<AudioLevelsTask *> tasksList;
 static QMutex tasksListMutex;
 
-static void deleteQVariantList(QVector<uint8_t> *list)
+namespace {
+// Do not split clips in ranges shorter than this number of frames
+constexpr int MinRangeFrames = 1500;
+// Maximum number of ranges of a clip decoded at the same time
+constexpr int MaxRanges = 4;
+// Interval between two checkpoints of a running extraction, in milliseconds
+constexpr int CheckpointInterval = 10000;
+constexpr quint32 CheckpointMagic = 0x4b4c5650; // "KLVP"
+constexpr quint32 CheckpointVersion = 2;
+
+/** @brief A range of frames extracted by one producer */
+struct LevelsRange
+{
+    int start = 0;
+    int end = 0;
+    /** @brief Number of frames of the range already extracted */
+    std::atomic<int> done{0};
+    std::atomic<uint> maxLevel{1};
+
+    bool isComplete() const { return done.load() >= end - start; }
+};
+
+/** @brief Number of frames extracted from the start of the clip without gap */
+qint64 contiguousFrames(const std::vector<LevelsRange> &ranges)
+{
+    qint64 frames = 0;
+    for (const LevelsRange &range : ranges) {
+        frames = range.start + range.done.load();
+        if (!range.isComplete()) {
+            break;
+        }
+    }
+    return frames;
+}
+
+/** @brief Identifies the media a checkpoint was extracted from, so that it is not resumed after the file changed */
+QString sourceIdentity(const QString &clipHash, const QString &resource)
+{
+    const QFileInfo info(resource);
+    return clipHash + QLatin1Char('-') + QString::number(info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0);
+}
+
+bool loadCheckpoint(const QString &path, const QString &source, int channels, int frames, std::vector<LevelsRange> &ranges, QVector<uint8_t> &levels)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 magic, version;
+    QString storedSource;
+    qint32 storedChannels, storedFrames, count;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != CheckpointMagic || version != CheckpointVersion) {
+        return false;
+    }
+    in >> storedSource >> storedChannels >> storedFrames >> count;
+    if (in.status() != QDataStream::Ok || storedSource != source || storedChannels != channels || storedFrames != frames || count <= 0 ||
+        count > MaxRanges) {
+        return false;
+    }
+    std::vector<LevelsRange> stored(size_t(count));
+    QVector<uint8_t> storedLevels(frames * channels, 0);
+    qint32 previousEnd = 0;
+    for (LevelsRange &range : stored) {
+        qint32 start, end, maxLevel;
+        QByteArray data;
+        in >> start >> end >> maxLevel >> data;
+        if (in.status() != QDataStream::Ok || start != previousEnd || end < start || end > frames || data.size() % channels != 0 ||
+            data.size() / channels > end - start) {
+            return false;
+        }
+        range.start = start;
+        range.end = end;
+        range.done = data.size() / channels;
+        range.maxLevel = uint(maxLevel);
+        memcpy(storedLevels.data() + qint64(start) * channels, data.constData(), size_t(data.size()));
+        previousEnd = end;
+    }
+    if (previousEnd != frames) {
+        return false;
+    }
+    levels = storedLevels;
+    ranges = std::move(stored);
+    return true;
+}
+
+void saveCheckpoint(const QString &path, const QString &source, int channels, int frames, const std::vector<LevelsRange> &ranges,
+                    const QVector<uint8_t> &levels)
 {
-    delete list;
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream out(&file);
+    out << CheckpointMagic << CheckpointVersion << source << qint32(channels) << qint32(frames) << qint32(ranges.size());
+    for (const LevelsRange &range : ranges) {
+        // Only the frames counted as done are written, the range may still be running
+        const int done = range.done.load();
+        out << qint32(range.start) << qint32(range.end) << qint32(range.maxLevel.load());
+        out << QByteArray::fromRawData(reinterpret_cast<const char *>(levels.constData() + qint64(range.start) * channels), done * channels);
+    }
+    file.commit();
 }
 
+/** @brief Create a producer giving the audio levels of @p stream */
+Mlt::Producer *createLevelsProducer(mlt_profile profile, const QString &service, const QString &resource, int stream)
+{
+    auto *aProd = new Mlt::Producer(profile, service.toUtf8().constData(), resource.toUtf8().constData());
+    if (!aProd->is_valid()) {
+        delete aProd;
+        return nullptr;
+    }
+    aProd->set("video_index", "-1");
+    aProd->set("audio_index", stream);
+    Mlt::Filter chans(profile, "audiochannels");
+    Mlt::Filter converter(profile, "audioconvert");
+    Mlt::Filter levels(profile, "audiolevel");
+    aProd->attach(chans);
+    aProd->attach(converter);
+    aProd->attach(levels);
+    return aProd;
+}
+} // namespace
+
 AudioLevelsTask::AudioLevelsTask(const ObjectId &owner, QObject *object)
     : AbstractTask(owner, AbstractTask::AUDIOTHUMBJOB, object)
 {
     m_description = i18n("Audio thumbs");
 }
 
+QString AudioLevelsTask::checkpointPath(const QString &cachePath)
+{
+    return cachePath + QStringLiteral(".part");
+}
+
 void AudioLevelsTask::start(const ObjectId &owner, QObject *object, bool force)
 {
     // See if there is already a task for this MLT service and resource.
@@ -102,29 +234,30 @@ void AudioLevelsTask::run()
         }
         // Generate one thumb per stream
         QString cachePath = binClip->getAudioThumbPath(stream);
-        QVector<uint8_t> mltLevels;
-        if (!m_isForce && QFile::exists(cachePath)) {
-            // Audio thumb already exists
-            QImage image(cachePath);
-            if (!m_isCanceled && !image.isNull()) {
-                // convert cached image
-                int n = image.width() * image.height();
-                for (int i = 0; n > 1 && i < n; i++) {
-                    QRgb p = image.pixel(i / channels, i % channels);
-                    mltLevels << qRed(p);
-                    mltLevels << qGreen(p);
-                    mltLevels << qBlue(p);
-                    mltLevels << qAlpha(p);
-                }
-                if (mltLevels.size() > 0) {
-                    QVector<uint8_t> *levelsCopy = new QVector<uint8_t>(mltLevels);
-                    producer->lock();
-                    QString key = QString("_kdenlive:audio%1").arg(stream);
-                    producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
-                    producer->unlock();
-                    continue;
+        if (!m_isForce) {
+            AudioLevelsPtr cachedLevels;
+            std::unique_ptr<AudioPeakFile> peaks(new AudioPeakFile());
+            if (peaks->open(cachePath) && peaks->channels() == channels) {
+                // Audio thumb already exists, use it in place
+                cachedLevels = AudioLevels::fromPeakFile(std::move(peaks));
+            } else {
+                // Convert the PNG thumbnail of older versions
+                const QString legacyPath = binClip->getAudioThumbPath(stream, true);
+                if (QFile::exists(legacyPath)) {
+                    QVector<uint8_t> legacyLevels = AudioPeakFile::readLegacyImage(legacyPath, channels);
+                    if (!legacyLevels.isEmpty()) {
+                        cachedLevels = AudioLevels::create(std::move(legacyLevels), channels);
+                        if (AudioPeakFile::write(cachePath, cachedLevels->constData(), cachedLevels->size(), channels, frequency, producer->get_fps(),
+                                                 cachedLevels->maxLevel())) {
+                            QFile::remove(legacyPath);
+                        }
+                    }
                 }
             }
+            if (!m_isCanceled && cachedLevels && !cachedLevels->isEmpty()) {
+                binClip->setAudioLevels(stream, cachedLevels, true);
+                continue;
+            }
         }
         QString service = producer->get("mlt_service");
         if (service == QLatin1String("avformat-novalidate")) {
@@ -133,110 +266,147 @@ void AudioLevelsTask::run()
             service = QStringLiteral("xml-nogl");
         }
         const QString res = qstrdup(producer->get("resource"));
-        Mlt::Producer *aProd = new Mlt::Producer(producer->get_profile(), service.toUtf8().constData(), res.toUtf8().constData());
-        if (!aProd->is_valid()) {
-            QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection, Q_ARG(QString, i18n("Audio thumbs: cannot open file %1", res)),
-                                      Q_ARG(int, int(KMessageWidget::Warning)));
-            delete aProd;
-            return;
+        mlt_profile profile = producer->get_profile();
+        double framesPerSecond = producer->get_fps();
+
+        // Resume an interrupted extraction, or split the clip in ranges decoded in parallel.
+        // Only files can be seeked cheaply, other producers are decoded in one range.
+        const QString partPath = checkpointPath(cachePath);
+        const QString source = sourceIdentity(binClip->hash(false), res);
+        QVector<uint8_t> levels;
+        std::vector<LevelsRange> ranges;
+        if (m_isForce || !loadCheckpoint(partPath, source, channels, lengthInFrames, ranges, levels)) {
+            int rangeCount = 1;
+            if (service == QLatin1String("avformat")) {
+                rangeCount = qBound(1, lengthInFrames / MinRangeFrames, qMin(MaxRanges, QThread::idealThreadCount()));
+            }
+            ranges = std::vector<LevelsRange>(size_t(rangeCount));
+            for (int i = 0; i < rangeCount; ++i) {
+                ranges[size_t(i)].start = int(qint64(lengthInFrames) * i / rangeCount);
+                ranges[size_t(i)].end = int(qint64(lengthInFrames) * (i + 1) / rangeCount);
+            }
+            levels = QVector<uint8_t>(lengthInFrames * channels, 0);
         }
-        aProd->set("video_index", "-1");
-        aProd->set("audio_index", stream);
-        Mlt::Filter chans(producer->get_profile(), "audiochannels");
-        Mlt::Filter converter(producer->get_profile(), "audioconvert");
-        Mlt::Filter levels(producer->get_profile(), "audiolevel");
-        aProd->attach(chans);
-        aProd->attach(converter);
-        aProd->attach(levels);
-        std::unique_ptr<Mlt::Producer> audioProducer;
-        audioProducer.reset(aProd);
-
-        double framesPerSecond = audioProducer->get_fps();
-        mlt_audio_format audioFormat = mlt_audio_s16;
-        QStringList keys;
-        keys.reserve(channels);
-        for (int i = 0; i < channels; i++) {
-            keys << "meta.media.audio_level." + QString::number(i);
+        // Each range writes its own part of the buffer, the pointer must not change while the ranges are running
+        uint8_t *data = levels.data();
+
+        auto extract = [&](LevelsRange &range) {
+            std::unique_ptr<Mlt::Producer> audioProducer(createLevelsProducer(profile, service, res, stream));
+            if (!audioProducer) {
+                return;
+            }
+            int z = range.start + range.done.load();
+            if (z > 0) {
+                audioProducer->seek(z);
+            }
+            mlt_audio_format audioFormat = mlt_audio_s16;
+            QList<QByteArray> keys;
+            keys.reserve(channels);
+            for (int i = 0; i < channels; i++) {
+                keys << QByteArray("meta.media.audio_level.") + QByteArray::number(i);
+            }
+            uint maxLevel = range.maxLevel.load();
+            uint8_t *out = data + qint64(z) * channels;
+            for (; z < range.end && !m_isCanceled; ++z, out += channels) {
+                QScopedPointer<Mlt::Frame> mltFrame(audioProducer->get_frame());
+                if ((mltFrame != nullptr) && mltFrame->is_valid() && (mltFrame->get_int("test_audio") == 0)) {
+                    // MLT writes the frame's values back, so each range needs its own copies
+                    int frameFrequency = frequency;
+                    int frameChannels = channels;
+                    int samples = mlt_audio_calculate_frame_samples(float(framesPerSecond), frameFrequency, z);
+                    mltFrame->get_audio(audioFormat, frameFrequency, frameChannels, samples);
+                    // Always fill the number of channels the buffer was sized for
+                    for (int channel = 0; channel < channels; ++channel) {
+                        uint lev = qMin(255u, uint(256 * qMin(mltFrame->get_double(keys.at(channel).constData()) * 0.9, 1.0)));
+                        out[channel] = uint8_t(lev);
+                        maxLevel = qMax(lev, maxLevel);
+                    }
+                } else if (z > range.start) {
+                    // Repeat the previous frame
+                    memcpy(out, out - channels, size_t(channels));
+                }
+                range.maxLevel.store(maxLevel);
+                range.done.store(z + 1 - range.start);
+            }
+        };
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(int(ranges.size()));
+        for (LevelsRange &range : ranges) {
+            if (!range.isComplete()) {
+                LevelsRange *r = &range;
+                pool.start([&extract, r]() { extract(*r); });
+            }
         }
-        uint maxLevel = 1;
         QElapsedTimer updateTime;
         updateTime.start();
-        for (int z = 0; z < lengthInFrames && !m_isCanceled; ++z) {
-            int val = int(100.0 * z / lengthInFrames);
+        QElapsedTimer checkpointTime;
+        checkpointTime.start();
+        qint64 publishedFrames = 0;
+        bool finished = false;
+        while (!finished) {
+            finished = pool.waitForDone(200);
+            qint64 doneFrames = 0;
+            for (const LevelsRange &range : ranges) {
+                doneFrames += range.done.load();
+            }
+            int val = int(100.0 * doneFrames / lengthInFrames);
             if (m_progress != val) {
                 m_progress = val;
                 QMetaObject::invokeMethod(m_object, "updateJobProgress");
             }
-            QScopedPointer<Mlt::Frame> mltFrame(audioProducer->get_frame());
-            if ((mltFrame != nullptr) && mltFrame->is_valid() && (mltFrame->get_int("test_audio") == 0)) {
-                int samples = mlt_audio_calculate_frame_samples(float(framesPerSecond), frequency, z);
-                mltFrame->get_audio(audioFormat, frequency, channels, samples);
-                for (int channel = 0; channel < channels; ++channel) {
-                    uint lev = 256 * qMin(mltFrame->get_double(keys.at(channel).toUtf8().constData()) * 0.9, 1.0);
-                    mltLevels << lev;
-                    // double lev = mltFrame->get_double(keys.at(channel).toUtf8().constData());
-                    // mltLevels << lev;
-                    maxLevel = qMax(lev, maxLevel);
-                }
-            } else if (!mltLevels.isEmpty()) {
-                for (int channel = 0; channel < channels; channel++) {
-                    mltLevels << mltLevels.last();
-                }
+            if (finished || m_isCanceled) {
+                continue;
             }
-            // Incrementally update the audio levels every 3 seconds.
-            if (updateTime.elapsed() > 3000 && !m_isCanceled) {
+            // Incrementally update the audio levels every 3 seconds, up to the first range still running.
+            // The published levels are a snapshot, readers never see the buffer being filled.
+            if (updateTime.elapsed() > 3000) {
                 updateTime.restart();
-                QVector<uint8_t> *levelsCopy = new QVector<uint8_t>(mltLevels);
-                producer->lock();
-                QString key = QString("_kdenlive:audio%1").arg(stream);
-                producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
-                producer->unlock();
-                QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
+                const qint64 frames = contiguousFrames(ranges);
+                if (frames > publishedFrames) {
+                    publishedFrames = frames;
+                    QVector<uint8_t> snapshot(int(frames * channels));
+                    memcpy(snapshot.data(), data, size_t(snapshot.size()));
+                    binClip->setAudioLevels(stream, AudioLevels::create(std::move(snapshot), channels), false);
+                    QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
+                }
+            }
+            if (checkpointTime.elapsed() > CheckpointInterval) {
+                checkpointTime.restart();
+                saveCheckpoint(partPath, source, channels, lengthInFrames, ranges, levels);
             }
         }
 
-        /*// Normalize
-        for (double &v : mltLevels) {
-            m_audioLevels << uchar(255 * v / maxLevel);
-        }*/
         if (m_isCanceled) {
-            mltLevels.clear();
+            // Keep what was done for the next run
+            saveCheckpoint(partPath, source, channels, lengthInFrames, ranges, levels);
             m_progress = 100;
             QMetaObject::invokeMethod(m_object, "updateJobProgress");
+            continue;
         }
-        if (mltLevels.size() > 0) {
-            QVector<uint8_t> *levelsCopy = new QVector<uint8_t>(mltLevels);
-            producer->lock();
-            QString key = QString("_kdenlive:audio%1").arg(stream);
-            QString key2 = QString("kdenlive:audio_max%1").arg(stream);
-            producer->set(key2.toUtf8().constData(), int(maxLevel));
-            producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
-            producer->unlock();
-            // qDebug()<<"=== FINISHED PRODUCING AUDIO FOR: "<<key<<", SIZE: "<<levelsCopy->size();
-            m_progress = 100;
-            QMetaObject::invokeMethod(m_object, "updateJobProgress");
-            // Put into an image for caching.
-            int count = mltLevels.size();
-            QImage image((count + 3) / 4 / channels, channels, QImage::Format_ARGB32);
-            int n = image.width() * image.height();
-            for (int i = 0; i < n; i++) {
-                QRgb p;
-                if ((4 * i + 3) < count) {
-                    p = qRgba(mltLevels.at(4 * i), mltLevels.at(4 * i + 1), mltLevels.at(4 * i + 2), mltLevels.at(4 * i + 3));
-                } else {
-                    int last = mltLevels.last();
-                    int r = (4 * i + 0) < count ? mltLevels.at(4 * i + 0) : last;
-                    int g = (4 * i + 1) < count ? mltLevels.at(4 * i + 1) : last;
-                    int b = (4 * i + 2) < count ? mltLevels.at(4 * i + 2) : last;
-                    int a = last;
-                    p = qRgba(r, g, b, a);
-                }
-                image.setPixel(i / channels, i % channels, p);
-            }
-            image.save(cachePath);
-            audioCreated = true;
-            QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
+        uint maxLevel = 1;
+        bool complete = true;
+        for (const LevelsRange &range : ranges) {
+            complete = complete && range.isComplete();
+            maxLevel = qMax(maxLevel, range.maxLevel.load());
+        }
+        if (!complete) {
+            // Only this stream failed, keep what was extracted and go on with the other streams
+            saveCheckpoint(partPath, source, channels, lengthInFrames, ranges, levels);
+            QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection, Q_ARG(QString, i18n("Audio thumbs: cannot open file %1", res)),
+                                      Q_ARG(int, int(KMessageWidget::Warning)));
+            continue;
         }
+        // The final levels take over the buffer, no copy
+        const AudioLevelsPtr finalLevels = AudioLevels::create(std::move(levels), channels, int(maxLevel));
+        binClip->setAudioLevels(stream, finalLevels, true);
+        m_progress = 100;
+        QMetaObject::invokeMethod(m_object, "updateJobProgress");
+        // Store for the next project opening
+        AudioPeakFile::write(cachePath, finalLevels->constData(), finalLevels->size(), channels, frequency, framesPerSecond, int(maxLevel));
+        QFile::remove(partPath);
+        audioCreated = true;
+        QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
     }
     if (!audioCreated && !m_isCanceled) {
         // Audio was cached, ensure the bin thumbnail is loaded
@@ -18,6 +18,8 @@ class AudioLevelsTask : public AbstractTask
 public:
     AudioLevelsTask(const ObjectId &owner, QObject* object);
     static void start(const ObjectId &owner, QObject* object, bool force = false);
+    /** @brief Path of the file keeping the progress of an interrupted extraction for @p cachePath */
+    static QString checkpointPath(const QString &cachePath);
 
 protected:
     void run() override;
@@ -63,6 +63,7 @@ void CacheTask::generateThumbnail(std::shared_ptr<ProjectClip> binClip)
         int size = int(frames.size());
         int count = 0;
         const QString clipId = QString::number(m_owner.itemId);
+        std::vector<int> onDisk;
         for (int i : frames) {
             m_progress = 100 * count / size;
             QMetaObject::invokeMethod(m_object, "updateJobProgress");
@@ -70,7 +71,12 @@ void CacheTask::generateThumbnail(std::shared_ptr<ProjectClip> binClip)
             if (m_isCanceled || pCore->taskManager.isBlocked()) {
                 break;
             }
+            if (ThumbnailCache::get()->hasThumbnail(clipId, i, true)) {
+                continue;
+            }
             if (ThumbnailCache::get()->hasThumbnail(clipId, i)) {
+                // Already generated, load it in memory for the bin preview
+                onDisk.push_back(i);
                 continue;
             }
             if (thumbProd == nullptr) {
@@ -93,6 +99,7 @@ void CacheTask::generateThumbnail(std::shared_ptr<ProjectClip> binClip)
                 }
             }
         }
+        ThumbnailCache::get()->promoteThumbnails(clipId, onDisk);
     }
 }
 
@@ -9,8 +9,19 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "kdenlive_debug.h"
 #include "klocalizedstring.h"
 #include <QElapsedTimer>
+#include <QtConcurrent>
 #include <cmath>
 #include <iostream>
+#include <numeric>
+
+struct AudioCorrelation::Batch
+{
+    QList<AudioEnvelope *> envelopes;
+    /** @brief Correlation of each envelope, filled by the worker threads */
+    std::vector<AudioCorrelationInfo *> infos;
+    /** @brief Number of envelopes still being computed */
+    int pending = 0;
+};
 
 AudioCorrelation::AudioCorrelation(std::unique_ptr<AudioEnvelope> mainTrackEnvelope)
     : m_mainTrackEnvelope(std::move(mainTrackEnvelope))
@@ -22,6 +33,15 @@ AudioCorrelation::AudioCorrelation(std::unique_ptr<AudioEnvelope> mainTrackEnvel
 
 AudioCorrelation::~AudioCorrelation()
 {
+    // Running jobs use the envelopes, wait for them before deleting anything
+    for (QFutureWatcher<void> *job : qAsConst(m_jobs)) {
+        job->disconnect(this);
+        job->waitForFinished();
+    }
+    for (const std::shared_ptr<Batch> &batch : qAsConst(m_batches)) {
+        qDeleteAll(batch->envelopes);
+        qDeleteAll(batch->infos);
+    }
     for (AudioEnvelope *envelope : qAsConst(m_children)) {
         delete envelope;
     }
@@ -39,43 +59,90 @@ void AudioCorrelation::slotAnnounceEnvelope()
 
 void AudioCorrelation::addChild(AudioEnvelope *envelope)
 {
-    // We need to connect before starting the computation, to make sure
-    // there is no race condition where the signal 'envelopeReady' is
-    // lost.
-    Q_ASSERT(!envelope->hasComputationStarted());
-    connect(envelope, &AudioEnvelope::envelopeReady, this, &AudioCorrelation::slotProcessChild);
-    envelope->startComputeEnvelope();
+    addChildren({envelope});
+}
+
+void AudioCorrelation::addChildren(const QList<AudioEnvelope *> &envelopes)
+{
+    if (envelopes.isEmpty()) {
+        return;
+    }
+    auto batch = std::make_shared<Batch>();
+    batch->envelopes = envelopes;
+    batch->infos.resize(size_t(envelopes.size()), nullptr);
+    batch->pending = envelopes.size();
+    m_batches.append(batch);
+    for (AudioEnvelope *envelope : envelopes) {
+        // We need to connect before starting the computation, to make sure
+        // there is no race condition where the signal 'envelopeReady' is
+        // lost.
+        Q_ASSERT(!envelope->hasComputationStarted());
+        connect(envelope, &AudioEnvelope::envelopeReady, this, [this, batch]() {
+            if (--batch->pending == 0) {
+                processBatch(batch);
+            }
+        });
+        envelope->startComputeEnvelope();
+    }
+}
+
+void AudioCorrelation::processBatch(const std::shared_ptr<Batch> &batch)
+{
+    auto *job = new QFutureWatcher<void>(this);
+    m_jobs.append(job);
+    connect(job, &QFutureWatcherBase::finished, this, [this, job, batch]() {
+        m_jobs.removeAll(job);
+        job->deleteLater();
+        m_batches.removeAll(batch);
+        QVector<AlignResult> results;
+        results.reserve(batch->envelopes.size());
+        for (int i = 0; i < batch->envelopes.size(); ++i) {
+            m_children.append(batch->envelopes.at(i));
+            m_correlations.append(batch->infos.at(size_t(i)));
+            results.append({batch->envelopes.at(i)->clipId(), getShift(m_children.size() - 1), batch->infos.at(size_t(i))->confidence()});
+        }
+        Q_ASSERT(m_correlations.size() == m_children.size());
+        Q_EMIT gotAudioAlignBatch(results);
+    });
+    job->setFuture(QtConcurrent::run([this, batch]() {
+        // Each clip is correlated on its own thread against the shared main track spectrum
+        QVector<int> indexes(batch->envelopes.size());
+        std::iota(indexes.begin(), indexes.end(), 0);
+        QtConcurrent::blockingMap(indexes, [this, batch](int &i) { batch->infos[size_t(i)] = correlateChild(batch->envelopes.at(i)); });
+    }));
 }
 
-void AudioCorrelation::slotProcessChild(AudioEnvelope *envelope)
+const FFTCorrelation::Reference &AudioCorrelation::reference()
+{
+    QMutexLocker lock(&m_referenceMutex);
+    if (!m_reference) {
+        const std::vector<qint64> &envMain = m_mainTrackEnvelope->envelope();
+        m_reference = std::make_unique<FFTCorrelation::Reference>(envMain.data(), envMain.size());
+    }
+    return *m_reference;
+}
+
+AudioCorrelationInfo *AudioCorrelation::correlateChild(AudioEnvelope *envelope)
 {
     // Note that at this point the computation of the envelope of the
     // main track might not be finished. envelope() will block until
     // the computation is done.
-    const size_t sizeMain = m_mainTrackEnvelope->envelope().size();
-    const size_t sizeSub = envelope->envelope().size();
+    const std::vector<qint64> &envMain = m_mainTrackEnvelope->envelope();
+    const std::vector<qint64> &envSub = envelope->envelope();
+    const size_t sizeMain = envMain.size();
+    const size_t sizeSub = envSub.size();
 
     auto *info = new AudioCorrelationInfo(sizeMain, sizeSub);
     qint64 *correlation = info->correlationVector();
 
-    const std::vector<qint64> &envMain = m_mainTrackEnvelope->envelope();
-    const std::vector<qint64> &envSub = envelope->envelope();
-    qint64 max = 0;
-
     if (sizeSub > 200) {
-        FFTCorrelation::correlate(&envMain[0], sizeMain, &envSub[0], sizeSub, correlation);
+        FFTCorrelation::correlate(reference(), envSub.data(), sizeSub, correlation);
     } else {
-        correlate(&envMain[0], sizeMain, &envSub[0], sizeSub, correlation, &max);
+        qint64 max = 0;
+        correlate(envMain.data(), sizeMain, envSub.data(), sizeSub, correlation, &max);
         info->setMax(max);
     }
-
-    m_children.append(envelope);
-    m_correlations.append(info);
-
-    Q_ASSERT(m_correlations.size() == m_children.size());
-    int index = m_children.indexOf(envelope);
-    int shift = getShift(index);
-    Q_EMIT gotAudioAlignData(envelope->clipId(), shift);
+    return info;
 }
 
 int AudioCorrelation::getShift(int childIndex) const
@@ -10,7 +10,11 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "audioCorrelationInfo.h"
 #include "audioEnvelope.h"
 #include "definitions.h"
+#include "fftCorrelation.h"
+#include <QFutureWatcher>
 #include <QList>
+#include <QVector>
+#include <memory>
 
 /**
   This class does the correlation between two tracks
@@ -18,11 +22,25 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
   It uses one main track (used in the initializer); further tracks will be
   aligned relative to this main track.
+
+  Clips added together are aligned as a batch: once all their envelopes
+  are computed, they are correlated on the thread pool against a single
+  spectrum of the main track, and the results are announced at once.
   */
 class AudioCorrelation : public QObject
 {
     Q_OBJECT
 public:
+    /** @brief Alignment of one clip to the main track */
+    struct AlignResult
+    {
+        int clipId;
+        /** @brief Position of the clip relative to the start of the main track */
+        int shift;
+        /** @brief See AudioCorrelationInfo::confidence() */
+        double confidence;
+    };
+
     /**
       @param mainTrackEnvelope Envelope of the reference track. Its
                                actual computation will be started in
@@ -38,15 +56,17 @@ public:
     ~AudioCorrelation() override;
 
     /**
-      Adds a child envelope that will be aligned to the reference
+      Adds child envelopes that will be aligned to the reference
       envelope. This function returns immediately, the alignment
-      computation is done asynchronously. When done, the signal
-      gotAudioAlignData will be emitted. Similarly to the main
-      envelope, the computation of the envelope must not be started
-      when it is passed to this object.
+      computation is done asynchronously. When all envelopes are
+      aligned, the signal gotAudioAlignBatch will be emitted once.
+      Similarly to the main envelope, the computation of the envelopes
+      must not be started when they are passed to this object.
 
-      This object will take ownership of the passed envelope.
+      This object will take ownership of the passed envelopes.
       */
+    void addChildren(const QList<AudioEnvelope *> &envelopes);
+    /** @brief Same as addChildren() for a single envelope */
     void addChild(AudioEnvelope *envelope);
 
     const AudioCorrelationInfo *info(int childIndex) const;
@@ -59,23 +79,30 @@ public:
     static void correlate(const qint64 *envMain, size_t sizeMain, const qint64 *envSub, size_t sizeSub, qint64 *correlation, qint64 *out_max = nullptr);
 
 private:
+    struct Batch;
     std::unique_ptr<AudioEnvelope> m_mainTrackEnvelope;
+    /** @brief Main envelope prepared for FFT correlation, built by the first batch */
+    std::unique_ptr<FFTCorrelation::Reference> m_reference;
+    QMutex m_referenceMutex;
 
     QList<AudioEnvelope *> m_children;
     QList<AudioCorrelationInfo *> m_correlations;
+    /** @brief Batches whose envelopes are not aligned yet, they own their envelopes */
+    QList<std::shared_ptr<Batch>> m_batches;
+    /** @brief Batches being correlated */
+    QList<QFutureWatcher<void> *> m_jobs;
 
-private Q_SLOTS:
-    /**
-     This is invoked when the child envelope is computed. This
-     triggers the actual computations of the cross-correlation for
-     aligning the envelope to the reference envelope.
+    /** @brief Returns the main envelope prepared for correlation. Blocks until the main envelope is computed */
+    const FFTCorrelation::Reference &reference();
+    /** @brief Correlates @p envelope against the main envelope, can be called from any thread */
+    AudioCorrelationInfo *correlateChild(AudioEnvelope *envelope);
+    /** @brief Correlates the envelopes of @p batch in parallel once they are all computed */
+    void processBatch(const std::shared_ptr<Batch> &batch);
 
-     Takes ownership of @p envelope.
-   */
-    void slotProcessChild(AudioEnvelope *envelope);
+private Q_SLOTS:
     void slotAnnounceEnvelope();
 
 Q_SIGNALS:
-    void gotAudioAlignData(int, int);
+    void gotAudioAlignBatch(const QVector<AudioCorrelation::AlignResult> &results);
     void displayMessage(const QString &, MessageType, int);
 };
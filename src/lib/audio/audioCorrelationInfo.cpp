@@ -7,6 +7,8 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include "audioCorrelationInfo.h"
 
+#include <algorithm>
+
 AudioCorrelationInfo::AudioCorrelationInfo(size_t mainSize, size_t subSize)
     : m_mainSize(mainSize)
     , m_subSize(subSize)
@@ -62,6 +64,32 @@ size_t AudioCorrelationInfo::maxIndex() const
     return index;
 }
 
+double AudioCorrelationInfo::confidence() const
+{
+    const size_t width = size();
+    const size_t peak = maxIndex();
+    const qint64 max = m_correlationVector[peak];
+    if (max <= 0) {
+        return 0.;
+    }
+    // The envelopes have a zero mean, so the main lobe ends where the correlation stops being positive
+    size_t lobeStart = peak;
+    while (lobeStart > 0 && m_correlationVector[lobeStart - 1] > 0) {
+        --lobeStart;
+    }
+    size_t lobeEnd = peak;
+    while (lobeEnd + 1 < width && m_correlationVector[lobeEnd + 1] > 0) {
+        ++lobeEnd;
+    }
+    qint64 secondPeak = 0;
+    for (size_t i = 0; i < width; ++i) {
+        if (i < lobeStart || i > lobeEnd) {
+            secondPeak = std::max(secondPeak, m_correlationVector[i]);
+        }
+    }
+    return qBound(0., 1. - double(secondPeak) / double(max), 1.);
+}
+
 qint64 *AudioCorrelationInfo::correlationVector()
 {
     return m_correlationVector;
@@ -38,6 +38,13 @@ public:
       */
     size_t maxIndex() const;
 
+    /**
+      Returns how much the maximum stands out of the correlation vector: one minus the ratio of
+      the highest value outside of the main lobe to the maximum. It goes from 0 (flat correlation
+      or another peak as high, the shift is a guess) to 1 (single peak)
+      */
+    double confidence() const;
+
     QImage toImage(size_t height = 400) const;
 
 private:
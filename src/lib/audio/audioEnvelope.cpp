@@ -11,13 +11,29 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "bin/projectclip.h"
 #include "core.h"
 #include "kdenlive_debug.h"
+#include "project/projectmanager.h"
 #include <KLocalizedString>
+#include <QDataStream>
 #include <QElapsedTimer>
+#include <QFile>
 #include <QImage>
+#include <QSaveFile>
 #include <QtConcurrent>
 #include <algorithm>
 #include <cmath>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+constexpr quint32 EnvelopeMagic = 0x4b454e56; // "KENV"
+// Increase when the envelope computation changes, so that cached envelopes are recomputed
+constexpr quint32 EnvelopeVersion = 1;
+// Minimum interval between two progress messages, in milliseconds
+constexpr int ProgressInterval = 200;
+} // namespace
+
 AudioEnvelope::AudioEnvelope(const QString &binId, int clipId, size_t offset, size_t length, size_t startPos)
     : m_offset(offset)
     , m_clipId(clipId)
@@ -32,6 +48,19 @@ AudioEnvelope::AudioEnvelope(const QString &binId, int clipId, size_t offset, si
     }
     m_envelopeSize = size_t(m_producer->get_playtime());
 
+    // Envelopes are cached per file, audio stream, zone and frame rate
+    bool ok = false;
+    QDir cacheFolder = pCore->projectManager()->cacheDir(true, &ok);
+    const QString clipHash = clip->hash(false);
+    if (ok && !clipHash.isEmpty()) {
+        m_cachePath = cacheFolder.absoluteFilePath(QStringLiteral("%1_%2_%3_%4_%5.envelope")
+                                                       .arg(clipHash)
+                                                       .arg(m_producer->get_int("audio_index"))
+                                                       .arg(m_producer->get_in())
+                                                       .arg(m_producer->get_out())
+                                                       .arg(int(pCore->getCurrentFps() * 100)));
+    }
+
     m_producer->set("set.test_image", 1);
     connect(&m_watcher, &QFutureWatcherBase::finished, this, [this] { Q_EMIT envelopeReady(this); });
     if (!m_producer || !m_producer->is_valid()) {
@@ -95,6 +124,79 @@ const std::vector<qint64> &AudioEnvelope::envelope()
     return audioSummary().audioAmplitudes;
 }
 
+qint64 AudioEnvelope::absSum(const qint16 *data, int count)
+{
+    qint64 sum = 0;
+    int k = 0;
+#ifdef __SSE2__
+    // |x| is computed as (x ^ sign) - sign, which gives 0x8000 for -32768: read as unsigned 16 bit values,
+    // all results are exact. They are widened to 32 bit lanes, flushed before they can overflow.
+    const __m128i zero = _mm_setzero_si128();
+    while (k + 8 <= count) {
+        __m128i acc = _mm_setzero_si128();
+        const int end = qMin(count - 7, k + 8 * 16384);
+        for (; k < end; k += 8) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + k));
+            const __m128i sign = _mm_srai_epi16(x, 15);
+            const __m128i abs = _mm_sub_epi16(_mm_xor_si128(x, sign), sign);
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_unpacklo_epi16(abs, zero), _mm_unpackhi_epi16(abs, zero)));
+        }
+        alignas(16) quint32 lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+        sum += qint64(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+#endif
+    for (; k < count; ++k) {
+        sum += qAbs(qint64(data[k]));
+    }
+    return sum;
+}
+
+bool AudioEnvelope::loadCachedSummary(AudioSummary &summary) const
+{
+    if (m_cachePath.isEmpty()) {
+        return false;
+    }
+    QFile file(m_cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 magic, version;
+    quint64 size;
+    qint64 amplitudeMax;
+    in >> magic >> version >> size >> amplitudeMax;
+    if (in.status() != QDataStream::Ok || magic != EnvelopeMagic || version != EnvelopeVersion || size != summary.audioAmplitudes.size()) {
+        return false;
+    }
+    for (qint64 &amplitude : summary.audioAmplitudes) {
+        in >> amplitude;
+    }
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+    summary.amplitudeMax = amplitudeMax;
+    return true;
+}
+
+void AudioEnvelope::saveCachedSummary(const AudioSummary &summary) const
+{
+    if (m_cachePath.isEmpty()) {
+        return;
+    }
+    QSaveFile file(m_cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(KDENLIVE_LOG) << "Cannot write audio envelope to" << m_cachePath;
+        return;
+    }
+    QDataStream out(&file);
+    out << EnvelopeMagic << EnvelopeVersion << quint64(summary.audioAmplitudes.size()) << summary.amplitudeMax;
+    for (qint64 amplitude : summary.audioAmplitudes) {
+        out << amplitude;
+    }
+    file.commit();
+}
+
 AudioEnvelope::AudioSummary AudioEnvelope::loadAndNormalizeEnvelope() const
 {
     qCDebug(KDENLIVE_LOG) << "Loading envelope …";
@@ -102,25 +204,36 @@ AudioEnvelope::AudioSummary AudioEnvelope::loadAndNormalizeEnvelope() const
     if (!m_info || m_info->size() < 1) {
         return summary;
     }
+    if (loadCachedSummary(summary)) {
+        qCDebug(KDENLIVE_LOG) << "Using cached envelope" << m_cachePath;
+        pCore->displayMessage(i18n("Audio analysis finished"), OperationCompletedMessage, 300);
+        return summary;
+    }
     int samplingRate = m_info->info(0)->samplingRate();
     mlt_audio_format format_s16 = mlt_audio_s16;
     int channels = 1;
 
     QElapsedTimer t;
     t.start();
+    QElapsedTimer progressTime;
+    progressTime.start();
+    int progress = -1;
     m_producer->seek(0);
+    const double fps = m_producer->get_fps();
     size_t max = summary.audioAmplitudes.size();
+    // Each frame is a block of samples, summed as soon as it is decoded
     for (size_t i = 0; i < max; ++i) {
         std::unique_ptr<Mlt::Frame> frame(m_producer->get_frame(int(i)));
         qint64 position = mlt_frame_get_position(frame->get_frame());
-        int samples = mlt_audio_calculate_frame_samples(float(m_producer->get_fps()), samplingRate, position);
+        int samples = mlt_audio_calculate_frame_samples(float(fps), samplingRate, position);
         auto *data = static_cast<qint16 *>(frame->get_audio(format_s16, samplingRate, channels, samples));
-
-        summary.audioAmplitudes[i] = 0;
-        for (int k = 0; k < samples; ++k) {
-            summary.audioAmplitudes[i] += abs(data[k]);
+        summary.audioAmplitudes[i] = data ? absSum(data, samples) : 0;
+        int val = int(100 * i / max);
+        if (val != progress && progressTime.elapsed() > ProgressInterval) {
+            progress = val;
+            progressTime.restart();
+            pCore->displayMessage(i18n("Processing data analysis"), ProcessingJobMessage, progress);
         }
-        pCore->displayMessage(i18n("Processing data analysis"), ProcessingJobMessage, int(100 * i / max));
     }
     qCDebug(KDENLIVE_LOG) << "Calculating the envelope (" << m_envelopeSize << " frames) took " << t.elapsed() << " ms.";
     qCDebug(KDENLIVE_LOG) << "Normalizing envelope …";
@@ -133,6 +246,7 @@ AudioEnvelope::AudioSummary AudioEnvelope::loadAndNormalizeEnvelope() const
         summary.audioAmplitudes[i] -= meanBeforeNormalization;
         summary.amplitudeMax = std::max(summary.amplitudeMax, qAbs(summary.audioAmplitudes[i]));
     }
+    saveCachedSummary(summary);
     pCore->displayMessage(i18n("Audio analysis finished"), OperationCompletedMessage, 300);
     return summary;
 }
@@ -21,6 +21,10 @@ class QImage;
   with frame resolution. One entry is calculated by the sum
   of the absolute values of all samples in the current frame.
 
+  Computed envelopes are stored in the project audio cache folder, keyed by
+  the clip file hash, audio stream and analysed zone, so that aligning several
+  clips against the same reference does not decode it again.
+
   See also: http://web.archive.org/web/20180626235917/http://bemasc.net/wordpress/2011/07/26/an-auto-aligner-for-pitivi/
   */
 class AudioEnvelope : public QObject
@@ -58,6 +62,9 @@ public:
     int clipId() const;
     size_t startPos() const;
 
+    /** @brief Sum of the absolute values of @p count samples, using SIMD instructions if available */
+    static qint64 absSum(const qint16 *data, int count);
+
 private:
     struct AudioSummary
     {
@@ -85,6 +92,10 @@ private:
     */
     AudioSummary loadAndNormalizeEnvelope() const;
 
+    /** @brief Read a previously computed envelope from m_cachePath */
+    bool loadCachedSummary(AudioSummary &summary) const;
+    void saveCachedSummary(const AudioSummary &summary) const;
+
     std::shared_ptr<Mlt::Producer> m_producer;
     std::unique_ptr<AudioInfo> m_info;
     QFutureWatcher<AudioSummary> m_watcher;
@@ -94,6 +105,8 @@ private:
     const int m_clipId;
     const size_t m_startpos;
     size_t m_envelopeSize;
+    /** @brief File storing the computed envelope, empty if it cannot be cached */
+    QString m_cachePath;
 
 Q_SIGNALS:
     void envelopeReady(AudioEnvelope *envelope);
@@ -0,0 +1,85 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "audioLevels.h"
+#include "audioPeakFile.h"
+#include "audioPeakPyramid.h"
+
+#include <algorithm>
+
+AudioLevels::~AudioLevels() = default;
+
+AudioLevelsPtr AudioLevels::create(QVector<uint8_t> levels, int channels, int maxLevel)
+{
+    // The constructor is private, so std::make_shared cannot be used
+    std::shared_ptr<AudioLevels> result(new AudioLevels());
+    result->m_channels = qMax(1, channels);
+    result->m_vector = std::move(levels);
+    result->m_size = result->m_vector.size() - result->m_vector.size() % result->m_channels;
+    result->m_data = result->m_vector.constData();
+    if (maxLevel < 0 && result->m_size > 0) {
+        maxLevel = *std::max_element(result->m_vector.constBegin(), result->m_vector.constEnd());
+    }
+    result->m_maxLevel = qMax(0, maxLevel);
+    return result;
+}
+
+AudioLevelsPtr AudioLevels::fromPeakFile(std::unique_ptr<AudioPeakFile> file)
+{
+    if (!file || !file->isValid()) {
+        return nullptr;
+    }
+    std::shared_ptr<AudioLevels> result(new AudioLevels());
+    result->m_channels = file->channels();
+    result->m_size = file->frames() * file->channels();
+    result->m_data = file->levels();
+    result->m_maxLevel = file->maxLevel();
+    result->m_file = std::move(file);
+    return result;
+}
+
+int AudioLevels::channels() const
+{
+    return m_channels;
+}
+
+qint64 AudioLevels::size() const
+{
+    return m_size;
+}
+
+qint64 AudioLevels::frames() const
+{
+    return m_size / m_channels;
+}
+
+bool AudioLevels::isEmpty() const
+{
+    return m_size == 0;
+}
+
+int AudioLevels::maxLevel() const
+{
+    return m_maxLevel;
+}
+
+const quint8 *AudioLevels::constData() const
+{
+    return m_data;
+}
+
+const AudioPeakPyramid &AudioLevels::pyramid() const
+{
+    std::call_once(m_pyramidFlag, [this]() {
+        if (m_file) {
+            m_pyramid.reset(new AudioPeakPyramid(*m_file.get()));
+        } else {
+            m_pyramid.reset(new AudioPeakPyramid(m_data, frames(), m_channels));
+        }
+    });
+    return *m_pyramid.get();
+}
@@ -0,0 +1,63 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QVector>
+#include <QtGlobal>
+#include <memory>
+#include <mutex>
+
+class AudioPeakFile;
+class AudioPeakPyramid;
+class AudioLevels;
+
+using AudioLevelsPtr = std::shared_ptr<const AudioLevels>;
+
+/**
+  Audio levels of a clip stream, one value per frame and channel, interleaved by channel.
+
+  The levels are immutable once created and shared by reference between the bin clip,
+  its timeline instances and the waveform painters. Updating the levels of a clip means
+  publishing a new instance, readers keep the one they hold until they ask again.
+
+  Levels loaded from an AudioPeakFile are read in place from the loaded file data.
+  */
+class AudioLevels
+{
+public:
+    /** @brief Take the values of @p levels. If @p maxLevel is negative, it is computed from the values */
+    static AudioLevelsPtr create(QVector<uint8_t> levels, int channels, int maxLevel = -1);
+    /** @brief Use the levels of the opened @p file without copying them */
+    static AudioLevelsPtr fromPeakFile(std::unique_ptr<AudioPeakFile> file);
+
+    ~AudioLevels();
+
+    int channels() const;
+    /** @brief Number of values, frames() * channels() */
+    qint64 size() const;
+    qint64 frames() const;
+    bool isEmpty() const;
+    /** @brief Highest value of all channels */
+    int maxLevel() const;
+    const quint8 *constData() const;
+    inline quint8 at(qint64 index) const { return m_data[index]; }
+
+    /** @brief The min/max pyramid of the levels, built on first use */
+    const AudioPeakPyramid &pyramid() const;
+
+private:
+    AudioLevels() = default;
+    QVector<uint8_t> m_vector;
+    std::unique_ptr<AudioPeakFile> m_file;
+    const quint8 *m_data{nullptr};
+    qint64 m_size{0};
+    int m_channels{1};
+    int m_maxLevel{0};
+    mutable std::once_flag m_pyramidFlag;
+    mutable std::unique_ptr<AudioPeakPyramid> m_pyramid;
+};
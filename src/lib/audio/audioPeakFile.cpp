@@ -0,0 +1,237 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "audioPeakFile.h"
+#include "audioPeakPyramid.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QImage>
+#include <QSaveFile>
+#include <QtEndian>
+#include <cstring>
+
+constexpr quint32 AudioPeakFile::Version;
+constexpr qint64 AudioPeakFile::MinMipFrames;
+
+namespace {
+const char Magic[8] = {'K', 'D', 'E', 'N', 'P', 'E', 'A', 'K'};
+constexpr qint64 HeaderSize = 48;
+constexpr qint64 TableEntrySize = 16;
+
+template <typename T> T readLE(const uchar *data, qint64 offset)
+{
+    return qFromLittleEndian<T>(data + offset);
+}
+
+template <typename T> void appendLE(QByteArray &buffer, T value)
+{
+    uchar bytes[sizeof(T)];
+    qToLittleEndian<T>(value, bytes);
+    buffer.append(reinterpret_cast<const char *>(bytes), int(sizeof(T)));
+}
+} // namespace
+
+AudioPeakFile::AudioPeakFile() = default;
+
+AudioPeakFile::~AudioPeakFile() = default;
+
+bool AudioPeakFile::open(const QString &path)
+{
+    m_data = nullptr;
+    m_size = 0;
+    m_buffer.clear();
+    // Read the whole file and close it, so that the cache can be rewritten while the levels are in use
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < HeaderSize) {
+        return false;
+    }
+    m_buffer = file.readAll();
+    file.close();
+    m_size = m_buffer.size();
+    m_data = reinterpret_cast<const uchar *>(m_buffer.constData());
+    if (m_size < HeaderSize || memcmp(m_data, Magic, sizeof(Magic)) != 0 || readLE<quint32>(m_data, 8) != Version || channels() <= 0) {
+        m_data = nullptr;
+        m_buffer.clear();
+        return false;
+    }
+    // Check that the table and all levels fit in the file
+    const int count = levelCount();
+    if (count <= 0 || HeaderSize + count * TableEntrySize > m_size) {
+        m_data = nullptr;
+        m_buffer.clear();
+        return false;
+    }
+    // The header frame count sizes the reads of the full resolution level, it must match its table entry
+    if (frames() < 0 || frames() != qint64(readLE<quint64>(m_data, HeaderSize + 8))) {
+        m_data = nullptr;
+        m_buffer.clear();
+        return false;
+    }
+    for (int level = 0; level < count; ++level) {
+        const qint64 entry = HeaderSize + level * TableEntrySize;
+        const auto offset = qint64(readLE<quint64>(m_data, entry));
+        const auto frames = qint64(readLE<quint64>(m_data, entry + 8));
+        // Compare before multiplying, so that a corrupted count cannot overflow
+        if (offset < HeaderSize || offset > m_size || frames < 0 || frames > (m_size - offset) / channels()) {
+            m_data = nullptr;
+            m_buffer.clear();
+            return false;
+        }
+        const qint64 bytes = frames * channels() * (level == 0 ? 1 : 2);
+        if (offset + bytes > m_size) {
+            m_data = nullptr;
+            m_buffer.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AudioPeakFile::isValid() const
+{
+    return m_data != nullptr;
+}
+
+int AudioPeakFile::channels() const
+{
+    return m_data ? int(readLE<quint32>(m_data, 12)) : 0;
+}
+
+int AudioPeakFile::sampleRate() const
+{
+    return m_data ? int(readLE<quint32>(m_data, 16)) : 0;
+}
+
+int AudioPeakFile::maxLevel() const
+{
+    return m_data ? int(readLE<quint32>(m_data, 20)) : 0;
+}
+
+double AudioPeakFile::fps() const
+{
+    if (!m_data) {
+        return 0.;
+    }
+    const quint64 bits = readLE<quint64>(m_data, 24);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+qint64 AudioPeakFile::frames() const
+{
+    return m_data ? qint64(readLE<quint64>(m_data, 32)) : 0;
+}
+
+int AudioPeakFile::levelCount() const
+{
+    return m_data ? int(readLE<quint32>(m_data, 40)) : 0;
+}
+
+const quint8 *AudioPeakFile::levels() const
+{
+    if (!m_data) {
+        return nullptr;
+    }
+    return m_data + readLE<quint64>(m_data, HeaderSize);
+}
+
+const quint8 *AudioPeakFile::mipLevel(int level, qint64 *frames) const
+{
+    if (!m_data || level < 1 || level >= levelCount()) {
+        *frames = 0;
+        return nullptr;
+    }
+    const qint64 entry = HeaderSize + level * TableEntrySize;
+    *frames = qint64(readLE<quint64>(m_data, entry + 8));
+    return m_data + readLE<quint64>(m_data, entry);
+}
+
+QVector<uint8_t> AudioPeakFile::toVector() const
+{
+    QVector<uint8_t> result;
+    if (!m_data) {
+        return result;
+    }
+    const qint64 count = frames() * channels();
+    result.resize(int(count));
+    memcpy(result.data(), levels(), size_t(count));
+    return result;
+}
+
+bool AudioPeakFile::write(const QString &path, const quint8 *levels, qint64 size, int channels, int sampleRate, double fps, int maxLevel)
+{
+    if (channels <= 0 || size < channels) {
+        return false;
+    }
+    const qint64 frames = size / channels;
+    const AudioPeakPyramid pyramid(levels, frames, channels);
+
+    const auto levelCount = quint32(pyramid.levelCount());
+    QByteArray header;
+    header.append(Magic, int(sizeof(Magic)));
+    appendLE<quint32>(header, Version);
+    appendLE<quint32>(header, quint32(channels));
+    appendLE<quint32>(header, quint32(sampleRate));
+    appendLE<quint32>(header, quint32(maxLevel));
+    quint64 fpsBits;
+    memcpy(&fpsBits, &fps, sizeof(fps));
+    appendLE<quint64>(header, fpsBits);
+    appendLE<quint64>(header, quint64(frames));
+    appendLE<quint32>(header, levelCount);
+    appendLE<quint32>(header, 0);
+    qint64 offset = HeaderSize + levelCount * TableEntrySize;
+    appendLE<quint64>(header, quint64(offset));
+    appendLE<quint64>(header, quint64(frames));
+    offset += frames * channels;
+    for (int level = 1; level < pyramid.levelCount(); ++level) {
+        qint64 levelFrames;
+        pyramid.mipLevel(level, &levelFrames);
+        appendLE<quint64>(header, quint64(offset));
+        appendLE<quint64>(header, quint64(levelFrames));
+        offset += levelFrames * channels * 2;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot write audio peaks to" << path;
+        return false;
+    }
+    file.write(header);
+    file.write(reinterpret_cast<const char *>(levels), frames * channels);
+    for (int level = 1; level < pyramid.levelCount(); ++level) {
+        qint64 levelFrames;
+        const quint8 *data = pyramid.mipLevel(level, &levelFrames);
+        file.write(reinterpret_cast<const char *>(data), levelFrames * channels * 2);
+    }
+    return file.commit();
+}
+
+QVector<uint8_t> AudioPeakFile::readLegacyImage(const QString &path, int channels)
+{
+    QVector<uint8_t> levels;
+    QImage image(path);
+    if (image.isNull() || channels <= 0) {
+        return levels;
+    }
+    image = image.convertToFormat(QImage::Format_ARGB32);
+    // Each pixel holds 4 consecutive values, pixel i being stored at (i / channels, i % channels)
+    const int n = image.width() * image.height();
+    if (n <= 1) {
+        return levels;
+    }
+    levels.resize(4 * n);
+    for (int i = 0; i < n; i++) {
+        const QRgb p = reinterpret_cast<const QRgb *>(image.constScanLine(i % channels))[i / channels];
+        levels[4 * i] = uint8_t(qRed(p));
+        levels[4 * i + 1] = uint8_t(qGreen(p));
+        levels[4 * i + 2] = uint8_t(qBlue(p));
+        levels[4 * i + 3] = uint8_t(qAlpha(p));
+    }
+    return levels;
+}
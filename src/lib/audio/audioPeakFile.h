@@ -0,0 +1,73 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "audioPeakPyramid.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+/**
+  Binary cache file for the audio levels of a clip stream, replacing the
+  PNG images previously used for that purpose.
+
+  The file starts with a fixed size header (magic, version, channels,
+  sample rate, fps, number of frames, max level), followed by a table of
+  the stored levels. Level 0 holds one value per frame and channel,
+  interleaved by channel, which is the layout used by the audio thumbnail
+  producer data. Each further level halves the number of frames and stores
+  a (min, max) pair per channel, so that a zoomed out waveform does not
+  need to walk all frames. All numbers are little endian.
+
+  Opening a file reads it in memory and closes it, so that the cache can be
+  rewritten while the levels are in use. The level data is read in place.
+  */
+class AudioPeakFile
+{
+public:
+    static constexpr quint32 Version = 1;
+    /** @brief Do not build reduced levels with less frames than this */
+    static constexpr qint64 MinMipFrames = AudioPeakPyramid::MinMipFrames;
+
+    AudioPeakFile();
+    ~AudioPeakFile();
+
+    /** @brief Load the file at @p path. Returns false if it does not exist, is truncated or has another version */
+    bool open(const QString &path);
+    bool isValid() const;
+
+    int channels() const;
+    int sampleRate() const;
+    double fps() const;
+    /** @brief Number of frames of level 0 */
+    qint64 frames() const;
+    int maxLevel() const;
+
+    /** @brief Number of stored levels, including level 0 */
+    int levelCount() const;
+    /** @brief The per frame values, frames() * channels() bytes */
+    const quint8 *levels() const;
+    /** @brief The (min, max) pairs of @p level >= 1, @p frames receives the number of entries per channel */
+    const quint8 *mipLevel(int level, qint64 *frames) const;
+
+    /** @brief Copy of the per frame values */
+    QVector<uint8_t> toVector() const;
+
+    /** @brief Write the @p size values of @p levels (interleaved by channel) with their reduced levels to @p path */
+    static bool write(const QString &path, const quint8 *levels, qint64 size, int channels, int sampleRate, double fps, int maxLevel);
+
+    /** @brief Decode the PNG audio thumbnails written by older versions */
+    static QVector<uint8_t> readLegacyImage(const QString &path, int channels);
+
+private:
+    QByteArray m_buffer;
+    const uchar *m_data{nullptr};
+    qint64 m_size{0};
+};
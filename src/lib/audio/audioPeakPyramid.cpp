@@ -0,0 +1,129 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "audioPeakPyramid.h"
+#include "audioPeakFile.h"
+
+#include <atomic>
+
+constexpr qint64 AudioPeakPyramid::MinMipFrames;
+
+namespace {
+std::atomic<quint64> s_nextSerial{1};
+} // namespace
+
+AudioPeakPyramid::AudioPeakPyramid(const quint8 *levels, qint64 frames, int channels)
+    : m_levels(levels)
+    , m_channels(qMax(1, channels))
+    , m_frames(frames)
+    , m_serial(s_nextSerial++)
+{
+    qint64 currentFrames = m_frames;
+    const quint8 *previous = m_levels;
+    while (currentFrames / 2 >= MinMipFrames) {
+        m_mipData.push_back(reduce(previous, currentFrames, m_channels, !m_mips.empty()));
+        currentFrames = (currentFrames + 1) / 2;
+        previous = reinterpret_cast<const quint8 *>(m_mipData.back().constData());
+        m_mips.push_back(previous);
+        m_mipFrames.push_back(currentFrames);
+    }
+}
+
+AudioPeakPyramid::AudioPeakPyramid(const AudioPeakFile &file)
+    : m_levels(file.levels())
+    , m_channels(qMax(1, file.channels()))
+    , m_frames(file.frames())
+    , m_serial(s_nextSerial++)
+{
+    for (int level = 1; level < file.levelCount(); ++level) {
+        qint64 frames;
+        m_mips.push_back(file.mipLevel(level, &frames));
+        m_mipFrames.push_back(frames);
+    }
+}
+
+int AudioPeakPyramid::channels() const
+{
+    return m_channels;
+}
+
+quint64 AudioPeakPyramid::serial() const
+{
+    return m_serial;
+}
+
+qint64 AudioPeakPyramid::frames() const
+{
+    return m_frames;
+}
+
+int AudioPeakPyramid::levelCount() const
+{
+    return int(1 + m_mips.size());
+}
+
+const quint8 *AudioPeakPyramid::mipLevel(int level, qint64 *frames) const
+{
+    if (level < 1 || level >= levelCount()) {
+        *frames = 0;
+        return nullptr;
+    }
+    *frames = m_mipFrames[size_t(level - 1)];
+    return m_mips[size_t(level - 1)];
+}
+
+quint8 AudioPeakPyramid::peak(int channel, qint64 first, qint64 last) const
+{
+    first = qMax(qint64(0), first);
+    last = qMin(m_frames, qMax(last, first + 1));
+    if (first >= last || channel < 0 || channel >= m_channels) {
+        return 0;
+    }
+    // Cover the range with the largest aligned entries: an entry e of level L holds the frames [e << L, (e + 1) << L)
+    quint8 result = 0;
+    while (first < last) {
+        int level = 0;
+        while (level + 1 < levelCount() && (first & ((qint64(2) << level) - 1)) == 0 && first + (qint64(2) << level) <= last) {
+            level++;
+        }
+        if (level == 0) {
+            result = qMax(result, m_levels[first * m_channels + channel]);
+        } else {
+            result = qMax(result, m_mips[size_t(level - 1)][((first >> level) * m_channels + channel) * 2 + 1]);
+        }
+        first += qint64(1) << level;
+    }
+    return result;
+}
+
+quint8 AudioPeakPyramid::peak(qint64 first, qint64 last) const
+{
+    quint8 result = 0;
+    for (int channel = 0; channel < m_channels; ++channel) {
+        result = qMax(result, peak(channel, first, last));
+    }
+    return result;
+}
+
+QByteArray AudioPeakPyramid::reduce(const quint8 *previous, qint64 frames, int channels, bool pairs)
+{
+    const qint64 reducedFrames = (frames + 1) / 2;
+    QByteArray reduced(int(reducedFrames * channels * 2), Qt::Uninitialized);
+    auto *out = reinterpret_cast<quint8 *>(reduced.data());
+    const int stride = pairs ? 2 : 1;
+    for (qint64 f = 0; f < reducedFrames; ++f) {
+        const qint64 first = 2 * f;
+        const qint64 second = qMin(first + 1, frames - 1);
+        for (int c = 0; c < channels; ++c) {
+            const quint8 *a = previous + (first * channels + c) * stride;
+            const quint8 *b = previous + (second * channels + c) * stride;
+            *out++ = qMin(a[0], b[0]);
+            *out++ = qMax(a[stride - 1], b[stride - 1]);
+        }
+    }
+    return reduced;
+}
@@ -0,0 +1,68 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QtGlobal>
+#include <vector>
+
+class AudioPeakFile;
+
+/**
+  Min/max pyramid over the audio levels of a clip stream.
+
+  Level 0 is the per frame data of the clip AudioLevels, one value per frame
+  and channel, interleaved by channel. Each further level halves the number
+  of frames and stores a (min, max) pair per channel, the same layout as the
+  reduced levels of AudioPeakFile.
+
+  A zoomed out waveform asks for the peak over many frames per pixel, which
+  is answered from the levels matching that span in a few reads instead of
+  walking all frames.
+
+  The pyramid does not own the level 0 data, which must outlive it.
+  */
+class AudioPeakPyramid
+{
+public:
+    /** @brief Do not build reduced levels with less frames than this */
+    static constexpr qint64 MinMipFrames = 64;
+
+    /** @brief Build the pyramid of @p frames frames of @p levels */
+    AudioPeakPyramid(const quint8 *levels, qint64 frames, int channels);
+    /** @brief Use the levels stored in @p file, which must stay open */
+    explicit AudioPeakPyramid(const AudioPeakFile &file);
+
+    int channels() const;
+    /** @brief Unique number of this pyramid, to identify data derived from it */
+    quint64 serial() const;
+    /** @brief Number of frames of level 0 */
+    qint64 frames() const;
+    /** @brief Number of levels, including level 0 */
+    int levelCount() const;
+    /** @brief The (min, max) pairs of @p level >= 1, @p frames receives the number of entries per channel */
+    const quint8 *mipLevel(int level, qint64 *frames) const;
+
+    /** @brief Highest value of @p channel over the frames [first, last) */
+    quint8 peak(int channel, qint64 first, qint64 last) const;
+    /** @brief Highest value of all channels over the frames [first, last) */
+    quint8 peak(qint64 first, qint64 last) const;
+
+    /** @brief Build the next level from the previous one. For level 1, @p previous holds plain values, so min and max are the same value. */
+    static QByteArray reduce(const quint8 *previous, qint64 frames, int channels, bool pairs);
+
+private:
+    const quint8 *m_levels;
+    int m_channels;
+    qint64 m_frames;
+    quint64 m_serial;
+    std::vector<const quint8 *> m_mips;
+    std::vector<qint64> m_mipFrames;
+    /** @brief Storage of the reduced levels when they are built in memory */
+    std::vector<QByteArray> m_mipData;
+};
@@ -13,10 +13,154 @@ extern "C" {
 #include <algorithm>
 #include <vector>
 
+static_assert(sizeof(kiss_fft_cpx) == 2 * sizeof(float), "Spectra are stored as interleaved floats");
+
+/**
+  kiss_fft plans by size. A plan owns a scratch buffer used
+  by the transform, so it cannot be used by two threads at
+  once: a thread takes a plan out of the cache for the time
+  of the transform, and another plan is allocated if all
+  plans of this size are in use.
+  */
+class FFTPlanCache
+{
+public:
+    FFTPlanCache() = default;
+    ~FFTPlanCache()
+    {
+        for (const auto &plan : m_plans) {
+            kiss_fftr_free(plan.second);
+        }
+    }
+    FFTPlanCache(const FFTPlanCache &) = delete;
+    FFTPlanCache &operator=(const FFTPlanCache &) = delete;
+
+    kiss_fftr_cfg acquire(size_t size, bool inverseTransform)
+    {
+        {
+            QMutexLocker lock(&m_mutex);
+            auto it = m_plans.find({size, inverseTransform});
+            if (it != m_plans.end()) {
+                kiss_fftr_cfg plan = it->second;
+                m_plans.erase(it);
+                return plan;
+            }
+        }
+        return kiss_fftr_alloc(int(size), inverseTransform ? 1 : 0, nullptr, nullptr);
+    }
+
+    void release(size_t size, bool inverseTransform, kiss_fftr_cfg plan)
+    {
+        QMutexLocker lock(&m_mutex);
+        m_plans.emplace(std::make_pair(size, inverseTransform), plan);
+    }
+
+private:
+    QMutex m_mutex;
+    /** @brief Plans not in use, by size and direction */
+    std::multimap<std::pair<size_t, bool>, kiss_fftr_cfg> m_plans;
+};
+
+namespace {
+/** @brief FFT size needed to convolve vectors of @p leftSize and @p rightSize */
+size_t fftSize(size_t leftSize, size_t rightSize)
+{
+    // To avoid issues with repetition (we are dealing with cosine waves
+    // in the fourier domain) we need to pad the vectors to at least twice their size,
+    // otherwise convolution would convolve with the repeated pattern as well
+    const size_t largestSize = std::max(leftSize, rightSize);
+
+    // The vectors must have the same size (same frequency resolution!) and should
+    // be a power of 2 (for FFT).
+    size_t size = 64;
+    while (size / 2 < largestSize) {
+        size = size << 1;
+    }
+    return size;
+}
+
+/**
+  The qint64 values need to be normalized to floats.
+  Dividing by the max value is maybe not the best solution, but the
+  maximum value after correlation should not be larger than the longest
+  vector since each value should be at most 1.
+  If @p reverse is true the values are stored in reverse order.
+  */
+std::vector<float> normalize(const qint64 *data, size_t size, bool reverse)
+{
+    qint64 maxValue = 1;
+    for (size_t i = 0; i < size; ++i) {
+        maxValue = std::max(maxValue, qAbs(data[i]));
+    }
+    std::vector<float> result(size);
+    for (size_t i = 0; i < size; ++i) {
+        result[reverse ? size - 1 - i : i] = float(data[i]) / maxValue;
+    }
+    return result;
+}
+
+/** @brief Writes the spectrum of @p data zero padded to @p size into @p out, which holds size / 2 + 1 entries */
+void forwardTransform(FFTPlanCache &plans, const float *data, size_t dataSize, size_t size, kiss_fft_cpx *out)
+{
+    std::vector<float> padded(size, 0);
+    std::copy(data, data + dataSize, padded.begin());
+    kiss_fftr_cfg plan = plans.acquire(size, false);
+    kiss_fftr(plan, padded.data(), out);
+    plans.release(size, false, plan);
+}
+
+/**
+  Multiplies the spectra, which is a convolution in spacial domain, and
+  transforms the result back into @p out, which holds @p outSize entries.
+  One element is inserted at the beginning to obtain the same result
+  that we also get with the nested for loop correlation.
+  */
+void convolveSpectra(FFTPlanCache &plans, const kiss_fft_cpx *left, const kiss_fft_cpx *right, size_t size, float *out, size_t outSize)
+{
+    std::vector<kiss_fft_cpx> product(size / 2 + 1);
+    for (size_t i = 0; i < product.size(); ++i) {
+        product[i].r = left[i].r * right[i].r - left[i].i * right[i].i;
+        product[i].i = left[i].r * right[i].i + left[i].i * right[i].r;
+    }
+    std::vector<float> convolved(size);
+    kiss_fftr_cfg plan = plans.acquire(size, true);
+    kiss_fftri(plan, product.data(), convolved.data());
+    plans.release(size, true, plan);
+    *out = 0;
+    std::copy(convolved.begin(), convolved.begin() + int(outSize) - 1, out + 1);
+}
+} // namespace
+
+FFTCorrelation::Reference::Reference(const qint64 *data, size_t size)
+    : m_normalized(normalize(data, size, false))
+    , m_plans(std::make_unique<FFTPlanCache>())
+{
+}
+
+FFTCorrelation::Reference::~Reference() = default;
+
+size_t FFTCorrelation::Reference::size() const
+{
+    return m_normalized.size();
+}
+
+const std::vector<float> &FFTCorrelation::Reference::spectrum(size_t fftSize) const
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_spectra.find(fftSize);
+    if (it == m_spectra.end()) {
+        std::vector<float> spectrum(2 * (fftSize / 2 + 1));
+        forwardTransform(*m_plans, m_normalized.data(), m_normalized.size(), fftSize, reinterpret_cast<kiss_fft_cpx *>(spectrum.data()));
+        // Entries of a std::map are never moved, the returned reference stays valid
+        it = m_spectra.emplace(fftSize, std::move(spectrum)).first;
+    }
+    return it->second;
+}
+
 void FFTCorrelation::correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, qint64 *out_correlated)
 {
-    auto *correlatedFloat = new float[leftSize + rightSize + 1];
-    correlate(left, leftSize, right, rightSize, correlatedFloat);
+    std::vector<float> correlatedFloat(leftSize + rightSize + 1);
+    correlate(left, leftSize, right, rightSize, correlatedFloat.data());
 
     // The correlation vector will have entries up to N (number of entries
     // of the vector), so converting to integers will not lose that much
@@ -24,49 +168,42 @@ void FFTCorrelation::correlate(const qint64 *left, const size_t leftSize, const
     for (size_t i = 0; i < leftSize + rightSize + 1; ++i) {
         out_correlated[i] = qint64(correlatedFloat[i]);
     }
-    delete[] correlatedFloat;
 }
 
-void FFTCorrelation::correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, float *out_correlated)
+void FFTCorrelation::correlate(const Reference &left, const qint64 *right, const size_t rightSize, qint64 *out_correlated)
 {
     QElapsedTimer t;
     t.start();
 
-    auto *leftF = new float[leftSize];
-    auto *rightF = new float[rightSize];
-
-    // First the qint64 values need to be normalized to floats
-    // Dividing by the max value is maybe not the best solution, but the
-    // maximum value after correlation should not be larger than the longest
-    // vector since each value should be at most 1
-    qint64 maxLeft = 1;
-    qint64 maxRight = 1;
-    for (size_t i = 0; i < leftSize; ++i) {
-        if (qAbs(left[i]) > maxLeft) {
-            maxLeft = qAbs(left[i]);
-        }
-    }
-    for (size_t i = 0; i < rightSize; ++i) {
-        if (qAbs(right[i]) > maxRight) {
-            maxRight = qAbs(right[i]);
-        }
+    const size_t size = fftSize(left.size(), rightSize);
+    const std::vector<float> &leftFFT = left.spectrum(size);
+    std::vector<kiss_fft_cpx> rightFFT(size / 2 + 1);
+    const std::vector<float> rightF = normalize(right, rightSize, true);
+    forwardTransform(*left.m_plans, rightF.data(), rightSize, size, rightFFT.data());
+
+    const size_t outSize = left.size() + rightSize + 1;
+    std::vector<float> correlatedFloat(outSize);
+    convolveSpectra(*left.m_plans, reinterpret_cast<const kiss_fft_cpx *>(leftFFT.data()), rightFFT.data(), size, correlatedFloat.data(), outSize);
+    for (size_t i = 0; i < outSize; ++i) {
+        out_correlated[i] = qint64(correlatedFloat[i]);
     }
+    qCDebug(KDENLIVE_LOG) << "Correlation (FFT based, cached reference) computed in " << t.elapsed() << " ms.";
+}
+
+void FFTCorrelation::correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, float *out_correlated)
+{
+    QElapsedTimer t;
+    t.start();
 
     // One side needs to be reversed, since multiplication in frequency domain (fourier space)
     // calculates the convolution: \sum l[x]r[N-x] and not the correlation: \sum l[x]r[x]
-    for (size_t i = 0; i < leftSize; ++i) {
-        leftF[i] = float(left[i]) / maxLeft;
-    }
-    for (size_t i = 0; i < rightSize; ++i) {
-        rightF[rightSize - 1 - i] = float(right[i]) / maxRight;
-    }
+    const std::vector<float> leftF = normalize(left, leftSize, false);
+    const std::vector<float> rightF = normalize(right, rightSize, true);
 
     // Now we can convolve to get the correlation
-    convolve(leftF, leftSize, rightF, rightSize, out_correlated);
+    convolve(leftF.data(), leftSize, rightF.data(), rightSize, out_correlated);
 
     qCDebug(KDENLIVE_LOG) << "Correlation (FFT based) computed in " << t.elapsed() << " ms.";
-    delete[] leftF;
-    delete[] rightF;
 }
 
 void FFTCorrelation::convolve(const float *left, const size_t leftSize, const float *right, const size_t rightSize, float *out_convolved)
@@ -74,55 +211,17 @@ void FFTCorrelation::convolve(const float *left, const size_t leftSize, const fl
     QElapsedTimer time;
     time.start();
 
-    // To avoid issues with repetition (we are dealing with cosine waves
-    // in the fourier domain) we need to pad the vectors to at least twice their size,
-    // otherwise convolution would convolve with the repeated pattern as well
-    size_t largestSize = std::max(leftSize, rightSize);
+    const size_t size = fftSize(leftSize, rightSize);
+    std::vector<kiss_fft_cpx> leftFFT(size / 2 + 1);
+    std::vector<kiss_fft_cpx> rightFFT(size / 2 + 1);
 
-    // The vectors must have the same size (same frequency resolution!) and should
-    // be a power of 2 (for FFT).
-    size_t size = 64;
-    while (size / 2 < largestSize) {
-        size = size << 1;
-    }
-
-    const size_t fft_size = size / 2 + 1;
-    kiss_fftr_cfg fftConfig = kiss_fftr_alloc(int(size), 0, nullptr, nullptr);
-    kiss_fftr_cfg ifftConfig = kiss_fftr_alloc(int(size), 1, nullptr, nullptr);
-    std::vector<kiss_fft_cpx> leftFFT(fft_size);
-    std::vector<kiss_fft_cpx> rightFFT(fft_size);
-    std::vector<kiss_fft_cpx> correlatedFFT(fft_size);
-
-    // Fill in the data into our new vectors with padding
-    std::vector<float> leftData(size, 0);
-    std::vector<float> rightData(size, 0);
-    std::vector<float> convolved(size);
-
-    std::copy(left, left + leftSize, leftData.begin());
-    std::copy(right, right + rightSize, rightData.begin());
-
-    // Fourier transformation of the vectors
-    kiss_fftr(fftConfig, &leftData[0], &leftFFT[0]);
-    kiss_fftr(fftConfig, &rightData[0], &rightFFT[0]);
+    // Fourier transformation of the zero padded vectors
+    FFTPlanCache plans;
+    forwardTransform(plans, left, leftSize, size, leftFFT.data());
+    forwardTransform(plans, right, rightSize, size, rightFFT.data());
 
     // Convolution in spacial domain is a multiplication in fourier domain. O(n).
-    for (size_t i = 0; i < correlatedFFT.size(); ++i) {
-        correlatedFFT[i].r = leftFFT[i].r * rightFFT[i].r - leftFFT[i].i * rightFFT[i].i;
-        correlatedFFT[i].i = leftFFT[i].r * rightFFT[i].i + leftFFT[i].i * rightFFT[i].r;
-    }
-
-    // Inverse fourier transformation to get the convolved data.
-    // Insert one element at the beginning to obtain the same result
-    // that we also get with the nested for loop correlation.
-    *out_convolved = 0;
-    size_t out_size = leftSize + rightSize + 1;
-
-    kiss_fftri(ifftConfig, &correlatedFFT[0], &convolved[0]);
-    std::copy(convolved.begin(), convolved.begin() + int(out_size) - 1, out_convolved + 1);
-
-    // Finally some cleanup.
-    kiss_fftr_free(fftConfig);
-    kiss_fftr_free(ifftConfig);
+    convolveSpectra(plans, leftFFT.data(), rightFFT.data(), size, out_convolved, leftSize + rightSize + 1);
 
     qCDebug(KDENLIVE_LOG) << "FFT convolution computed. Time taken: " << time.elapsed() << " ms";
 }
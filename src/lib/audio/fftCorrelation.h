@@ -5,16 +5,52 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #pragma once
 
+#include <QMutex>
 #include <QtGlobal>
+#include <map>
+#include <memory>
+#include <vector>
+
+class FFTPlanCache;
+
 /** @class FFTCorrelation
     @brief This class provides methods to calculate convolution
     and correlation of two vectors by means of FFT, which
     is O(n log n) (convolution in spacial domain would be
     O(n²)).
+
+    FFT plans are cached by the Reference, so correlating
+    many vectors against it does not allocate a plan for each
+    of them.
   */
 class FFTCorrelation
 {
 public:
+    /**
+      A vector that is correlated against several others, like
+      the reference clip when aligning a batch of clips. It is
+      normalized once, and its spectrum is computed once per FFT size.
+      Can be shared by several threads.
+      */
+    class Reference
+    {
+    public:
+        Reference(const qint64 *data, size_t size);
+        ~Reference();
+        size_t size() const;
+
+    private:
+        friend class FFTCorrelation;
+        /** @brief Spectrum of the data zero padded to @p fftSize, as interleaved real and imaginary parts */
+        const std::vector<float> &spectrum(size_t fftSize) const;
+
+        std::vector<float> m_normalized;
+        mutable QMutex m_mutex;
+        mutable std::map<size_t, std::vector<float>> m_spectra;
+        /** @brief Plans used to correlate against this reference, freed with it */
+        std::unique_ptr<FFTPlanCache> m_plans;
+    };
+
     /**
       Computes the convolution between \c left and \c right.
       \c out_correlated must be a pre-allocated vector of size
@@ -30,4 +66,11 @@ public:
     static void correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, float *out_correlated);
 
     static void correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, qint64 *out_correlated);
+
+    /**
+      Same as above, reusing the spectrum of \c left.
+      \c out_correlated must be a pre-allocated vector of size
+      \c left.size() + \c rightSize + 1.
+      */
+    static void correlate(const Reference &left, const qint64 *right, const size_t rightSize, qint64 *out_correlated);
 };
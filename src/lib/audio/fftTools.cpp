@@ -9,6 +9,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 #include <QString>
 
@@ -107,13 +108,17 @@ const QVector<float> FFTTools::window(const WindowType windowType, const int siz
 
 void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint channel, const uint numChannels, float *freqSpectrum, const WindowType windowType,
                              const uint windowSize, const float param)
+{
+    fftNormalized(QVector<audioShortVector>{audioFrame}, channel, numChannels, freqSpectrum, windowType, windowSize, param);
+}
+
+void FFTTools::fftNormalized(const QVector<audioShortVector> &audioFrames, const uint channel, const uint numChannels, float *freqSpectra,
+                             const WindowType windowType, const uint windowSize, const float param)
 {
 #ifdef DEBUG_FFTTOOLS
     QTime start = QTime::currentTime();
 #endif
 
-    const uint numSamples = uint(audioFrame.size()) / numChannels;
-
     if (((windowSize & 1) != 0u) || windowSize < 2) {
         return;
     }
@@ -158,40 +163,45 @@ void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint chan
         windowScaleFactor = 1.0f / window[int(windowSize)];
     }
 
-    // Prepare frequency space vector. The resulting FFT vector is only half as long.
-    auto *freqData = new kiss_fft_cpx[size_t(windowSize) / 2];
-    auto *data = new float[size_t(windowSize)];
+    // Logarithmic scale: 20 * log ( 2 * magnitude / N ) with magnitude = sqrt(r² + i²)
+    // with N = FFT size (after FFT, 1/2 window size).
+    // This is 10 * log(r² + i²) plus a constant, which avoids the square root and powf calls per value.
+    const float dbOffset = 20.f * log10f(windowScaleFactor / (float(windowSize) / 2.0f));
 
-    // Copy the first channel's audio into a vector for the FFT display;
-    // Fill the data vector indices that cannot be covered with sample data with 0
-    if (numSamples < windowSize) {
-        std::fill(&data[numSamples], &data[windowSize - 1], 0);
-    }
-    // Normalize signals to [0,1] to get correct dB values later on
-    for (uint i = 0; i < numSamples && i < windowSize; ++i) {
-        // Performance note: Benchmarking has shown that using the if/else inside the loop
-        // does not do noticeable worse than keeping it outside (perhaps the branch predictor
-        // is good enough), so it remains in there for better readability.
+    // Prepare frequency space vector. The resulting FFT vector is only half as long.
+    // The buffers are shared by all frames of the batch.
+    std::vector<kiss_fft_cpx> freqData(size_t(windowSize) / 2);
+    std::vector<float> data(size_t(windowSize));
+
+    for (int frame = 0; frame < audioFrames.size(); ++frame) {
+        const audioShortVector &audioFrame = audioFrames.at(frame);
+        const uint numSamples = uint(audioFrame.size()) / numChannels;
+        const qint16 *samples = audioFrame.constData();
+        float *freqSpectrum = freqSpectra + size_t(frame) * (windowSize / 2);
+
+        // Copy the requested channel's audio into a vector for the FFT display;
+        // Fill the data vector indices that cannot be covered with sample data with 0
+        if (numSamples < windowSize) {
+            std::fill(data.begin() + numSamples, data.end(), 0.f);
+        }
+        // Normalize signals to [0,1] to get correct dB values later on
+        const uint count = qMin(numSamples, windowSize);
         if (windowType != FFTTools::Window_Rect) {
-            data[i] = float(audioFrame.data()[i * numChannels + channel]) / 32767.0f * window[int(i)];
+            for (uint i = 0; i < count; ++i) {
+                data[i] = float(samples[i * numChannels + channel]) / 32767.0f * window[int(i)];
+            }
         } else {
-            data[i] = float(audioFrame.data()[i * numChannels + channel]) / 32767.0f;
+            for (uint i = 0; i < count; ++i) {
+                data[i] = float(samples[i * numChannels + channel]) / 32767.0f;
+            }
         }
-    }
 
-    // Calculate the Fast Fourier Transform for the input data
-    kiss_fftr(myCfg, data, freqData);
+        // Calculate the Fast Fourier Transform for the input data
+        kiss_fftr(myCfg, data.data(), freqData.data());
 
-    // Logarithmic scale: 20 * log ( 2 * magnitude / N ) with magnitude = sqrt(r² + i²)
-    // with N = FFT size (after FFT, 1/2 window size)
-    for (uint i = 0; i < windowSize / 2; ++i) {
-        // Logarithmic scale: 20 * log ( 2 * magnitude / N ) with magnitude = sqrt(r² + i²)
-        // with N = FFT size (after FFT, 1/2 window size)
-        freqSpectrum[i] =
-            20 *
-            logf(powf(powf(fabs(freqData[i].r * windowScaleFactor), 2) + powf(fabs(freqData[i].i * windowScaleFactor), 2), .5) / (float(windowSize) / 2.0f)) /
-            logf(10);
-        ;
+        for (uint i = 0; i < windowSize / 2; ++i) {
+            freqSpectrum[i] = 10.f * log10f(freqData[i].r * freqData[i].r + freqData[i].i * freqData[i].i) + dbOffset;
+        }
     }
 
 #ifdef DEBUG_FFTTOOLS
@@ -219,21 +229,24 @@ void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint chan
 #endif
 
 #ifdef DEBUG_FFTTOOLS
-    qCDebug(KDENLIVE_LOG) << "Calculated FFT in " << start.elapsed() << " ms.";
+    qCDebug(KDENLIVE_LOG) << "Calculated " << audioFrames.size() << " FFTs in " << start.elapsed() << " ms.";
 #endif
-    delete[] freqData;
-    delete[] data;
 }
 
 const QVector<float> FFTTools::interpolatePeakPreserving(const QVector<float> &in, const uint targetSize, uint left, uint right, float fill)
+{
+    return interpolatePeakPreserving(in.constData(), in.size(), targetSize, left, right, fill);
+}
+
+const QVector<float> FFTTools::interpolatePeakPreserving(const float *in, const int size, const uint targetSize, uint left, uint right, float fill)
 {
 #ifdef DEBUG_FFTTOOLS
     QTime start = QTime::currentTime();
 #endif
 
     if (right == 0) {
-        Q_ASSERT(in.size() > 0);
-        right = uint(in.size()) - 1;
+        Q_ASSERT(size > 0);
+        right = uint(size) - 1;
     }
     Q_ASSERT(targetSize > 0);
     Q_ASSERT(left < right);
@@ -255,14 +268,14 @@ const QVector<float> FFTTools::interpolatePeakPreserving(const QVector<float> &i
             x = float(i) / (targetSize - 1) * (right - left) + left;
             xi = int(floor(x));
 
-            if (x > float(in.size() - 1)) {
-                // This may happen if right > in.size()-1; Fill the rest of the vector
+            if (x > float(size - 1)) {
+                // This may happen if right > size-1; Fill the rest of the vector
                 // with the default value now.
                 break;
             }
 
             // Use linear interpolation in order to get smoother display
-            if (xi == 0 || xi == in.size() - 1) {
+            if (xi == 0 || xi == size - 1) {
                 // ... except if we are at the left or right border of the input signal.
                 // Special case here since we consider previous and future values as well for
                 // the actual interpolation (not possible here).
@@ -296,7 +309,7 @@ const QVector<float> FFTTools::interpolatePeakPreserving(const QVector<float> &i
 
             out[i] = fill;
 
-            for (; src < xi && src < in.size(); ++src) {
+            for (; src < xi && src < size; ++src) {
                 if (out[i] < in[src]) {
                     out[i] = in[src];
                 }
@@ -312,7 +325,7 @@ const QVector<float> FFTTools::interpolatePeakPreserving(const QVector<float> &i
     }
 
 #ifdef DEBUG_FFTTOOLS
-    qCDebug(KDENLIVE_LOG) << "Interpolated " << targetSize << " nodes from " << in.size() << " input points in " << start.elapsed() << " ms";
+    qCDebug(KDENLIVE_LOG) << "Interpolated " << targetSize << " nodes from " << size << " input points in " << start.elapsed() << " ms";
 #endif
 
     return out;
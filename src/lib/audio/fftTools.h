@@ -53,6 +53,13 @@ public:
     void fftNormalized(const audioShortVector &audioFrame, const uint channel, const uint numChannels, float *freqSpectrum, const WindowType windowType,
                        const uint windowSize, const float param = 0);
 
+    /** Calculates the Fourier Transformation of several audio frames, like the function above does for one frame.
+        The FFT configuration, the window function and the buffers are only looked up once for the whole batch.
+        * freqSpectra has to be of size audioFrames.size() * windowSize/2, the spectrum of frame k starts at k * windowSize/2
+    */
+    void fftNormalized(const QVector<audioShortVector> &audioFrames, const uint channel, const uint numChannels, float *freqSpectra,
+                       const WindowType windowType, const uint windowSize, const float param = 0);
+
     /** This is linear interpolation with the special property that it preserves peaks, which is required
         for e.g. showing correct Decibel values (where the peak values are of interest because of clipping which
         may occur for too strong frequencies; The lower values are smeared by the window function anyway).
@@ -68,6 +75,9 @@ public:
                             will be used for filling the missing information.
         */
     static const QVector<float> interpolatePeakPreserving(const QVector<float> &in, const uint targetSize, uint left = 0, uint right = 0, float fill = 0.0);
+    /** Same as above, for the @p size values starting at @p in */
+    static const QVector<float> interpolatePeakPreserving(const float *in, const int size, const uint targetSize, uint left = 0, uint right = 0,
+                                                          float fill = 0.0);
 
 private:
     QHash<QString, kiss_fftr_cfg> m_fftCfgs;          // FFT cfg cache
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <QReadWriteLock>
+
 /** This file contains a collection of macros that can be used in model related classes.
     The class only needs to have the following members:
     - For Push_undo : std::weak_ptr<DocUndoStack> m_undoStack;  this is a pointer to the undoStack
@@ -28,20 +30,48 @@
         return res_lambda;                                                                                                                                     \
     };
 
+/** @brief Scoped lock used by READ_LOCK(), living on the stack.
+    In the default mode, the write lock is taken if it is free or already owned by the current thread,
+    and the read lock otherwise. This allows a thread executing a write operation to read a
+    Read-protected property, since the recursive write lock is granted again.
+    In shared mode, a read lock is taken first so that several threads can read at the same time.
+    The write lock is only used if another write holds the lock, which can only be the current thread
+    when it succeeds. A function using the shared mode must not take the write lock while it runs.
+*/
+class ReadLockGuard
+{
+public:
+    enum class Mode { PreferWrite, Shared };
+
+    explicit ReadLockGuard(QReadWriteLock &lock, Mode mode = Mode::PreferWrite)
+        : m_lock(lock)
+    {
+        if (mode == Mode::Shared && m_lock.tryLockForRead()) {
+            return;
+        }
+        if (!m_lock.tryLockForWrite()) {
+            m_lock.lockForRead();
+        }
+    }
+    ~ReadLockGuard() { m_lock.unlock(); }
+    ReadLockGuard(const ReadLockGuard &) = delete;
+    ReadLockGuard &operator=(const ReadLockGuard &) = delete;
+
+private:
+    QReadWriteLock &m_lock;
+};
+
 /** This convenience macro locks the mutex for reading.
 Note that it might happen that a thread is executing a write operation that requires
 reading a Read-protected property. In that case, we try to write lock it first (this will be granted since the lock is recursive)
 */
-#define READ_LOCK()                                                                                                                                            \
-    std::unique_ptr<QReadLocker> rlocker(new QReadLocker(nullptr));                                                                                            \
-    std::unique_ptr<QWriteLocker> wlocker(new QWriteLocker(nullptr));                                                                                          \
-    if (m_lock.tryLockForWrite()) {                                                                                                                            \
-        /*we yield ownership of the lock to the WriteLocker*/                                                                                                  \
-        m_lock.unlock();                                                                                                                                       \
-        wlocker.reset(new QWriteLocker(&m_lock));                                                                                                              \
-    } else {                                                                                                                                                   \
-        rlocker.reset(new QReadLocker(&m_lock));                                                                                                               \
-    }
+#define READ_LOCK() ReadLockGuard rlocker(m_lock)
+
+/** Same as READ_LOCK() but lets concurrent readers in, for the getters called very often (for example
+    by the timeline view during a drag). Only use it in functions that never take the write lock, even
+    indirectly, since a thread cannot get the write lock while it holds a read lock.
+*/
+#define READ_LOCK_SHARED() ReadLockGuard rlocker(m_lock, ReadLockGuard::Mode::Shared)
 
 /** @brief This macro takes some lambdas that represent undo/redo for an operation and the text (name) associated with this operation
  * The lambdas are transformed to make sure they lock access to the class they operate on.
@@ -26,6 +26,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "docktitlebarmanager.h"
 #include "effects/effectbasket.h"
 #include "effects/effectlist/view/effectlistwidget.hpp"
+#include "effects/effectsrepository.hpp"
 #include "jobs/audiolevelstask.h"
 #include "jobs/customjobtask.h"
 #include "jobs/scenesplittask.h"
@@ -220,6 +221,9 @@ void MainWindow::init(const QString &mltPath)
 #endif
     QString defaultProfile = KdenliveSettings::default_profile();
 
+    // Read the assets snapshots while MLT loads its modules
+    EffectsRepository::preloadCache();
+    TransitionsRepository::preloadCache();
     // Initialise MLT connection
     MltConnection::construct(mltPath);
     pCore->setCurrentProfile(defaultProfile.isEmpty() ? ProjectManager::getDefaultProjectFormat() : defaultProfile);
@@ -976,7 +980,7 @@ bool MainWindow::queryClose()
                                                          i18np("You have 1 rendering job waiting in the queue.\nWhat do you want to do with this job?",
                                                                "You have %1 rendering jobs waiting in the queue.\nWhat do you want to do with these jobs?",
                                                                waitingJobs),
-                                                         QString(), KGuiItem(i18n("Start them now")), KGuiItem(i18n("Delete them")))) {
+                                                         QString(), KGuiItem(i18n("Start them now")), KGuiItem(i18n("Keep them for next session")))) {
             case KMessageBox::PrimaryAction:
                 // create script with waiting jobs and start it
                 if (!m_renderWidget->startWaitingRenderJobs()) {
@@ -984,7 +988,7 @@ bool MainWindow::queryClose()
                 }
                 break;
             case KMessageBox::SecondaryAction:
-                // Don't do anything, jobs will be deleted
+                // Jobs are saved with the render queue and restored on next start
                 break;
             default:
                 return false;
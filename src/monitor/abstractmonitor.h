@@ -7,6 +7,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #pragma once
 
 #include "definitions.h"
+#include "scopes/sharedframe.h"
 
 #include <cstdint>
 
@@ -87,6 +88,8 @@ protected:
 Q_SIGNALS:
     /** @brief Send a frame for analysis or title background display. */
     void frameUpdated(const QImage &);
+    /** @brief Send a displayed frame to the color scopes, which read its YUV data */
+    void scopeFrameUpdated(const SharedFrame &);
     /** @brief This signal contains the audio of the current frame. */
     void audioSamplesSignal(const audioShortVector &, int, int, int);
     /** @brief Scopes are ready to receive a new frame. */
@@ -40,6 +40,7 @@
 #include "glwidget.h"
 #include "monitorproxy.h"
 #include "profiles/profilemodel.hpp"
+#include "scopes/colorscopes/scopeanalyzer.h"
 #include "timeline2/view/qml/timelineitems.h"
 #include "timeline2/view/qmltypes/thumbnailprovider.h"
 #include <lib/localeHandling.h>
@@ -76,6 +77,7 @@ using namespace Mlt;
 GLWidget::GLWidget(int id, QWidget *parent)
     : QQuickWidget(parent)
     , sendFrameForAnalysis(false)
+    , sendFrameForScopes(false)
     , m_glslManager(nullptr)
     , m_consumer(nullptr)
     , m_producer(nullptr)
@@ -1284,10 +1286,15 @@ void GLWidget::setZoom(float zoom, bool force)
 
 void GLWidget::onFrameDisplayed(const SharedFrame &frame)
 {
+    // Scopes read YUV frames directly, the displayed image only has to be grabbed for frames living on the GPU
+    const bool scopesReadFrame = sendFrameForScopes && ScopeAnalyzer::canAnalyse(frame);
     m_contextSharedAccess.lock();
     m_sharedFrame = frame;
-    m_sendFrame = sendFrameForAnalysis;
+    m_sendFrame = sendFrameForAnalysis || (sendFrameForScopes && !scopesReadFrame);
     m_contextSharedAccess.unlock();
+    if (scopesReadFrame && m_analyseSem.tryAcquire(1)) {
+        Q_EMIT analyseSharedFrame(frame);
+    }
     quickWindow()->update();
 }
 
@@ -90,6 +90,9 @@ public:
     QRect displayRect() const;
     /** @brief set to true if we want to emit a QImage of the frame for analysis */
     bool sendFrameForAnalysis;
+    /** @brief set to true if the color scopes want the displayed frames. Frames in a YUV format are sent as they are,
+     *  others are rendered to a QImage like for sendFrameForAnalysis */
+    bool sendFrameForScopes;
     /** @brief delete and rebuild consumer, for example when external display is switched */
     void resetConsumer(bool fullReset);
     void lockMonitor();
@@ -172,6 +175,7 @@ Q_SIGNALS:
     void mouseSeek(int eventDelta, uint modifiers);
     void startDrag();
     void analyseFrame(const QImage &);
+    void analyseSharedFrame(const SharedFrame &);
     void showContextMenu(const QPoint &);
     void lockMonitor(bool);
     void passKeyEvent(QKeyEvent *);
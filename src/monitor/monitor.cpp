@@ -409,6 +409,7 @@ Monitor::Monitor(Kdenlive::MonitorId id, MonitorManager *manager, QWidget *paren
 
     connect(this, &Monitor::scopesClear, m_glMonitor, &GLWidget::releaseAnalyse, Qt::DirectConnection);
     connect(m_glMonitor, &GLWidget::analyseFrame, this, &Monitor::frameUpdated);
+    connect(m_glMonitor, &GLWidget::analyseSharedFrame, this, &Monitor::scopeFrameUpdated);
     m_timePos = new TimecodeDisplay(this);
 
     if (id == Kdenlive::ProjectMonitor) {
@@ -2124,7 +2125,7 @@ void Monitor::slotSetVolume(int volume)
 
 void Monitor::sendFrameForAnalysis(bool analyse)
 {
-    m_glMonitor->sendFrameForAnalysis = analyse;
+    m_glMonitor->sendFrameForScopes = analyse;
 }
 
 void Monitor::updateAudioForAnalysis()
@@ -36,7 +36,7 @@ BackupWidget::BackupWidget(const QUrl &projectUrl, QUrl projectFolder, const QSt
     m_projectWildcard.append(QStringLiteral("-??"));
     m_projectWildcard.append(QStringLiteral("-??"));
     m_projectWildcard.append(QStringLiteral("-??"));
-    m_projectWildcard.append(QStringLiteral("-??.kdenlive"));
+    m_projectWildcard.append(QStringLiteral("-??"));
 
     slotParseBackupFiles();
     connect(backup_list, &QListWidget::currentRowChanged, this, &BackupWidget::slotDisplayBackupPreview);
@@ -51,7 +51,8 @@ void BackupWidget::slotParseBackupFiles()
 {
     QLocale locale;
     QStringList filter;
-    filter << m_projectWildcard;
+    // Backups stored as a delta against a previous backup use their own extension
+    filter << m_projectWildcard + QStringLiteral(".kdenlive") << m_projectWildcard + QStringLiteral(".kdenlivedelta");
     backup_list->clear();
 
     // Parse new XDG backup folder $HOME/.local/share/kdenlive/.backup
@@ -95,7 +96,10 @@ void BackupWidget::slotDisplayBackupPreview()
         backup_preview->setPixmap(QPixmap());
         return;
     }
-    const QString path = backup_list->currentItem()->data(Qt::UserRole).toString();
+    QString path = backup_list->currentItem()->data(Qt::UserRole).toString();
+    if (path.endsWith(QStringLiteral(".kdenlivedelta"))) {
+        path.chop(5);
+    }
     QPixmap pix(path + QStringLiteral(".png"));
     backup_preview->setPixmap(pix);
 }
@@ -8,6 +8,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "bin/projectclip.h"
 #include "bin/projectitemmodel.h"
 #include "core.h"
+#include "doc/backupdelta.h"
 #include "doc/docundostack.hpp"
 #include "doc/kdenlivedoc.h"
 #include "jobs/cliploadtask.h"
@@ -438,6 +439,7 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
 bool ProjectManager::saveFileAs(const QString &outputFileName, bool saveACopy)
 {
     pCore->monitorManager()->pauseActiveMonitor();
+    m_project->waitForAutoSave();
     QString oldProjectFolder =
         m_project->url().isEmpty() ? QString() : QFileInfo(m_project->url().toLocalFile()).absolutePath() + QStringLiteral("/cachefiles");
     // this was the old project folder in case the "save in project file location" setting was active
@@ -579,6 +581,7 @@ bool ProjectManager::saveFile()
         return saveFileAs();
     }
     bool result = saveFileAs(m_project->url().toLocalFile());
+    m_project->waitForAutoSave();
     m_project->m_autosave->resize(0);
     return result;
 }
@@ -910,7 +913,13 @@ bool ProjectManager::slotOpenBackup(const QUrl &url)
     bool result = false;
     QPointer<BackupWidget> dia = new BackupWidget(projectFile, projectFolder, projectId, pCore->window());
     if (dia->exec() == QDialog::Accepted) {
-        QString requestedBackup = dia->selectedFile();
+        // Backups can be stored as a delta, rebuild the full project
+        QString requestedBackup = BackupDelta::restore(dia->selectedFile());
+        if (requestedBackup.isEmpty()) {
+            KMessageBox::error(pCore->window(), i18n("Cannot restore backup file %1", dia->selectedFile()));
+            delete dia;
+            return false;
+        }
         if (m_project) {
             m_project->backupLastSavedVersion(projectFile.toLocalFile());
             closeCurrentDocument(false);
@@ -949,22 +958,16 @@ void ProjectManager::slotStartAutoSave()
 
 void ProjectManager::slotAutoSave()
 {
-    prepareSave();
-    QString saveFolder = m_project->url().adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash).toLocalFile();
-    QString scene = projectSceneList(saveFolder);
-    if (!m_replacementPattern.isEmpty()) {
-        QMapIterator<QString, QString> i(m_replacementPattern);
-        while (i.hasNext()) {
-            i.next();
-            scene.replace(i.key(), i.value());
-        }
-    }
-    if (!scene.contains(QLatin1String("<track "))) {
-        // In some unexplained cases, the MLT playlist is corrupted and all tracks are deleted. Don't save in that case.
-        pCore->displayMessage(i18n("Project was corrupted, cannot backup. Please close and reopen your project file to recover last backup"), ErrorMessage);
+    if (pCore->monitorManager()->isTrimming()) {
+        // Saving would leave the trimming mode, wait until the user is done
+        m_autoSaveTimer.start(3000);
         return;
     }
-    m_project->slotAutoSave(scene);
+    prepareSave();
+    QString saveFolder = m_project->url().adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash).toLocalFile();
+    // The MLT graph can only be serialized here, the resulting xml is then processed and written in a worker thread
+    const QString scene = projectSceneList(saveFolder);
+    m_project->slotAutoSave(scene, m_replacementPattern);
     m_lastSave.start();
 }
 
@@ -68,6 +68,11 @@ void RenderRequest::setAudioFilePerTrack(bool enabled)
     m_audioFilePerTrack = enabled;
 }
 
+void RenderRequest::setSegmentedRendering(int segmentLength)
+{
+    m_segmentLength = qMax(0, segmentLength);
+}
+
 void RenderRequest::setGuideParams(std::weak_ptr<MarkerListModel> model, bool enableMultiExport, int filterCategory)
 {
     m_guidesModel = std::move(model);
@@ -176,7 +181,17 @@ std::vector<RenderRequest::RenderJob> RenderRequest::process()
         // set parameters
         setDocGeneralParams(sectionDoc, section.in, section.out);
 
+        const size_t firstJob = jobs.size();
         createRenderJobs(jobs, sectionDoc, newPlaylistPath, outputPath, subtitleFile);
+
+        // Video segments are concatenated without re-encoding, which is not possible for image sequences and 2 pass encoding
+        if (m_segmentLength > 0 && !m_twoPass && !m_delayedRendering && !m_presetParams.isImageSequence() && jobs.size() > firstJob) {
+            QStringList segments;
+            for (const auto &segment : getSegments(section.in, section.out)) {
+                segments << QStringLiteral("%1-%2").arg(segment.in).arg(segment.out);
+            }
+            jobs.back().segments = segments.join(QLatin1Char(','));
+        }
     }
 
     return jobs;
@@ -396,6 +411,46 @@ std::vector<RenderRequest::RenderSection> RenderRequest::getGuideSections()
     return sections;
 }
 
+std::vector<RenderRequest::RenderSection> RenderRequest::getSegments(int in, int out) const
+{
+    std::vector<RenderSection> segments;
+    if (m_segmentLength <= 0 || out - in + 1 < 2 * m_segmentLength) {
+        return segments;
+    }
+    // Guides are preferred cut points, as long as the segment keeps at least half of the requested length
+    const int minLength = m_segmentLength / 2;
+    QList<int> guides;
+    if (auto ptr = m_guidesModel.lock()) {
+        double fps = pCore->getCurrentFps();
+        for (const auto &marker : ptr->getAllMarkers()) {
+            guides << marker.time().frames(fps);
+        }
+        std::sort(guides.begin(), guides.end());
+    }
+    int start = in;
+    while (start <= out) {
+        int end = start + m_segmentLength;
+        for (int guide : qAsConst(guides)) {
+            if (guide > start + m_segmentLength) {
+                break;
+            }
+            if (guide >= start + minLength) {
+                end = guide;
+            }
+        }
+        if (out + 1 - end < minLength) {
+            // Don't leave a tiny segment at the end
+            end = out + 1;
+        }
+        RenderSection segment;
+        segment.in = start;
+        segment.out = end - 1;
+        segments.push_back(segment);
+        start = end;
+    }
+    return segments;
+}
+
 void RenderRequest::prepareMultiAudioFiles(std::vector<RenderJob> &jobs, const QDomDocument &doc, const QString &playlistFile, const QString &targetFile)
 {
     int audioCount = 0;
@@ -18,6 +18,8 @@ public:
         QString playlistPath;
         QString outputPath;
         QString subtitlePath;
+        /** @brief Comma separated in-out ranges encoded by parallel processes and concatenated afterwards, empty to encode in one go */
+        QString segments;
     };
 
     /** @brief Set frame range that should be rendered
@@ -32,6 +34,10 @@ public:
     void setEmbedSubtitles(bool enabled);
     void setTwoPass(bool enabled);
     void setAudioFilePerTrack(bool enabled);
+    /** @brief Encode the render range as several segments in parallel, each segment being
+     *  about @param segmentLength frames long and ending on a guide if there is one close enough.
+     *  A value of 0 disables segmented rendering. */
+    void setSegmentedRendering(int segmentLength);
     void setGuideParams(std::weak_ptr<MarkerListModel> model, bool enableMultiExport, int filterCategory);
     void setOverlayData(const QString &data);
 
@@ -60,12 +66,16 @@ private:
     bool m_guideMultiExport = false;
     int m_guideCategory = -1; /// category used as filter if @variable guideMultiExport is @value true
     bool m_twoPass = false;
+    int m_segmentLength = 0;
 
     QStringList m_errors;
 
     void setDocGeneralParams(QDomDocument doc, int in, int out);
     void setDocTwoPassParams(int pass, QDomDocument &doc, const QString &outputFile);
     std::vector<RenderSection> getGuideSections();
+    /** @brief Split the range from @param in to @param out into segments for parallel encoding.
+     *  Returns an empty list if the range is too short to be split. */
+    std::vector<RenderSection> getSegments(int in, int out) const;
     static void prepareMultiAudioFiles(std::vector<RenderJob> &jobs, const QDomDocument &doc, const QString &playlistFile, const QString &targetFile);
 
     static QString createEmptyTempFile(const QString &extension);
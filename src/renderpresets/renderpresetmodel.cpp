@@ -145,6 +145,49 @@ bool RenderPresetParams::isX265()
     return value(QStringLiteral("vcodec")).toLower() == QStringLiteral("libx265");
 }
 
+int RenderPresetParams::encodingCost(const QSize &frameSize, int maxCost) const
+{
+    maxCost = qMax(1, maxCost);
+    if (value(QStringLiteral("vn")) == QLatin1String("1")) {
+        // Audio only
+        return 1;
+    }
+    const QString vcodec = value(QStringLiteral("vcodec")).toLower();
+    static const QStringList hwSuffixes = {QStringLiteral("_nvenc"), QStringLiteral("_vaapi"), QStringLiteral("_qsv"), QStringLiteral("_amf"),
+                                           QStringLiteral("_videotoolbox")};
+    for (const QString &suffix : hwSuffixes) {
+        if (vcodec.endsWith(suffix)) {
+            return 1;
+        }
+    }
+    // A 1080p H.264 encode keeps about 4 cores busy
+    double scale = 1.;
+    if (contains(QStringLiteral("scale"))) {
+        scale = value(QStringLiteral("scale")).toDouble();
+        if (scale <= 0.) {
+            scale = 1.;
+        }
+    }
+    double cost = 4. * frameSize.width() * frameSize.height() * scale * scale / (1920. * 1080.);
+    static const QStringList slowCodecs = {QStringLiteral("libx265"), QStringLiteral("libaom-av1"), QStringLiteral("libsvtav1"), QStringLiteral("librav1e"),
+                                           QStringLiteral("libvpx-vp9")};
+    static const QStringList intraCodecs = {QStringLiteral("prores"),   QStringLiteral("prores_ks"), QStringLiteral("dnxhd"), QStringLiteral("mjpeg"),
+                                            QStringLiteral("huffyuv"),  QStringLiteral("ffv1"),      QStringLiteral("utvideo"), QStringLiteral("png"),
+                                            QStringLiteral("qtrle")};
+    if (slowCodecs.contains(vcodec)) {
+        cost *= 2.;
+    } else if (intraCodecs.contains(vcodec)) {
+        cost /= 2.;
+    }
+    int result = qBound(1, qRound(cost), maxCost);
+    // The encoder will not use more threads than requested
+    const int threads = value(QStringLiteral("threads")).toInt();
+    if (threads > 0) {
+        result = qMin(result, threads + 1);
+    }
+    return result;
+}
+
 RenderPresetModel::RenderPresetModel(QDomElement preset, const QString &presetFile, bool editable, const QString &groupName, const QString &renderer)
     : m_presetFile(presetFile)
     , m_editable(editable)
@@ -8,6 +8,7 @@
 
 #include <KLocalizedString>
 #include <QDomElement>
+#include <QSize>
 #include <QString>
 #include <memory>
 
@@ -26,6 +27,9 @@ public:
     bool hasAlpha();
     bool isImageSequence();
     bool isX265();
+    /** @brief Rough estimate of the number of processor cores kept busy when encoding a @param frameSize
+     *  project with these parameters, between 1 and @param maxCost. Used to run several render jobs at once. */
+    int encodingCost(const QSize &frameSize, int maxCost) const;
 };
 
 /** @class RenderPresetModel
@@ -32,6 +32,13 @@ void AbstractAudioScopeWidget::slotReceiveAudio(const audioShortVector &sampleDa
     m_freq = freq;
     m_nChannels = num_channels;
     m_nSamples = num_samples;
+    if (m_audioQueueSize > 0) {
+        QMutexLocker lock(&m_queueMutex);
+        m_audioQueue << sampleData;
+        if (m_audioQueue.size() > m_audioQueueSize) {
+            m_audioQueue.remove(0, m_audioQueue.size() - m_audioQueueSize);
+        }
+    }
 
     m_newData.fetchAndAddAcquire(1);
 
@@ -47,6 +54,21 @@ QImage AbstractAudioScopeWidget::renderScope(uint accelerationFactor)
     return renderAudioScope(accelerationFactor, m_audioFrame, m_freq, m_nChannels, m_nSamples, newData);
 }
 
+void AbstractAudioScopeWidget::setAudioFrameQueueSize(int count)
+{
+    QMutexLocker lock(&m_queueMutex);
+    m_audioQueueSize = count;
+    m_audioQueue.clear();
+}
+
+QVector<audioShortVector> AbstractAudioScopeWidget::takeAudioFrames()
+{
+    QMutexLocker lock(&m_queueMutex);
+    QVector<audioShortVector> frames;
+    frames.swap(m_audioQueue);
+    return frames;
+}
+
 #ifdef DEBUG_AASW
 #undef DEBUG_AASW
 #endif
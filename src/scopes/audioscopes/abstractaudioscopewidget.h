@@ -7,6 +7,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #pragma once
 
+#include <QMutex>
 #include <QWidget>
 
 #include <cstdint>
@@ -40,6 +41,12 @@ protected:
     virtual QImage renderAudioScope(uint accelerationFactor, const audioShortVector &audioFrame, const int freq, const int num_channels, const int num_samples,
                                     const int newData) = 0;
 
+    /** @brief Keep up to @p count audio frames received between two renderings, see takeAudioFrames().
+        By default only the last frame is kept. */
+    void setAudioFrameQueueSize(int count);
+    /** @brief Returns the audio frames received since the last call, oldest first */
+    QVector<audioShortVector> takeAudioFrames();
+
     int m_freq{0};
     int m_nChannels{0};
     int m_nSamples{0};
@@ -47,4 +54,7 @@ protected:
 private:
     audioShortVector m_audioFrame;
     QAtomicInt m_newData;
+    QMutex m_queueMutex;
+    QVector<audioShortVector> m_audioQueue;
+    int m_audioQueueSize{0};
 };
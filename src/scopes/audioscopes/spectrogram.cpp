@@ -20,6 +20,10 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 // highest vertical screen resolution available for complete reconstruction.
 // Can be less as a pre-rendered image is kept in space.
 #define SPECTROGRAM_HISTORY_SIZE 1000
+// Number of audio frames kept when they arrive faster than the spectrogram is rendered
+#define SPECTROGRAM_QUEUE_SIZE 50
+// Resolution of the dB to color table, in steps per dB
+#define SPECTROGRAM_DB_STEPS 8
 
 // Uncomment for debugging
 //#define DEBUG_SPECTROGRAM
@@ -36,7 +40,7 @@ Spectrogram::Spectrogram(QWidget *parent)
     : AbstractAudioScopeWidget(true, parent)
     , m_fftTools()
     , m_fftHistory()
-    , m_fftHistoryImg()
+    , m_historyImg()
 
 {
     m_ui = new Ui::Spectrogram_UI;
@@ -77,6 +81,7 @@ Spectrogram::Spectrogram(QWidget *parent)
     connect(this, &Spectrogram::signalMousePositionChanged, this, &Spectrogram::forceUpdateHUD);
 
     AbstractScopeWidget::init();
+    setAudioFrameQueueSize(SPECTROGRAM_QUEUE_SIZE);
 
     for (int i = 0; i <= 255 / 5; ++i) {
         m_colorMap[i + 0 * 255 / 5] = qRgb(0, 0, i * 5);         // black to blue
@@ -323,21 +328,38 @@ QImage Spectrogram::renderAudioScope(uint, const audioShortVector &audioFrame, c
         // Show the window size used, for information
         m_ui->labelFFTSizeNumber->setText(QVariant(fftWindow).toString());
 
+        // This method might be called also when a simple refresh is required.
+        // In this case there is no data to append to the history. Only append new data.
+        int newLines = 0;
         if (newDataAvailable) {
-
-            auto *freqSpectrum = new float[uint(fftWindow / 2)];
+            QVector<audioShortVector> frames = takeAudioFrames();
+            if (frames.isEmpty()) {
+                frames << audioFrame;
+            } else if (frames.size() > SPECTROGRAM_HISTORY_SIZE) {
+                frames = frames.mid(frames.size() - SPECTROGRAM_HISTORY_SIZE);
+            }
+            const int bins = fftWindow / 2;
+            if (bins != m_fftBins) {
+                // Spectra of different sizes cannot share the ring buffer, start a new history
+                m_fftBins = bins;
+                m_fftHistory = QVector<float>(SPECTROGRAM_HISTORY_SIZE * bins);
+                m_historyHead = 0;
+                m_historyCount = 0;
+                m_parameterChanged = true;
+            }
 
             // Get the spectral power distribution of the input samples,
             // using the given window size and function
+            QVector<float> spectra(frames.size() * bins);
             FFTTools::WindowType windowType = FFTTools::WindowType(m_ui->windowFunction->itemData(m_ui->windowFunction->currentIndex()).toInt());
-            m_fftTools.fftNormalized(audioFrame, 0, uint(num_channels), freqSpectrum, windowType, uint(fftWindow), 0);
-
-            // This method might be called also when a simple refresh is required.
-            // In this case there is no data to append to the history. Only append new data.
-            QVector<float> spectrumVector(fftWindow / 2);
-            memcpy(spectrumVector.data(), &freqSpectrum[0], uint(fftWindow) / 2 * sizeof(float));
-            m_fftHistory.prepend(spectrumVector);
-            delete[] freqSpectrum;
+            m_fftTools.fftNormalized(frames, 0, uint(num_channels), spectra.data(), windowType, uint(fftWindow), 0);
+
+            for (int i = 0; i < frames.size(); ++i) {
+                m_historyHead = (m_historyHead + 1) % SPECTROGRAM_HISTORY_SIZE;
+                memcpy(m_fftHistory.data() + m_historyHead * bins, spectra.constData() + i * bins, size_t(bins) * sizeof(float));
+            }
+            m_historyCount = qMin(m_historyCount + frames.size(), SPECTROGRAM_HISTORY_SIZE);
+            newLines = frames.size();
         }
 #ifdef DEBUG_SPECTROGRAM
         else {
@@ -345,12 +367,30 @@ QImage Spectrogram::renderAudioScope(uint, const audioShortVector &audioFrame, c
         }
 #endif
 
-        // Limit the maximum history size to avoid wasting space
-        while (m_fftHistory.size() > SPECTROGRAM_HISTORY_SIZE) {
-            m_fftHistory.removeLast();
+        const int h = m_innerScopeRect.height();
+        const int w = m_innerScopeRect.width();
+        const bool colorsChanged = updateColorTable();
+        bool completeRedraw = m_parameterChanged || colorsChanged || m_historyImg.size() != m_innerScopeRect.size() || newLines >= h;
+        m_parameterChanged = false;
+
+        if (completeRedraw) {
+            // Render the whole history, newest spectrum at the bottom
+            m_historyImg = QImage(m_innerScopeRect.size(), QImage::Format_ARGB32);
+            m_historyImg.fill(qRgba(0, 0, 0, 0));
+            m_imageHead = h - 1;
+            for (int age = 0; age < qMin(h, m_historyCount); ++age) {
+                renderLine(historySpectrum(age), h - 1 - age);
+            }
+        } else {
+            // The size of the widget and the parameters (like min/max dB) have not changed since last time,
+            // so only the new spectra are drawn, over the oldest lines.
+            for (int age = newLines - 1; age >= 0; --age) {
+                m_imageHead = (m_imageHead + 1) % h;
+                renderLine(historySpectrum(age), m_imageHead);
+            }
         }
 
-        // Draw the spectrum
+        // Draw the spectrum: the lines following the newest one are the oldest
         QImage spectrum(m_scopeRect.size(), QImage::Format_ARGB32);
         spectrum.fill(qRgba(0, 0, 0, 0));
 
@@ -361,87 +401,75 @@ QImage Spectrogram::renderAudioScope(uint, const audioShortVector &audioFrame, c
             return spectrum;
         }
 
-        const int h = m_innerScopeRect.height();
         const int leftDist = m_innerScopeRect.left() - m_scopeRect.left();
         const int topDist = m_innerScopeRect.top() - m_scopeRect.top();
-        int y;
-        bool completeRedraw = true;
-
-        if (m_fftHistoryImg.size() == m_scopeRect.size() && !m_parameterChanged) {
-            // The size of the widget and the parameters (like min/max dB) have not changed since last time,
-            // so we can re-use it, shift it by one pixel, and render the single remaining line. Usually about
-            // 10 times faster for a widget height of around 400 px.
-            if (newDataAvailable) {
-                davinci.drawImage(0, -1, m_fftHistoryImg);
-            } else {
-                // spectrum = m_fftHistoryImg does NOT work, leads to segfaults (anyone knows why, please tell me)
-                davinci.drawImage(0, 0, m_fftHistoryImg);
-            }
-            completeRedraw = false;
-        }
-
-        y = 0;
-        if ((newData != 0) || m_parameterChanged) {
-            m_parameterChanged = false;
-
-            QVector<float> dbMap;
-            uint right;
-            ////////////////FIXME
-            for (auto &it : m_fftHistory) {
-
-                int windowSize = it.size();
-
-                // Interpolate the frequency data to match the pixel coordinates
-                right = uint(m_freqMax / (m_freq / 2.f) * (windowSize - 1));
-                dbMap = FFTTools::interpolatePeakPreserving(it, uint(m_innerScopeRect.width()), 0, right, -180);
-
-                for (int i = 0; i < dbMap.size(); ++i) {
-                    float val;
-                    val = dbMap[i];
-                    bool peak = val > m_dBmax;
-
-                    // Normalize dB value to [0 1], 1 corresponding to dbMax dB and 0 to dbMin dB
-                    val = (val - m_dBmax) / (m_dBmax - m_dBmin) + 1.f;
-                    if (val < 0) {
-                        val = 0;
-                    } else if (val > 1) {
-                        val = 1;
-                    }
-                    if (!peak || !m_aHighlightPeaks->isChecked()) {
-                        spectrum.setPixel(leftDist + i, topDist + h - 1 - y, m_colorMap[int(val * 255)]);
-                    } else {
-                        spectrum.setPixel(leftDist + i, topDist + h - 1 - y, AbstractScopeWidget::colHighlightDark.rgba());
-                    }
-                }
-
-                y++;
-                if (y >= topDist + m_innerScopeRect.height()) {
-                    break;
-                }
-                if (!completeRedraw) {
-                    break;
-                }
-            }
+        const int olderLines = h - 1 - m_imageHead;
+        if (olderLines > 0) {
+            davinci.drawImage(QPoint(leftDist, topDist), m_historyImg, QRect(0, m_imageHead + 1, w, olderLines));
         }
+        davinci.drawImage(QPoint(leftDist, topDist + olderLines), m_historyImg, QRect(0, 0, w, m_imageHead + 1));
 
 #ifdef DEBUG_SPECTROGRAM
-        qCDebug(KDENLIVE_LOG) << "Rendered " << y - topDist << "lines from " << m_fftHistory.size() << " available samples in " << start.elapsed() << " ms"
-                              << (completeRedraw ? "" : " (re-used old image)");
-        uint storedBytes = 0;
-        for (QList<QVector<float>>::iterator it = m_fftHistory.begin(); it != m_fftHistory.end(); ++it) {
-            storedBytes += (*it).size() * sizeof((*it)[0]);
-        }
-        qCDebug(KDENLIVE_LOG) << QString("Total storage used: %1 kB").arg((double)storedBytes / 1000, 0, 'f', 2);
+        qCDebug(KDENLIVE_LOG) << "Rendered " << (completeRedraw ? qMin(h, m_historyCount) : newLines) << "lines from " << m_historyCount
+                              << " available samples in " << timer.elapsed() << " ms" << (completeRedraw ? "" : " (re-used old image)");
+        qCDebug(KDENLIVE_LOG) << QString("Total storage used: %1 kB").arg(double(m_fftHistory.size() * sizeof(float)) / 1000, 0, 'f', 2);
 #endif
 
-        m_fftHistoryImg = spectrum;
-
         Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()), 1);
         return spectrum;
     }
     Q_EMIT signalScopeRenderingFinished(0, 1);
     return QImage();
 }
+
+const float *Spectrogram::historySpectrum(int age) const
+{
+    const int index = (m_historyHead - age + SPECTROGRAM_HISTORY_SIZE) % SPECTROGRAM_HISTORY_SIZE;
+    return m_fftHistory.constData() + index * m_fftBins;
+}
+
+bool Spectrogram::updateColorTable()
+{
+    const bool highlight = m_aHighlightPeaks->isChecked();
+    if (!m_dbColors.isEmpty() && m_colorsDbMin == m_dBmin && m_colorsDbMax == m_dBmax && m_colorsHighlight == highlight) {
+        return false;
+    }
+    m_colorsDbMin = m_dBmin;
+    m_colorsDbMax = m_dBmax;
+    m_colorsHighlight = highlight;
+    const int steps = (m_dBmax - m_dBmin) * SPECTROGRAM_DB_STEPS;
+    m_dbColors.resize(steps + 2);
+    for (int i = 0; i <= steps; ++i) {
+        // Normalize dB value to [0 1], 1 corresponding to dbMax dB and 0 to dbMin dB
+        m_dbColors[i] = m_colorMap[int(float(i) / steps * 255)];
+    }
+    m_dbColors[steps + 1] = highlight ? AbstractScopeWidget::colHighlightDark.rgba() : m_colorMap[255];
+    return true;
+}
+
+void Spectrogram::renderLine(const float *spectrum, int line)
+{
+    // Interpolate the frequency data to match the pixel coordinates
+    const uint right = uint(m_freqMax / (m_freq / 2.f) * (m_fftBins - 1));
+    const QVector<float> dbMap = FFTTools::interpolatePeakPreserving(spectrum, m_fftBins, uint(m_historyImg.width()), 0, right, -180);
+
+    const float dbMin = m_colorsDbMin;
+    const float dbMax = m_colorsDbMax;
+    const int peakIndex = m_dbColors.size() - 1;
+    const QRgb *colors = m_dbColors.constData();
+    auto *pixels = reinterpret_cast<QRgb *>(m_historyImg.scanLine(line));
+    for (int i = 0; i < dbMap.size(); ++i) {
+        const float val = dbMap.at(i);
+        if (val <= dbMin) {
+            pixels[i] = colors[0];
+        } else if (val > dbMax) {
+            pixels[i] = colors[peakIndex];
+        } else {
+            pixels[i] = colors[int((val - dbMin) * SPECTROGRAM_DB_STEPS)];
+        }
+    }
+}
+
 QImage Spectrogram::renderBackground(uint)
 {
     return QImage();
@@ -541,6 +569,8 @@ void Spectrogram::resizeEvent(QResizeEvent *event)
 }
 
 #undef SPECTROGRAM_HISTORY_SIZE
+#undef SPECTROGRAM_QUEUE_SIZE
+#undef SPECTROGRAM_DB_STEPS
 #ifdef DEBUG_SPECTROGRAM
 #undef DEBUG_SPECTROGRAM
 #endif
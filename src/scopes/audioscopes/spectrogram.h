@@ -18,14 +18,16 @@ class Spectrogram_UI;
     over time. See https://en.wikipedia.org/wiki/Spectrogram.
 
     The Spectrogram makes use of two caches:
-    * A cached image where only the most recent line needs to be appended instead of
-      having to recalculate the whole image. A typical speedup factor is 10x.
+    * A circular image where each new spectrum is written over the oldest line. Displaying it
+      only means drawing its two parts around the newest line, so the cost of a new audio frame
+      does not depend on the scope height.
     * A FFT cache storing a history of previous spectral power distributions (i.e.
-      the Fourier-transformed audio signals). This is used if the user adjusts parameters
+      the Fourier-transformed audio signals) in a ring buffer. This is used if the user adjusts parameters
       like the maximum frequency to display or minimum/maximum signal strength in dB.
       All required information is preserved in the FFT history, which would not be the
       case for an image (consider re-sizing the widget to 100x100 px and then back to
       800x400 px -- lost is lost).
+    All audio frames received since the last rendering are transformed together.
 */
 class Spectrogram : public AbstractAudioScopeWidget
 {
@@ -60,8 +62,21 @@ private:
     QAction *m_aTrackMouse;
     QAction *m_aHighlightPeaks;
 
-    QList<QVector<float>> m_fftHistory;
-    QImage m_fftHistoryImg;
+    /** @brief Ring buffer of the last spectra, m_fftBins values each */
+    QVector<float> m_fftHistory;
+    int m_fftBins{0};
+    /// Index of the newest spectrum in m_fftHistory
+    int m_historyHead{0};
+    int m_historyCount{0};
+    /** @brief Rendered spectra, one line each. Line m_imageHead holds the newest one, the lines below it the oldest ones. */
+    QImage m_historyImg;
+    int m_imageHead{0};
+
+    /** @brief Colors of the dB values between m_dBmin and m_dBmax, followed by the color of peaks */
+    QVector<QRgb> m_dbColors;
+    int m_colorsDbMin{0};
+    int m_colorsDbMax{0};
+    bool m_colorsHighlight{false};
 
     int m_dBmin{-70};
     int m_dBmax{0};
@@ -74,6 +89,13 @@ private:
     QRect m_innerScopeRect;
     QRgb m_colorMap[256];
 
+    /** @brief Returns the spectrum @p age frames old from the history */
+    const float *historySpectrum(int age) const;
+    /** @brief Rebuild m_dbColors if the dB range or the peak highlighting changed. Returns true if it was rebuilt. */
+    bool updateColorTable();
+    /** @brief Draw @p spectrum into line @p line of m_historyImg */
+    void renderLine(const float *spectrum, int line);
+
 private Q_SLOTS:
     void slotResetMaxFreq();
 };
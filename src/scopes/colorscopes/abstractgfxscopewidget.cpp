@@ -6,8 +6,12 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 */
 
 #include "abstractgfxscopewidget.h"
+#include "kdenlivesettings.h"
 #include "monitor/monitormanager.h"
 
+#include "klocalizedstring.h"
+#include <QActionGroup>
+#include <QMenu>
 #include <QMouseEvent>
 
 // Uncomment for debugging.
@@ -19,14 +23,38 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 AbstractGfxScopeWidget::AbstractGfxScopeWidget(bool trackMouse, QWidget *parent)
     : AbstractScopeWidget(trackMouse, parent)
 {
+    QMenu *scaleMenu = m_menu->addMenu(i18n("Analysis Resolution"));
+    m_analysisScale = new QActionGroup(this);
+    const QList<QPair<QString, int>> scales = {{i18n("Full"), 1}, {i18n("Half"), 2}, {i18n("Quarter"), 4}};
+    for (const auto &scale : scales) {
+        QAction *a = scaleMenu->addAction(scale.first);
+        a->setCheckable(true);
+        a->setData(scale.second);
+        m_analysisScale->addAction(a);
+    }
+    // The setting is shared by all color scopes, it may have been changed from another one
+    connect(scaleMenu, &QMenu::aboutToShow, this, [this]() {
+        for (QAction *a : m_analysisScale->actions()) {
+            a->setChecked(a->data().toInt() == analysisScale());
+        }
+    });
+    connect(m_analysisScale, &QActionGroup::triggered, this, [this](QAction *a) {
+        KdenliveSettings::setScopesAnalysisScale(a->data().toInt());
+        Q_EMIT signalFrameRequest(widgetName());
+    });
 }
 
 AbstractGfxScopeWidget::~AbstractGfxScopeWidget() = default;
 
+int AbstractGfxScopeWidget::analysisScale()
+{
+    return qMax(1, KdenliveSettings::scopesAnalysisScale());
+}
+
 QImage AbstractGfxScopeWidget::renderScope(uint accelerationFactor)
 {
     QMutexLocker lock(&m_mutex);
-    return renderGfxScope(accelerationFactor, m_scopeImage);
+    return renderGfxScope(accelerationFactor, m_scopeInput);
 }
 
 void AbstractGfxScopeWidget::mouseReleaseEvent(QMouseEvent *event)
@@ -40,7 +68,14 @@ void AbstractGfxScopeWidget::mouseReleaseEvent(QMouseEvent *event)
 void AbstractGfxScopeWidget::slotRenderZoneUpdated(const QImage &frame)
 {
     QMutexLocker lock(&m_mutex);
-    m_scopeImage = frame;
+    m_scopeInput = ScopeInput(frame);
+    AbstractScopeWidget::slotRenderZoneUpdated();
+}
+
+void AbstractGfxScopeWidget::slotRenderZoneUpdated(const SharedFrame &frame)
+{
+    QMutexLocker lock(&m_mutex);
+    m_scopeInput = ScopeInput(frame);
     AbstractScopeWidget::slotRenderZoneUpdated();
 }
 
@@ -11,6 +11,9 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QWidget>
 
 #include "../abstractscopewidget.h"
+#include "scopeanalyzer.h"
+
+class QActionGroup;
 
 /**
 * @brief Abstract class for scopes analyzing image frames.
@@ -29,21 +32,27 @@ protected:
     /** @brief Scope renderer. Must emit signalScopeRenderingFinished()
      *  when calculation has finished, to allow multi-threading.
      *  accelerationFactor hints how much faster than usual the calculation should be accomplished, if possible. */
-    virtual QImage renderGfxScope(uint accelerationFactor, const QImage &) = 0;
+    virtual QImage renderGfxScope(uint accelerationFactor, const ScopeInput &frame) = 0;
 
     QImage renderScope(uint accelerationFactor) override;
 
     void mouseReleaseEvent(QMouseEvent *) override;
 
+    /** @brief The frame size is divided by this factor before being analysed, shared by all color scopes */
+    static int analysisScale();
+
 private:
-    QImage m_scopeImage;
+    ScopeInput m_scopeInput;
     QMutex m_mutex;
+    QActionGroup *m_analysisScale;
 
 public Q_SLOTS:
     /** @brief Must be called when the active monitor has shown a new frame.
      * This slot must be connected in the implementing class, it is *not*
      * done in this abstract class. */
     void slotRenderZoneUpdated(const QImage &);
+    /** @brief Same as above for monitor frames, which are analysed from their YUV data */
+    void slotRenderZoneUpdated(const SharedFrame &);
 
 protected Q_SLOTS:
     virtual void slotAutoRefreshToggled(bool autoRefresh);
@@ -128,7 +128,7 @@ QImage Histogram::renderHUD(uint)
     Q_EMIT signalHUDRenderingFinished(0, 1);
     return QImage();
 }
-QImage Histogram::renderGfxScope(uint accelFactor, const QImage &qimage)
+QImage Histogram::renderGfxScope(uint accelFactor, const ScopeInput &frame)
 {
     QElapsedTimer timer;
     timer.start();
@@ -139,8 +139,10 @@ QImage Histogram::renderGfxScope(uint accelFactor, const QImage &qimage)
 
     ITURec rec = m_aRec601->isChecked() ? ITURec::Rec_601 : ITURec::Rec_709;
 
-    QImage histogram = m_histogramGenerator->calculateHistogram(m_scopeRect.size(), qimage, componentFlags, rec, m_aUnscaled->isChecked(),
-                                                                m_ui->rbLogarithmic->isChecked(), accelFactor);
+    // The statistics are computed once per frame by the shared analysis pass, for all pixels,
+    // so there is nothing to accelerate here.
+    QImage histogram = m_histogramGenerator->calculateHistogram(m_scopeRect.size(), frame.analyse(rec, analysisScale()), componentFlags,
+                                                                m_aUnscaled->isChecked(), m_ui->rbLogarithmic->isChecked());
 
     Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()), accelFactor);
     return histogram;
@@ -6,6 +6,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 */
 
 #include "histogramgenerator.h"
+#include "scopeanalyzer.h"
 
 #include "klocalizedstring.h"
 #include <QDebug>
@@ -19,7 +20,19 @@ HistogramGenerator::HistogramGenerator() = default;
 QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QImage &image, const int &components, ITURec rec, bool unscaled, bool logScale,
                                               uint accelFactor) const
 {
-    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (image.width() <= 0 || image.height() <= 0) {
+        return QImage();
+    }
+    // The statistics are computed once per frame by the shared analysis pass, for all pixels,
+    // so there is nothing to accelerate here.
+    Q_UNUSED(accelFactor)
+    return calculateHistogram(paradeSize, ScopeAnalyzer::analyse(image, rec), components, unscaled, logScale);
+}
+
+QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const std::shared_ptr<const ScopeFrameAnalysis> &analysis, const int &components,
+                                              bool unscaled, bool logScale) const
+{
+    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || !analysis || analysis->width <= 0 || analysis->height <= 0) {
         return QImage();
     }
 
@@ -31,39 +44,21 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
 
     int r[256], g[256], b[256], y[256], s[766];
     // Initialize the values to zero
-    std::fill(r, r + 256, 0);
-    std::fill(g, g + 256, 0);
-    std::fill(b, b + 256, 0);
-    std::fill(y, y + 256, 0);
     std::fill(s, s + 766, 0);
 
     const int ww = paradeSize.width();
     const int wh = paradeSize.height();
 
-    // Read the stats from the input image
-    for (int Y = 0; Y < image.height(); ++Y) {
-        for (int X = 0; X < image.width(); X += accelFactor) {
-
-            QRgb col = image.pixel(X, Y);
-            r[qRed(col)]++;
-            g[qGreen(col)]++;
-            b[qBlue(col)]++;
-
-            if (drawY) {
-                // Use if branch to avoid expensive multiplication if Y disabled
-                if (rec == ITURec::Rec_601) {
-                    y[int(REC_601_R * qRed(col) + REC_601_G * qGreen(col) + REC_601_B * qBlue(col))]++;
-                } else {
-                    y[int(REC_709_R * qRed(col) + REC_709_G * qGreen(col) + REC_709_B * qBlue(col))]++;
-                }
-            }
-
-            if (drawSum) {
-                // Use an if branch here because the sum takes more operations than rgb
-                s[qRed(col)]++;
-                s[qGreen(col)]++;
-                s[qBlue(col)]++;
-            }
+    if (drawR || drawG || drawB || drawSum) {
+        analysis->ensureRgb();
+    }
+    for (int i = 0; i < 256; ++i) {
+        r[i] = int(analysis->histR[size_t(i)]);
+        g[i] = int(analysis->histG[size_t(i)]);
+        b[i] = int(analysis->histB[size_t(i)]);
+        y[i] = int(analysis->histY[size_t(i)]);
+        if (drawSum) {
+            s[i] = r[i] + g[i] + b[i];
         }
     }
 
@@ -79,8 +74,8 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     // Height of a single histogram box without text
     const int partH = (wh - nParts * d) / nParts;
 
-    // Total number of bytes of the image
-    const int byteCount = int(image.sizeInBytes());
+    // Total number of bytes of the image in a 32 bit format
+    const int byteCount = analysis->width * analysis->height * 4;
 
     // Factor for scaling the measured value to the histogram.
     // This factor is used for linear scaling and does not depend
@@ -9,12 +9,14 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include <QObject>
 #include "colorconstants.h"
+#include <memory>
 
 class QColor;
 class QImage;
 class QPainter;
 class QRect;
 class QSize;
+struct ScopeFrameAnalysis;
 
 class HistogramGenerator : public QObject
 {
@@ -36,6 +38,9 @@ public:
     QImage calculateHistogram(const QSize &paradeSize, const QImage &image, const int &components, const ITURec rec, bool unscaled,
                               bool logScale,
                               uint accelFactor = 1) const;
+    /** @brief Same as above, from an already analysed frame */
+    QImage calculateHistogram(const QSize &paradeSize, const std::shared_ptr<const ScopeFrameAnalysis> &analysis, const int &components, bool unscaled,
+                              bool logScale) const;
 
     /**
      * Draws the histogram of a single component.
@@ -6,6 +6,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 */
 
 #include "rgbparadegenerator.h"
+#include "scopeanalyzer.h"
 #include "klocalizedstring.h"
 #include <QColor>
 #include <QDebug>
@@ -21,23 +22,26 @@ const QColor RGBParadeGenerator::colSoft(150, 150, 150, 255);
 const uchar RGBParadeGenerator::distRight(40);
 const uchar RGBParadeGenerator::distBottom(40);
 
-struct StructRGB
-{
-    uint r;
-    uint g;
-    uint b;
-};
-
 RGBParadeGenerator::RGBParadeGenerator() = default;
 
 QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QImage &image, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis,
                                               bool drawGradientRef, uint accelFactor)
+{
+    if (image.width() <= 0 || image.height() <= 0) {
+        return QImage();
+    }
+    return calculateRGBParade(paradeSize, ScopeAnalyzer::analyse(image), paintMode, drawAxis, drawGradientRef, accelFactor);
+}
+
+QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const std::shared_ptr<const ScopeFrameAnalysis> &analysis,
+                                              const RGBParadeGenerator::PaintMode paintMode, bool drawAxis, bool drawGradientRef, uint accelFactor)
 {
     Q_ASSERT(accelFactor >= 1);
 
-    if (paradeSize.width() <= 0 || paradeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (paradeSize.width() <= 0 || paradeSize.height() <= 0 || !analysis || analysis->width <= 0 || analysis->height <= 0) {
         return QImage();
     }
+    analysis->ensureRgb();
     QImage parade(paradeSize, QImage::Format_ARGB32);
     parade.fill(Qt::transparent);
 
@@ -50,8 +54,8 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
 
     const uint ww = uint(paradeSize.width());
     const uint wh = uint(paradeSize.height());
-    const uint iw = uint(image.width());
-    const uint ih = uint(image.height());
+    const uint iw = uint(analysis->width);
+    const uint ih = uint(analysis->height);
 
     const uchar offset = 10;
     const uint partW = (ww - 2 * offset - distRight) / 3;
@@ -69,65 +73,71 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
     QImage unscaled(int(ww) - distRight, 256, QImage::Format_ARGB32);
     unscaled.fill(qRgba(0, 0, 0, 0));
 
-    const float wPrediv = float(partW - 1) / (iw - 1);
-
-    std::vector<std::vector<StructRGB>> paradeVals(partW, std::vector<StructRGB>(256, {0, 0, 0}));
-
-    const auto totalPixels = image.width() * image.height();
-    for (int i = 0; i < totalPixels; i += accelFactor) {
-        const auto x = i % image.width();
-        const QRgb pixel = image.pixel(x, i / image.width());
-        auto r = uchar(qRed(pixel));
-        auto g = uchar(qGreen(pixel));
-        auto b = uchar(qBlue(pixel));
-
-        double dx = x * double(wPrediv);
+    const float wPrediv = iw > 1 ? float(partW - 1) / (iw - 1) : 0.f;
 
-        paradeVals[size_t(dx)][r].r++;
-        paradeVals[size_t(dx)][g].g++;
-        paradeVals[size_t(dx)][b].b++;
+    // Parade column of each image column
+    std::vector<uint> columns(iw);
+    for (uint x = 0; x < iw; ++x) {
+        columns[x] = uint(x * double(wPrediv));
+    }
 
-        if (r < minR) {
-            minR = r;
-        }
-        if (g < minG) {
-            minG = g;
-        }
-        if (b < minB) {
-            minB = b;
+    // Each strip counts the values in its own flat buffer, laid out as [column][value][r, g, b].
+    const int strips = ScopeAnalyzer::stripCount(analysis->height);
+    const size_t stripSize = size_t(partW) * 256 * 3;
+    m_stripVals.assign(size_t(strips) * stripSize, 0);
+    ScopeAnalyzer::forEachStrip(analysis->height, [&](int strip, int firstRow, int endRow) {
+        uint *vals = m_stripVals.data() + size_t(strip) * stripSize;
+        for (int y = firstRow; y < endRow; ++y) {
+            const QRgb *line = analysis->rgbLine(y);
+            for (uint x = uint(ScopeAnalyzer::firstSample(y, int(iw), accelFactor)); x < iw; x += accelFactor) {
+                const QRgb pixel = line[x];
+                uint *col = vals + columns[x] * 256 * 3;
+                col[qRed(pixel) * 3]++;
+                col[qGreen(pixel) * 3 + 1]++;
+                col[qBlue(pixel) * 3 + 2]++;
+            }
         }
-        if (r > maxR) {
-            maxR = r;
+    });
+    m_paradeVals.assign(stripSize, 0);
+    for (int strip = 0; strip < strips; ++strip) {
+        const uint *vals = m_stripVals.data() + size_t(strip) * stripSize;
+        for (size_t i = 0; i < stripSize; ++i) {
+            m_paradeVals[i] += vals[i];
         }
-        if (g > maxG) {
-            maxG = g;
+    }
+
+    for (size_t i = 0; i < stripSize; ++i) {
+        if (m_paradeVals[i] == 0) {
+            continue;
         }
-        if (b > maxB) {
-            maxB = b;
+        const auto value = uchar((i / 3) % 256);
+        switch (i % 3) {
+        case 0:
+            minR = qMin(minR, value);
+            maxR = qMax(maxR, value);
+            break;
+        case 1:
+            minG = qMin(minG, value);
+            maxG = qMax(maxG, value);
+            break;
+        default:
+            minB = qMin(minB, value);
+            maxB = qMax(maxB, value);
+            break;
         }
     }
 
     const int offset1 = int(partW + offset);
     const int offset2 = int(2 * partW + 2 * offset);
-    switch (paintMode) {
-    case PaintMode_RGB:
+    const bool rgb = paintMode == PaintMode_RGB;
+    for (int j = 0; j < 256; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(unscaled.scanLine(j));
         for (int i = 0; i < int(partW); ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 10, 10, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].r))));
-                unscaled.setPixel(i + offset1, j, qRgba(10, 255, 10, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].g))));
-                unscaled.setPixel(i + offset2, j, qRgba(10, 10, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].b))));
-            }
-        }
-        break;
-    default:
-        for (int i = 0; i < int(partW); ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].r))));
-                unscaled.setPixel(i + offset1, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].g))));
-                unscaled.setPixel(i + offset2, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].b))));
-            }
+            const uint *vals = m_paradeVals.data() + (size_t(i) * 256 + size_t(j)) * 3;
+            line[i] = rgb ? qRgba(255, 10, 10, CHOP255(gain * float(vals[0]))) : qRgba(255, 255, 255, CHOP255(gain * float(vals[0])));
+            line[i + offset1] = rgb ? qRgba(10, 255, 10, CHOP255(gain * float(vals[1]))) : qRgba(255, 255, 255, CHOP255(gain * float(vals[1])));
+            line[i + offset2] = rgb ? qRgba(10, 10, 255, CHOP255(gain * float(vals[2]))) : qRgba(255, 255, 255, CHOP255(gain * float(vals[2])));
         }
-        break;
     }
 
     // Scale the image to the target height. Scaling is not accomplished before because
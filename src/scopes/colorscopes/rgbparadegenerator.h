@@ -8,10 +8,13 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #pragma once
 
 #include <QObject>
+#include <memory>
+#include <vector>
 
 class QColor;
 class QImage;
 class QSize;
+struct ScopeFrameAnalysis;
 class RGBParadeGenerator : public QObject
 {
     Q_OBJECT
@@ -21,6 +24,8 @@ public:
     RGBParadeGenerator();
     QImage calculateRGBParade(const QSize &paradeSize, const QImage &image, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis, bool drawGradientRef,
                               uint accelFactor = 1);
+    QImage calculateRGBParade(const QSize &paradeSize, const std::shared_ptr<const ScopeFrameAnalysis> &analysis, const RGBParadeGenerator::PaintMode paintMode,
+                              bool drawAxis, bool drawGradientRef, uint accelFactor = 1);
 
     static const QColor colHighlight;
     static const QColor colLight;
@@ -28,4 +33,9 @@ public:
 
     static const uchar distRight;
     static const uchar distBottom;
+
+private:
+    /** @brief Counting buffers kept between frames, the scope never computes two frames at once */
+    std::vector<uint> m_stripVals;
+    std::vector<uint> m_paradeVals;
 };
@@ -0,0 +1,383 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "scopeanalyzer.h"
+
+#include <QMutex>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+// Luma factors in 1.15 fixed point. They sum up to 1 << 15 so that white maps to 255,
+// and fit in a signed 16 bit integer for _mm_madd_epi16.
+constexpr int FIXED_SHIFT = 15;
+constexpr int FIXED_ROUND = 1 << (FIXED_SHIFT - 1);
+constexpr int REC_601_FIXED[3] = {9798, 19235, 3735};
+constexpr int REC_709_FIXED[3] = {6963, 23442, 2363};
+
+// Do not bother other threads for less rows than this
+constexpr int MIN_STRIP_HEIGHT = 32;
+
+QMutex s_cacheMutex;
+std::shared_ptr<const ScopeFrameAnalysis> s_lastAnalysis[2];
+qint64 s_lastKey[2] = {0, 0};
+QSize s_lastSize[2];
+int s_lastScale[2] = {1, 1};
+// Last monitor frame analysis, identified by its image data
+std::shared_ptr<const ScopeFrameAnalysis> s_lastFrameAnalysis;
+const uint8_t *s_lastFrameData = nullptr;
+int s_lastFrameScale = 1;
+
+bool isCached(int slot, const QImage &image, int scale)
+{
+    return s_lastAnalysis[slot] && s_lastKey[slot] == image.cacheKey() && s_lastSize[slot] == image.size() && s_lastScale[slot] == scale;
+}
+
+// Full range YCbCr to RGB factors in 16.16 fixed point: Cr for red, Cb and Cr for green, Cb for blue
+constexpr int YUV_SHIFT = 16;
+constexpr int YUV_ROUND = 1 << (YUV_SHIFT - 1);
+constexpr int REC_601_YUV[4] = {91881, 22553, 46802, 116130};
+constexpr int REC_709_YUV[4] = {103206, 12276, 30679, 121609};
+
+inline uchar clampByte(int value)
+{
+    return uchar(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+} // namespace
+
+void ScopeFrameAnalysis::ensureRgb() const
+{
+    std::call_once(rgbOnce, [this]() {
+        if (hasChroma()) {
+            ScopeAnalyzer::convertToRgb(*this);
+        }
+    });
+}
+
+ScopeInput::ScopeInput(const QImage &image)
+    : m_image(image)
+{
+}
+
+ScopeInput::ScopeInput(const SharedFrame &frame)
+    : m_frame(frame)
+{
+}
+
+bool ScopeInput::isNull() const
+{
+    return m_image.isNull() && !m_frame.is_valid();
+}
+
+std::shared_ptr<const ScopeFrameAnalysis> ScopeInput::analyse(ITURec rec, int scale) const
+{
+    if (m_frame.is_valid()) {
+        return ScopeAnalyzer::analyse(m_frame, scale);
+    }
+    if (m_image.isNull()) {
+        return nullptr;
+    }
+    return ScopeAnalyzer::analyse(m_image, rec, scale);
+}
+
+std::shared_ptr<const ScopeFrameAnalysis> ScopeInput::analyse(int scale) const
+{
+    if (m_frame.is_valid()) {
+        return ScopeAnalyzer::analyse(m_frame, scale);
+    }
+    if (m_image.isNull()) {
+        return nullptr;
+    }
+    return ScopeAnalyzer::analyse(m_image, scale);
+}
+
+int ScopeAnalyzer::stripCount(int height)
+{
+    const int threads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    return qBound(1, height / MIN_STRIP_HEIGHT, threads);
+}
+
+void ScopeAnalyzer::forEachStrip(int height, const std::function<void(int, int, int)> &function)
+{
+    const int count = stripCount(height);
+    if (count == 1) {
+        function(0, 0, height);
+        return;
+    }
+    QVector<int> strips(count);
+    for (int i = 0; i < count; ++i) {
+        strips[i] = i;
+    }
+    QtConcurrent::blockingMap(strips, [&function, count, height](int &strip) {
+        function(strip, strip * height / count, (strip + 1) * height / count);
+    });
+}
+
+void ScopeAnalyzer::computeLumaScalar(const QRgb *src, uchar *dst, int count, ITURec rec)
+{
+    const int *f = rec == ITURec::Rec_601 ? REC_601_FIXED : REC_709_FIXED;
+    for (int i = 0; i < count; ++i) {
+        const QRgb px = src[i];
+        dst[i] = uchar((f[0] * qRed(px) + f[1] * qGreen(px) + f[2] * qBlue(px) + FIXED_ROUND) >> FIXED_SHIFT);
+    }
+}
+
+void ScopeAnalyzer::computeLuma(const QRgb *src, uchar *dst, int count, ITURec rec)
+{
+    int i = 0;
+#ifdef __SSE2__
+    const int *f = rec == ITURec::Rec_601 ? REC_601_FIXED : REC_709_FIXED;
+    // In memory a QRgb is B, G, R, A. Seen as 16 bit lanes, masking with 0x00ff00ff gives (B, R)
+    // and shifting by 8 gives (G, A), so each pixel needs two multiply-adds.
+    const __m128i mask = _mm_set1_epi32(0x00ff00ff);
+    const __m128i coeffBR = _mm_set1_epi32(int(uint(f[2]) | (uint(f[0]) << 16)));
+    const __m128i coeffG = _mm_set1_epi32(f[1]);
+    const __m128i round = _mm_set1_epi32(FIXED_ROUND);
+    auto luma4 = [&](const QRgb *p) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i br = _mm_and_si128(px, mask);
+        const __m128i ga = _mm_and_si128(_mm_srli_epi16(px, 8), mask);
+        __m128i sum = _mm_add_epi32(_mm_madd_epi16(br, coeffBR), _mm_madd_epi16(ga, coeffG));
+        return _mm_srli_epi32(_mm_add_epi32(sum, round), FIXED_SHIFT);
+    };
+    for (; i + 16 <= count; i += 16) {
+        const __m128i lo = _mm_packs_epi32(luma4(src + i), luma4(src + i + 4));
+        const __m128i hi = _mm_packs_epi32(luma4(src + i + 8), luma4(src + i + 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    computeLumaScalar(src + i, dst + i, count - i, rec);
+}
+
+std::shared_ptr<const ScopeFrameAnalysis> ScopeAnalyzer::analyse(const QImage &image, int scale)
+{
+    scale = qMax(1, scale);
+    QMutexLocker lock(&s_cacheMutex);
+    for (int slot = 0; slot < 2; ++slot) {
+        if (isCached(slot, image, scale)) {
+            return s_lastAnalysis[slot];
+        }
+    }
+    return analyseLocked(image, ITURec::Rec_709, scale);
+}
+
+std::shared_ptr<const ScopeFrameAnalysis> ScopeAnalyzer::analyse(const QImage &image, ITURec rec, int scale)
+{
+    scale = qMax(1, scale);
+    // Keep the lock while computing: another scope asking for the same frame
+    // rather waits for the result than computing it a second time.
+    QMutexLocker lock(&s_cacheMutex);
+    if (isCached(rec == ITURec::Rec_601 ? 0 : 1, image, scale)) {
+        return s_lastAnalysis[rec == ITURec::Rec_601 ? 0 : 1];
+    }
+    return analyseLocked(image, rec, scale);
+}
+
+std::shared_ptr<const ScopeFrameAnalysis> ScopeAnalyzer::analyseLocked(const QImage &image, ITURec rec, int scale)
+{
+    const int slot = rec == ITURec::Rec_601 ? 0 : 1;
+
+    QImage source = image;
+    if (scale > 1 && image.width() >= scale && image.height() >= scale) {
+        source = image.scaled(image.width() / scale, image.height() / scale, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+    }
+    auto analysis = std::make_shared<ScopeFrameAnalysis>();
+    switch (source.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        analysis->image = source;
+        break;
+    default:
+        analysis->image = source.convertToFormat(QImage::Format_RGB32);
+        break;
+    }
+    analysis->rec = rec;
+    analysis->width = source.width();
+    analysis->height = source.height();
+    analysis->luma.resize(size_t(analysis->width) * size_t(analysis->height));
+
+    // One flat buffer per strip holding the R, G, B and Y histograms
+    const int strips = stripCount(analysis->height);
+    std::vector<uint> histograms(size_t(strips) * 4 * 256, 0);
+    ScopeFrameAnalysis *a = analysis.get();
+    forEachStrip(a->height, [a, rec, &histograms](int strip, int firstRow, int endRow) {
+        uint *hist = histograms.data() + size_t(strip) * 4 * 256;
+        for (int y = firstRow; y < endRow; ++y) {
+            const QRgb *line = a->rgbLine(y);
+            uchar *lumaLine = a->luma.data() + size_t(y) * size_t(a->width);
+            computeLuma(line, lumaLine, a->width, rec);
+            for (int x = 0; x < a->width; ++x) {
+                const QRgb px = line[x];
+                hist[qRed(px)]++;
+                hist[256 + qGreen(px)]++;
+                hist[512 + qBlue(px)]++;
+                hist[768 + lumaLine[x]]++;
+            }
+        }
+    });
+    for (int strip = 0; strip < strips; ++strip) {
+        const uint *hist = histograms.data() + size_t(strip) * 4 * 256;
+        for (int i = 0; i < 256; ++i) {
+            a->histR[i] += hist[i];
+            a->histG[i] += hist[256 + i];
+            a->histB[i] += hist[512 + i];
+            a->histY[i] += hist[768 + i];
+        }
+    }
+
+    s_lastAnalysis[slot] = analysis;
+    s_lastKey[slot] = image.cacheKey();
+    s_lastSize[slot] = image.size();
+    s_lastScale[slot] = scale;
+    return analysis;
+}
+
+bool ScopeAnalyzer::canAnalyse(const SharedFrame &frame)
+{
+    if (!frame.is_valid() || frame.get_image_width() <= 0 || frame.get_image_height() <= 0) {
+        return false;
+    }
+    const mlt_image_format format = frame.get_image_format();
+    return format == mlt_image_yuv422 || format == mlt_image_yuv420p;
+}
+
+std::shared_ptr<const ScopeFrameAnalysis> ScopeAnalyzer::analyse(const SharedFrame &frame, int scale)
+{
+    if (!canAnalyse(frame)) {
+        return nullptr;
+    }
+    const mlt_image_format format = frame.get_image_format();
+    const int frameWidth = frame.get_image_width();
+    const int frameHeight = frame.get_image_height();
+    // The native image, no conversion happens here
+    const uint8_t *data = frame.get_image(format);
+    if (data == nullptr) {
+        return nullptr;
+    }
+    scale = qBound(1, scale, qMin(frameWidth, frameHeight));
+
+    QMutexLocker lock(&s_cacheMutex);
+    if (s_lastFrameAnalysis && s_lastFrameData == data && s_lastFrameScale == scale) {
+        return s_lastFrameAnalysis;
+    }
+
+    auto analysis = std::make_shared<ScopeFrameAnalysis>();
+    ScopeFrameAnalysis *a = analysis.get();
+    a->frame = frame;
+    const int colorspace = frame.get_int("colorspace");
+    a->rec = colorspace == 601 || (colorspace == 0 && frameHeight < 720) ? ITURec::Rec_601 : ITURec::Rec_709;
+    a->width = frameWidth / scale;
+    a->height = frameHeight / scale;
+    const size_t size = size_t(a->width) * size_t(a->height);
+    a->luma.resize(size);
+    a->cb.resize(size);
+    a->cr.resize(size);
+
+    // Scopes show full range values, expand limited range video levels
+    uchar lumaLevels[256];
+    uchar chromaLevels[256];
+    const bool fullRange = frame.get_int("full_range") != 0;
+    for (int i = 0; i < 256; ++i) {
+        lumaLevels[i] = fullRange ? uchar(i) : clampByte(qRound((i - 16) * 255. / 219.));
+        chromaLevels[i] = fullRange ? uchar(i) : clampByte(qRound((i - 128) * 255. / 224.) + 128);
+    }
+
+    const int strips = stripCount(a->height);
+    std::vector<uint> histograms(size_t(strips) * 256, 0);
+    forEachStrip(a->height, [&](int strip, int firstRow, int endRow) {
+        uint *hist = histograms.data() + size_t(strip) * 256;
+        for (int y = firstRow; y < endRow; ++y) {
+            const int sy = y * scale;
+            uchar *luma = a->luma.data() + size_t(y) * size_t(a->width);
+            uchar *cb = a->cb.data() + size_t(y) * size_t(a->width);
+            uchar *cr = a->cr.data() + size_t(y) * size_t(a->width);
+            if (format == mlt_image_yuv422) {
+                // Packed Y0 Cb Y1 Cr, two pixels share their chroma
+                const uint8_t *row = data + size_t(sy) * size_t(frameWidth) * 2;
+                for (int x = 0; x < a->width; ++x) {
+                    const int sx = x * scale;
+                    const uint8_t *pair = row + (sx & ~1) * 2;
+                    luma[x] = lumaLevels[row[sx * 2]];
+                    cb[x] = chromaLevels[pair[1]];
+                    cr[x] = chromaLevels[pair[3]];
+                    hist[luma[x]]++;
+                }
+            } else {
+                // Planar, chroma planes have half the width and height
+                const int chromaWidth = frameWidth / 2;
+                const uint8_t *yRow = data + size_t(sy) * size_t(frameWidth);
+                const uint8_t *uRow = data + size_t(frameWidth) * size_t(frameHeight) + size_t(sy / 2) * size_t(chromaWidth);
+                const uint8_t *vRow = uRow + size_t(chromaWidth) * size_t(frameHeight / 2);
+                for (int x = 0; x < a->width; ++x) {
+                    const int sx = x * scale;
+                    luma[x] = lumaLevels[yRow[sx]];
+                    cb[x] = chromaLevels[uRow[qMin(sx / 2, chromaWidth - 1)]];
+                    cr[x] = chromaLevels[vRow[qMin(sx / 2, chromaWidth - 1)]];
+                    hist[luma[x]]++;
+                }
+            }
+        }
+    });
+    for (int strip = 0; strip < strips; ++strip) {
+        const uint *hist = histograms.data() + size_t(strip) * 256;
+        for (int i = 0; i < 256; ++i) {
+            a->histY[i] += hist[i];
+        }
+    }
+
+    s_lastFrameAnalysis = analysis;
+    s_lastFrameData = data;
+    s_lastFrameScale = scale;
+    return analysis;
+}
+
+void ScopeAnalyzer::convertToRgb(const ScopeFrameAnalysis &analysis)
+{
+    const ScopeFrameAnalysis *a = &analysis;
+    a->image = QImage(a->width, a->height, QImage::Format_RGB32);
+    const int *f = a->rec == ITURec::Rec_601 ? REC_601_YUV : REC_709_YUV;
+    // Detach once here, scanLine() is not safe to call from several threads
+    uchar *bits = a->image.bits();
+    const size_t bytesPerLine = size_t(a->image.bytesPerLine());
+    const int strips = stripCount(a->height);
+    std::vector<uint> histograms(size_t(strips) * 3 * 256, 0);
+    forEachStrip(a->height, [a, f, bits, bytesPerLine, &histograms](int strip, int firstRow, int endRow) {
+        uint *hist = histograms.data() + size_t(strip) * 3 * 256;
+        for (int y = firstRow; y < endRow; ++y) {
+            const uchar *luma = a->lumaLine(y);
+            const uchar *cb = a->cbLine(y);
+            const uchar *cr = a->crLine(y);
+            auto *line = reinterpret_cast<QRgb *>(bits + size_t(y) * bytesPerLine);
+            for (int x = 0; x < a->width; ++x) {
+                const int l = luma[x] << YUV_SHIFT;
+                const int u = cb[x] - 128;
+                const int v = cr[x] - 128;
+                const uchar r = clampByte((l + f[0] * v + YUV_ROUND) >> YUV_SHIFT);
+                const uchar g = clampByte((l - f[1] * u - f[2] * v + YUV_ROUND) >> YUV_SHIFT);
+                const uchar b = clampByte((l + f[3] * u + YUV_ROUND) >> YUV_SHIFT);
+                line[x] = qRgb(r, g, b);
+                hist[r]++;
+                hist[256 + g]++;
+                hist[512 + b]++;
+            }
+        }
+    });
+    for (int strip = 0; strip < strips; ++strip) {
+        const uint *hist = histograms.data() + size_t(strip) * 3 * 256;
+        for (int i = 0; i < 256; ++i) {
+            a->histR[i] += hist[i];
+            a->histG[i] += hist[256 + i];
+            a->histB[i] += hist[512 + i];
+        }
+    }
+}
@@ -0,0 +1,131 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "colorconstants.h"
+#include "monitor/scopes/sharedframe.h"
+
+#include <QImage>
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Data about a frame that is shared by all color scopes.
+ *
+ * The frame is analysed once, no matter how many scopes are docked: the first
+ * scope asking for a frame computes it, the others get the cached result.
+ *
+ * Monitor frames are analysed from their YUV planes: the luma and chroma are read
+ * as they are, and the RGB data is only computed if a scope asks for it with ensureRgb().
+ */
+struct ScopeFrameAnalysis
+{
+    /** @brief The frame in a 32 bit RGB format, so rows can be read with constScanLine() as QRgb.
+     *  For frames analysed from YUV data, only valid after ensureRgb() */
+    mutable QImage image;
+    ITURec rec = ITURec::Rec_709;
+    int width = 0;
+    int height = 0;
+    /** @brief One luma value per pixel, row after row, without padding */
+    std::vector<uchar> luma;
+    /** @brief For frames analysed from YUV data, one full range Cb and Cr value per pixel, laid out like the luma */
+    std::vector<uchar> cb;
+    std::vector<uchar> cr;
+    /** @brief Component histograms of the whole frame. For frames analysed from YUV data, the RGB ones are only valid after ensureRgb() */
+    mutable std::array<uint, 256> histR{};
+    mutable std::array<uint, 256> histG{};
+    mutable std::array<uint, 256> histB{};
+    std::array<uint, 256> histY{};
+
+    inline bool hasChroma() const { return !cb.empty(); }
+    inline const uchar *lumaLine(int row) const { return luma.data() + size_t(row) * size_t(width); }
+    inline const uchar *cbLine(int row) const { return cb.data() + size_t(row) * size_t(width); }
+    inline const uchar *crLine(int row) const { return cr.data() + size_t(row) * size_t(width); }
+    inline const QRgb *rgbLine(int row) const { return reinterpret_cast<const QRgb *>(image.constScanLine(row)); }
+
+    /** @brief Computes the RGB image and histograms from the YUV data if needed. Can be called from several threads. */
+    void ensureRgb() const;
+
+    /** @brief The analysed frame, keeping its image data alive while it is cached */
+    SharedFrame frame;
+    mutable std::once_flag rgbOnce;
+};
+
+/**
+ * @brief The frame a color scope has to render: either a monitor frame, read from its native
+ * YUV planes, or an image (frame grabbed from the GPU, capture device).
+ */
+class ScopeInput
+{
+public:
+    ScopeInput() = default;
+    explicit ScopeInput(const QImage &image);
+    explicit ScopeInput(const SharedFrame &frame);
+
+    bool isNull() const;
+    /** @brief Returns the analysis of the frame, with its size divided by @p scale. @p rec is used to compute the
+     *  luma of images, YUV frames come with their own. */
+    std::shared_ptr<const ScopeFrameAnalysis> analyse(ITURec rec, int scale = 1) const;
+    /** @brief Same as above for scopes which do not use the luma */
+    std::shared_ptr<const ScopeFrameAnalysis> analyse(int scale = 1) const;
+
+private:
+    QImage m_image;
+    SharedFrame m_frame;
+};
+
+/**
+ * @brief Shared per-frame pass for the color scope generators.
+ *
+ * The frame is split in horizontal strips which are processed on the global thread pool.
+ * Generators use forEachStrip() the same way for their own accumulation, each strip
+ * working on its own flat buffer which is merged when all strips are done.
+ */
+class ScopeAnalyzer
+{
+public:
+    /** @brief Returns the analysis of @p image, with its size divided by @p scale. The last analysed frame is cached,
+     *  so that scopes rendering the same frame only compute it once. */
+    static std::shared_ptr<const ScopeFrameAnalysis> analyse(const QImage &image, ITURec rec, int scale = 1);
+    /** @brief Same as above for scopes which do not use the luma, any cached analysis of @p image is fine. */
+    static std::shared_ptr<const ScopeFrameAnalysis> analyse(const QImage &image, int scale = 1);
+    /** @brief Analysis of a monitor frame read from its YUV planes, with its size divided by @p scale.
+     *  Returns nullptr if the frame image is not in a YUV format, see canAnalyse(). */
+    static std::shared_ptr<const ScopeFrameAnalysis> analyse(const SharedFrame &frame, int scale = 1);
+    /** @brief Returns true if the image of @p frame is in a format analyse() can read without conversion */
+    static bool canAnalyse(const SharedFrame &frame);
+
+    /** @brief Number of strips an image of @p height rows is split into */
+    static int stripCount(int height);
+
+    /** @brief Calls @p function(strip, firstRow, endRow) for each of the stripCount(height) strips
+     *  in parallel, and returns once all of them are processed. */
+    static void forEachStrip(int height, const std::function<void(int, int, int)> &function);
+
+    /** @brief Writes the luma of @p count pixels from @p src to @p dst, using SIMD instructions if available */
+    static void computeLuma(const QRgb *src, uchar *dst, int count, ITURec rec);
+    /** @brief Reference implementation of computeLuma(), giving the exact same results */
+    static void computeLumaScalar(const QRgb *src, uchar *dst, int count, ITURec rec);
+
+    /** @brief Column of the first pixel of @p row that is sampled when only every @p accelFactor-th pixel
+     *  of the image is used. */
+    static inline int firstSample(int row, int width, uint accelFactor)
+    {
+        const uint mod = uint((qint64(row) * width) % accelFactor);
+        return int((accelFactor - mod) % accelFactor);
+    }
+
+private:
+    static std::shared_ptr<const ScopeFrameAnalysis> analyseLocked(const QImage &image, ITURec rec, int scale);
+    /** @brief Fills the RGB data of @p analysis from its luma and chroma */
+    static void convertToRgb(const ScopeFrameAnalysis &analysis);
+    friend struct ScopeFrameAnalysis;
+};
@@ -61,6 +61,7 @@ mRgb2YPbPr =                        r =
  */
 
 #include "vectorscopegenerator.h"
+#include "scopeanalyzer.h"
 #include <cmath>
 
 // The maximum distance from the center for any RGB color is 0.63, so
@@ -105,10 +106,20 @@ QPoint VectorscopeGenerator::mapToCircle(const QSize &targetSize, const QPointF
 }
 
 QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize, const QImage &image, const float &gain,
+                                                  const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace,
+                                                  bool axis, uint accelFactor) const
+{
+    if (image.width() <= 0 || image.height() <= 0) {
+        return QImage();
+    }
+    return calculateVectorscope(vectorscopeSize, ScopeAnalyzer::analyse(image), gain, paintMode, colorSpace, axis, accelFactor);
+}
+
+QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize, const std::shared_ptr<const ScopeFrameAnalysis> &analysis, const float &gain,
                                                   const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool,
                                                   uint accelFactor) const
 {
-    if (vectorscopeSize.width() <= 0 || vectorscopeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (vectorscopeSize.width() <= 0 || vectorscopeSize.height() <= 0 || !analysis || analysis->width <= 0 || analysis->height <= 0) {
         // Invalid size
         return QImage();
     }
@@ -120,25 +131,20 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
     scope.fill(qRgba(0, 0, 0, 0));
 
     double dy, dr, dg, db, dmax;
-    double /*y,*/ u, v;
     QPoint pt;
     QRgb px;
 
     // Just an average for the number of image pixels per scope pixel.
-    // NOTE: byteCount() has to be replaced by (img.bytesPerLine()*img.height()) for Qt 4.5 to compile, see:
-    // https://doc.qt.io/qt-5/qimage.html#bytesPerLine
-    double avgPxPerPx = double(image.depth()) / 8 * (image.bytesPerLine() * image.height()) / scope.size().width() / scope.size().height() / accelFactor;
+    // The analysed frame is counted as a 32 bit image.
+    double avgPxPerPx = 4. * (4. * analysis->width * analysis->height) / scope.size().width() / scope.size().height() / accelFactor;
 
     // benchmarking code
     // const auto start = std::chrono::high_resolution_clock::now();
 
-    const auto totalPixels = image.width() * image.height();
-    for (int i = 0; i < totalPixels; i += accelFactor) {
-        const QRgb pixel = image.pixel(i % image.width(), i / image.width());
+    auto toUV = [colorSpace](QRgb pixel, double &u, double &v) {
         const int r = qRed(pixel);
         const int g = qGreen(pixel);
         const int b = qBlue(pixel);
-
         switch (colorSpace) {
         case VectorscopeGenerator::ColorSpace_YUV:
             //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
@@ -152,110 +158,184 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
             v = 0.001961 * r - 0.001642 * g - 0.0003189 * b;
             break;
         }
-
-        pt = mapToCircle(vectorscopeSize, QPointF(SCALING * double(gain) * u, SCALING * double(gain) * v));
-
-        if (pt.x() >= scope.width() || pt.x() < 0 || pt.y() >= scope.height() || pt.y() < 0) {
-            // Point lies outside (because of scaling), don't plot it
-
-        } else {
-
-            // Draw the pixel using the chosen draw mode.
-            switch (paintMode) {
-            case PaintMode_YUV:
-                // see yuvColorWheel
-                dy = 128; // Default Y value. Lower = darker.
-
-                // Calculate the RGB values from YUV/YPbPr
-                switch (colorSpace) {
-                case VectorscopeGenerator::ColorSpace_YUV:
-                    dr = dy + 290.8 * v;
-                    dg = dy - 100.6 * u - 148 * v;
-                    db = dy + 517.2 * u;
-                    break;
-                case VectorscopeGenerator::ColorSpace_YPbPr:
-                default:
-                    dr = dy + 357.5 * v;
-                    dg = dy - 87.75 * u - 182 * v;
-                    db = dy + 451.9 * u;
-                    break;
-                }
-
-                if (dr < 0) {
-                    dr = 0;
-                }
-                if (dg < 0) {
-                    dg = 0;
-                }
-                if (db < 0) {
-                    db = 0;
-                }
-                if (dr > 255) {
-                    dr = 255;
+    };
+
+    // The green and black modes brighten a scope pixel each time an image pixel falls on it, so only the
+    // number of hits matters. The other modes paint the color of the last image pixel falling on it.
+    // Either way, strips can work on their own buffer: hit counts add up, and the last pixel is the one
+    // with the highest index.
+    const bool countHits = paintMode != PaintMode_YUV && paintMode != PaintMode_Chroma && paintMode != PaintMode_Original;
+    // Frames analysed from YUV data come with their chroma, the RGB pixels are only needed to paint their color
+    const bool useChroma = countHits && analysis->hasChroma();
+    if (!useChroma) {
+        analysis->ensureRgb();
+    }
+    // U and V of each full range Cb and Cr value
+    double chromaU[256];
+    double chromaV[256];
+    for (int i = 0; i < 256; ++i) {
+        const double c = (i - 128) / 255.;
+        chromaU[i] = colorSpace == ColorSpace_YUV ? 0.872 * c : c;
+        chromaV[i] = colorSpace == ColorSpace_YUV ? 1.23 * c : c;
+    }
+    const int iw = analysis->width;
+    const int strips = ScopeAnalyzer::stripCount(analysis->height);
+    const size_t cells = size_t(cw) * size_t(cw);
+    std::vector<int> stripCells(size_t(strips) * cells, countHits ? 0 : -1);
+    ScopeAnalyzer::forEachStrip(analysis->height, [&](int strip, int firstRow, int endRow) {
+        int *hits = stripCells.data() + size_t(strip) * cells;
+        double u, v;
+        for (int y = firstRow; y < endRow; ++y) {
+            const QRgb *line = useChroma ? nullptr : analysis->rgbLine(y);
+            const uchar *cb = useChroma ? analysis->cbLine(y) : nullptr;
+            const uchar *cr = useChroma ? analysis->crLine(y) : nullptr;
+            for (int x = ScopeAnalyzer::firstSample(y, iw, accelFactor); x < iw; x += int(accelFactor)) {
+                if (useChroma) {
+                    u = chromaU[cb[x]];
+                    v = chromaV[cr[x]];
+                } else {
+                    toUV(line[x], u, v);
                 }
-                if (dg > 255) {
-                    dg = 255;
+                const QPoint p = mapToCircle(vectorscopeSize, QPointF(SCALING * double(gain) * u, SCALING * double(gain) * v));
+                if (p.x() >= cw || p.x() < 0 || p.y() >= cw || p.y() < 0) {
+                    // Point lies outside (because of scaling), don't plot it
+                    continue;
                 }
-                if (db > 255) {
-                    db = 255;
+                const size_t cell = size_t(p.y()) * size_t(cw) + size_t(p.x());
+                if (countHits) {
+                    hits[cell]++;
+                } else {
+                    hits[cell] = y * iw + x;
                 }
+            }
+        }
+    });
+    std::vector<int> hits(stripCells.begin(), stripCells.begin() + qint64(cells));
+    for (int strip = 1; strip < strips; ++strip) {
+        const int *stripHits = stripCells.data() + size_t(strip) * cells;
+        for (size_t cell = 0; cell < cells; ++cell) {
+            hits[cell] = countHits ? hits[cell] + stripHits[cell] : qMax(hits[cell], stripHits[cell]);
+        }
+    }
 
-                scope.setPixel(pt, qRgba(int(dr), int(dg), int(db), 255));
-                break;
-
-            case PaintMode_Chroma:
-                dy = 200; // Default Y value. Lower = darker.
-
-                // Calculate the RGB values from YUV/YPbPr
-                switch (colorSpace) {
-                case VectorscopeGenerator::ColorSpace_YUV:
-                    dr = dy + 290.8 * v;
-                    dg = dy - 100.6 * u - 148 * v;
-                    db = dy + 517.2 * u;
+    double u, v;
+    for (size_t cell = 0; cell < cells; ++cell) {
+        if (countHits ? hits[cell] == 0 : hits[cell] < 0) {
+            continue;
+        }
+        pt = QPoint(int(cell % size_t(cw)), int(cell / size_t(cw)));
+        if (countHits) {
+            // Apply the brightening once per hit, until the pixel does not change anymore
+            px = scope.pixel(pt);
+            for (int n = 0; n < hits[cell]; ++n) {
+                QRgb next;
+                switch (paintMode) {
+                case PaintMode_Green:
+                    next = qRgba(qRed(px) + int((255 - qRed(px)) / (3 * avgPxPerPx)), qGreen(px) + int(20 * (255 - qGreen(px)) / (avgPxPerPx)),
+                                 qBlue(px) + int((255 - qBlue(px)) / (avgPxPerPx)), qAlpha(px) + int((255 - qAlpha(px)) / (avgPxPerPx)));
                     break;
-                case VectorscopeGenerator::ColorSpace_YPbPr:
+                case PaintMode_Green2:
+                    next = qRgba(qRed(px) + int(ceil((255 - qRed(px)) / (4 * avgPxPerPx))), 255, qBlue(px) + int(ceil((255 - qBlue(px)) / (avgPxPerPx))),
+                                 qAlpha(px) + int(ceil((255 - qAlpha(px)) / (avgPxPerPx))));
+                    break;
+                case PaintMode_Black:
                 default:
-                    dr = dy + 357.5 * v;
-                    dg = dy - 87.75 * u - 182 * v;
-                    db = dy + 451.9 * u;
+                    next = qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20);
                     break;
                 }
-
-                // Scale the RGB values back to max 255
-                dmax = dr;
-                if (dg > dmax) {
-                    dmax = dg;
-                }
-                if (db > dmax) {
-                    dmax = db;
+                if (next == px) {
+                    break;
                 }
-                dmax = 255 / dmax;
-
-                dr *= dmax;
-                dg *= dmax;
-                db *= dmax;
+                px = next;
+            }
+            scope.setPixel(pt, px);
+            continue;
+        }
 
-                scope.setPixel(pt, qRgba(int(dr), int(dg), int(db), 255));
-                break;
-            case PaintMode_Original:
-                scope.setPixel(pt, pixel);
+        const QRgb pixel = analysis->rgbLine(hits[cell] / iw)[hits[cell] % iw];
+        toUV(pixel, u, v);
+
+        // Draw the pixel using the chosen draw mode.
+        switch (paintMode) {
+        case PaintMode_YUV:
+            // see yuvColorWheel
+            dy = 128; // Default Y value. Lower = darker.
+
+            // Calculate the RGB values from YUV/YPbPr
+            switch (colorSpace) {
+            case VectorscopeGenerator::ColorSpace_YUV:
+                dr = dy + 290.8 * v;
+                dg = dy - 100.6 * u - 148 * v;
+                db = dy + 517.2 * u;
                 break;
-            case PaintMode_Green:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(qRed(px) + int((255 - qRed(px)) / (3 * avgPxPerPx)), qGreen(px) + int(20 * (255 - qGreen(px)) / (avgPxPerPx)),
-                                         qBlue(px) + int((255 - qBlue(px)) / (avgPxPerPx)), qAlpha(px) + int((255 - qAlpha(px)) / (avgPxPerPx))));
+            case VectorscopeGenerator::ColorSpace_YPbPr:
+            default:
+                dr = dy + 357.5 * v;
+                dg = dy - 87.75 * u - 182 * v;
+                db = dy + 451.9 * u;
                 break;
-            case PaintMode_Green2:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(qRed(px) + int(ceil((255 - qRed(px)) / (4 * avgPxPerPx))), 255,
-                                         qBlue(px) + int(ceil((255 - qBlue(px)) / (avgPxPerPx))), qAlpha(px) + int(ceil((255 - qAlpha(px)) / (avgPxPerPx)))));
+            }
+
+            if (dr < 0) {
+                dr = 0;
+            }
+            if (dg < 0) {
+                dg = 0;
+            }
+            if (db < 0) {
+                db = 0;
+            }
+            if (dr > 255) {
+                dr = 255;
+            }
+            if (dg > 255) {
+                dg = 255;
+            }
+            if (db > 255) {
+                db = 255;
+            }
+
+            scope.setPixel(pt, qRgba(int(dr), int(dg), int(db), 255));
+            break;
+
+        case PaintMode_Chroma:
+            dy = 200; // Default Y value. Lower = darker.
+
+            // Calculate the RGB values from YUV/YPbPr
+            switch (colorSpace) {
+            case VectorscopeGenerator::ColorSpace_YUV:
+                dr = dy + 290.8 * v;
+                dg = dy - 100.6 * u - 148 * v;
+                db = dy + 517.2 * u;
                 break;
-            case PaintMode_Black:
+            case VectorscopeGenerator::ColorSpace_YPbPr:
             default:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20));
+                dr = dy + 357.5 * v;
+                dg = dy - 87.75 * u - 182 * v;
+                db = dy + 451.9 * u;
                 break;
             }
+
+            // Scale the RGB values back to max 255
+            dmax = dr;
+            if (dg > dmax) {
+                dmax = dg;
+            }
+            if (db > dmax) {
+                dmax = db;
+            }
+            dmax = 255 / dmax;
+
+            dr *= dmax;
+            dg *= dmax;
+            db *= dmax;
+
+            scope.setPixel(pt, qRgba(int(dr), int(dg), int(db), 255));
+            break;
+        case PaintMode_Original:
+        default:
+            scope.setPixel(pt, pixel);
+            break;
         }
     }
     // const auto elapsed = std::chrono::high_resolution_clock::now() - start;
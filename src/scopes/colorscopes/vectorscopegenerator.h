@@ -9,11 +9,13 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include <QImage>
 #include <QObject>
+#include <memory>
 
 class QImage;
 class QPoint;
 class QPointF;
 class QSize;
+struct ScopeFrameAnalysis;
 
 class VectorscopeGenerator : public QObject
 {
@@ -25,6 +27,11 @@ public:
 
     QImage calculateVectorscope(const QSize &vectorscopeSize, const QImage &image, const float &gain, const VectorscopeGenerator::PaintMode &paintMode,
                                 const VectorscopeGenerator::ColorSpace &colorSpace, bool, uint accelFactor = 1) const;
+    /** @brief Same as above, from an already analysed frame. If the analysis has chroma planes, they are used directly
+     *  in the modes which do not paint the pixel colors */
+    QImage calculateVectorscope(const QSize &vectorscopeSize, const std::shared_ptr<const ScopeFrameAnalysis> &analysis, const float &gain,
+                                const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool,
+                                uint accelFactor = 1) const;
 
     QPoint mapToCircle(const QSize &targetSize, const QPointF &point) const;
     static const double scaling;
@@ -178,15 +178,15 @@ QImage Waveform::renderHUD(uint)
     return hud;
 }
 
-QImage Waveform::renderGfxScope(uint accelFactor, const QImage &qimage)
+QImage Waveform::renderGfxScope(uint accelFactor, const ScopeInput &frame)
 {
     QElapsedTimer timer;
     timer.start();
 
     const int paintmode = m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt();
     ITURec rec = m_aRec601->isChecked() ? ITURec::Rec_601 : ITURec::Rec_709;
-    QImage wave = m_waveformGenerator->calculateWaveform(scopeRect().size() - m_textWidth - QSize(0, m_paddingBottom), qimage,
-                                                         WaveformGenerator::PaintMode(paintmode), true, rec, accelFactor);
+    QImage wave = m_waveformGenerator->calculateWaveform(scopeRect().size() - m_textWidth - QSize(0, m_paddingBottom), frame.analyse(rec, analysisScale()),
+                                                         WaveformGenerator::PaintMode(paintmode), true, accelFactor);
 
     Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()), 1);
     return wave;
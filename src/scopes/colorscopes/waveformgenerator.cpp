@@ -6,6 +6,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 */
 
 #include "waveformgenerator.h"
+#include "scopeanalyzer.h"
 
 #include <cmath>
 
@@ -24,27 +25,33 @@ WaveformGenerator::~WaveformGenerator() = default;
 
 QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QImage &image, WaveformGenerator::PaintMode paintMode, bool drawAxis, ITURec rec,
                                             uint accelFactor)
+{
+    if (image.width() <= 0 || image.height() <= 0) {
+        return QImage();
+    }
+    return calculateWaveform(waveformSize, ScopeAnalyzer::analyse(image, rec), paintMode, drawAxis, accelFactor);
+}
+
+QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const std::shared_ptr<const ScopeFrameAnalysis> &analysis,
+                                            WaveformGenerator::PaintMode paintMode, bool drawAxis, uint accelFactor)
 {
     Q_ASSERT(accelFactor >= 1);
 
     // QTime time;
     // time.start();
 
-    QImage wave(waveformSize, QImage::Format_ARGB32);
-
-    if (waveformSize.width() <= 0 || waveformSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (waveformSize.width() <= 0 || waveformSize.height() <= 0 || !analysis || analysis->width <= 0 || analysis->height <= 0) {
         return QImage();
     }
+    QImage wave(waveformSize, QImage::Format_ARGB32);
 
     // Fill with transparent color
     wave.fill(qRgba(0, 0, 0, 0));
 
     const uint ww = uint(waveformSize.width());
     const uint wh = uint(waveformSize.height());
-    const uint iw = uint(image.width());
-    const auto totalPixels = image.width() * image.height();
-
-    std::vector<std::vector<uint>> waveValues(size_t(waveformSize.width()), std::vector<uint>(size_t(waveformSize.height()), 0));
+    const uint iw = uint(analysis->width);
+    const auto totalPixels = analysis->width * analysis->height;
 
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
@@ -55,55 +62,62 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QIm
     // Subtract 1 from sizes because we start counting from 0.
     // Not doing it would result in attempts to paint outside of the image.
     const float hPrediv = (wh - 1) / 255.f;
-    const float wPrediv = (ww - 1) / float(iw - 1);
-
-    for (int i = 0; i < totalPixels; i += accelFactor) {
-        const int x = i % image.width();
-        const QRgb pixel = image.pixel(x, i / image.width());
+    const float wPrediv = iw > 1 ? (ww - 1) / float(iw - 1) : 0.f;
 
-        float dY, dx, dy;
-
-        if (rec == ITURec::Rec_601) {
-            // CIE 601 Luminance
-            dY = REC_601_R * qRed(pixel) + REC_601_G * qGreen(pixel) + REC_601_B * qBlue(pixel);
-        } else {
-            // CIE 709 Luminance
-            dY = REC_709_R * qRed(pixel) + REC_709_G * qGreen(pixel) + REC_709_B * qBlue(pixel);
-        }
-        // dY is on [0,255] now.
-
-        dy = dY * hPrediv;
-        dx = x * wPrediv;
-        waveValues[size_t(dx)][size_t(dy)]++;
+    // Scope column of each image column, and scope row of each luma value
+    std::vector<uint> columns(iw);
+    for (uint x = 0; x < iw; ++x) {
+        columns[x] = uint(x * wPrediv);
+    }
+    uint rows[256];
+    for (int l = 0; l < 256; ++l) {
+        rows[l] = uint(l * hPrediv);
     }
 
-    switch (paintMode) {
-    case PaintMode_Green:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                // Logarithmic scale. Needs fine tuning by hand, but looks great.
-                wave.setPixel(i, waveformSize.height() - j - 1,
-                              qRgba(CHOP255(52 * logf(0.1f * gain * float(waveValues[size_t(i)][size_t(j)]))),
-                                    CHOP255(52 * logf(gain * float(waveValues[size_t(i)][size_t(j)]))),
-                                    CHOP255(52 * logf(.25f * gain * float(waveValues[size_t(i)][size_t(j)]))),
-                                    CHOP255(64 * logf(gain * float(waveValues[size_t(i)][size_t(j)])))));
+    // Each strip counts (column, luma) pairs in its own flat buffer, merged into m_waveValues afterwards.
+    const int strips = ScopeAnalyzer::stripCount(analysis->height);
+    m_stripValues.assign(size_t(strips) * ww * 256, 0);
+    ScopeAnalyzer::forEachStrip(analysis->height, [&](int strip, int firstRow, int endRow) {
+        uint *values = m_stripValues.data() + size_t(strip) * ww * 256;
+        for (int y = firstRow; y < endRow; ++y) {
+            const uchar *luma = analysis->lumaLine(y);
+            for (uint x = uint(ScopeAnalyzer::firstSample(y, int(iw), accelFactor)); x < iw; x += accelFactor) {
+                values[columns[x] * 256 + luma[x]]++;
             }
         }
-        break;
-    case PaintMode_Yellow:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 242, 0, CHOP255(gain * float(waveValues[size_t(i)][size_t(j)]))));
+    });
+    m_waveValues.assign(size_t(ww) * wh, 0);
+    for (int strip = 0; strip < strips; ++strip) {
+        const uint *values = m_stripValues.data() + size_t(strip) * ww * 256;
+        for (uint i = 0; i < ww; ++i) {
+            for (int l = 0; l < 256; ++l) {
+                m_waveValues[i * wh + rows[l]] += values[i * 256 + l];
             }
         }
-        break;
-    default:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 255, 255, CHOP255(2.f * gain * float(waveValues[size_t(i)][size_t(j)]))));
+    }
+
+    // Rows are flipped, the lowest luma is at the bottom. Empty bins stay transparent.
+    for (uint j = 0; j < wh; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(wave.scanLine(int(wh - j - 1)));
+        for (uint i = 0; i < ww; ++i) {
+            const uint value = m_waveValues[i * wh + j];
+            if (value == 0) {
+                continue;
+            }
+            switch (paintMode) {
+            case PaintMode_Green:
+                // Logarithmic scale. Needs fine tuning by hand, but looks great.
+                line[i] = qRgba(CHOP255(52 * logf(0.1f * gain * float(value))), CHOP255(52 * logf(gain * float(value))),
+                                CHOP255(52 * logf(.25f * gain * float(value))), CHOP255(64 * logf(gain * float(value))));
+                break;
+            case PaintMode_Yellow:
+                line[i] = qRgba(255, 242, 0, CHOP255(gain * float(value)));
+                break;
+            default:
+                line[i] = qRgba(255, 255, 255, CHOP255(2.f * gain * float(value)));
+                break;
             }
         }
-        break;
     }
 
     if (drawAxis) {
@@ -9,9 +9,12 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include <QObject>
 #include "colorconstants.h"
+#include <memory>
+#include <vector>
 
 class QImage;
 class QSize;
+struct ScopeFrameAnalysis;
 
 class WaveformGenerator : public QObject
 {
@@ -25,4 +28,11 @@ public:
 
     QImage calculateWaveform(const QSize &waveformSize, const QImage &image, WaveformGenerator::PaintMode paintMode, bool drawAxis,
                              const ITURec rec, uint accelFactor = 1);
+    QImage calculateWaveform(const QSize &waveformSize, const std::shared_ptr<const ScopeFrameAnalysis> &analysis, WaveformGenerator::PaintMode paintMode,
+                             bool drawAxis, uint accelFactor = 1);
+
+private:
+    /** @brief Counting buffers kept between frames, the scope never computes two frames at once */
+    std::vector<uint> m_stripValues;
+    std::vector<uint> m_waveValues;
 };
@@ -122,6 +122,16 @@ void ScopeManager::slotDistributeAudio(const audioShortVector &sampleData, int f
     }
 }
 void ScopeManager::slotDistributeFrame(const QImage &image)
+{
+    distributeFrame([&image](AbstractGfxScopeWidget *scope) { scope->slotRenderZoneUpdated(image); });
+}
+
+void ScopeManager::slotDistributeSharedFrame(const SharedFrame &frame)
+{
+    distributeFrame([&frame](AbstractGfxScopeWidget *scope) { scope->slotRenderZoneUpdated(frame); });
+}
+
+void ScopeManager::distributeFrame(const std::function<void(AbstractGfxScopeWidget *)> &sendFrame)
 {
 #ifdef DEBUG_SM
     qCDebug(KDENLIVE_LOG) << "ScopeManager: Starting to distribute frame.";
@@ -129,7 +139,7 @@ void ScopeManager::slotDistributeFrame(const QImage &image)
     for (auto &m_colorScope : m_colorScopes) {
         if (!m_colorScope.scope->visibleRegion().isEmpty()) {
             if (m_colorScope.scope->autoRefreshEnabled()) {
-                m_colorScope.scope->slotRenderZoneUpdated(image);
+                sendFrame(m_colorScope.scope);
 #ifdef DEBUG_SM
                 qCDebug(KDENLIVE_LOG) << "ScopeManager: Distributed frame to " << m_colorScopes[i].scope->widgetName();
 #endif
@@ -137,7 +147,7 @@ void ScopeManager::slotDistributeFrame(const QImage &image)
                 // Special case: Auto refresh is disabled, but user requested an update (e.g. by clicking).
                 // Force the scope to update.
                 m_colorScope.singleFrameRequested = false;
-                m_colorScope.scope->slotRenderZoneUpdated(image);
+                sendFrame(m_colorScope.scope);
                 m_colorScope.scope->forceUpdateScope();
 #ifdef DEBUG_SM
                 qCDebug(KDENLIVE_LOG) << "ScopeManager: Distributed forced frame to " << m_colorScopes[i].scope->widgetName();
@@ -202,6 +212,7 @@ void ScopeManager::slotUpdateActiveRenderer()
     // Connect new renderer
     if (m_lastConnectedRenderer != nullptr) {
         connect(m_lastConnectedRenderer, &Monitor::frameUpdated, this, &ScopeManager::slotDistributeFrame, Qt::UniqueConnection);
+        connect(m_lastConnectedRenderer, &Monitor::scopeFrameUpdated, this, &ScopeManager::slotDistributeSharedFrame, Qt::UniqueConnection);
         connect(m_lastConnectedRenderer, &Monitor::audioSamplesSignal, this, &ScopeManager::slotDistributeAudio, Qt::UniqueConnection);
 
 #ifdef DEBUG_SM
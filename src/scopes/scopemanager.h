@@ -11,6 +11,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "colorscopes/abstractgfxscopewidget.h"
 
 #include <QList>
+#include <functional>
 
 class QDockWidget;
 class AbstractMonitor;
@@ -95,6 +96,10 @@ private:
       @param scopeWidget has to be of type AbstractAudioScopeWidget or AbstractGfxScopeWidget (@see addScope).
      */
     template <class T> void createScopeDock(T *scopeWidget, const QString &title, const QString &name);
+    /**
+      Calls @param sendFrame for each color scope that wants the new frame.
+     */
+    void distributeFrame(const std::function<void(AbstractGfxScopeWidget *)> &sendFrame);
 
 public Q_SLOTS:
     void slotCheckActiveScopes();
@@ -125,6 +130,7 @@ private Q_SLOTS:
     void checkActiveColourScopes();
 
     void slotDistributeFrame(const QImage &image);
+    void slotDistributeSharedFrame(const SharedFrame &frame);
     void slotDistributeAudio(const audioShortVector &sampleData, int freq, int num_channels, int num_samples);
     /**
       Allows a scope to explicitly request a new frame, even if the scope's autoRefresh is disabled.
@@ -19,8 +19,10 @@
 #include <KMessageBox>
 #include <QApplication>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QProgressDialog>
 #include <QSet>
+#include <QtConcurrent>
 #include <mlt++/MltField.h>
 #include <mlt++/MltMultitrack.h>
 #include <mlt++/MltProfile.h>
@@ -28,16 +30,117 @@
 #include <mlt++/MltTractor.h>
 #include <mlt++/MltTransition.h>
 #include <project/projectmanager.h>
+#include <unordered_map>
 
 static QStringList m_errorMessage;
 static QStringList m_notesLog;
 std::unordered_map<QString, QString> binIdCorresp;
 
+namespace {
+
+/** @brief A clip of a timeline playlist, read before the track is built */
+struct ClipLoadInfo
+{
+    std::shared_ptr<Mlt::Producer> clip;
+    int position;
+    mlt_service_type type;
+};
+
+/** @brief Clips of the playlists parsed by parseTimelinePlaylists, consumed when the track is built */
+using ParsedPlaylists = std::unordered_map<mlt_playlist, QVector<ClipLoadInfo>>;
+
+// This function tries to recover the state of the producer (audio or video or both)
+PlaylistState::ClipState inferState(const std::shared_ptr<Mlt::Producer> &prod, bool audioTrack)
+{
+    auto getProperty = [prod](const QString &name) {
+        if (prod->parent().is_valid()) {
+            return QString::fromUtf8(prod->parent().get(name.toUtf8().constData()));
+        }
+        return QString::fromUtf8(prod->get(name.toUtf8().constData()));
+    };
+    auto getIntProperty = [prod](const QString &name) {
+        if (prod->parent().is_valid()) {
+            return prod->parent().get_int(name.toUtf8().constData());
+        }
+        return prod->get_int(name.toUtf8().constData());
+    };
+    QString service = getProperty("mlt_service");
+    std::pair<bool, bool> VidAud{true, true};
+    VidAud.first = getIntProperty("set.test_image") == 0;
+    VidAud.second = getIntProperty("set.test_audio") == 0;
+    if (audioTrack || ((service.contains(QStringLiteral("avformat")) && getIntProperty(QStringLiteral("video_index")) == -1))) {
+        VidAud.first = false;
+    }
+    if (!audioTrack || ((service.contains(QStringLiteral("avformat")) && getIntProperty(QStringLiteral("audio_index")) == -1))) {
+        VidAud.second = false;
+    }
+    return stateFromBool(VidAud);
+}
+
+/** @brief Read the clips of @p playlist. This only reads the playlist entries and their cuts, which belong to this playlist,
+    so playlists can be parsed concurrently. The bin producers are shared between playlists and must not be read here. */
+QVector<ClipLoadInfo> parsePlaylist(Mlt::Playlist &playlist)
+{
+    QVector<ClipLoadInfo> entries;
+    int max = playlist.count();
+    entries.reserve(max);
+    for (int i = 0; i < max; i++) {
+        if (playlist.is_blank(i)) {
+            continue;
+        }
+        ClipLoadInfo info;
+        info.clip.reset(playlist.get_clip(i));
+        info.position = playlist.clip_start(i);
+        info.type = info.clip->type();
+        entries << info;
+    }
+    return entries;
+}
+
+/** @brief Parse the playlists of all timeline tracks of @p tractor in parallel.
+    Building the tracks then only has to insert the clips in the model, which is not thread safe. */
+ParsedPlaylists parseTimelinePlaylists(Mlt::Tractor &tractor, const QSet<QString> &reserved_names)
+{
+    struct PlaylistJob
+    {
+        std::shared_ptr<Mlt::Playlist> playlist;
+        QVector<ClipLoadInfo> entries;
+    };
+    std::vector<PlaylistJob> jobs;
+    for (int i = 0; i < tractor.count(); i++) {
+        std::unique_ptr<Mlt::Producer> track(tractor.track(i));
+        const QString playlist_name = track->property_exists("kdenlive:playlistid") ? track->get("kdenlive:playlistid") : track->get("id");
+        if (reserved_names.contains(playlist_name)) {
+            continue;
+        }
+        if (track->type() == mlt_service_tractor_type) {
+            Mlt::Tractor local_tractor(*track.get());
+            for (int j = 0; j < local_tractor.count(); j++) {
+                std::unique_ptr<Mlt::Producer> sub_track(local_tractor.track(j));
+                if (sub_track->type() == mlt_service_playlist_type) {
+                    jobs.push_back({std::make_shared<Mlt::Playlist>(*sub_track), {}});
+                }
+            }
+        } else if (track->type() == mlt_service_playlist_type) {
+            jobs.push_back({std::make_shared<Mlt::Playlist>(*track), {}});
+        }
+    }
+    QtConcurrent::blockingMap(jobs, [](PlaylistJob &job) { job.entries = parsePlaylist(*job.playlist); });
+    ParsedPlaylists parsedPlaylists;
+    for (auto &job : jobs) {
+        parsedPlaylists[job.playlist->get_playlist()] = std::move(job.entries);
+    }
+    return parsedPlaylists;
+}
+
+} // namespace
+
 bool constructTrackFromMelt(const std::shared_ptr<TimelineItemModel> &timeline, int tid, bool useMappedIds, const QString trackTag, Mlt::Tractor &track,
-                            Fun &undo, Fun &redo, bool audioTrack, const QString &originalDecimalPoint, QProgressDialog *progressDialog = nullptr);
+                            Fun &undo, Fun &redo, bool audioTrack, const QString &originalDecimalPoint, ParsedPlaylists *parsedPlaylists,
+                            QProgressDialog *progressDialog = nullptr);
 bool constructTrackFromMelt(const std::shared_ptr<TimelineItemModel> &timeline, int tid, bool useMappedIds, const QString trackTag, Mlt::Playlist &track,
                             Fun &undo, Fun &redo, bool audioTrack, const QString &originalDecimalPoint, int playlist,
-                            const QList<Mlt::Transition *> &compositions, QProgressDialog *progressDialog = nullptr);
+                            const QList<Mlt::Transition *> &compositions, ParsedPlaylists *parsedPlaylists, QProgressDialog *progressDialog = nullptr);
 
 bool loadProjectBin(Mlt::Tractor tractor, QProgressDialog *progressDialog)
 {
@@ -74,6 +177,8 @@ bool constructTimelineFromTractor(const std::shared_ptr<TimelineItemModel> &time
     Fun redo = []() { return true; };
     // First, we destruct the previous tracks
     timeline->requestReset(undo, redo);
+    QElapsedTimer timer;
+    timer.start();
     m_errorMessage.clear();
     m_notesLog.clear();
     bool useMappedIds = true;
@@ -107,6 +212,8 @@ bool constructTimelineFromTractor(const std::shared_ptr<TimelineItemModel> &time
         }
     }
 
+    qint64 binTime = timer.restart();
+
     QSet<QString> reserved_names{QLatin1String("playlistmain"), QLatin1String("timeline_preview"), QLatin1String("timeline_overlay"),
                                  QLatin1String("black_track"), QLatin1String("overlay_track")};
     bool ok = true;
@@ -154,6 +261,10 @@ bool constructTimelineFromTractor(const std::shared_ptr<TimelineItemModel> &time
         }
     }
 
+    // Read all tracks in parallel before inserting their clips
+    ParsedPlaylists parsedPlaylists = parseTimelinePlaylists(tractor, reserved_names);
+    qint64 parseTime = timer.restart();
+
     qDebug() << "=== OPENING FILE WITH TRACKS: " << tractor.count();
     for (int i = 0; i < tractor.count() && ok; i++) {
         std::unique_ptr<Mlt::Producer> track(tractor.track(i));
@@ -194,8 +305,8 @@ bool constructTimelineFromTractor(const std::shared_ptr<TimelineItemModel> &time
                 lockedTracksIndexes << tid;
             }
             const QString trackTag = audioTrack ? QStringLiteral("A%1").arg(aTracksCount - aTracks) : QStringLiteral("V%1").arg(vTracks);
-            ok = ok &&
-                 constructTrackFromMelt(timeline, tid, useMappedIds, trackTag, local_tractor, undo, redo, audioTrack, originalDecimalPoint, progressDialog);
+            ok = ok && constructTrackFromMelt(timeline, tid, useMappedIds, trackTag, local_tractor, undo, redo, audioTrack, originalDecimalPoint,
+                                              &parsedPlaylists, progressDialog);
             timeline->setTrackProperty(tid, QStringLiteral("kdenlive:thumbs_format"), track->get("kdenlive:thumbs_format"));
             timeline->setTrackProperty(tid, QStringLiteral("kdenlive:audio_rec"), track->get("kdenlive:audio_rec"));
             timeline->setTrackProperty(tid, QStringLiteral("kdenlive:timeline_active"), track->get("kdenlive:timeline_active"));
@@ -218,7 +329,7 @@ bool constructTimelineFromTractor(const std::shared_ptr<TimelineItemModel> &time
             }
             const QString trackTag = audioTrack ? QStringLiteral("A%1").arg(aTracksCount - aTracks) : QStringLiteral("V%1").arg(vTracks);
             ok = ok && constructTrackFromMelt(timeline, tid, useMappedIds, trackTag, local_playlist, undo, redo, audioTrack, originalDecimalPoint, 0,
-                                              QList<Mlt::Transition *>(), progressDialog);
+                                              QList<Mlt::Transition *>(), &parsedPlaylists, progressDialog);
             if (local_playlist.get_int("kdenlive:locked_track") > 0) {
                 lockedTracksIndexes << tid;
             }
@@ -232,6 +343,7 @@ bool constructTimelineFromTractor(const std::shared_ptr<TimelineItemModel> &time
         }
     }
     timeline->_resetView();
+    qint64 tracksTime = timer.restart();
 
     // Loading compositions
     Mlt::Service *prod = tractor.producer();
@@ -300,6 +412,7 @@ bool constructTimelineFromTractor(const std::shared_ptr<TimelineItemModel> &time
 
     // build internal track compositing
     timeline->buildTrackCompositing();
+    qDebug() << "Timeline loaded, bin:" << binTime << "ms, parsing:" << parseTime << "ms, tracks:" << tracksTime << "ms, compositions:" << timer.elapsed() << "ms";
 
     // load locked state as last step
     for (int tid : qAsConst(lockedTracksIndexes)) {
@@ -330,6 +443,8 @@ bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timelin
     Fun redo = []() { return true; };
     // First, we destruct the previous tracks
     timeline->requestReset(undo, redo);
+    QElapsedTimer timer;
+    timer.start();
     m_errorMessage.clear();
     m_notesLog.clear();
     QStringList expandedFolders;
@@ -349,6 +464,8 @@ bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timelin
         pCore->bin()->loadBinProperties(foldersToExpand, zoomLevel);
     }
 
+    qint64 binTime = timer.restart();
+
     QSet<QString> reserved_names{QLatin1String("playlistmain"), QLatin1String("timeline_preview"), QLatin1String("timeline_overlay"),
                                  QLatin1String("black_track"), QLatin1String("overlay_track")};
     bool ok = true;
@@ -397,6 +514,10 @@ bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timelin
         }
     }
 
+    // Read all tracks in parallel before inserting their clips
+    ParsedPlaylists parsedPlaylists = parseTimelinePlaylists(tractor, reserved_names);
+    qint64 parseTime = timer.restart();
+
     for (int i = 0; i < tractor.count() && ok; i++) {
         qDebug() << "::: PROCESSING TK " << i;
         std::unique_ptr<Mlt::Producer> track(tractor.track(i));
@@ -432,7 +553,8 @@ bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timelin
             }
             Mlt::Tractor local_tractor(*track);
             const QString trackTag = audioTrack ? QStringLiteral("A%1").arg(aTracksCount - aTracks) : QStringLiteral("V%1").arg(vTracks);
-            ok = ok && constructTrackFromMelt(timeline, tid, true, trackTag, local_tractor, undo, redo, audioTrack, originalDecimalPoint, progressDialog);
+            ok = ok && constructTrackFromMelt(timeline, tid, true, trackTag, local_tractor, undo, redo, audioTrack, originalDecimalPoint, &parsedPlaylists,
+                                              progressDialog);
             timeline->setTrackProperty(tid, QStringLiteral("kdenlive:thumbs_format"), track->get("kdenlive:thumbs_format"));
             timeline->setTrackProperty(tid, QStringLiteral("kdenlive:audio_rec"), track->get("kdenlive:audio_rec"));
             timeline->setTrackProperty(tid, QStringLiteral("kdenlive:timeline_active"), track->get("kdenlive:timeline_active"));
@@ -457,7 +579,7 @@ bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timelin
             }
             const QString trackTag = audioTrack ? QStringLiteral("A%1").arg(aTracksCount - aTracks) : QStringLiteral("V%1").arg(vTracks);
             ok = ok && constructTrackFromMelt(timeline, tid, true, trackTag, local_playlist, undo, redo, audioTrack, originalDecimalPoint, 0,
-                                              QList<Mlt::Transition *>(), progressDialog);
+                                              QList<Mlt::Transition *>(), &parsedPlaylists, progressDialog);
             if (local_playlist.get_int("kdenlive:locked_track") > 0) {
                 lockedTracksIndexes << tid;
             }
@@ -471,6 +593,7 @@ bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timelin
         }
     }
     timeline->_resetView();
+    qint64 tracksTime = timer.restart();
 
     // Loading compositions
     QScopedPointer<Mlt::Service> service(tractor.producer());
@@ -551,6 +674,7 @@ bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timelin
 
     // build internal track compositing
     timeline->buildTrackCompositing();
+    qDebug() << "Timeline loaded, bin:" << binTime << "ms, parsing:" << parseTime << "ms, tracks:" << tracksTime << "ms, compositions:" << timer.elapsed() << "ms";
 
     // load locked state as last step
     for (int tid : qAsConst(lockedTracksIndexes)) {
@@ -583,7 +707,8 @@ bool constructTimelineFromMelt(const std::shared_ptr<TimelineItemModel> &timelin
 }
 
 bool constructTrackFromMelt(const std::shared_ptr<TimelineItemModel> &timeline, int tid, bool useMappedIds, const QString trackTag, Mlt::Tractor &track,
-                            Fun &undo, Fun &redo, bool audioTrack, const QString &originalDecimalPoint, QProgressDialog *progressDialog)
+                            Fun &undo, Fun &redo, bool audioTrack, const QString &originalDecimalPoint, ParsedPlaylists *parsedPlaylists,
+                            QProgressDialog *progressDialog)
 {
     if (track.count() != 2) {
         // we expect a tractor with two tracks (a "fake" track)
@@ -612,7 +737,8 @@ bool constructTrackFromMelt(const std::shared_ptr<TimelineItemModel> &timeline,
             return false;
         }
         Mlt::Playlist playlist(*sub_track);
-        constructTrackFromMelt(timeline, tid, useMappedIds, trackTag, playlist, undo, redo, audioTrack, originalDecimalPoint, i, compositions, progressDialog);
+        constructTrackFromMelt(timeline, tid, useMappedIds, trackTag, playlist, undo, redo, audioTrack, originalDecimalPoint, i, compositions, parsedPlaylists,
+                               progressDialog);
         if (i == 0) {
             // Pass track properties
             int height = track.get_int("kdenlive:trackheight");
@@ -674,54 +800,32 @@ bool constructTrackFromMelt(const std::shared_ptr<TimelineItemModel> &timeline,
     return true;
 }
 
-namespace {
-
-// This function tries to recover the state of the producer (audio or video or both)
-PlaylistState::ClipState inferState(const std::shared_ptr<Mlt::Producer> &prod, bool audioTrack)
-{
-    auto getProperty = [prod](const QString &name) {
-        if (prod->parent().is_valid()) {
-            return QString::fromUtf8(prod->parent().get(name.toUtf8().constData()));
-        }
-        return QString::fromUtf8(prod->get(name.toUtf8().constData()));
-    };
-    auto getIntProperty = [prod](const QString &name) {
-        if (prod->parent().is_valid()) {
-            return prod->parent().get_int(name.toUtf8().constData());
-        }
-        return prod->get_int(name.toUtf8().constData());
-    };
-    QString service = getProperty("mlt_service");
-    std::pair<bool, bool> VidAud{true, true};
-    VidAud.first = getIntProperty("set.test_image") == 0;
-    VidAud.second = getIntProperty("set.test_audio") == 0;
-    if (audioTrack || ((service.contains(QStringLiteral("avformat")) && getIntProperty(QStringLiteral("video_index")) == -1))) {
-        VidAud.first = false;
-    }
-    if (!audioTrack || ((service.contains(QStringLiteral("avformat")) && getIntProperty(QStringLiteral("audio_index")) == -1))) {
-        VidAud.second = false;
-    }
-    return stateFromBool(VidAud);
-}
-} // namespace
-
 bool constructTrackFromMelt(const std::shared_ptr<TimelineItemModel> &timeline, int tid, bool useMappedIds, const QString trackTag, Mlt::Playlist &track,
                             Fun &undo, Fun &redo, bool audioTrack, const QString &originalDecimalPoint, int playlist,
-                            const QList<Mlt::Transition *> &compositions, QProgressDialog *progressDialog)
+                            const QList<Mlt::Transition *> &compositions, ParsedPlaylists *parsedPlaylists, QProgressDialog *progressDialog)
 {
-    int max = track.count();
-    for (int i = 0; i < max; i++) {
-        if (track.is_blank(i)) {
-            continue;
-        }
-        if (progressDialog) {
-            progressDialog->setValue(progressDialog->value() + 1);
-        } else {
-            Q_EMIT pCore->loadingMessageUpdated(QString(), 1);
+    QVector<ClipLoadInfo> entries;
+    bool parsed = false;
+    if (parsedPlaylists) {
+        auto it = parsedPlaylists->find(track.get_playlist());
+        if (it != parsedPlaylists->end()) {
+            entries = std::move(it->second);
+            parsedPlaylists->erase(it);
+            parsed = true;
         }
-        std::shared_ptr<Mlt::Producer> clip(track.get_clip(i));
-        int position = track.clip_start(i);
-        switch (clip->type()) {
+    }
+    if (!parsed) {
+        entries = parsePlaylist(track);
+    }
+    if (progressDialog) {
+        progressDialog->setValue(progressDialog->value() + entries.size());
+    } else if (!entries.isEmpty()) {
+        Q_EMIT pCore->loadingMessageUpdated(QString(), entries.size());
+    }
+    for (const ClipLoadInfo &entry : qAsConst(entries)) {
+        std::shared_ptr<Mlt::Producer> clip = entry.clip;
+        int position = entry.position;
+        switch (entry.type) {
         case mlt_service_unknown_type:
         case mlt_service_chain_type:
         case mlt_service_producer_type: {
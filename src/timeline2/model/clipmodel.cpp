@@ -882,6 +882,9 @@ void ClipModel::refreshProducerFromBin(int trackId, PlaylistState::ClipState sta
         m_producer->set("kdenlive:activeeffect", activeEffect);
     }
     m_endlessResize = !binClip->hasLimitedDuration();
+    if (auto ptr = m_parent.lock()) {
+        ptr->invalidateClipSnapshot(m_id);
+    }
 }
 
 void ClipModel::refreshProducerFromBin(int trackId)
@@ -1192,6 +1195,7 @@ Fun ClipModel::setClipState_lambda(PlaylistState::ClipState state)
     return [this, state]() {
         if (auto ptr = m_parent.lock()) {
             m_currentState = state;
+            ptr->invalidateClipSnapshot(m_id);
             // Enforce producer reload
             m_lastTrackId = -1;
             if (m_currentTrackId != -1 && ptr->isClip(m_id)) { // if this is false, the clip is being created. Don't update model in that case
@@ -22,6 +22,8 @@
 #include "transitions/transitionsrepository.hpp"
 #include <QDebug>
 #include <QFileInfo>
+#include <limits>
+#include <map>
 #include <mlt++/MltField.h>
 #include <mlt++/MltProfile.h>
 #include <mlt++/MltTractor.h>
@@ -47,6 +49,10 @@ TimelineItemModel::TimelineItemModel(const QUuid &uuid, std::weak_ptr<DocUndoSta
     : TimelineModel(uuid, std::move(undo_stack))
 {
     m_guidesModel->registerSnapModel(std::static_pointer_cast<SnapInterface>(m_snaps));
+    // Changes can also be sent directly by the items, without going through notifyChange
+    connect(this, &TimelineItemModel::dataChanged, this,
+            [this](const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles) { invalidateSnapshots(topleft, bottomright, roles); },
+            Qt::DirectConnection);
 }
 
 void TimelineItemModel::finishConstruct(const std::shared_ptr<TimelineItemModel> &ptr)
@@ -287,6 +293,12 @@ QHash<int, QByteArray> TimelineItemModel::roleNames() const
 
 QVariant TimelineItemModel::data(const QModelIndex &index, int role) const
 {
+    if (index.isValid() && isSnapshotRole(role)) {
+        QVariant value;
+        if (snapshotValue(int(index.internalId()), role, value)) {
+            return value;
+        }
+    }
     READ_LOCK();
     if (!m_tractor || !index.isValid()) {
         // qDebug() << "DATA abort. Index validity="<<index.isValid();
@@ -304,71 +316,31 @@ QVariant TimelineItemModel::data(const QModelIndex &index, int role) const
     }
     if (isClip(id)) {
         // qDebug() << "REQUESTING DATA "<<roleNames()[role]<<index;
+        if (isSnapshotRole(role)) {
+            // No snapshot yet, or the clip changed since it was built
+            return buildSnapshot(id, role);
+        }
         std::shared_ptr<ClipModel> clip = m_allClips.at(id);
         // Get data for a clip
         switch (role) {
-        // TODO
-        case NameRole:
-        case Qt::DisplayRole: {
-            return clip->clipName();
-        }
-        case ResourceRole: {
-            QString result = clip->getProperty("resource");
-            if (result == QLatin1String("<producer>")) {
-                result = clip->getProperty("mlt_service");
-            }
-            return result;
-        }
-        case StatusRole: {
-            return clip->clipStatus();
-        }
         case FakeTrackIdRole:
             return clip->getFakeTrackId();
         case FakePositionRole:
             return clip->getFakePosition();
-        case BinIdRole:
-            return clip->binId();
         case TrackIdRole:
             return clip->getCurrentTrackId();
-        case ServiceRole:
-            return clip->getProperty("mlt_service");
-            break;
-        case AudioChannelsRole:
-            return clip->audioChannels();
-        case AudioStreamRole:
-            return clip->audioStream();
-        case AudioMultiStreamRole:
-            return clip->audioMultiStream();
-        case AudioStreamIndexRole:
-            return clip->audioStreamIndex();
-        case HasAudio:
-            return clip->audioEnabled();
-        case IsAudioRole:
-            return clip->isAudioOnly();
-        case CanBeAudioRole:
-            return clip->canBeAudio();
-        case CanBeVideoRole:
-            return clip->canBeVideo();
         case MarkersRole: {
             return QVariant::fromValue<MarkerListModel *>(clip->getMarkerModel().get());
         }
         case KeyframesRole: {
             return QVariant::fromValue<KeyframeModel *>(clip->getKeyframeModel());
         }
-        case PlaylistStateRole:
-            return QVariant::fromValue(clip->clipState());
-        case TypeRole:
-            return QVariant::fromValue(clip->clipType());
         case StartRole:
             return clip->getPosition();
         case DurationRole:
             return clip->getPlaytime();
-        case MaxDurationRole:
-            return clip->getMaxDuration();
         case GroupedRole:
             return m_groups->isInGroup(id);
-        case EffectNamesRole:
-            return clip->effectNames();
         case InPointRole:
             return clip->getIn();
         case OutPointRole:
@@ -383,22 +355,14 @@ QVariant TimelineItemModel::data(const QModelIndex &index, int role) const
             return clip->getMixDuration();
         case MixCutRole:
             return clip->getMixCutPosition();
-        case ClipThumbRole:
-            return clip->clipThumbPath();
         case ReloadAudioThumbRole:
             return clip->forceThumbReload;
         case PositionOffsetRole:
             return clip->getOffset();
-        case SpeedRole:
-            return clip->getSpeed();
         case GrabbedRole:
             return clip->isGrabbed();
         case SelectedRole:
             return clip->selected;
-        case TagRole:
-            return clip->clipTag();
-        case TimeRemapRole:
-            return clip->hasTimeRemap();
         default:
             break;
         }
@@ -502,6 +466,284 @@ QVariant TimelineItemModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
+QVariant TimelineItemModel::ClipRoleSnapshot::value(int role) const
+{
+    switch (role) {
+    case NameRole:
+    case Qt::DisplayRole:
+        return name;
+    case ResourceRole:
+        return resource;
+    case ServiceRole:
+        return service;
+    case BinIdRole:
+        return binId;
+    case TagRole:
+        return tag;
+    case ClipThumbRole:
+        return thumbPath;
+    case EffectNamesRole:
+        return effectNames;
+    case StatusRole:
+        return status;
+    case PlaylistStateRole:
+        return QVariant::fromValue(state);
+    case TypeRole:
+        return QVariant::fromValue(type);
+    case AudioChannelsRole:
+        return audioChannels;
+    case AudioStreamRole:
+        return audioStream;
+    case AudioStreamIndexRole:
+        return audioStreamIndex;
+    case MaxDurationRole:
+        return maxDuration;
+    case SpeedRole:
+        return speed;
+    case AudioMultiStreamRole:
+        return audioMultiStream;
+    case HasAudio:
+        return audioEnabled;
+    case IsAudioRole:
+        return audioOnly;
+    case CanBeAudioRole:
+        return canBeAudio;
+    case CanBeVideoRole:
+        return canBeVideo;
+    case TimeRemapRole:
+        return timeRemap;
+    default:
+        return QVariant();
+    }
+}
+
+bool TimelineItemModel::isSnapshotRole(int role)
+{
+    switch (role) {
+    case NameRole:
+    case Qt::DisplayRole:
+    case ResourceRole:
+    case ServiceRole:
+    case BinIdRole:
+    case TagRole:
+    case ClipThumbRole:
+    case EffectNamesRole:
+    case StatusRole:
+    case PlaylistStateRole:
+    case TypeRole:
+    case AudioChannelsRole:
+    case AudioStreamRole:
+    case AudioStreamIndexRole:
+    case MaxDurationRole:
+    case SpeedRole:
+    case AudioMultiStreamRole:
+    case HasAudio:
+    case IsAudioRole:
+    case CanBeAudioRole:
+    case CanBeVideoRole:
+    case TimeRemapRole:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool TimelineItemModel::snapshotValue(int id, int role, QVariant &value) const
+{
+    QMutexLocker lock(&m_snapshotMutex);
+    auto it = m_snapshots.find(id);
+    if (it == m_snapshots.end()) {
+        return false;
+    }
+    value = it->second.value(role);
+    return true;
+}
+
+QVariant TimelineItemModel::buildSnapshot(int id, int role) const
+{
+    quint64 generation;
+    {
+        QMutexLocker lock(&m_snapshotMutex);
+        generation = m_snapshotGeneration;
+    }
+    std::shared_ptr<ClipModel> clip = m_allClips.at(id);
+    ClipRoleSnapshot snapshot;
+    snapshot.name = clip->clipName();
+    snapshot.resource = clip->getProperty("resource");
+    snapshot.service = clip->getProperty("mlt_service");
+    if (snapshot.resource == QLatin1String("<producer>")) {
+        snapshot.resource = snapshot.service;
+    }
+    snapshot.binId = clip->binId();
+    snapshot.tag = clip->clipTag();
+    snapshot.thumbPath = clip->clipThumbPath();
+    snapshot.effectNames = clip->effectNames();
+    snapshot.status = clip->clipStatus();
+    snapshot.state = clip->clipState();
+    snapshot.type = clip->clipType();
+    snapshot.audioChannels = clip->audioChannels();
+    snapshot.audioStream = clip->audioStream();
+    snapshot.audioStreamIndex = clip->audioStreamIndex();
+    snapshot.maxDuration = clip->getMaxDuration();
+    snapshot.speed = clip->getSpeed();
+    snapshot.audioMultiStream = clip->audioMultiStream();
+    snapshot.audioEnabled = clip->audioEnabled();
+    snapshot.audioOnly = clip->isAudioOnly();
+    snapshot.canBeAudio = clip->canBeAudio();
+    snapshot.canBeVideo = clip->canBeVideo();
+    snapshot.timeRemap = clip->hasTimeRemap();
+    QVariant value = snapshot.value(role);
+    QMutexLocker lock(&m_snapshotMutex);
+    if (generation == m_snapshotGeneration) {
+        // No change was notified while the values were read
+        m_snapshots[id] = std::move(snapshot);
+    }
+    return value;
+}
+
+void TimelineItemModel::invalidateSnapshots(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles)
+{
+    if (!topleft.isValid() || (!roles.isEmpty() && std::none_of(roles.cbegin(), roles.cend(), isSnapshotRole))) {
+        return;
+    }
+    if (topleft != bottomright && bottomright.isValid()) {
+        // Resolving the rows of a range needs the model, ranges are rare so drop everything
+        clearSnapshots();
+        return;
+    }
+    invalidateClipSnapshot(int(topleft.internalId()));
+}
+
+void TimelineItemModel::invalidateClipSnapshot(int clipId)
+{
+    QMutexLocker lock(&m_snapshotMutex);
+    m_snapshotGeneration++;
+    m_snapshots.erase(clipId);
+}
+
+void TimelineItemModel::clearSnapshots()
+{
+    QMutexLocker lock(&m_snapshotMutex);
+    m_snapshotGeneration++;
+    m_snapshots.clear();
+}
+
+void TimelineItemModel::queueChange(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles)
+{
+    if (!topleft.isValid()) {
+        return;
+    }
+    invalidateSnapshots(topleft, bottomright, roles);
+    // Only plain ids are stored here, indexes are built by flushChanges on the model thread
+    const int itemId = int(topleft.internalId());
+    QMutexLocker lock(&m_changesMutex);
+    if (topleft != bottomright && bottomright.isValid()) {
+        m_pendingRanges.push_back({itemId, bottomright.row() - topleft.row() + 1, roles});
+    } else {
+        auto found = m_pendingLookup.find(itemId);
+        if (found == m_pendingLookup.end()) {
+            m_pendingLookup[itemId] = m_pendingChanges.size();
+            m_pendingChanges.push_back({itemId, roles, roles.isEmpty()});
+        } else {
+            PendingChange &change = m_pendingChanges[found->second];
+            if (roles.isEmpty()) {
+                change.allRoles = true;
+            }
+            for (int role : roles) {
+                if (!change.roles.contains(role)) {
+                    change.roles.push_back(role);
+                }
+            }
+        }
+    }
+    if (!m_flushQueued) {
+        m_flushQueued = true;
+        QMetaObject::invokeMethod(this, [this]() { flushChanges(); }, Qt::QueuedConnection);
+    }
+}
+
+QModelIndex TimelineItemModel::indexFromItemId(int itemId) const
+{
+    if (isTrack(itemId)) {
+        return makeTrackIndexFromID(itemId);
+    }
+    if (isClip(itemId)) {
+        return makeClipIndexFromID(itemId);
+    }
+    if (isComposition(itemId) && getCompositionTrackId(itemId) != -1) {
+        return makeCompositionIndexFromID(itemId);
+    }
+    return {};
+}
+
+void TimelineItemModel::flushChanges()
+{
+    std::vector<PendingChange> changes;
+    std::vector<PendingRange> ranges;
+    {
+        QMutexLocker lock(&m_changesMutex);
+        changes.swap(m_pendingChanges);
+        ranges.swap(m_pendingRanges);
+        m_pendingLookup.clear();
+        m_flushQueued = false;
+    }
+    // Group the changes by parent, items that were removed in the meantime are skipped
+    std::map<quintptr, std::vector<std::pair<QModelIndex, const PendingChange *>>> rowsByParent;
+    std::vector<std::pair<QModelIndex, const PendingRange *>> rangeStarts;
+    {
+        READ_LOCK();
+        for (const PendingChange &change : changes) {
+            const QModelIndex ix = indexFromItemId(change.itemId);
+            if (!ix.isValid()) {
+                continue;
+            }
+            const QModelIndex parent = ix.parent();
+            const quintptr key = parent.isValid() ? parent.internalId() : std::numeric_limits<quintptr>::max();
+            rowsByParent[key].emplace_back(ix, &change);
+        }
+        for (const PendingRange &range : ranges) {
+            const QModelIndex ix = indexFromItemId(range.itemId);
+            if (ix.isValid()) {
+                rangeStarts.emplace_back(ix, &range);
+            }
+        }
+    }
+    for (auto &entry : rowsByParent) {
+        auto &rows = entry.second;
+        std::sort(rows.begin(), rows.end(), [](const std::pair<QModelIndex, const PendingChange *> &a, const std::pair<QModelIndex, const PendingChange *> &b) {
+            return a.first.row() < b.first.row();
+        });
+        size_t first = 0;
+        while (first < rows.size()) {
+            size_t last = first;
+            while (last + 1 < rows.size() && rows[last + 1].first.row() == rows[last].first.row() + 1) {
+                last++;
+            }
+            QVector<int> roles;
+            bool allRoles = false;
+            for (size_t i = first; i <= last; i++) {
+                const PendingChange *change = rows[i].second;
+                allRoles = allRoles || change->allRoles;
+                for (int role : change->roles) {
+                    if (!roles.contains(role)) {
+                        roles.push_back(role);
+                    }
+                }
+            }
+            if (allRoles) {
+                roles.clear();
+            }
+            Q_EMIT dataChanged(rows[first].first, rows[last].first, roles);
+            first = last + 1;
+        }
+    }
+    for (const auto &start : rangeStarts) {
+        const QModelIndex parent = start.first.parent();
+        const int last = std::min(start.first.row() + start.second->count, rowCount(parent)) - 1;
+        Q_EMIT dataChanged(start.first, index(last, 0, parent), start.second->roles);
+    }
+}
+
 void TimelineItemModel::setTrackName(int trackId, const QString &text)
 {
     QWriteLocker locker(&m_lock);
@@ -665,12 +907,12 @@ void TimelineItemModel::notifyChange(const QModelIndex &topleft, const QModelInd
             roles.push_back(TimelineModel::OutPointRole);
         }
     }
-    Q_EMIT dataChanged(topleft, bottomright, roles);
+    queueChange(topleft, bottomright, roles);
 }
 
 void TimelineItemModel::notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles)
 {
-    Q_EMIT dataChanged(topleft, bottomright, roles);
+    queueChange(topleft, bottomright, roles);
 }
 
 void TimelineItemModel::rebuildMixer()
@@ -781,12 +1023,18 @@ void TimelineItemModel::buildTrackCompositing(bool rebuild)
 
 void TimelineItemModel::notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, int role)
 {
-    Q_EMIT dataChanged(topleft, bottomright, {role});
+    queueChange(topleft, bottomright, {role});
 }
 
 void TimelineItemModel::_beginRemoveRows(const QModelIndex &i, int j, int k)
 {
     // qDebug()<<"FORWARDING beginRemoveRows"<<i<<j<<k;
+    if (i.isValid()) {
+        invalidateSnapshots(index(j, 0, i), index(k, 0, i), {});
+    } else {
+        // Removing tracks
+        clearSnapshots();
+    }
     beginRemoveRows(i, j, k);
 }
 void TimelineItemModel::_beginInsertRows(const QModelIndex &i, int j, int k)
@@ -807,6 +1055,7 @@ void TimelineItemModel::_endInsertRows()
 
 void TimelineItemModel::_resetView()
 {
+    clearSnapshots();
     beginResetModel();
     endResetModel();
 }
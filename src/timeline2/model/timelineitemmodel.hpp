@@ -8,6 +8,9 @@
 #include "timelinemodel.hpp"
 #include "undohelper.hpp"
 
+#include <QMutex>
+#include <unordered_map>
+
 class MarkerListModel;
 
 /** @class TimelineItemModel
@@ -26,6 +29,10 @@ class MarkerListModel;
    An ModelIndex in the ItemModel consists of a row number, a column number, and a parent index. In our case, tracks have always an empty parent, and the clip
    have a track index as parent.
    A ModelIndex can also store one additional integer, and we exploit this feature to store the unique ID of the object it corresponds to.
+
+   The clip roles that are read from MLT are kept in a snapshot per clip, so that the view can read them without locking the model.
+   A snapshot is dropped when the clip producer is rebuilt, when its bin clip changes or when a change of one of these roles is notified.
+   Changes passed to notifyChange are collected by item id and sent as one dataChanged per range of consecutive rows when control returns to the event loop.
    */
 class TimelineItemModel : public TimelineModel
 {
@@ -84,6 +91,7 @@ public:
     void notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, bool start, bool duration, bool updateThumb) override;
     void notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles) override;
     void notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, int role) override;
+    void invalidateClipSnapshot(int clipId) override;
 
     /** @brief Import track effects */
     void importTrackEffects(int tid, std::weak_ptr<Mlt::Service> service);
@@ -112,4 +120,74 @@ Q_SIGNALS:
     /** @brief Triggered when a video track visibility changed */
     void trackVisibilityChanged();
     void showTrackEffectStack(int tid);
+
+private:
+    /** @brief Values of the clip roles that need MLT access */
+    struct ClipRoleSnapshot
+    {
+        QString name;
+        QString resource;
+        QString service;
+        QString binId;
+        QString tag;
+        QString thumbPath;
+        QString effectNames;
+        FileStatus::ClipStatus status;
+        PlaylistState::ClipState state;
+        ClipType::ProducerType type;
+        int audioChannels;
+        int audioStream;
+        int audioStreamIndex;
+        int maxDuration;
+        double speed;
+        bool audioMultiStream;
+        bool audioEnabled;
+        bool audioOnly;
+        bool canBeAudio;
+        bool canBeVideo;
+        bool timeRemap;
+        QVariant value(int role) const;
+    };
+    /** @brief A change waiting to be sent by flushChanges, the item index is only resolved when flushing */
+    struct PendingChange
+    {
+        int itemId;
+        QVector<int> roles;
+        /// An empty list of roles was passed, meaning that all roles changed
+        bool allRoles;
+    };
+    /** @brief A change of @p count rows starting at item @p itemId */
+    struct PendingRange
+    {
+        int itemId;
+        int count;
+        QVector<int> roles;
+    };
+
+    /** @brief Returns true if @p role is read from the clip snapshots */
+    static bool isSnapshotRole(int role);
+    /** @brief Returns true and sets @p value if the snapshot of clip @p id exists */
+    bool snapshotValue(int id, int role, QVariant &value) const;
+    /** @brief Build the snapshot of clip @p id and returns the value of @p role. Called with the model locked */
+    QVariant buildSnapshot(int id, int role) const;
+    /** @brief Drop the snapshots of the items between @p topleft and @p bottomright if @p roles contains a snapshot role */
+    void invalidateSnapshots(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles);
+    void clearSnapshots();
+    /** @brief Add a change to the ones that will be sent by flushChanges, can be called from any thread */
+    void queueChange(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles);
+    /** @brief Returns the current index of the clip, composition or track @p itemId, or an invalid index if it was removed */
+    QModelIndex indexFromItemId(int itemId) const;
+    /** @brief Send the queued changes, merging the ones of consecutive rows */
+    void flushChanges();
+
+    mutable QMutex m_snapshotMutex;
+    mutable std::unordered_map<int, ClipRoleSnapshot> m_snapshots;
+    /// Incremented when snapshots are dropped, so that a snapshot built concurrently is not stored
+    quint64 m_snapshotGeneration{0};
+    QMutex m_changesMutex;
+    std::vector<PendingChange> m_pendingChanges;
+    std::vector<PendingRange> m_pendingRanges;
+    /// Position of the change queued for an item in m_pendingChanges, by item id
+    std::unordered_map<int, size_t> m_pendingLookup;
+    bool m_flushQueued{false};
 };
@@ -210,7 +210,7 @@ TimelineModel::~TimelineModel()
 
 int TimelineModel::getTracksCount() const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     int count = m_tractor->count();
     if (m_overlayTrackCount > -1) {
         count -= m_overlayTrackCount;
@@ -255,7 +255,7 @@ QList<int> TimelineModel::getTracksIds(bool audio) const
 int TimelineModel::getTrackIndexFromPosition(int pos) const
 {
     Q_ASSERT(pos >= 0 && pos < int(m_allTracks.size()));
-    READ_LOCK();
+    READ_LOCK_SHARED();
     auto it = m_allTracks.cbegin();
     while (pos > 0) {
         it++;
@@ -266,21 +266,21 @@ int TimelineModel::getTrackIndexFromPosition(int pos) const
 
 int TimelineModel::getClipsCount() const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     int size = int(m_allClips.size());
     return size;
 }
 
 int TimelineModel::getCompositionsCount() const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     int size = int(m_allCompositions.size());
     return size;
 }
 
 int TimelineModel::getClipTrackId(int clipId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(m_allClips.count(clipId) > 0);
     const auto clip = m_allClips.at(clipId);
     return clip->getCurrentTrackId();
@@ -295,7 +295,7 @@ int TimelineModel::getCompositionTrackId(int compoId) const
 
 int TimelineModel::getItemTrackId(int itemId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(isItem(itemId));
     if (isClip(itemId)) {
         return getClipTrackId(itemId);
@@ -321,7 +321,7 @@ bool TimelineModel::hasClipEndMix(int clipId) const
 
 int TimelineModel::getClipPosition(int clipId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(m_allClips.count(clipId) > 0);
     const auto clip = m_allClips.at(clipId);
     int pos = clip->getPosition();
@@ -330,7 +330,7 @@ int TimelineModel::getClipPosition(int clipId) const
 
 int TimelineModel::getClipEnd(int clipId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(m_allClips.count(clipId) > 0);
     const auto clip = m_allClips.at(clipId);
     int pos = clip->getPosition() + clip->getPlaytime();
@@ -339,7 +339,7 @@ int TimelineModel::getClipEnd(int clipId) const
 
 double TimelineModel::getClipSpeed(int clipId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(m_allClips.count(clipId) > 0);
     return m_allClips.at(clipId)->getSpeed();
 }
@@ -353,7 +353,7 @@ int TimelineModel::getClipSplitPartner(int clipId) const
 
 int TimelineModel::getClipIn(int clipId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(m_allClips.count(clipId) > 0);
     const auto clip = m_allClips.at(clipId);
     return clip->getIn();
@@ -361,7 +361,7 @@ int TimelineModel::getClipIn(int clipId) const
 
 QPoint TimelineModel::getClipInDuration(int clipId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(m_allClips.count(clipId) > 0);
     const auto clip = m_allClips.at(clipId);
     return {clip->getIn(), clip->getPlaytime()};
@@ -369,7 +369,7 @@ QPoint TimelineModel::getClipInDuration(int clipId) const
 
 PlaylistState::ClipState TimelineModel::getClipState(int clipId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(m_allClips.count(clipId) > 0);
     const auto clip = m_allClips.at(clipId);
     return clip->clipState();
@@ -377,7 +377,7 @@ PlaylistState::ClipState TimelineModel::getClipState(int clipId) const
 
 const QString TimelineModel::getClipBinId(int clipId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(m_allClips.count(clipId) > 0);
     const auto clip = m_allClips.at(clipId);
     QString id = clip->binId();
@@ -386,7 +386,7 @@ const QString TimelineModel::getClipBinId(int clipId) const
 
 int TimelineModel::getClipPlaytime(int clipId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(isClip(clipId));
     const auto clip = m_allClips.at(clipId);
     int playtime = clip->getPlaytime();
@@ -395,7 +395,7 @@ int TimelineModel::getClipPlaytime(int clipId) const
 
 QSize TimelineModel::getClipFrameSize(int clipId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(isClip(clipId));
     const auto clip = m_allClips.at(clipId);
     return clip->getFrameSize();
@@ -460,7 +460,7 @@ int TimelineModel::getSubtitleByPosition(int position) const
 
 int TimelineModel::getTrackPosition(int trackId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(isTrack(trackId));
     auto it = m_allTracks.cbegin();
     int pos = int(std::distance(it, static_cast<decltype(it)>(m_iteratorTable.at(trackId))));
@@ -469,7 +469,7 @@ int TimelineModel::getTrackPosition(int trackId) const
 
 int TimelineModel::getTrackMltIndex(int trackId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     // Because of the black track that we insert in first position, the mlt index is the position + 1
     return getTrackPosition(trackId) + 1;
 }
@@ -5155,7 +5155,7 @@ bool TimelineModel::requestCompositionMove(int compoId, int trackId, int positio
 
 bool TimelineModel::isAudioTrack(int trackId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(isTrack(trackId));
     auto it = m_iteratorTable.at(trackId);
     return (*it)->isAudioTrack();
@@ -5717,7 +5717,6 @@ void TimelineModel::requestClipReload(int clipId, int forceDuration)
     int oldPos = getClipPosition(clipId);
     int oldOut = getClipIn(clipId) + getClipPlaytime(clipId);
     int currentSubplaylist = m_allClips[clipId]->getSubPlaylistIndex();
-    int maxDuration = m_allClips[clipId]->getMaxDuration();
     bool hasPitch = false;
     double speed = m_allClips[clipId]->getSpeed();
     PlaylistState::ClipState state = m_allClips[clipId]->clipState();
@@ -5737,9 +5736,10 @@ void TimelineModel::requestClipReload(int clipId, int forceDuration)
             m_allClips[clipId]->requestResize(forceDuration, true, local_undo, local_redo);
         }
         getTrackById(old_trackId)->requestClipInsertion(clipId, oldPos, refreshView, true, local_undo, local_redo, false, false);
-        if (maxDuration != m_allClips[clipId]->getMaxDuration()) {
+        if (!refreshView) {
+            // The view was not told about the new producer, any role read from it may have changed
             QModelIndex ix = makeClipIndexFromID(clipId);
-            Q_EMIT dataChanged(ix, ix, {TimelineModel::MaxDurationRole});
+            notifyChange(ix, ix, QVector<int>());
         }
     }
 }
@@ -774,6 +774,8 @@ public:
 
     void requestClipReload(int clipId, int forceDuration = -1);
     void requestClipUpdate(int clipId, const QVector<int> &roles);
+    /** @brief Drop the cached view values of clip @p clipId, to be called whenever its producer or bin clip changes */
+    virtual void invalidateClipSnapshot(int clipId) = 0;
     /** @brief define current edit mode (normal, insert, overwrite */
     void setEditMode(TimelineMode::EditMode mode);
     TimelineMode::EditMode editMode() const;
@@ -100,6 +100,7 @@ TrackModel::~TrackModel()
         field->unlock();
         m_sameCompositions.clear();
         m_allClips.clear();
+        m_clipPos.clear();
         m_allCompositions.clear();
         m_track->remove_track(1);
         m_track->remove_track(0);
@@ -188,6 +189,7 @@ Fun TrackModel::requestClipInsertion_lambda(int clipId, int position, bool updat
             m_allClips[clip->getId()] = clip; // store clip
             // update clip position and track
             clip->setPosition(position);
+            updateClipPosition(clipId, -1, position);
             if (finalMove) {
                 clip->setSubPlaylistIndex(subPlaylist, m_id);
             }
@@ -437,6 +439,7 @@ Fun TrackModel::requestClipDeletion_lambda(int clipId, bool updateView, bool fin
             m_playlists[target_track].consolidate_blanks();
             m_allClips[clipId]->setCurrentTrackId(-1);
             // m_allClips[clipId]->setSubPlaylistIndex(-1);
+            updateClipPosition(clipId, m_allClips[clipId]->getPosition(), -1);
             m_allClips.erase(clipId);
             delete prod;
             field->unblock();
@@ -708,6 +711,7 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
             m_playlists[target_track].insert_blank(blank_index, delta - 1);
             if (!right) {
                 m_allClips[clipId]->setPosition(clip_position + delta);
+                updateClipPosition(clipId, clip_position, clip_position + delta);
                 // Because we inserted blank before, the index of our clip has increased
                 target_clip_mutable++;
             }
@@ -802,7 +806,9 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
                     // m_track->unblock();
                 }
                 if (!right && err == 0) {
+                    int old_position = m_allClips[clipId]->getPosition();
                     m_allClips[clipId]->setPosition(m_playlists[target_track].clip_start(target_clip_mutable));
+                    updateClipPosition(clipId, old_position, m_allClips[clipId]->getPosition());
                 }
                 if (err == 0) {
                     update_snaps(m_allClips[clipId]->getPosition(), m_allClips[clipId]->getPosition() + out - in + 1);
@@ -827,18 +833,22 @@ int TrackModel::getId() const
 
 int TrackModel::getClipByStartPosition(int position) const
 {
-    READ_LOCK();
-    for (auto &clip : m_allClips) {
-        if (clip.second->getPosition() == position) {
-            return clip.second->getId();
-        }
-    }
-    return -1;
+    READ_LOCK_SHARED();
+    auto it = m_clipPos.find(position);
+    return it == m_clipPos.end() ? -1 : it->second;
 }
 
 int TrackModel::getClipByPosition(int position, int playlist)
 {
     READ_LOCK();
+    const std::pair<int, int> clips = getClipsAt(position);
+    if (clips.first == -1) {
+        return -1;
+    }
+    if (playlist == -1 && clips.second == -1 && !hasMix(clips.first)) {
+        // Single clip, no need to ask the playlists
+        return clips.first;
+    }
     QSharedPointer<Mlt::Producer> prod(nullptr);
     if ((playlist == 0 || playlist == -1) && m_playlists[0].count() > 0) {
         prod = QSharedPointer<Mlt::Producer>(m_playlists[0].get_clip_at(position));
@@ -883,21 +893,22 @@ QSharedPointer<Mlt::Producer> TrackModel::getClipProducer(int clipId)
 int TrackModel::getCompositionByPosition(int position)
 {
     READ_LOCK();
-    for (const auto &comp : m_compoPos) {
-        if (comp.first == position) {
-            return comp.second;
-        } else if (comp.first < position) {
-            if (comp.first + m_allCompositions[comp.second]->getPlaytime() >= position) {
-                return comp.second;
-            }
+    // Compositions of a track do not overlap, so only the last two starting before position can match:
+    // one ending at position and one covering it. The first one wins.
+    int result = -1;
+    auto it = m_compoPos.upper_bound(position);
+    for (int i = 0; i < 2 && it != m_compoPos.begin(); ++i) {
+        --it;
+        if (it->first == position || it->first + m_allCompositions[it->second]->getPlaytime() >= position) {
+            result = it->second;
         }
     }
-    return -1;
+    return result;
 }
 
 int TrackModel::getClipByRow(int row) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     if (row >= static_cast<int>(m_allClips.size())) {
         return -1;
     }
@@ -910,22 +921,22 @@ std::unordered_set<int> TrackModel::getClipsInRange(int position, int end)
 {
     READ_LOCK();
     std::unordered_set<int> ids;
-    for (const auto &clp : m_allClips) {
-        int pos = clp.second->getPosition();
-        int length = clp.second->getPlaytime();
-        if (end > -1 && pos >= end) {
-            continue;
-        }
-        if (pos >= position || pos + length - 1 >= position) {
-            ids.insert(clp.first);
+    // Clips starting before the range and covering its start
+    const std::pair<int, int> clips = getClipsAt(position);
+    for (int cid : {clips.first, clips.second}) {
+        if (cid > -1 && (end == -1 || m_allClips.at(cid)->getPosition() < end)) {
+            ids.insert(cid);
         }
     }
+    for (auto it = m_clipPos.lower_bound(position); it != m_clipPos.end() && (end == -1 || it->first < end); ++it) {
+        ids.insert(it->second);
+    }
     return ids;
 }
 
 int TrackModel::getRowfromClip(int clipId) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(m_allClips.count(clipId) > 0);
     return int(std::distance(m_allClips.begin(), m_allClips.find(clipId)));
 }
@@ -951,7 +962,7 @@ std::unordered_set<int> TrackModel::getCompositionsInRange(int position, int end
 
 int TrackModel::getRowfromComposition(int tid) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     Q_ASSERT(m_allCompositions.count(tid) > 0);
     return int(m_allClips.size()) + int(std::distance(m_allCompositions.begin(), m_allCompositions.find(tid)));
 }
@@ -1099,6 +1110,19 @@ bool TrackModel::checkConsistency()
         return false;
     }
 
+    // Check the clip position index
+    if (m_allClips.size() != m_clipPos.size()) {
+        qDebug() << "Error: the number of clip positions doesn't match number of clips";
+        return false;
+    }
+    for (const auto &c : clips) {
+        auto it = m_clipPos.find(c.first);
+        if (it == m_clipPos.end() || it->second != c.second) {
+            qDebug() << "Error: the position of clip " << c.second << " is not properly stored";
+            return false;
+        }
+    }
+
     // We now check compositions positions
     if (m_allCompositions.size() != m_compoPos.size()) {
         qDebug() << "Error: the number of compositions position doesn't match number of compositions";
@@ -1219,21 +1243,52 @@ bool TrackModel::isBlankAt(int position, int playlist)
 
 int TrackModel::getNextBlankStart(int position)
 {
-    while (!isBlankAt(position)) {
-        int end1 = getClipEnd(position, 0);
-        int end2 = getClipEnd(position, 1);
-        if (end1 > position) {
-            position = end1;
-        } else if (end2 > position) {
-            position = end2;
-        } else {
-            // We reached playlist end
-            return -1;
+    READ_LOCK();
+    // Jump to the end of the clips covering position until we reach a blank
+    std::pair<int, int> clips = getClipsAt(position);
+    while (clips.first > -1) {
+        int end = 0;
+        for (int cid : {clips.first, clips.second}) {
+            if (cid > -1) {
+                end = std::max(end, m_allClips.at(cid)->getPosition() + m_allClips.at(cid)->getPlaytime());
+            }
         }
+        position = end;
+        clips = getClipsAt(position);
     }
     return getBlankStart(position);
 }
 
+std::pair<int, int> TrackModel::getClipsAt(int position) const
+{
+    std::pair<int, int> result{-1, -1};
+    // A clip only overlaps its neighbour when they are mixed, so only the two last clips
+    // starting at or before position can cover it
+    auto it = m_clipPos.upper_bound(position);
+    for (int i = 0; i < 2 && it != m_clipPos.begin(); ++i) {
+        --it;
+        if (it->first + m_allClips.at(it->second)->getPlaytime() > position) {
+            result = {it->second, result.first};
+        }
+    }
+    return result;
+}
+
+void TrackModel::updateClipPosition(int clipId, int oldPosition, int newPosition)
+{
+    if (oldPosition > -1) {
+        auto it = m_clipPos.find(oldPosition);
+        if (it != m_clipPos.end() && it->second == clipId) {
+            m_clipPos.erase(it);
+        }
+    }
+    if (newPosition > -1) {
+        // Two clips of a track never start on the same frame, not even in a mix
+        Q_ASSERT(m_clipPos.count(newPosition) == 0 || m_clipPos.at(newPosition) == clipId);
+        m_clipPos[newPosition] = clipId;
+    }
+}
+
 int TrackModel::getBlankStart(int position)
 {
     READ_LOCK();
@@ -1464,7 +1519,7 @@ Fun TrackModel::requestCompositionDeletion_lambda(int compoId, bool updateView,
 
 int TrackModel::getCompositionByRow(int row) const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     if (row < int(m_allClips.size())) {
         return -1;
     }
@@ -1476,7 +1531,7 @@ int TrackModel::getCompositionByRow(int row) const
 
 int TrackModel::getCompositionsCount() const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     return int(m_allCompositions.size());
 }
 
@@ -1571,19 +1626,19 @@ int TrackModel::trackDuration() const
 
 bool TrackModel::isLocked() const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     return m_track->get_int("kdenlive:locked_track");
 }
 
 bool TrackModel::isTimelineActive() const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     return m_track->get_int("kdenlive:timeline_active");
 }
 
 bool TrackModel::shouldReceiveTimelineOp() const
 {
-    READ_LOCK();
+    READ_LOCK_SHARED();
     return isTimelineActive() && !isLocked();
 }
 
@@ -277,6 +277,12 @@ protected:
 
     /** @brief This is an helper function that checks in all playlists if the given position is a blank */
     bool isBlankAt(int position, int playlist = -1);
+    /** @brief Returns the ids of the clips covering the given position, the second one being set when two mixed clips overlap.
+     *  Ids are -1 if there is no such clip, the first id is the clip starting first */
+    std::pair<int, int> getClipsAt(int position) const;
+    /** @brief Updates the start position of a clip in the position index. Use -1 as @param oldPosition for an inserted clip
+     *  and as @param newPosition for a removed clip */
+    void updateClipPosition(int clipId, int oldPosition, int newPosition);
 
     /** @brief This is an helper function that returns the end of the blank that covers given position */
     int getBlankEnd(int position);
@@ -367,6 +373,11 @@ private:
      *  those positions here to check for moves and resize
      */
     std::map<int, int> m_compoPos;
+    /** Start position of each clip, in both playlists, mapped to the clip id. This allows position queries
+     *  without walking all clips or asking the MLT playlists. It is updated along with the clip positions
+     *  in the insertion, deletion and resize lambdas.
+     */
+    std::map<int, int> m_clipPos;
 
     /// This is a lock that ensures safety in case of concurrent access
     mutable QReadWriteLock m_lock;
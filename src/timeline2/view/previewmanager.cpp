@@ -24,10 +24,10 @@
 #include <QMutexLocker>
 #include <QSaveFile>
 #include <QStandardPaths>
+#include <QThread>
 
 PreviewManager::PreviewManager(Mlt::Tractor *tractor, QUuid uuid, QObject *parent)
     : QObject(parent)
-    , workingPreview(-1)
     , m_tractor(tractor)
     , m_uuid(uuid)
     , m_previewTrack(nullptr)
@@ -38,7 +38,6 @@ PreviewManager::PreviewManager(Mlt::Tractor *tractor, QUuid uuid, QObject *paren
 {
     m_previewGatherTimer.setSingleShot(true);
     m_previewGatherTimer.setInterval(200);
-    QObject::connect(&m_previewProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &PreviewManager::processEnded);
 
     // Find path for Kdenlive renderer
 #ifdef Q_OS_WIN
@@ -53,8 +52,6 @@ PreviewManager::PreviewManager(Mlt::Tractor *tractor, QUuid uuid, QObject *paren
                                i18n("Could not find the kdenlive_render application, something is wrong with your installation. Rendering will not work"));
         }
     }
-    connect(this, &PreviewManager::abortPreview, &m_previewProcess, &QProcess::kill, Qt::DirectConnection);
-    connect(&m_previewProcess, &QProcess::readyReadStandardError, this, &PreviewManager::receivedStderr);
 }
 
 PreviewManager::~PreviewManager()
@@ -481,12 +478,12 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
     }
     if (add) {
         Q_EMIT dirtyChunksChanged();
-        if (m_previewProcess.state() == QProcess::NotRunning && KdenliveSettings::autopreview()) {
+        if (!processRunning() && KdenliveSettings::autopreview()) {
             m_previewTimer.start();
         }
     } else {
         // Remove processed chunks
-        bool isRendering = m_previewProcess.state() != QProcess::NotRunning;
+        bool isRendering = processRunning();
         m_previewGatherTimer.stop();
         abortRendering();
         m_tractor->lock();
@@ -516,16 +513,19 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
 
 void PreviewManager::abortRendering()
 {
-    if (m_previewProcess.state() == QProcess::NotRunning) {
+    if (!processRunning()) {
         return;
     }
     // Don't display error message on voluntary abort
     m_warnOnCrash = false;
+    m_chunkQueue.clear();
     Q_EMIT abortPreview();
-    m_previewProcess.waitForFinished();
-    if (m_previewProcess.state() != QProcess::NotRunning) {
-        m_previewProcess.kill();
-        m_previewProcess.waitForFinished();
+    for (QProcess *process : qAsConst(m_previewProcesses)) {
+        process->waitForFinished();
+        if (process->state() != QProcess::NotRunning) {
+            process->kill();
+            process->waitForFinished();
+        }
     }
     // Re-init time estimation
     Q_EMIT previewRender(-1, QString(), 1000);
@@ -563,18 +563,60 @@ void PreviewManager::startPreviewRender()
     }
 }
 
-void PreviewManager::receivedStderr()
+int PreviewManager::workerCount()
+{
+    // Each process already uses several encoding threads
+    return qBound(1, QThread::idealThreadCount() / 4, 8);
+}
+
+QVariantList PreviewManager::workingPreviews() const
+{
+    QVariantList chunks;
+    for (int chunk : m_workerChunks) {
+        if (chunk >= 0) {
+            chunks << chunk;
+        }
+    }
+    std::sort(chunks.begin(), chunks.end(), chunkSort);
+    return chunks;
+}
+
+bool PreviewManager::processRunning() const
+{
+    for (QProcess *process : m_previewProcesses) {
+        if (process->state() != QProcess::NotRunning) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PreviewManager::feedProcess(QProcess *process)
 {
-    QStringList resultList = QString::fromLocal8Bit(m_previewProcess.readAllStandardError()).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+    if (m_workerChunks.value(process, -1) >= 0) {
+        m_workerChunks[process] = -1;
+        Q_EMIT workingPreviewChanged();
+    }
+    if (m_chunkQueue.isEmpty()) {
+        process->closeWriteChannel();
+        return;
+    }
+    process->write(QByteArray::number(m_chunkQueue.takeFirst()) + '\n');
+}
+
+void PreviewManager::receivedStderr(QProcess *process)
+{
+    QStringList resultList = QString::fromLocal8Bit(process->readAllStandardError()).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
     for (auto &result : resultList) {
         if (result.startsWith(QLatin1String("START:"))) {
-            if (m_previewProcess.state() == QProcess::Running) {
-                workingPreview = result.section(QLatin1String("START:"), 1).simplified().toInt();
+            if (process->state() == QProcess::Running) {
+                m_workerChunks[process] = result.section(QLatin1String("START:"), 1).simplified().toInt();
                 Q_EMIT workingPreviewChanged();
             }
         } else if (result.startsWith(QLatin1String("DONE:"))) {
             int chunk = result.section(QLatin1String("DONE:"), 1).simplified().toInt();
             m_processedChunks++;
+            feedProcess(process);
             QString fileName = QStringLiteral("%1.%2").arg(chunk).arg(m_extension);
             Q_EMIT previewRender(chunk, m_cacheDir.absoluteFilePath(fileName), 1000 * m_processedChunks / m_chunksToRender);
         } else {
@@ -590,44 +632,83 @@ void PreviewManager::doPreviewRender(const QString &scene)
         return;
     }
     QMutexLocker lock(&m_dirtyMutex);
-    Q_ASSERT(m_previewProcess.state() == QProcess::NotRunning);
+    Q_ASSERT(!processRunning());
     std::sort(m_dirtyChunks.begin(), m_dirtyChunks.end(), chunkSort);
-    const QStringList dirtyChunks = getCompressedList(m_dirtyChunks);
-    m_chunksToRender = m_dirtyChunks.count();
+    // Render the chunks closest to the playhead first
+    const int position = pCore->getMonitorPosition();
+    m_chunkQueue.clear();
+    for (const QVariant &chunk : qAsConst(m_dirtyChunks)) {
+        m_chunkQueue << chunk.toInt();
+    }
+    std::stable_sort(m_chunkQueue.begin(), m_chunkQueue.end(), [position](int c1, int c2) { return qAbs(c1 - position) < qAbs(c2 - position); });
+    m_chunksToRender = m_chunkQueue.count();
     m_processedChunks = 0;
+    m_renderFailed = false;
     int chunkSize = KdenliveSettings::timelinechunks();
     QStringList args{QStringLiteral("preview-chunks"),
                      scene,
                      m_cacheDir.absolutePath(),
-                     dirtyChunks.join(QLatin1Char(',')),
+                     QStringLiteral("-"),
                      QString::number(chunkSize - 1),
                      pCore->getCurrentProfilePath(),
                      m_extension,
                      m_consumerParams.join(QLatin1Char(' '))};
+    const int workers = qMin(workerCount(), m_chunkQueue.count());
+    while (m_previewProcesses.count() < workers) {
+        auto *process = new QProcess(this);
+        connect(this, &PreviewManager::abortPreview, process, &QProcess::kill, Qt::DirectConnection);
+        connect(process, &QProcess::readyReadStandardError, this, [this, process]() { receivedStderr(process); });
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+                [this, process](int exitCode, QProcess::ExitStatus status) { processEnded(process, exitCode, status); });
+        m_previewProcesses << process;
+    }
     pCore->currentDoc()->previewProgress(0);
-    m_previewProcess.start(m_renderer, args);
-    if (m_previewProcess.waitForStarted()) {
-        qDebug() << " -  - -STARTING PREVIEW JOBS . . . STARTED";
+    m_workerChunks.clear();
+    m_runningProcesses = 0;
+    for (int i = 0; i < workers; ++i) {
+        QProcess *process = m_previewProcesses.at(i);
+        process->start(m_renderer, args);
+        if (process->waitForStarted()) {
+            m_runningProcesses++;
+            feedProcess(process);
+        }
     }
+    qDebug() << " -  - -STARTING PREVIEW JOBS . . . STARTED" << m_runningProcesses << "PROCESSES";
 }
 
-void PreviewManager::processEnded(int exitCode, QProcess::ExitStatus status)
+void PreviewManager::processEnded(QProcess *process, int exitCode, QProcess::ExitStatus status)
 {
-    const QString sceneList = m_cacheDir.absoluteFilePath(QStringLiteral("preview.mlt"));
-    QFile::remove(sceneList);
+    m_runningProcesses--;
+    const int chunk = m_workerChunks.value(process, -1);
+    m_workerChunks.remove(process);
     if (pCore->window() && (status == QProcess::QProcess::CrashExit || exitCode != 0)) {
-        Q_EMIT previewRender(0, m_errorLog, -1);
-        if (workingPreview >= 0) {
-            const QString fileName = QStringLiteral("%1.%2").arg(workingPreview).arg(m_extension);
+        if (chunk >= 0) {
+            const QString fileName = QStringLiteral("%1.%2").arg(chunk).arg(m_extension);
             if (m_cacheDir.exists(fileName)) {
                 m_cacheDir.remove(fileName);
             }
         }
-    } else {
-        // Normal exit and exit code 0: everything okay
+        if (!m_renderFailed) {
+            // Report the error once and stop the other processes
+            m_renderFailed = true;
+            m_chunkQueue.clear();
+            Q_EMIT previewRender(0, m_errorLog, -1);
+            Q_EMIT abortPreview();
+        }
+    }
+    if (m_runningProcesses > 0) {
+        if (chunk >= 0) {
+            Q_EMIT workingPreviewChanged();
+        }
+        return;
+    }
+    const QString sceneList = m_cacheDir.absoluteFilePath(QStringLiteral("preview.mlt"));
+    QFile::remove(sceneList);
+    if (!m_renderFailed) {
+        // Normal exit and exit code 0 for all processes: everything okay
         pCore->currentDoc()->previewProgress(1000);
     }
-    workingPreview = -1;
+    m_workerChunks.clear();
     m_warnOnCrash = true;
     Q_EMIT workingPreviewChanged();
 }
@@ -672,7 +753,7 @@ void PreviewManager::invalidatePreview(int startFrame, int endFrame)
     int end = endFrame - endFrame % chunkSize;
 
     m_previewGatherTimer.stop();
-    bool previewWasRunning = m_previewProcess.state() == QProcess::Running;
+    bool previewWasRunning = processRunning();
     bool alreadyRendered = false;
     bool wasInDirtyZone = false;
     if (!m_renderedChunks.isEmpty()) {
@@ -680,8 +761,13 @@ void PreviewManager::invalidatePreview(int startFrame, int endFrame)
         std::sort(m_renderedChunks.begin(), m_renderedChunks.end(), chunkSort);
         if (start <= m_renderedChunks.last().toInt() && end >= m_renderedChunks.first().toInt()) {
             alreadyRendered = true;
-        } else if (workingPreview >= start && workingPreview <= end) {
-            alreadyRendered = true;
+        } else {
+            for (int chunk : qAsConst(m_workerChunks)) {
+                if (chunk >= start && chunk <= end) {
+                    alreadyRendered = true;
+                    break;
+                }
+            }
         }
     }
     if (!alreadyRendered && !m_dirtyChunks.isEmpty()) {
@@ -803,10 +889,13 @@ void PreviewManager::gotPreviewRender(int frame, const QString &file, int progre
 
 void PreviewManager::corruptedChunk(int frame, const QString &fileName)
 {
+    m_chunkQueue.clear();
     Q_EMIT abortPreview();
-    m_previewProcess.waitForFinished();
-    if (workingPreview >= 0) {
-        workingPreview = -1;
+    for (QProcess *process : qAsConst(m_previewProcesses)) {
+        process->waitForFinished();
+    }
+    if (!m_workerChunks.isEmpty()) {
+        m_workerChunks.clear();
         Q_EMIT workingPreviewChanged();
     }
     Q_EMIT previewRender(0, m_errorLog, -1);
@@ -905,5 +994,5 @@ int PreviewManager::addedTracks() const
 
 bool PreviewManager::isRunning() const
 {
-    return workingPreview >= 0 || m_previewProcess.state() != QProcess::NotRunning;
+    return !workingPreviews().isEmpty() || processRunning();
 }
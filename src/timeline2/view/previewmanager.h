@@ -10,6 +10,7 @@
 
 #include <QDir>
 #include <QFuture>
+#include <QHash>
 #include <QMutex>
 #include <QProcess>
 #include <QTimer>
@@ -68,8 +69,8 @@ public:
     int setOverlayTrack(Mlt::Playlist *overlay);
     /** @brief Remove the effect compare overlay track */
     void removeOverlayTrack();
-    /** @brief The current preview chunk being processed, -1 if none */
-    int workingPreview;
+    /** @brief The preview chunks currently rendered, one per busy render process */
+    QVariantList workingPreviews() const;
     /** @brief Returns the list of existing chunks */
     QPair<QStringList, QStringList> previewChunks();
     bool hasOverlayTrack() const;
@@ -89,8 +90,16 @@ private:
     int m_previewTrackIndex;
     /** @brief: The kdenlive renderer app. */
     QString m_renderer;
-    /** @brief: The kdenlive timeline preview process. */
-    QProcess m_previewProcess;
+    /** @brief: The kdenlive timeline preview processes, they all pull their chunks from m_chunkQueue. */
+    QList<QProcess *> m_previewProcesses;
+    /** @brief: The chunk currently rendered by each process, -1 if it is waiting for one */
+    QHash<QProcess *, int> m_workerChunks;
+    /** @brief: The chunks not yet sent to a render process, closest to the playhead first */
+    QList<int> m_chunkQueue;
+    /** @brief: The count of render processes that did not exit yet */
+    int m_runningProcesses{0};
+    /** @brief: True if a render process of the current job crashed or failed */
+    bool m_renderFailed{false};
     /** @brief: The directory used to store the preview files. */
     QDir m_cacheDir;
     /** @brief: The directory used to store undo history of preview files (child of m_cacheDir). */
@@ -118,6 +127,13 @@ private:
     /** @brief: Get a compressed list of chunks, like: "0-500,525,575". */
     const QStringList getCompressedList(const QVariantList items) const;
 
+    /** @brief: Number of render processes to use, derived from the processor count. */
+    static int workerCount();
+    /** @brief: Returns true if one of the render processes is running. */
+    bool processRunning() const;
+    /** @brief: Send the next queued chunk to @param process, or tell it to stop if the queue is empty. */
+    void feedProcess(QProcess *process);
+
     /** @brief Compare two chunks for usage by std::sort
      * @returns true if @param c1 is less than @param c2
      */
@@ -133,8 +149,8 @@ private Q_SLOTS:
     /** @brief: When the timer collecting invalid zones is done, process. */
     void slotProcessDirtyChunks();
     /** @brief: Process preview rendering output. */
-    void receivedStderr();
-    void processEnded(int exitCode, QProcess::ExitStatus status);
+    void receivedStderr(QProcess *process);
+    void processEnded(QProcess *process, int exitCode, QProcess::ExitStatus status);
 
 public Q_SLOTS:
     /** @brief: Prepare and start rendering. */
@@ -18,7 +18,6 @@ Item {
     // The space we want between each ticks in the ruler
     property real tickSpacing: timeline.scaleFactor
     property alias rulerZone : zone
-    property int workingPreview : timeline.workingPreview
     property int labelMod: 1
     property bool useTimelineRuler : timeline.useRuler
     property int zoneHeight: Math.ceil(root.baseUnit / 2) + 1
@@ -85,15 +84,17 @@ Item {
             color: 'darkgreen'
         }
     }
-    Rectangle {
-        id: working
-        x: rulerRoot.workingPreview * timeline.scaleFactor
-        anchors.bottom: parent.bottom
-        anchors.bottomMargin: zoneHeight
-        width: 25 * timeline.scaleFactor
-        height: previewHeight
-        color: 'orange'
-        visible: rulerRoot.workingPreview > -1
+    Repeater {
+        model: timeline.workingPreviews
+        anchors.fill: parent
+        delegate: Rectangle {
+            x: modelData * timeline.scaleFactor
+            anchors.bottom: parent.bottom
+            anchors.bottomMargin: zoneHeight
+            width: 25 * timeline.scaleFactor
+            height: previewHeight
+            color: 'orange'
+        }
     }
 
     // Guides
@@ -9,12 +9,17 @@
 #include "capture/mediacapture.h"
 #include "core.h"
 #include "kdenlivesettings.h"
+#include "lib/audio/audioLevels.h"
+#include "lib/audio/audioPeakPyramid.h"
+#include <QCache>
 #include <QElapsedTimer>
+#include <QMutex>
 #include <QPainter>
 #include <QPainterPath>
 #include <QQuickPaintedItem>
 #include <QtMath>
 #include <cmath>
+#include <vector>
 
 class TimelineTriangle : public QQuickPaintedItem
 {
@@ -68,6 +73,43 @@ private:
     QColor m_color;
 };
 
+namespace {
+// Width of the rasterized waveform tiles, in pixels
+constexpr int WaveformTileWidth = 256;
+
+/** @brief Waveform tiles shared by all timeline clips, so that scrolling or recreating
+ *  the clip items blits the tiles already drawn at the current zoom level. */
+class WaveformTileCache
+{
+public:
+    static WaveformTileCache &get()
+    {
+        static WaveformTileCache cache;
+        return cache;
+    }
+    bool find(const QString &key, QImage &tile)
+    {
+        QMutexLocker lock(&m_mutex);
+        QImage *cached = m_tiles.object(key);
+        if (cached == nullptr) {
+            return false;
+        }
+        tile = *cached;
+        return true;
+    }
+    void insert(const QString &key, const QImage &tile)
+    {
+        QMutexLocker lock(&m_mutex);
+        m_tiles.insert(key, new QImage(tile), qMax(1, int(tile.sizeInBytes())));
+    }
+
+private:
+    QMutex m_mutex;
+    // Cost is the size of the tiles in bytes
+    QCache<QString, QImage> m_tiles{64 * 1024 * 1024};
+};
+} // namespace
+
 class TimelineWaveform : public QQuickPaintedItem
 {
     Q_OBJECT
@@ -105,11 +147,11 @@ public:
         // setTextureSize(QSize(1, 1));
         connect(this, &TimelineWaveform::levelsChanged, [&]() {
             if (!m_binId.isEmpty()) {
-                if (m_audioLevels.isEmpty() && m_stream >= 0) {
+                if (!m_levels && m_stream >= 0) {
                     update();
                 } else {
                     // Clip changed, reset levels
-                    m_audioLevels.clear();
+                    m_levels.reset();
                 }
             }
         });
@@ -125,164 +167,197 @@ public:
         if (m_binId.isEmpty()) {
             return;
         }
-        if (m_audioLevels.isEmpty() && m_stream >= 0) {
-            m_audioLevels = pCore->projectItemModel()->getAudioLevelsByBinID(m_binId, m_stream);
-            if (m_audioLevels.isEmpty()) {
+        if (!m_levels && m_stream >= 0) {
+            m_levels = pCore->projectItemModel()->getAudioLevelsByBinID(m_binId, m_stream);
+            if (!m_levels || m_levels->isEmpty()) {
+                m_levels.reset();
                 return;
             }
             m_audioMax = KdenliveSettings::normalizechannels() ? pCore->projectItemModel()->getAudioMaxLevel(m_binId, m_stream) : 0;
         }
-
-        if (m_outPoint == m_inPoint) {
+        if (!m_levels || m_outPoint == m_inPoint || m_channels <= 0) {
             return;
         }
-        QRectF bgRect(0, 0, width(), height());
         if (m_opaquePaint) {
-            painter->fillRect(bgRect, m_bgColor);
+            painter->fillRect(QRectF(0, 0, width(), height()), m_bgColor);
         }
-        QPen pen(painter->pen());
-        double increment = qMax(1., m_scale / m_channels);           // qMax(1., 1. / qAbs(indicesPrPixel));
-        qreal indicesPrPixel = m_channels / m_scale * qAbs(m_speed); // qreal(m_outPoint - m_inPoint) / width() * m_precisionFactor;
-        int h = int(height());
-        double offset = 0;
-        bool pathDraw = increment > 1.2;
-        if (increment > 1. && !pathDraw) {
-            pen.setWidth(int(ceil(increment)));
-            offset = pen.width() / 2.;
-            pen.setColor(m_color);
-            pen.setCapStyle(Qt::FlatCap);
-        } else if (pathDraw) {
-            pen.setWidth(0);
-            painter->setBrush(m_color);
-            pen.setColor(m_bgColor.darker(200));
+        const double framesPerPixel = qAbs(m_speed) / m_scale;
+        const bool reverse = m_speed < 0;
+        if (reverse) {
+            m_inPoint = qMin(m_inPoint, int(m_levels->size()) - m_channels);
+        }
+        // The waveform is drawn in tiles of the whole clip at this zoom level, startPixel is the tile pixel at our in point
+        const qint64 startPixel = qint64(m_inPoint / m_channels / framesPerPixel);
+        const qint64 w = qint64(ceil(width()));
+        const qreal dpr = painter->device() ? painter->device()->devicePixelRatioF() : 1.;
+        const QString keyBase = QStringLiteral("%1:%2:%3:%4:%5:%6:%7:%8:%9")
+                                    .arg(m_levels->pyramid().serial())
+                                    .arg(framesPerPixel, 0, 'g', 12)
+                                    .arg(int(height()))
+                                    .arg(dpr)
+                                    .arg(int(KdenliveSettings::displayallchannels()))
+                                    .arg(m_audioMax)
+                                    .arg(m_bgColor.rgba())
+                                    .arg(m_color.rgba())
+                                    .arg(m_color2.rgba());
+        painter->save();
+        qint64 firstTile;
+        qint64 lastTile;
+        if (reverse) {
+            // Item pixel x shows tile pixel startPixel - x
+            painter->translate(startPixel + 1, 0);
+            painter->scale(-1, 1);
+            firstTile = qMax(qint64(0), startPixel - w) / WaveformTileWidth;
+            lastTile = startPixel / WaveformTileWidth;
         } else {
-            pen.setColor(m_color);
+            painter->translate(-startPixel, 0);
+            firstTile = startPixel / WaveformTileWidth;
+            lastTile = (startPixel + w) / WaveformTileWidth;
         }
-        painter->setPen(pen);
+        for (qint64 tile = firstTile; tile <= lastTile; ++tile) {
+            const QString key = keyBase + QLatin1Char(':') + QString::number(tile);
+            QImage image;
+            if (!WaveformTileCache::get().find(key, image)) {
+                image = renderTile(tile, framesPerPixel, dpr);
+                WaveformTileCache::get().insert(key, image);
+            }
+            painter->drawImage(QPointF(tile * WaveformTileWidth, 0), image);
+        }
+        painter->restore();
+
+        if (m_firstChunk && KdenliveSettings::displayallchannels() && m_channels > 1 && m_channels < 7) {
+            const QStringList chanelNames{"L", "R", "C", "LFE", "BL", "BR"};
+            double channelHeight = height() / m_channels;
+            for (int channel = 0; channel < m_channels; channel++) {
+                painter->setPen(channel % 2 == 0 ? m_color : m_color2);
+                painter->drawText(2, int((channel + 1) * channelHeight), chanelNames[channel]);
+            }
+        }
+    }
+
+Q_SIGNALS:
+    void levelsChanged();
+    void propertyChanged();
+    void normalizeChanged();
+    void inPointChanged();
+    void audioChannelsChanged();
+
+private:
+    /** @brief Draw tile @p tile of the waveform, the tile pixel p showing the frames [p * framesPerPixel, (p + 1) * framesPerPixel) */
+    QImage renderTile(qint64 tile, double framesPerPixel, qreal dpr) const
+    {
+        const int h = int(height());
+        QImage image(QSize(int(ceil(WaveformTileWidth * dpr)), int(ceil(h * dpr))), QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(dpr);
+        image.fill(Qt::transparent);
+        // Peak of each tile column, one row per channel
+        const qint64 firstPixel = tile * WaveformTileWidth;
+        const AudioPeakPyramid &pyramid = m_levels->pyramid();
+        const int channels = pyramid.channels();
+        int columns = 0;
+        std::vector<quint8> peaks(size_t(WaveformTileWidth) * size_t(channels));
+        for (; columns < WaveformTileWidth; ++columns) {
+            const auto first = qint64((firstPixel + columns) * framesPerPixel);
+            if (first >= pyramid.frames()) {
+                break;
+            }
+            const auto last = qint64((firstPixel + columns + 1) * framesPerPixel);
+            for (int channel = 0; channel < channels; ++channel) {
+                peaks[size_t(channel) * WaveformTileWidth + size_t(columns)] = pyramid.peak(channel, first, last);
+            }
+        }
+        if (columns == 0) {
+            return image;
+        }
+        QPainter painter(&image);
+        QPen pen(painter.pen());
+        // When zoomed in, a frame spans several pixels, draw it as an outlined path
+        const bool pathDraw = framesPerPixel < 1 / 1.2;
         double scaleFactor = 255;
         if (m_audioMax > 1) {
             scaleFactor = m_audioMax;
         }
-        bool reverse = m_speed < 0;
-        int maxLength = m_audioLevels.length();
-        if (reverse) {
-            m_inPoint = qMin(m_inPoint, maxLength - m_channels);
-        }
-        int startPos = int(m_inPoint / indicesPrPixel);
         if (!KdenliveSettings::displayallchannels()) {
             // Draw merged channels
-            double i = 0;
-            int j = 0;
-            int idx = 0;
-            QPainterPath path;
-            if (pathDraw) {
-                path.moveTo(j - 1, height());
-            }
-            for (; i <= width(); j++) {
-                double level;
-                i = j * increment;
-                if (reverse) {
-                    idx = qCeil((startPos - i) * indicesPrPixel);
-                    idx -= idx % m_channels;
-                } else {
-                    idx = qCeil((startPos + i) * indicesPrPixel);
-                    idx += idx % m_channels;
-                }
-                i -= offset;
-                if (idx + m_channels >= maxLength || idx < 0) {
-                    break;
+            std::vector<quint8> merged(peaks.begin(), peaks.begin() + columns);
+            for (int channel = 1; channel < channels; ++channel) {
+                const quint8 *row = peaks.data() + size_t(channel) * WaveformTileWidth;
+                for (int x = 0; x < columns; ++x) {
+                    merged[size_t(x)] = qMax(merged[size_t(x)], row[x]);
                 }
-                level = m_audioLevels.at(idx) / scaleFactor;
-                for (int k = 1; k < m_channels; k++) {
-                    level = qMax(level, m_audioLevels.at(idx + k) / scaleFactor);
+            }
+            if (pathDraw) {
+                pen.setWidth(0);
+                pen.setColor(m_bgColor.darker(200));
+                painter.setPen(pen);
+                painter.setBrush(m_color);
+                // Start and end outside of the tile so that the outline is not drawn on its borders
+                const double left = -1;
+                const double right = columns == WaveformTileWidth ? columns + 1 : columns;
+                QPainterPath path;
+                path.moveTo(left, h);
+                for (int x = 0; x < columns; ++x) {
+                    double val = h - qMin(1., merged[size_t(x)] / scaleFactor) * h;
+                    path.lineTo(x == 0 ? left : x, val);
+                    path.lineTo(x + 1 == columns ? right : x + 1, val);
                 }
-                if (pathDraw) {
-                    double val = height() - level * height();
-                    path.lineTo(i, val);
-                    path.lineTo((j + 1) * increment - offset, val);
-                } else {
-                    painter->drawLine(int(i), h, int(i), int(h - (h * level)));
+                path.lineTo(right, h);
+                painter.drawPath(path);
+            } else {
+                pen.setColor(m_color);
+                painter.setPen(pen);
+                for (int x = 0; x < columns; ++x) {
+                    painter.drawLine(x, h, x, int(h - h * qMin(1., merged[size_t(x)] / scaleFactor)));
                 }
             }
-            if (pathDraw) {
-                path.lineTo(i, height());
-                painter->drawPath(path);
+            return image;
+        }
+        // Draw separate channels
+        double channelHeight = double(h) / channels;
+        QRectF bgRect(0, 0, WaveformTileWidth, channelHeight);
+        scaleFactor = channelHeight / (2 * scaleFactor);
+        for (int channel = 0; channel < channels; channel++) {
+            // y is channel median pos
+            double y = (channel * channelHeight) + channelHeight / 2;
+            const quint8 *row = peaks.data() + size_t(channel) * WaveformTileWidth;
+            if (channel % 2 == 0) {
+                // Add dark background on odd channels
+                painter.setOpacity(0.2);
+                bgRect.moveTo(0, channel * channelHeight);
+                painter.fillRect(bgRect, Qt::black);
             }
-        } else {
-            double channelHeight = height() / m_channels;
-            QPen pen(painter->pen());
-            // Draw separate channels
-            scaleFactor = channelHeight / (2 * scaleFactor);
-            bgRect.setHeight(channelHeight);
-            // Path for vector drawing
-            for (int channel = 0; channel < m_channels; channel++) {
-                double level;
-                // y is channel median pos
-                double y = (channel * channelHeight) + channelHeight / 2;
+            // Draw channel median line
+            pen.setColor(channel % 2 == 0 ? m_color : m_color2);
+            painter.setBrush(channel % 2 == 0 ? m_color : m_color2);
+            painter.setOpacity(0.5);
+            pen.setWidthF(0);
+            painter.setPen(pen);
+            painter.drawLine(QLineF(0., y, WaveformTileWidth, y));
+            painter.setOpacity(1);
+            if (pathDraw) {
+                painter.setPen(Qt::NoPen);
                 QPainterPath path;
                 path.moveTo(-1, y);
-                if (channel % 2 == 0) {
-                    // Add dark background on odd channels
-                    painter->setOpacity(0.2);
-                    bgRect.moveTo(0, channel * channelHeight);
-                    painter->fillRect(bgRect, Qt::black);
+                for (int x = 0; x < columns; ++x) {
+                    double level = row[x] * scaleFactor;
+                    path.lineTo(x, y - level);
+                    path.lineTo(x + 1, y - level);
                 }
-                // Draw channel median line
-                pen.setColor(channel % 2 == 0 ? m_color : m_color2);
-                painter->setBrush(channel % 2 == 0 ? m_color : m_color2);
-                painter->setOpacity(0.5);
-                pen.setWidthF(0);
-                painter->setPen(pen);
-                painter->drawLine(QLineF(0., y, width(), y));
-                pen.setWidth(int(ceil(increment)));
-                painter->setPen(pathDraw ? Qt::NoPen : pen);
-                painter->setOpacity(1);
-                double i = 0;
-                int j = 0;
-                int idx = 0;
-                for (; i <= width(); j++) {
-                    i = j * increment;
-                    if (reverse) {
-                        idx = qCeil((startPos - i) * indicesPrPixel);
-                        idx -= idx % m_channels;
-                    } else {
-                        idx = qCeil((startPos + i) * indicesPrPixel);
-                        idx += idx % m_channels;
-                    }
-                    i -= offset;
-                    idx += channel;
-                    if (idx >= maxLength || idx < 0) break;
-                    if (pathDraw) {
-                        level = m_audioLevels.at(idx) * scaleFactor;
-                        path.lineTo(i, y - level);
-                    } else {
-                        level = m_audioLevels.at(idx) * scaleFactor; // divide height by 510 (2*255) to get height
-                        painter->drawLine(int(i), int(y - level), int(i), int(y + level));
-                    }
-                }
-                if (pathDraw) {
-                    path.lineTo(i, y);
-                    painter->drawPath(path);
-                    QTransform tr(1, 0, 0, -1, 0, 2 * y);
-                    painter->drawPath(tr.map(path));
-                }
-                if (m_firstChunk && m_channels > 1 && m_channels < 7) {
-                    const QStringList chanelNames{"L", "R", "C", "LFE", "BL", "BR"};
-                    painter->drawText(2, int(y + channelHeight / 2), chanelNames[channel]);
+                path.lineTo(columns, y);
+                painter.drawPath(path);
+                QTransform tr(1, 0, 0, -1, 0, 2 * y);
+                painter.drawPath(tr.map(path));
+            } else {
+                for (int x = 0; x < columns; ++x) {
+                    double level = row[x] * scaleFactor; // divide height by 510 (2*255) to get height
+                    painter.drawLine(x, int(y - level), x, int(y + level));
                 }
             }
         }
+        return image;
     }
 
-Q_SIGNALS:
-    void levelsChanged();
-    void propertyChanged();
-    void normalizeChanged();
-    void inPointChanged();
-    void audioChannelsChanged();
-
-private:
-    QVector<uint8_t> m_audioLevels;
+    AudioLevelsPtr m_levels;
     int m_inPoint;
     int m_outPoint;
     QString m_binId;
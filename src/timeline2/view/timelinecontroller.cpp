@@ -2594,9 +2594,9 @@ QVariantList TimelineController::renderedChunks() const
     return m_model->hasTimelinePreview() ? m_model->previewManager()->m_renderedChunks : QVariantList();
 }
 
-int TimelineController::workingPreview() const
+QVariantList TimelineController::workingPreviews() const
 {
-    return m_model->hasTimelinePreview() ? m_model->previewManager()->workingPreview : -1;
+    return m_model->hasTimelinePreview() ? m_model->previewManager()->workingPreviews() : QVariantList();
 }
 
 bool TimelineController::useRuler() const
@@ -3297,17 +3297,42 @@ void TimelineController::setAudioRef(int clipId)
     m_audioRef = clipId;
     std::unique_ptr<AudioEnvelope> envelope(new AudioEnvelope(getClipBinId(clipId), clipId));
     m_audioCorrelator.reset(new AudioCorrelation(std::move(envelope)));
-    connect(m_audioCorrelator.get(), &AudioCorrelation::gotAudioAlignData, this, [&](int cid, int shift) {
-        // Ensure the clip was not deleted while processing calculations
-        if (m_model->isClip(cid)) {
-            int pos = m_model->getClipPosition(m_audioRef) + shift - m_model->getClipIn(m_audioRef);
-            bool result = m_model->requestClipMove(cid, m_model->getClipTrackId(cid), pos, true, true, true);
-            if (!result) {
-                pCore->displayMessage(i18n("Cannot move clip to frame %1.", (pos + shift)), ErrorMessage, 500);
-            }
-        } else {
+    connect(m_audioCorrelator.get(), &AudioCorrelation::gotAudioAlignBatch, this, [this](const QVector<AudioCorrelation::AlignResult> &results) {
+        if (!m_model->isClip(m_audioRef)) {
             // Clip was deleted, discard audio reference
             m_audioRef = -1;
+            return;
+        }
+        // All clips of the batch are moved in a single undo operation
+        Fun undo = []() { return true; };
+        Fun redo = []() { return true; };
+        int moved = 0;
+        for (const AudioCorrelation::AlignResult &result : results) {
+            // Ensure the clip was not deleted while processing calculations
+            if (!m_model->isClip(result.clipId)) {
+                continue;
+            }
+            if (result.confidence <= 0.) {
+                // Flat correlation, most likely a silent clip
+                qCDebug(KDENLIVE_LOG) << "No audio match found for clip" << result.clipId;
+                continue;
+            }
+            int pos = m_model->getClipPosition(m_audioRef) + result.shift - m_model->getClipIn(m_audioRef);
+            bool ok = true;
+            if (m_model->m_groups->isInGroup(result.clipId)) {
+                int groupId = m_model->m_groups->getRootId(result.clipId);
+                ok = m_model->requestGroupMove(result.clipId, groupId, 0, pos - m_model->getClipPosition(result.clipId), true, true, undo, redo);
+            } else {
+                ok = m_model->requestClipMove(result.clipId, m_model->getClipTrackId(result.clipId), pos, true, true, true, true, undo, redo);
+            }
+            if (ok) {
+                moved++;
+            } else {
+                pCore->displayMessage(i18n("Cannot move clip to frame %1.", pos), ErrorMessage, 500);
+            }
+        }
+        if (moved > 0) {
+            pCore->pushUndo(undo, redo, i18np("Align clip", "Align %1 clips", moved));
         }
     });
     connect(m_audioCorrelator.get(), &AudioCorrelation::displayMessage, pCore.get(), &Core::displayMessage);
@@ -3336,6 +3361,7 @@ void TimelineController::alignAudio(int clipId)
         clipsToAnalyse.insert(clipId);
     }
     QList<int> processedGroups;
+    QList<AudioEnvelope *> envelopes;
     int processed = 0;
     for (int cid : clipsToAnalyse) {
         if (!m_model->isClip(cid) || cid == m_audioRef) {
@@ -3373,10 +3399,11 @@ void TimelineController::alignAudio(int clipId)
         }
         processed++;
         // Perform audio calculation
-        auto *envelope =
-            new AudioEnvelope(otherBinId, cid, size_t(m_model->getClipIn(cid)), size_t(m_model->getClipPlaytime(cid)), size_t(m_model->getClipPosition(cid)));
-        m_audioCorrelator->addChild(envelope);
+        envelopes << new AudioEnvelope(otherBinId, cid, size_t(m_model->getClipIn(cid)), size_t(m_model->getClipPlaytime(cid)),
+                                       size_t(m_model->getClipPosition(cid)));
     }
+    // The clips are correlated in parallel and moved together once all are processed
+    m_audioCorrelator->addChildren(envelopes);
     if (processed == 0) {
         // TODO: improve feedback message after freeze
         pCore->displayMessage(i18n("Select a clip to apply an effect"), ErrorMessage, 500);
@@ -44,7 +44,7 @@ class TimelineController : public QObject
     Q_PROPERTY(QVariantList dirtyChunks READ dirtyChunks NOTIFY dirtyChunksChanged)
     Q_PROPERTY(QVariantList renderedChunks READ renderedChunks NOTIFY renderedChunksChanged)
     Q_PROPERTY(QVariantList masterEffectZones MEMBER m_masterEffectZones NOTIFY masterZonesChanged)
-    Q_PROPERTY(int workingPreview READ workingPreview NOTIFY workingPreviewChanged)
+    Q_PROPERTY(QVariantList workingPreviews READ workingPreviews NOTIFY workingPreviewChanged)
     Q_PROPERTY(bool useRuler READ useRuler NOTIFY useRulerChanged)
     Q_PROPERTY(bool scrollVertically READ scrollVertically NOTIFY scrollVerticallyChanged)
     Q_PROPERTY(int activeTrack READ activeTrack WRITE setActiveTrack NOTIFY activeTrackChanged)
@@ -575,9 +575,9 @@ public:
     void stopPreviewRender();
     QVariantList dirtyChunks() const;
     QVariantList renderedChunks() const;
-    /** @brief returns the frame currently processed by timeline preview, -1 if none
+    /** @brief returns the chunks currently processed by timeline preview, one per render process
      */
-    int workingPreview() const;
+    QVariantList workingPreviews() const;
 
     /** @brief Return true if we want to use timeline ruler zone for editing */
     bool useRuler() const;
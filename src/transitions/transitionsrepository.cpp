@@ -4,6 +4,7 @@
 */
 
 #include "transitionsrepository.hpp"
+#include "assets/assetcache.h"
 #include "core.h"
 #include "kdenlivesettings.h"
 #include "xml/xml.hpp"
@@ -100,6 +101,16 @@ std::unique_ptr<TransitionsRepository> &TransitionsRepository::get()
     return instance;
 }
 
+void TransitionsRepository::preloadCache()
+{
+    AssetCache::preload(QStringLiteral("transitions"));
+}
+
+QString TransitionsRepository::assetCacheName() const
+{
+    return QStringLiteral("transitions");
+}
+
 QStringList TransitionsRepository::assetDirs() const
 {
     return QStandardPaths::locateAll(QStandardPaths::AppDataLocation, QStringLiteral("transitions"), QStandardPaths::LocateDirectory);
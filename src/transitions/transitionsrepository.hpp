@@ -22,6 +22,8 @@ class TransitionsRepository : public AbstractAssetsRepository<AssetListType::Ass
 public:
     /** @brief Returns the instance of the Singleton */
     static std::unique_ptr<TransitionsRepository> &get();
+    /** @brief Start reading the startup cache in a worker thread, to be called before MLT is initialized */
+    static void preloadCache();
 
     /** @brief Creates and return an instance of a transition given its id.
      */
@@ -57,6 +59,8 @@ protected:
     /** @brief Returns the path to the effects' preferred list*/
     QString assetPreferredListPath() const override;
 
+    QString assetCacheName() const override;
+
     void parseType(Mlt::Properties *metadata, Info &res) override;
 
     /** @brief Returns the metadata associated with the given asset*/
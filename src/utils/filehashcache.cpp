@@ -0,0 +1,221 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "filehashcache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include <QtConcurrent>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+std::unique_ptr<FileHashCache> FileHashCache::instance;
+std::once_flag FileHashCache::m_onceFlag;
+
+namespace {
+constexpr quint32 CacheMagic = 0x4b484331; // "KHC1"
+// Files larger than this are identified by their first and last chunk
+constexpr qint64 ChunkSize = 1000000;
+// Forget everything if the cache grows beyond this, entries are tiny but should not accumulate forever
+constexpr int MaxEntries = 200000;
+} // namespace
+
+FileHashCache::FileHashCache()
+{
+    load();
+}
+
+FileHashCache::~FileHashCache() = default;
+
+std::unique_ptr<FileHashCache> &FileHashCache::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new FileHashCache()); });
+    return instance;
+}
+
+bool FileHashCache::fileStat(const QString &path, Entry &entry)
+{
+#ifdef Q_OS_UNIX
+    // A single stat call gives everything we need, and the inode detects files replaced by another one
+    struct stat info;
+    if (::stat(QFile::encodeName(path).constData(), &info) != 0 || !S_ISREG(info.st_mode)) {
+        return false;
+    }
+    entry.size = qint64(info.st_size);
+#if defined(Q_OS_MACOS)
+    entry.modified = qint64(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+    entry.modified = qint64(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+    entry.inode = quint64(info.st_ino);
+#else
+    const QFileInfo info(path);
+    if (!info.isFile()) {
+        return false;
+    }
+    entry.size = info.size();
+    entry.modified = info.lastModified().toMSecsSinceEpoch();
+    entry.inode = 0;
+#endif
+    return true;
+}
+
+QPair<QByteArray, qint64> FileHashCache::computeHash(const QString &path)
+{
+    QFile file(path);
+    QByteArray fileHash;
+    qint64 fSize = 0;
+    // Unbuffered, the data is read straight into our buffer
+    if (file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        /*
+         * 1 MB = 1 second per 450 files (or faster)
+         * 10 MB = 9 seconds per 450 files (or faster)
+         */
+        QCryptographicHash hasher(QCryptographicHash::Md5);
+        fSize = file.size();
+        QByteArray buffer;
+        if (fSize > 2 * ChunkSize) {
+            buffer.resize(int(ChunkSize));
+            qint64 read = file.read(buffer.data(), ChunkSize);
+            if (read > 0) {
+                hasher.addData(buffer.constData(), int(read));
+            }
+            if (file.seek(fSize - ChunkSize)) {
+                read = file.read(buffer.data(), ChunkSize);
+                if (read > 0) {
+                    hasher.addData(buffer.constData(), int(read));
+                }
+            }
+        } else {
+            buffer.resize(int(fSize));
+            const qint64 read = file.read(buffer.data(), fSize);
+            if (read > 0) {
+                hasher.addData(buffer.constData(), int(read));
+            }
+        }
+        file.close();
+        fileHash = hasher.result();
+    }
+    return {fileHash, fSize};
+}
+
+QPair<QByteArray, qint64> FileHashCache::hash(const QString &path)
+{
+    Entry current;
+    if (!fileStat(path, current)) {
+        // Not a regular file, nothing to remember
+        return computeHash(path);
+    }
+    {
+        QMutexLocker lock(&m_mutex);
+        auto it = m_entries.constFind(path);
+        if (it != m_entries.constEnd() && it->size == current.size && it->modified == current.modified && it->inode == current.inode) {
+            m_stats.hits++;
+            return {it->hash, it->size};
+        }
+        m_stats.misses++;
+    }
+    const QPair<QByteArray, qint64> result = computeHash(path);
+    if (result.first.isEmpty()) {
+        return result;
+    }
+    current.hash = result.first;
+    QMutexLocker lock(&m_mutex);
+    if (m_entries.size() >= MaxEntries) {
+        m_entries.clear();
+    }
+    m_entries.insert(path, current);
+    m_modified = true;
+    return result;
+}
+
+QHash<QString, QPair<QByteArray, qint64>> FileHashCache::hashFiles(const QStringList &paths)
+{
+    QVector<QPair<QString, QPair<QByteArray, qint64>>> results;
+    results.reserve(paths.size());
+    for (const QString &path : paths) {
+        results.append({path, {}});
+    }
+    QtConcurrent::blockingMap(results, [this](QPair<QString, QPair<QByteArray, qint64>> &item) { item.second = hash(item.first); });
+    QHash<QString, QPair<QByteArray, qint64>> hashes;
+    for (const auto &item : qAsConst(results)) {
+        hashes.insert(item.first, item.second);
+    }
+    return hashes;
+}
+
+FileHashCache::Stats FileHashCache::stats() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_stats;
+}
+
+void FileHashCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_entries.clear();
+    m_modified = true;
+}
+
+QString FileHashCache::cacheFile() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/filehashes");
+}
+
+void FileHashCache::load()
+{
+    QFile file(cacheFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream in(&file);
+    quint32 magic;
+    qint32 count;
+    in >> magic >> count;
+    if (magic != CacheMagic || count < 0 || count > MaxEntries) {
+        return;
+    }
+    m_entries.reserve(count);
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Entry entry;
+        in >> path >> entry.size >> entry.modified >> entry.inode >> entry.hash;
+        if (in.status() == QDataStream::Ok) {
+            m_entries.insert(path, entry);
+        }
+    }
+}
+
+void FileHashCache::save()
+{
+    QMutexLocker lock(&m_mutex);
+    if (!m_modified) {
+        return;
+    }
+    QDir().mkpath(QFileInfo(cacheFile()).absolutePath());
+    QSaveFile file(cacheFile());
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream out(&file);
+    out << CacheMagic << qint32(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        out << it.key() << it->size << it->modified << it->inode << it->hash;
+    }
+    if (file.commit()) {
+        m_modified = false;
+    }
+}
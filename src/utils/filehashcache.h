@@ -0,0 +1,79 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <mutex>
+
+/** @class FileHashCache
+    @brief Computes the hash identifying a media file, and remembers it.
+    The hash is the md5 of the first and last megabyte of the file, as stored in project files (kdenlive:file_hash).
+    Results are kept with the size, modification time and inode of the file, and reused as long as these do not change.
+    The cache is stored on disk, so that reopening a project or reimporting files does not read them again.
+ * Note that this class is a Singleton
+ */
+class FileHashCache
+{
+
+public:
+    /** @brief Counters describing the cache efficiency */
+    struct Stats
+    {
+        quint64 hits{0};
+        quint64 misses{0};
+    };
+
+    // Returns the instance of the Singleton
+    static std::unique_ptr<FileHashCache> &get();
+    ~FileHashCache();
+
+    /** @brief Returns the hash and size of the file at @p path. The hash is empty if the file cannot be read. */
+    QPair<QByteArray, qint64> hash(const QString &path);
+    /** @brief Hash all @p paths in parallel, returning the results by path */
+    QHash<QString, QPair<QByteArray, qint64>> hashFiles(const QStringList &paths);
+
+    /** @brief Write the cache to disk if it changed */
+    void save();
+    /** @brief Drop all entries */
+    void clear();
+    Stats stats() const;
+
+    /** @brief Reads the file at @p path and computes its hash, without using the cache */
+    static QPair<QByteArray, qint64> computeHash(const QString &path);
+
+protected:
+    // Constructor is protected because class is a Singleton
+    FileHashCache();
+
+private:
+    struct Entry
+    {
+        qint64 size{0};
+        qint64 modified{0};
+        quint64 inode{0};
+        QByteArray hash;
+    };
+    /** @brief Reads size, modification time and inode of @p path, returns false if it is not a file */
+    static bool fileStat(const QString &path, Entry &entry);
+    QString cacheFile() const;
+    void load();
+
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    bool m_modified{false};
+    Stats m_stats;
+
+    static std::unique_ptr<FileHashCache> instance;
+    static std::once_flag m_onceFlag; // flag to create the repository only once;
+};
@@ -9,9 +9,12 @@
 #include "core.h"
 #include "doc/kdenlivedoc.h"
 #include "project/projectmanager.h"
+#include "kdenlivesettings.h"
 #include <QDir>
 #include <QMutexLocker>
-#include <list>
+#include <QReadWriteLock>
+#include <QtConcurrent>
+#include <algorithm>
 
 std::unique_ptr<ThumbnailCache> ThumbnailCache::instance;
 std::once_flag ThumbnailCache::m_onceFlag;
@@ -19,130 +22,243 @@ std::once_flag ThumbnailCache::m_onceFlag;
 class ThumbnailCache::Cache_t
 {
 public:
-    Cache_t(int maxCost)
-        : m_maxCost(maxCost)
+    struct Entry
     {
-    }
-
-    bool contains(const QString &key) const { return m_cache.count(key) > 0; }
+        QImage image;
+        QString hash;
+        qint64 cost;
+        // position of the key in m_clock
+        size_t slot;
+        // set on each read, cleared when the clock hand passes
+        mutable std::atomic<bool> referenced{true};
+    };
 
-    void remove(const QString &key)
+    /** @brief Returns the image stored at key, or a null image. Only takes the lock for reading */
+    QImage get(quint64 key, const QString &hash, bool *found) const
     {
-        if (!contains(key)) {
-            return;
+        QReadLocker locker(&m_lock);
+        auto it = m_cache.find(key);
+        if (it == m_cache.end() || (!hash.isEmpty() && it->second->hash != hash)) {
+            *found = false;
+            return QImage();
         }
-        auto it = m_cache.at(key);
-        m_currentCost -= (*it).second.second;
-        // Need to erase reference to iterator before erasing what it points to.
-        // Fixes BUG 463764.
-        m_cache.erase(key);
-        m_data.erase(it);
+        *found = true;
+        it->second->referenced.store(true, std::memory_order_relaxed);
+        return it->second->image;
     }
 
-    void insert(const QString &key, const QImage &img, int cost)
+    /** @brief Returns true if an image is stored at key. A non empty @p hash must match the one of the stored image */
+    bool contains(quint64 key, const QString &hash) const
     {
-        if (cost > m_maxCost) {
-            return;
+        QReadLocker locker(&m_lock);
+        auto it = m_cache.find(key);
+        return it != m_cache.end() && (hash.isEmpty() || it->second->hash == hash);
+    }
+
+    /** @brief Insert or replace the image stored at key, and returns the number of evicted images */
+    int insert(quint64 key, const QString &hash, const QImage &img, qint64 maxCost)
+    {
+        const qint64 cost = img.sizeInBytes();
+        QWriteLocker locker(&m_lock);
+        removeLocked(key);
+        if (cost > maxCost) {
+            return 0;
         }
-        m_data.push_front({key, {img, cost}});
-        auto it = m_data.begin();
-        m_cache[key] = it;
+        auto entry = std::make_unique<Entry>();
+        entry->image = img;
+        entry->hash = hash;
+        entry->cost = cost;
+        entry->slot = m_clock.size();
+        m_clock.push_back(key);
+        m_cache[key] = std::move(entry);
         m_currentCost += cost;
-        while (m_currentCost > m_maxCost) {
-            remove(m_data.back().first);
+        int evicted = 0;
+        // CLOCK eviction: entries read since the last pass of the hand get a second chance
+        while (m_currentCost > maxCost && !m_clock.empty()) {
+            if (m_hand >= m_clock.size()) {
+                m_hand = 0;
+            }
+            const quint64 candidate = m_clock[m_hand];
+            if (candidate != key && m_cache.at(candidate)->referenced.exchange(false, std::memory_order_relaxed)) {
+                ++m_hand;
+                continue;
+            }
+            if (candidate == key && m_clock.size() > 1) {
+                ++m_hand;
+                continue;
+            }
+            // removing swaps the last key into the hand position, so don't advance
+            removeLocked(candidate);
+            evicted++;
         }
+        return evicted;
     }
 
-    QImage get(const QString &key)
+    void remove(quint64 key)
     {
-        if (!contains(key)) {
-            return QImage();
+        QWriteLocker locker(&m_lock);
+        removeLocked(key);
+    }
+
+    /** @brief Remove all images of a given bin clip */
+    void removeClip(quint32 binId)
+    {
+        QWriteLocker locker(&m_lock);
+        std::vector<quint64> keys;
+        for (quint64 k : m_clock) {
+            if (quint32(k >> 32) == binId) {
+                keys.push_back(k);
+            }
+        }
+        for (quint64 k : keys) {
+            removeLocked(k);
         }
-        // when a get operation occurs, we put the corresponding list item in front to remember last access
-        std::pair<QString, std::pair<QImage, int>> data;
-        auto it = m_cache.at(key);
-        std::swap(data, (*it));                                         // take data out without copy
-        QImage result = data.second.first;                              // a copy occurs here
-        m_data.erase(it);                                               // delete old iterator
-        m_cache[key] = m_data.emplace(m_data.begin(), std::move(data)); // reinsert without copy and store iterator
-        return result;
     }
+
     void clear()
     {
-        m_data.clear();
+        QWriteLocker locker(&m_lock);
         m_cache.clear();
+        m_clock.clear();
+        m_hand = 0;
         m_currentCost = 0;
     }
+
+    qint64 cost() const
+    {
+        QReadLocker locker(&m_lock);
+        return m_currentCost;
+    }
+
     bool checkIntegrity() const
     {
-        if (m_data.size() != m_cache.size()) {
+        QReadLocker locker(&m_lock);
+        if (m_clock.size() != m_cache.size()) {
             // Cache is corrupted
             return false;
         }
-        for (const auto &d : m_data) {
-            if (!contains(d.first)) {
+        qint64 cost = 0;
+        for (size_t i = 0; i < m_clock.size(); ++i) {
+            auto it = m_cache.find(m_clock[i]);
+            if (it == m_cache.end() || it->second->slot != i) {
                 return false;
             }
+            cost += it->second->cost;
         }
-        return true;
+        return cost == m_currentCost;
     }
 
 protected:
-    int m_maxCost;
-    int m_currentCost{0};
-
-    // The data is stored as (key,(image, cost)) in a std::list that serves as a
-    // FIFO queue. If m_maxCost is exceeded, elements are removed from the
-    // end of the list until the sum of the costs in the list is less than m_maxCost.
-    std::list<std::pair<QString, std::pair<QImage, int>>> m_data;
-    // m_cache keeps a mapping from the key to an iterator that represents the
-    // item's location in m_data, like a pointer.
-    std::unordered_map<QString, decltype(m_data.begin())> m_cache;
+    void removeLocked(quint64 key)
+    {
+        auto it = m_cache.find(key);
+        if (it == m_cache.end()) {
+            return;
+        }
+        const size_t slot = it->second->slot;
+        m_currentCost -= it->second->cost;
+        m_cache.erase(it);
+        // Move the last key of the clock into the freed slot
+        if (slot != m_clock.size() - 1) {
+            m_clock[slot] = m_clock.back();
+            m_cache.at(m_clock[slot])->slot = slot;
+        }
+        m_clock.pop_back();
+    }
+
+    mutable QReadWriteLock m_lock;
+    qint64 m_currentCost{0};
+    // Entries are heap allocated since they hold an atomic flag, which cannot be moved on rehash
+    std::unordered_map<quint64, std::unique_ptr<Entry>> m_cache;
+    // The keys in insertion order, swept by the clock hand on eviction
+    std::vector<quint64> m_clock;
+    size_t m_hand{0};
 };
 
 ThumbnailCache::ThumbnailCache()
-    : m_volatileCache(new Cache_t(10000000))
+    : m_memoryBudget(qint64(KdenliveSettings::thumbcachememory()) * 1048576)
 {
+    for (auto &cache : m_volatileCache) {
+        cache.reset(new Cache_t());
+    }
 }
 
+ThumbnailCache::~ThumbnailCache() = default;
+
 std::unique_ptr<ThumbnailCache> &ThumbnailCache::get()
 {
     std::call_once(m_onceFlag, [] { instance.reset(new ThumbnailCache()); });
     return instance;
 }
 
+QImage ThumbnailCache::getVolatile(quint64 key, const QString &hash) const
+{
+    bool found = false;
+    QImage img = shard(key).get(key, hash, &found);
+    if (found) {
+        m_hits++;
+    } else {
+        m_misses++;
+    }
+    return img;
+}
+
+void ThumbnailCache::storeVolatile(quint64 key, const QString &hash, const QImage &img)
+{
+    int evicted = shard(key).insert(key, hash, img, m_memoryBudget.load() / ShardCount);
+    if (evicted > 0) {
+        m_evictions += quint64(evicted);
+    }
+}
+
+void ThumbnailCache::markStoredOnDisk(const QString &binId, int pos) const
+{
+    auto &positions = m_storedOnDisk[binId];
+    if (std::find(positions.begin(), positions.end(), pos) == positions.end()) {
+        positions.push_back(pos);
+    }
+}
+
 bool ThumbnailCache::hasThumbnail(const QString &binId, int pos, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
-    auto key = pos < 0 ? getAudioKey(binId, &ok).constFirst() : getKey(binId, pos, &ok);
-    if (ok && m_volatileCache->contains(key)) {
-        return true;
+    if (pos < 0 && volatileOnly) {
+        // Audio thumbnails are only stored on disk
+        return false;
     }
-    if (!ok || volatileOnly) {
+    auto key = pos < 0 ? getAudioKey(binId, &ok).constFirst() : getKey(binId, pos, &ok);
+    if (!ok) {
         return false;
     }
-    locker.unlock();
+    if (pos >= 0) {
+        // A thumbnail of a previous version of the clip does not count
+        quint64 volatileKey = getVolatileKey(binId, pos, &ok);
+        if (ok && shard(volatileKey).contains(volatileKey, key.section(QLatin1Char('#'), 0, 0))) {
+            return true;
+        }
+        if (volatileOnly) {
+            return false;
+        }
+    }
     QDir thumbFolder = getDir(pos < 0, &ok);
     return ok && thumbFolder.exists(key);
 }
 
 QImage ThumbnailCache::getAudioThumbnail(const QString &binId, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
+    if (volatileOnly) {
+        // Audio thumbnails are only stored on disk
+        return QImage();
+    }
     bool ok = false;
     auto key = getAudioKey(binId, &ok).constFirst();
-    if (ok && m_volatileCache->contains(key)) {
-        return m_volatileCache->get(key);
-    }
-    if (!ok || volatileOnly) {
+    if (!ok) {
         return QImage();
     }
     QDir thumbFolder = getDir(true, &ok);
     if (ok && thumbFolder.exists(key)) {
-        if (std::find(m_storedOnDisk[binId].begin(), m_storedOnDisk[binId].end(), -1) != m_storedOnDisk[binId].end()) {
-            m_storedOnDisk[binId].push_back(-1);
-        }
+        QMutexLocker locker(&m_mutex);
+        markStoredOnDisk(binId, -1);
         locker.unlock();
         return QImage(thumbFolder.absoluteFilePath(key));
     }
@@ -170,73 +286,83 @@ QImage ThumbnailCache::getThumbnail(QString hash, const QString &binId, int pos,
     if (hash.isEmpty()) {
         return QImage();
     }
-    hash.append(QString("#%1.jpg").arg(pos));
-    QMutexLocker locker(&m_mutex);
-    if (m_volatileCache->contains(hash)) {
-        return m_volatileCache->get(hash);
-    }
-    if (volatileOnly) {
+    bool ok = false;
+    const quint64 volatileKey = getVolatileKey(binId, pos, &ok);
+    const bool hasVolatileKey = ok;
+    if (ok) {
+        QImage img = getVolatile(volatileKey, hash);
+        if (!img.isNull() || volatileOnly) {
+            return img;
+        }
+    } else if (volatileOnly) {
         return QImage();
     }
-    bool ok = false;
+    hash.append(QString("#%1.jpg").arg(pos));
     QDir thumbFolder = getDir(false, &ok);
     if (ok && thumbFolder.exists(hash)) {
-        if (m_storedOnDisk.find(binId) == m_storedOnDisk.end() ||
-            std::find(m_storedOnDisk[binId].begin(), m_storedOnDisk[binId].end(), pos) == m_storedOnDisk[binId].end()) {
-            m_storedOnDisk[binId].push_back(pos);
-        }
+        QMutexLocker locker(&m_mutex);
+        markStoredOnDisk(binId, pos);
         locker.unlock();
-        return QImage(thumbFolder.absoluteFilePath(hash));
+        m_diskHits++;
+        QImage img(thumbFolder.absoluteFilePath(hash));
+        if (!img.isNull() && hasVolatileKey) {
+            // Keep it in memory for the next request
+            const_cast<ThumbnailCache *>(this)->storeVolatile(volatileKey, hash.section(QLatin1Char('#'), 0, 0), img);
+        }
+        return img;
     }
-    locker.unlock();
     return QImage();
 }
 
 QImage ThumbnailCache::getThumbnail(const QString &binId, int pos, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
-    auto key = getKey(binId, pos, &ok);
-    if (ok && m_volatileCache->contains(key)) {
-        return m_volatileCache->get(key);
+    const quint64 volatileKey = getVolatileKey(binId, pos, &ok);
+    if (!ok) {
+        return QImage();
     }
-    if (!ok || volatileOnly) {
+    // The key starts with the current hash of the clip, thumbnails of a previous version of the clip are ignored
+    auto key = getKey(binId, pos, &ok);
+    if (!ok) {
         return QImage();
     }
+    QImage img = getVolatile(volatileKey, key.section(QLatin1Char('#'), 0, 0));
+    if (!img.isNull() || volatileOnly) {
+        return img;
+    }
     QDir thumbFolder = getDir(false, &ok);
     if (ok && thumbFolder.exists(key)) {
-        if (m_storedOnDisk.find(binId) == m_storedOnDisk.end() ||
-            std::find(m_storedOnDisk[binId].begin(), m_storedOnDisk[binId].end(), pos) == m_storedOnDisk[binId].end()) {
-            m_storedOnDisk[binId].push_back(pos);
-        }
+        QMutexLocker locker(&m_mutex);
+        markStoredOnDisk(binId, pos);
         locker.unlock();
-        return QImage(thumbFolder.absoluteFilePath(key));
+        m_diskHits++;
+        img = QImage(thumbFolder.absoluteFilePath(key));
+        if (!img.isNull()) {
+            // Keep it in memory for the next request
+            const_cast<ThumbnailCache *>(this)->storeVolatile(volatileKey, key.section(QLatin1Char('#'), 0, 0), img);
+        }
+        return img;
     }
     return QImage();
 }
 
 void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent)
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
     const QString key = getKey(binId, pos, &ok);
     if (!ok) {
         return;
     }
-    // if volatile cache also contains this entry, update it
-    if (m_volatileCache->contains(key)) {
-        m_volatileCache->remove(key);
-    } else {
-        m_storedVolatile[binId].push_back(pos);
+    const quint64 volatileKey = getVolatileKey(binId, pos, &ok);
+    if (!ok) {
+        return;
     }
-    m_volatileCache->insert(key, img, (int)img.sizeInBytes());
+    storeVolatile(volatileKey, key.section(QLatin1Char('#'), 0, 0), img);
     if (persistent) {
         QDir thumbFolder = getDir(false, &ok);
         if (ok) {
-            if (m_storedOnDisk.find(binId) == m_storedOnDisk.end() ||
-                std::find(m_storedOnDisk[binId].begin(), m_storedOnDisk[binId].end(), pos) == m_storedOnDisk[binId].end()) {
-                m_storedOnDisk[binId].push_back(pos);
-            }
+            QMutexLocker locker(&m_mutex);
+            markStoredOnDisk(binId, pos);
             locker.unlock();
             if (!img.save(thumbFolder.absoluteFilePath(key))) {
                 qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB in: " << thumbFolder.absoluteFilePath(key);
@@ -245,9 +371,67 @@ void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage
     }
 }
 
+void ThumbnailCache::promoteThumbnails(const QString &binId, const std::vector<int> &positions)
+{
+    if (positions.empty()) {
+        return;
+    }
+    QtConcurrent::run([this, binId, positions]() {
+        bool ok = false;
+        QDir thumbFolder = getDir(false, &ok);
+        if (!ok) {
+            return;
+        }
+        for (int pos : positions) {
+            const quint64 volatileKey = getVolatileKey(binId, pos, &ok);
+            if (!ok) {
+                continue;
+            }
+            const QString key = getKey(binId, pos, &ok);
+            if (!ok || shard(volatileKey).contains(volatileKey, key.section(QLatin1Char('#'), 0, 0)) || !thumbFolder.exists(key)) {
+                continue;
+            }
+            QImage img(thumbFolder.absoluteFilePath(key));
+            if (!img.isNull()) {
+                storeVolatile(volatileKey, key.section(QLatin1Char('#'), 0, 0), img);
+            }
+        }
+    });
+}
+
+void ThumbnailCache::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = bytes;
+    // Drop the extra thumbnails right away rather than on the next insertion
+    for (auto &cache : m_volatileCache) {
+        if (cache->cost() > bytes / ShardCount) {
+            cache->clear();
+        }
+    }
+}
+
+ThumbnailCache::Stats ThumbnailCache::stats() const
+{
+    Stats result;
+    result.hits = m_hits.load();
+    result.misses = m_misses.load();
+    result.diskHits = m_diskHits.load();
+    result.evictions = m_evictions.load();
+    result.memoryBudget = m_memoryBudget.load();
+    for (const auto &cache : m_volatileCache) {
+        result.memoryUsed += cache->cost();
+    }
+    return result;
+}
+
 bool ThumbnailCache::checkIntegrity() const
 {
-    return m_volatileCache->checkIntegrity();
+    for (const auto &cache : m_volatileCache) {
+        if (!cache->checkIntegrity()) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void ThumbnailCache::saveCachedThumbs(const std::unordered_map<QString, std::vector<int>> &keys)
@@ -267,8 +451,13 @@ void ThumbnailCache::saveCachedThumbs(const std::unordered_map<QString, std::vec
                 if (!ok) {
                     continue;
                 }
-                if (!thumbFolder.exists(thumbKey) && m_volatileCache->contains(thumbKey)) {
-                    QImage img = m_volatileCache->get(thumbKey);
+                if (thumbFolder.exists(thumbKey)) {
+                    continue;
+                }
+                const quint64 volatileKey = getVolatileKey(key.first, pos, &ok);
+                bool found = false;
+                QImage img = ok ? shard(volatileKey).get(volatileKey, thumbKey.section(QLatin1Char('#'), 0, 0), &found) : QImage();
+                if (found) {
                     if (!img.save(thumbFolder.absoluteFilePath(thumbKey))) {
                         qDebug() << "// Error writing thumbnails to " << thumbFolder.absolutePath();
                         break;
@@ -283,18 +472,14 @@ void ThumbnailCache::saveCachedThumbs(const std::unordered_map<QString, std::vec
 
 void ThumbnailCache::invalidateThumbsForClip(const QString &binId)
 {
-    QMutexLocker locker(&m_mutex);
-    if (m_storedVolatile.find(binId) != m_storedVolatile.end()) {
-        bool ok = false;
-        for (int pos : m_storedVolatile.at(binId)) {
-            auto key = getKey(binId, pos, &ok);
-            if (ok) {
-                m_volatileCache->remove(key);
-            }
+    bool ok = false;
+    const quint64 volatileKey = getVolatileKey(binId, 0, &ok);
+    if (ok) {
+        for (auto &cache : m_volatileCache) {
+            cache->removeClip(quint32(volatileKey >> 32));
         }
-        m_storedVolatile.erase(binId);
     }
-    bool ok = false;
+    QMutexLocker locker(&m_mutex);
     // Video thumbs
     QStringList files;
     if (m_storedOnDisk.find(binId) != m_storedOnDisk.end()) {
@@ -323,9 +508,10 @@ void ThumbnailCache::invalidateThumbsForClip(const QString &binId)
 
 void ThumbnailCache::clearCache()
 {
+    for (auto &cache : m_volatileCache) {
+        cache->clear();
+    }
     QMutexLocker locker(&m_mutex);
-    m_volatileCache->clear();
-    m_storedVolatile.clear();
     m_storedOnDisk.clear();
 }
 
@@ -344,6 +530,18 @@ QString ThumbnailCache::getKey(const QString &binId, int pos, bool *ok)
     return binClip->hashForThumbs() + QLatin1Char('#') + QString::number(pos) + QStringLiteral(".jpg");
 }
 
+// static
+quint64 ThumbnailCache::getVolatileKey(const QString &binId, int pos, bool *ok)
+{
+    // Subclips use the thumbnails of their parent, their id is "parentId_subclipId"
+    int id = binId.toInt(ok);
+    if (!*ok) {
+        id = binId.section(QLatin1Char('_'), 0, 0).toInt(ok);
+    }
+    *ok = *ok && pos >= 0;
+    return (quint64(quint32(id)) << 32) | quint32(pos);
+}
+
 // static
 QStringList ThumbnailCache::getAudioKey(const QString &binId, bool *ok)
 {
@@ -10,6 +10,7 @@
 #include <QImage>
 #include <QMutex>
 #include <QUrl>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -18,18 +19,33 @@
 /** @class ThumbnailCache
     @brief This class class is an interface to the caches that store thumbnails.
     In Kdenlive, we use two such caches, a persistent that is stored on disk to allow thumbnails to be reused when reopening.
-    The other one is a volatile LRU cache that lives in memory.
+    The other one is a volatile cache that lives in memory.
     Note that for the volatile cache uses a custom implementation.
     QCache is not suitable since it operates on pointers and since the object is removed from the cache when accessed.
     KImageCache is not suitable since it lacks a way to remove objects from the cache.
+    The volatile cache is split in shards, each with its own read/write lock, so that the many threads of the
+    QML thumbnail provider do not contend on a single mutex. Thumbnails are keyed by (bin id, frame) packed in an integer
+    and evicted with a CLOCK policy: a read only flags the entry as recently used, it never needs exclusive access.
  * Note that this class is a Singleton
  */
 class ThumbnailCache
 {
 
 public:
+    /** @brief Counters describing the volatile cache efficiency */
+    struct Stats
+    {
+        quint64 hits{0};
+        quint64 misses{0};
+        quint64 diskHits{0};
+        quint64 evictions{0};
+        qint64 memoryUsed{0};
+        qint64 memoryBudget{0};
+    };
+
     // Returns the instance of the Singleton
     static std::unique_ptr<ThumbnailCache> &get();
+    ~ThumbnailCache();
 
     /** @brief Check whether a given thumbnail is in the cache
        @param binId is the id of the queried clip
@@ -67,12 +83,26 @@ public:
     /** @brief Ensure the cache is not corrupted */
     bool checkIntegrity() const;
 
+    /** @brief Load the given thumbnails from the persistent cache into the volatile cache, on a worker thread
+       @param binId is the id of the clip
+       @param positions are the frames to load, those not found on disk are ignored
+    */
+    void promoteThumbnails(const QString &binId, const std::vector<int> &positions);
+
+    /** @brief Set the size in bytes above which the volatile cache starts dropping thumbnails */
+    void setMemoryBudget(qint64 bytes);
+
+    /** @brief Returns the current hit/miss/eviction counters */
+    Stats stats() const;
+
 protected:
     // Constructor is protected because class is a Singleton
     ThumbnailCache();
 
     // Return the key associated to a thumbnail
     static QString getKey(const QString &binId, int pos, bool *ok);
+    // Return the key of a thumbnail in the volatile cache
+    static quint64 getVolatileKey(const QString &binId, int pos, bool *ok);
     static QStringList getAudioKey(const QString &binId, bool *ok);
 
     // Return the dir where the persistent cache lives
@@ -81,12 +111,26 @@ protected:
     static std::unique_ptr<ThumbnailCache> instance;
     static std::once_flag m_onceFlag; // flag to create the repository only once;
 
+    /** @brief Look up the volatile cache, updating the counters. A non empty @p hash must match the one of the stored thumbnail */
+    QImage getVolatile(quint64 key, const QString &hash) const;
+    /** @brief Insert in the volatile cache, evicting other thumbnails if needed */
+    void storeVolatile(quint64 key, const QString &hash, const QImage &img);
+    /** @brief Remember that a thumbnail is stored on disk. Requires m_mutex */
+    void markStoredOnDisk(const QString &binId, int pos) const;
+
     class Cache_t;
-    std::unique_ptr<Cache_t> m_volatileCache;
-    mutable QMutex m_mutex;
+    static constexpr int ShardCount = 16;
+    std::unique_ptr<Cache_t> m_volatileCache[ShardCount];
+    inline Cache_t &shard(quint64 key) const { return *m_volatileCache[(quint32(key >> 32) * 0x9E3779B1u ^ quint32(key)) % ShardCount]; }
 
-    // the following maps keeps track of the positions that we store for each clip in volatile caches.
-    // Note that we don't track deletions due to items dropped from the cache. So the maps can contain more items that are currently stored.
-    std::unordered_map<QString, std::vector<int>> m_storedVolatile;
+    // guards m_storedOnDisk
+    mutable QMutex m_mutex;
+    // the following map keeps track of the positions that we store for each clip on disk.
     mutable std::unordered_map<QString, std::vector<int>> m_storedOnDisk;
+
+    mutable std::atomic<quint64> m_hits{0};
+    mutable std::atomic<quint64> m_misses{0};
+    mutable std::atomic<quint64> m_diskHits{0};
+    std::atomic<quint64> m_evictions{0};
+    std::atomic<qint64> m_memoryBudget;
 };
@@ -0,0 +1,300 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+#include "catch.hpp"
+#include "test_utils.hpp"
+// test specific headers
+#include "lib/audio/audioCorrelationInfo.h"
+#include "lib/audio/audioEnvelope.h"
+#include "lib/audio/audioLevels.h"
+#include "lib/audio/audioPeakFile.h"
+#include "lib/audio/audioPeakPyramid.h"
+#include "lib/audio/fftCorrelation.h"
+#include "lib/audio/fftTools.h"
+#include <QImage>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+TEST_CASE("Audio peak file", "[AudioPeaks]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const int channels = 2;
+    // 1000 frames of a ramp on the left channel and a constant on the right one
+    QVector<uint8_t> levels;
+    for (int i = 0; i < 1000; ++i) {
+        levels << uint8_t(i % 256) << uint8_t(100);
+    }
+
+    SECTION("Write and read back")
+    {
+        const QString path = dir.filePath(QStringLiteral("test.peaks"));
+        REQUIRE(AudioPeakFile::write(path, levels.constData(), levels.size(), channels, 48000, 25., 255));
+        AudioPeakFile peaks;
+        REQUIRE(peaks.open(path));
+        CHECK(peaks.channels() == channels);
+        CHECK(peaks.sampleRate() == 48000);
+        CHECK(peaks.fps() == 25.);
+        CHECK(peaks.frames() == 1000);
+        CHECK(peaks.maxLevel() == 255);
+        CHECK(peaks.toVector() == levels);
+
+        // 1000 -> 500 -> 250 -> 125 frames, the next one would be smaller than MinMipFrames
+        REQUIRE(peaks.levelCount() == 4);
+        qint64 frames;
+        const quint8 *mip = peaks.mipLevel(1, &frames);
+        REQUIRE(frames == 500);
+        // first pair of the left channel covers frames 0 and 1
+        CHECK(mip[0] == 0);
+        CHECK(mip[1] == 1);
+        CHECK(mip[2] == 100);
+        CHECK(mip[3] == 100);
+        mip = peaks.mipLevel(3, &frames);
+        REQUIRE(frames == 125);
+        // frames 248 to 255, the ramp wraps at 256
+        CHECK(mip[31 * 4] == 248);
+        CHECK(mip[31 * 4 + 1] == 255);
+        CHECK(peaks.mipLevel(4, &frames) == nullptr);
+    }
+
+    SECTION("Reject other files")
+    {
+        const QString path = dir.filePath(QStringLiteral("broken.peaks"));
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write(QByteArray(100, 'x'));
+        file.close();
+        AudioPeakFile peaks;
+        CHECK_FALSE(peaks.open(path));
+        CHECK_FALSE(peaks.open(dir.filePath(QStringLiteral("missing.peaks"))));
+        CHECK_FALSE(peaks.isValid());
+    }
+
+    SECTION("Reject a frame count larger than the data")
+    {
+        const QString path = dir.filePath(QStringLiteral("truncated.peaks"));
+        REQUIRE(AudioPeakFile::write(path, levels.constData(), levels.size(), channels, 48000, 25., 255));
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::ReadWrite));
+        // Header frame count, little endian at offset 32
+        REQUIRE(file.seek(32));
+        const char frames[8] = {char(0xe8), 0x07, 0, 0, 0, 0, 0, 0};
+        file.write(frames, 8);
+        file.close();
+        AudioPeakFile peaks;
+        CHECK_FALSE(peaks.open(path));
+        CHECK_FALSE(peaks.isValid());
+    }
+
+    SECTION("Convert legacy PNG thumbnails")
+    {
+        // Same layout as written by older versions: 4 values per pixel, pixel i at (i / channels, i % channels)
+        const int count = levels.size();
+        QImage image((count + 3) / 4 / channels, channels, QImage::Format_ARGB32);
+        for (int i = 0; i < image.width() * image.height(); i++) {
+            image.setPixel(i / channels, i % channels, qRgba(levels.at(4 * i), levels.at(4 * i + 1), levels.at(4 * i + 2), levels.at(4 * i + 3)));
+        }
+        const QString path = dir.filePath(QStringLiteral("legacy.png"));
+        REQUIRE(image.save(path));
+        CHECK(AudioPeakFile::readLegacyImage(path, channels) == levels);
+    }
+}
+
+TEST_CASE("Audio peak pyramid", "[AudioPeaks]")
+{
+    const int channels = 2;
+    // 1000 frames of a ramp on the left channel and a constant on the right one
+    QVector<uint8_t> levels;
+    for (int i = 0; i < 1000; ++i) {
+        levels << uint8_t(i % 256) << uint8_t(100);
+    }
+    AudioPeakPyramid pyramid(levels.constData(), 1000, channels);
+    CHECK(pyramid.frames() == 1000);
+    CHECK(pyramid.levelCount() == 4);
+
+    // Any range gives the same peak as walking the frames
+    for (qint64 first = 0; first < 1000; first += 37) {
+        for (qint64 span : {1, 2, 5, 16, 130, 900}) {
+            const qint64 last = qMin(qint64(1000), first + span);
+            quint8 expected = 0;
+            for (qint64 f = first; f < last; ++f) {
+                expected = qMax(expected, levels.at(int(f * channels)));
+            }
+            CHECK(pyramid.peak(0, first, last) == expected);
+            CHECK(pyramid.peak(1, first, last) == 100);
+        }
+    }
+    CHECK(pyramid.peak(0, 0, 1000) == 255);
+    CHECK(pyramid.peak(0, 10, 20) == 19);
+    CHECK(pyramid.peak(10, 11) == 100);
+    CHECK(pyramid.peak(0, 5000, 6000) == 0);
+}
+
+TEST_CASE("Shared audio levels", "[AudioPeaks]")
+{
+    const int channels = 2;
+    QVector<uint8_t> levels;
+    for (int i = 0; i < 1000; ++i) {
+        levels << uint8_t(i % 200) << uint8_t(100);
+    }
+
+    SECTION("Levels take over the vector")
+    {
+        QVector<uint8_t> copy = levels;
+        const uint8_t *data = copy.constData();
+        AudioLevelsPtr shared = AudioLevels::create(std::move(copy), channels);
+        CHECK(shared->constData() == data);
+        CHECK(shared->frames() == 1000);
+        CHECK(shared->size() == 2000);
+        CHECK(shared->maxLevel() == 199);
+        CHECK(shared->at(3) == 100);
+        // Readers share the same instance
+        AudioLevelsPtr reader = shared;
+        CHECK(reader->constData() == data);
+        CHECK(shared->pyramid().peak(0, 1000) == 199);
+        CHECK(&shared->pyramid() == &reader->pyramid());
+    }
+
+    SECTION("Levels read in place from a peak file")
+    {
+        QTemporaryDir dir;
+        REQUIRE(dir.isValid());
+        const QString path = dir.filePath(QStringLiteral("test.peaks"));
+        REQUIRE(AudioPeakFile::write(path, levels.constData(), levels.size(), channels, 48000, 25., 199));
+        std::unique_ptr<AudioPeakFile> file(new AudioPeakFile());
+        REQUIRE(file->open(path));
+        const quint8 *loaded = file->levels();
+        AudioLevelsPtr shared = AudioLevels::fromPeakFile(std::move(file));
+        REQUIRE(shared);
+        CHECK(shared->constData() == loaded);
+        CHECK(shared->maxLevel() == 199);
+        CHECK(memcmp(shared->constData(), levels.constData(), size_t(levels.size())) == 0);
+        // The pyramid uses the reduced levels of the file
+        AudioPeakPyramid built(levels.constData(), 1000, channels);
+        REQUIRE(shared->pyramid().levelCount() == built.levelCount());
+        for (qint64 first = 0; first < 1000; first += 91) {
+            CHECK(shared->pyramid().peak(0, first, first + 300) == built.peak(0, first, first + 300));
+        }
+        // The file is not kept open, the cache can be replaced while the levels are in use
+        QVector<uint8_t> other(levels.size(), 42);
+        REQUIRE(AudioPeakFile::write(path, other.constData(), other.size(), channels, 48000, 25., 42));
+        CHECK(memcmp(shared->constData(), levels.constData(), size_t(levels.size())) == 0);
+        AudioPeakFile rewritten;
+        REQUIRE(rewritten.open(path));
+        CHECK(rewritten.toVector() == other);
+    }
+}
+
+TEST_CASE("Audio envelope sum", "[AudioPeaks]")
+{
+    // Include the lowest sample value, whose absolute value does not fit in 16 bits
+    std::vector<qint16> samples;
+    for (int i = 0; i < 5003; ++i) {
+        samples.push_back(i % 7 == 0 ? qint16(-32768) : qint16((i * 7919) % 65536 - 32768));
+    }
+    for (int count : {0, 1, 7, 8, 9, 100, 5003}) {
+        qint64 expected = 0;
+        for (int k = 0; k < count; ++k) {
+            expected += qAbs(qint64(samples[size_t(k)]));
+        }
+        CHECK(AudioEnvelope::absSum(samples.data(), count) == expected);
+    }
+}
+
+TEST_CASE("FFT correlation with a shared reference", "[AudioPeaks]")
+{
+    std::vector<qint64> main(3000);
+    std::vector<qint64> sub(700);
+    // Pseudo random values, a periodic signal would match at several shifts
+    quint32 seed = 1;
+    for (qint64 &value : main) {
+        seed = seed * 1103515245u + 12345u;
+        value = qint64((seed >> 16) % 1000);
+    }
+    // The sub envelope is a copy of a part of the main one
+    std::copy(main.begin() + 1200, main.begin() + 1900, sub.begin());
+
+    const FFTCorrelation::Reference reference(main.data(), main.size());
+    REQUIRE(reference.size() == main.size());
+    std::vector<qint64> expected(main.size() + sub.size() + 1);
+    std::vector<qint64> result(main.size() + sub.size() + 1);
+    FFTCorrelation::correlate(main.data(), main.size(), sub.data(), sub.size(), expected.data());
+    // Twice, the second call uses the cached spectrum
+    for (int pass = 0; pass < 2; ++pass) {
+        FFTCorrelation::correlate(reference, sub.data(), sub.size(), result.data());
+        CHECK(result == expected);
+    }
+    CHECK(std::max_element(result.begin(), result.end()) - result.begin() == 1200 + 700);
+}
+
+TEST_CASE("Batched FFT of audio frames", "[AudioPeaks]")
+{
+    const uint windowSize = 512;
+    const int channels = 2;
+    // Stereo frames with a sine at a different bin on the left channel of each frame
+    QVector<audioShortVector> frames;
+    for (int frame = 0; frame < 4; ++frame) {
+        audioShortVector samples(int(windowSize) * channels);
+        const int bin = 10 + 20 * frame;
+        for (int i = 0; i < int(windowSize); ++i) {
+            samples[i * channels] = qint16(16000 * sin(2 * M_PI * bin * i / windowSize));
+            samples[i * channels + 1] = qint16(i % 100);
+        }
+        frames << samples;
+    }
+
+    for (auto windowType : {FFTTools::Window_Rect, FFTTools::Window_Hamming}) {
+        FFTTools tools;
+        std::vector<float> batch(size_t(frames.size()) * windowSize / 2);
+        tools.fftNormalized(frames, 0, channels, batch.data(), windowType, windowSize);
+        for (int frame = 0; frame < frames.size(); ++frame) {
+            std::vector<float> single(windowSize / 2);
+            tools.fftNormalized(frames.at(frame), 0, channels, single.data(), windowType, windowSize);
+            const float *spectrum = batch.data() + size_t(frame) * windowSize / 2;
+            CHECK(std::equal(single.begin(), single.end(), spectrum));
+            // The sine is the loudest frequency, close to 0 dB
+            const auto peak = std::max_element(single.begin(), single.end());
+            CHECK(peak - single.begin() == 10 + 20 * frame);
+            CHECK(*peak > -12.f);
+            CHECK(*peak <= 0.f);
+        }
+    }
+}
+
+TEST_CASE("Audio correlation confidence", "[AudioPeaks]")
+{
+    AudioCorrelationInfo info(50, 49);
+    qint64 *correlation = info.correlationVector();
+    auto fill = [&](const std::vector<std::pair<size_t, qint64>> &peaks) {
+        // Zero mean noise, with a triangular lobe around each peak
+        for (size_t i = 0; i < info.size(); ++i) {
+            correlation[i] = (i % 2) ? -10 : 10;
+        }
+        for (const auto &peak : peaks) {
+            for (size_t i = peak.first - 3; i <= peak.first + 3; ++i) {
+                correlation[i] = peak.second - 200 * qint64(i > peak.first ? i - peak.first : peak.first - i);
+            }
+        }
+    };
+
+    SECTION("Single peak")
+    {
+        fill({{40, 1000}});
+        CHECK(info.maxIndex() == 40);
+        CHECK(info.confidence() > 0.95);
+    }
+    SECTION("Second peak outside of the main lobe")
+    {
+        fill({{20, 1000}, {70, 900}});
+        CHECK(info.maxIndex() == 20);
+        CHECK(info.confidence() == Approx(0.1));
+    }
+    SECTION("Flat correlation")
+    {
+        std::fill(correlation, correlation + info.size(), 0);
+        CHECK(info.confidence() == 0.);
+    }
+}
@@ -50,6 +50,57 @@ TEST_CASE("Cache insert-remove", "[Cache]")
         ThumbnailCache::get()->storeThumbnail(binId, 0, img, false);
         REQUIRE(ThumbnailCache::get()->checkIntegrity());
     }
+    SECTION("Volatile cache counters and byte budget")
+    {
+        QImage img(100, 100, QImage::Format_ARGB32_Premultiplied);
+        img.fill(Qt::red);
+        ThumbnailCache::get()->clearCache();
+        const ThumbnailCache::Stats before = ThumbnailCache::get()->stats();
+        ThumbnailCache::get()->storeThumbnail(binId, 3, img, false);
+        REQUIRE(ThumbnailCache::get()->hasThumbnail(binId, 3, true));
+        REQUIRE(!ThumbnailCache::get()->getThumbnail(binId, 3, true).isNull());
+        REQUIRE(ThumbnailCache::get()->getThumbnail(binId, 4, true).isNull());
+        ThumbnailCache::Stats after = ThumbnailCache::get()->stats();
+        REQUIRE(after.hits == before.hits + 1);
+        REQUIRE(after.misses == before.misses + 1);
+        REQUIRE(after.memoryUsed == img.sizeInBytes());
+
+        // Leave room for about 2 images per shard, then fill the cache
+        const qint64 budget = after.memoryBudget;
+        ThumbnailCache::get()->setMemoryBudget(img.sizeInBytes() * 2 * ThumbnailCache::ShardCount);
+        for (int i = 0; i < 20 * ThumbnailCache::ShardCount; ++i) {
+            ThumbnailCache::get()->storeThumbnail(binId, i, img, false);
+        }
+        REQUIRE(ThumbnailCache::get()->checkIntegrity());
+        after = ThumbnailCache::get()->stats();
+        REQUIRE(after.evictions > before.evictions);
+        REQUIRE(after.memoryUsed <= after.memoryBudget);
+
+        // Invalidating the clip drops all its thumbnails
+        ThumbnailCache::get()->invalidateThumbsForClip(binId);
+        REQUIRE(ThumbnailCache::get()->stats().memoryUsed == 0);
+        REQUIRE(ThumbnailCache::get()->checkIntegrity());
+        ThumbnailCache::get()->setMemoryBudget(budget);
+    }
+    SECTION("Thumbnails of a previous version of the clip are ignored")
+    {
+        QImage img(100, 100, QImage::Format_ARGB32_Premultiplied);
+        img.fill(Qt::red);
+        ThumbnailCache::get()->clearCache();
+        auto clip = binModel->getClipByBinID(binId);
+        clip->setProducerProperty(QStringLiteral("kdenlive:file_hash"), QStringLiteral("first"));
+        ThumbnailCache::get()->storeThumbnail(binId, 5, img, false);
+        REQUIRE(ThumbnailCache::get()->hasThumbnail(binId, 5, true));
+        REQUIRE(!ThumbnailCache::get()->getThumbnail(binId, 5, true).isNull());
+
+        // The clip file changed
+        clip->setProducerProperty(QStringLiteral("kdenlive:file_hash"), QStringLiteral("second"));
+        REQUIRE_FALSE(ThumbnailCache::get()->hasThumbnail(binId, 5, true));
+        REQUIRE(ThumbnailCache::get()->getThumbnail(binId, 5, true).isNull());
+        ThumbnailCache::get()->storeThumbnail(binId, 5, img, false);
+        REQUIRE(!ThumbnailCache::get()->getThumbnail(binId, 5, true).isNull());
+        REQUIRE(ThumbnailCache::get()->checkIntegrity());
+    }
     pCore->projectManager()->closeCurrentDocument(false, false);
 }
 
@@ -9,6 +9,7 @@
 #include "scopes/colorscopes/waveformgenerator.h"
 #include "scopes/colorscopes/rgbparadegenerator.h"
 #include "scopes/colorscopes/histogramgenerator.h"
+#include "scopes/colorscopes/scopeanalyzer.h"
 
 // test for a bug where pixels were assumed to be RGB which was not true on
 // Windows, resulting in red and blue switched. BUG: 453149
@@ -80,3 +81,198 @@ TEST_CASE("Colorscope RGB/BGR handling")
         CHECK(rgbScope == bgrScope);
     }
 }
+
+TEST_CASE("Colorscope shared frame analysis")
+{
+    // A 1000x200 gradient, wide enough for the SIMD path and high enough to use several strips
+    QImage inputImage(1000, 200, QImage::Format_RGB32);
+    for (int y = 0; y < inputImage.height(); ++y) {
+        for (int x = 0; x < inputImage.width(); ++x) {
+            inputImage.setPixel(x, y, qRgb(x % 256, y % 256, (x + y) % 256));
+        }
+    }
+
+    SECTION("SIMD luma matches the scalar version")
+    {
+        const auto *line = reinterpret_cast<const QRgb *>(inputImage.constScanLine(0));
+        std::vector<uchar> simd(size_t(inputImage.width()));
+        std::vector<uchar> scalar(size_t(inputImage.width()));
+        for (ITURec rec : {ITURec::Rec_601, ITURec::Rec_709}) {
+            ScopeAnalyzer::computeLuma(line, simd.data(), inputImage.width(), rec);
+            ScopeAnalyzer::computeLumaScalar(line, scalar.data(), inputImage.width(), rec);
+            CHECK(simd == scalar);
+        }
+        const QRgb white = qRgb(255, 255, 255);
+        uchar luma;
+        ScopeAnalyzer::computeLumaScalar(&white, &luma, 1, ITURec::Rec_709);
+        CHECK(luma == 255);
+    }
+
+    SECTION("Analysis counts every pixel and is shared between scopes")
+    {
+        auto analysis = ScopeAnalyzer::analyse(inputImage, ITURec::Rec_601);
+        uint total = 0;
+        for (uint count : analysis->histY) {
+            total += count;
+        }
+        CHECK(total == uint(inputImage.width() * inputImage.height()));
+        CHECK(analysis->histR[0] == 4 * 200);
+        CHECK(ScopeAnalyzer::analyse(inputImage, ITURec::Rec_601) == analysis);
+        CHECK(ScopeAnalyzer::analyse(inputImage) == analysis);
+        CHECK(ScopeAnalyzer::analyse(inputImage, ITURec::Rec_709) != analysis);
+    }
+
+    SECTION("Sampling with an acceleration factor picks every n-th pixel")
+    {
+        const uint accel = 7;
+        qint64 sampled = 0;
+        for (int y = 0; y < 13; ++y) {
+            for (int x = ScopeAnalyzer::firstSample(y, 10, accel); x < 10; x += accel) {
+                CHECK((y * 10 + x) % accel == 0);
+                sampled++;
+            }
+        }
+        CHECK(sampled == (13 * 10 + accel - 1) / accel);
+    }
+}
+
+TEST_CASE("Colorscope analysis of YUV frames")
+{
+    // A 4x2 limited range yuv422 frame: black and white on the first row, gray on the second one
+    const int width = 4;
+    const int height = 2;
+    const int size = width * height * 2;
+    auto *data = static_cast<uint8_t *>(mlt_pool_alloc(size));
+    const uint8_t rows[2][8] = {{16, 128, 16, 128, 235, 128, 235, 128}, {126, 128, 126, 128, 126, 128, 126, 128}};
+    memcpy(data, rows, size_t(size));
+    mlt_frame raw = mlt_frame_init(nullptr);
+    Mlt::Frame mltFrame(raw);
+    mlt_frame_close(raw);
+    mltFrame.set("image", data, size, mlt_pool_release);
+    mltFrame.set("format", mlt_image_yuv422);
+    mltFrame.set("width", width);
+    mltFrame.set("height", height);
+    mltFrame.set("colorspace", 709);
+    SharedFrame frame(mltFrame);
+    REQUIRE(ScopeAnalyzer::canAnalyse(frame));
+
+    SECTION("Luma and chroma are read from the frame")
+    {
+        auto analysis = ScopeAnalyzer::analyse(frame);
+        REQUIRE(analysis);
+        CHECK(analysis->width == width);
+        CHECK(analysis->height == height);
+        CHECK(analysis->hasChroma());
+        // Video levels are expanded to full range
+        CHECK(analysis->lumaLine(0)[0] == 0);
+        CHECK(analysis->lumaLine(0)[3] == 255);
+        CHECK(analysis->lumaLine(1)[1] == 128);
+        CHECK(analysis->cbLine(1)[2] == 128);
+        CHECK(analysis->histY[0] == 2);
+        CHECK(analysis->histY[255] == 2);
+        CHECK(analysis->histY[128] == 4);
+        CHECK(ScopeAnalyzer::analyse(frame) == analysis);
+        CHECK(ScopeInput(frame).analyse(ITURec::Rec_601) == analysis);
+
+        // RGB data is only computed on request
+        CHECK(analysis->image.isNull());
+        analysis->ensureRgb();
+        CHECK(analysis->rgbLine(0)[0] == qRgb(0, 0, 0));
+        CHECK(analysis->rgbLine(0)[2] == qRgb(255, 255, 255));
+        CHECK(analysis->rgbLine(1)[0] == qRgb(128, 128, 128));
+        CHECK(analysis->histR[128] == 4);
+    }
+
+    SECTION("Analysis resolution")
+    {
+        auto analysis = ScopeAnalyzer::analyse(frame, 2);
+        REQUIRE(analysis);
+        CHECK(analysis->width == width / 2);
+        CHECK(analysis->height == height / 2);
+        CHECK(analysis->lumaLine(0)[0] == 0);
+        CHECK(analysis->lumaLine(0)[1] == 255);
+
+        QImage image(8, 6, QImage::Format_RGB32);
+        image.fill(Qt::white);
+        auto imageAnalysis = ScopeAnalyzer::analyse(image, ITURec::Rec_709, 2);
+        CHECK(imageAnalysis->width == 4);
+        CHECK(imageAnalysis->height == 3);
+        CHECK(imageAnalysis->histY[255] == 12);
+    }
+
+    SECTION("Scopes accept the analysed frame")
+    {
+        WaveformGenerator waveform;
+        CHECK_FALSE(waveform.calculateWaveform({64, 64}, ScopeAnalyzer::analyse(frame), WaveformGenerator::PaintMode_Green, false, 1).isNull());
+        VectorscopeGenerator vectorscope;
+        CHECK_FALSE(vectorscope
+                        .calculateVectorscope({64, 64}, ScopeAnalyzer::analyse(frame), 1, VectorscopeGenerator::PaintMode_Green2,
+                                              VectorscopeGenerator::ColorSpace_YUV, false, 1)
+                        .isNull());
+    }
+
+    SECTION("Frames in other formats are not read")
+    {
+        mltFrame.set("format", mlt_image_rgba);
+        CHECK_FALSE(ScopeAnalyzer::canAnalyse(frame));
+        CHECK_FALSE(ScopeAnalyzer::analyse(frame));
+    }
+}
+
+TEST_CASE("Colorscope throughput", "[.][benchmark]")
+{
+    // A UHD frame with some content so that all scope buckets are used
+    QImage frame(3840, 2160, QImage::Format_RGB32);
+    for (int y = 0; y < frame.height(); ++y) {
+        auto *line = reinterpret_cast<QRgb *>(frame.scanLine(y));
+        for (int x = 0; x < frame.width(); ++x) {
+            line[x] = qRgb(x % 256, y % 256, (x * y) % 256);
+        }
+    }
+    const QSize scopeSize{720, 400};
+    const auto ALL_COMPONENTS = HistogramGenerator::Components::ComponentY | HistogramGenerator::Components::ComponentR |
+                                HistogramGenerator::Components::ComponentG | HistogramGenerator::Components::ComponentB;
+    WaveformGenerator waveform{};
+    HistogramGenerator hist{};
+    RGBParadeGenerator parade{};
+    VectorscopeGenerator vectorscope{};
+
+    BENCHMARK("Luma kernel, one UHD frame")
+    {
+        std::vector<uchar> luma(size_t(frame.width()));
+        for (int y = 0; y < frame.height(); ++y) {
+            ScopeAnalyzer::computeLuma(reinterpret_cast<const QRgb *>(frame.constScanLine(y)), luma.data(), frame.width(), ITURec::Rec_709);
+        }
+        return luma[0];
+    };
+    BENCHMARK("Shared analysis pass")
+    {
+        // Force a new analysis by detaching the image
+        QImage copy = frame.copy();
+        return ScopeAnalyzer::analyse(copy, ITURec::Rec_709);
+    };
+    BENCHMARK("Waveform")
+    {
+        return waveform.calculateWaveform(scopeSize, frame, WaveformGenerator::PaintMode_Green, true, ITURec::Rec_709, 1);
+    };
+    BENCHMARK("Histogram")
+    {
+        return hist.calculateHistogram(scopeSize, frame, ALL_COMPONENTS, ITURec::Rec_709, false, false, 1);
+    };
+    BENCHMARK("RGB Parade")
+    {
+        return parade.calculateRGBParade(scopeSize, frame, RGBParadeGenerator::PaintMode_RGB, true, false, 1);
+    };
+    BENCHMARK("Vectorscope")
+    {
+        return vectorscope.calculateVectorscope(scopeSize, frame, 1, VectorscopeGenerator::PaintMode_Green2, VectorscopeGenerator::ColorSpace_YUV, false, 1);
+    };
+    BENCHMARK("All four scopes on a new frame")
+    {
+        QImage copy = frame.copy();
+        waveform.calculateWaveform(scopeSize, copy, WaveformGenerator::PaintMode_Green, true, ITURec::Rec_709, 1);
+        hist.calculateHistogram(scopeSize, copy, ALL_COMPONENTS, ITURec::Rec_709, false, false, 1);
+        parade.calculateRGBParade(scopeSize, copy, RGBParadeGenerator::PaintMode_RGB, true, false, 1);
+        return vectorscope.calculateVectorscope(scopeSize, copy, 1, VectorscopeGenerator::PaintMode_Green2, VectorscopeGenerator::ColorSpace_YUV, false, 1);
+    };
+}
@@ -5,7 +5,13 @@
 
 #include "test_utils.hpp"
 // test specific headers
+#include "doc/backupdelta.h"
 #include "doc/documentchecker.h"
+#include "doc/mediasearchindex.h"
+
+#include <QCryptographicHash>
+#include <QTemporaryDir>
+#include <QThread>
 
 TEST_CASE("Basic tests of the document checker parts", "[DocumentChecker]")
 {
@@ -40,3 +46,172 @@ TEST_CASE("Basic tests of the document checker parts", "[DocumentChecker]")
         CHECK_FALSE(DocumentChecker::isMltBuildInLuma(QStringLiteral("luma87.pgm")));
     }
 }
+
+TEST_CASE("Project backups stored as delta", "[BackupDelta]")
+{
+    QString path = sourcesPath + "/dataset/test-mix.kdenlive";
+    QFile file(path);
+    REQUIRE(file.open(QIODevice::ReadOnly));
+    const QByteArray base = file.readAll();
+
+    SECTION("Rebuild modified projects")
+    {
+        QByteArray target = base;
+        target.replace("<property name=\"kdenlive:id\">", "<property name=\"kdenlive:id\" >");
+        target.prepend("<?xml version='1.0' encoding='utf-8'?>\n");
+        target.append("\n<!-- last line without end -->");
+        target.remove(base.size() / 3, 200);
+
+        const QByteArray delta = BackupDelta::create(base, target, QStringLiteral("checkpoint.kdenlive"));
+        CHECK(BackupDelta::isDelta(delta));
+        CHECK_FALSE(BackupDelta::isDelta(base));
+        CHECK(BackupDelta::baseName(delta) == QStringLiteral("checkpoint.kdenlive"));
+        CHECK(delta.size() < target.size() / 2);
+
+        QByteArray result;
+        CHECK(BackupDelta::apply(base, delta, &result));
+        CHECK(result == target);
+
+        // Identical and empty files
+        CHECK(BackupDelta::apply(base, BackupDelta::create(base, base, QString()), &result));
+        CHECK(result == base);
+        CHECK(BackupDelta::apply(base, BackupDelta::create(base, QByteArray(), QString()), &result));
+        CHECK(result.isEmpty());
+        CHECK(BackupDelta::apply(QByteArray(), BackupDelta::create(QByteArray(), target, QString()), &result));
+        CHECK(result == target);
+    }
+
+    SECTION("Reject a delta applied to another checkpoint")
+    {
+        QByteArray target = base;
+        target.replace("kdenlive:", "kdenlive::");
+        const QByteArray delta = BackupDelta::create(base, target, QStringLiteral("checkpoint.kdenlive"));
+        QByteArray otherBase = base;
+        otherBase.replace("<track ", "<track  ");
+        QByteArray result;
+        CHECK_FALSE(BackupDelta::apply(otherBase, delta, &result));
+        CHECK_FALSE(BackupDelta::apply(base, base, &result));
+    }
+
+    SECTION("Follow a renamed checkpoint")
+    {
+        QTemporaryDir dir;
+        REQUIRE(dir.isValid());
+        QByteArray target = base;
+        target.replace("<track ", "<track  ");
+        QFile checkpoint(dir.filePath(QStringLiteral("moved.checkpoint")));
+        REQUIRE(checkpoint.open(QIODevice::WriteOnly));
+        checkpoint.write(base);
+        checkpoint.close();
+        const QString deltaPath = dir.filePath(QStringLiteral("backup.kdenlivedelta"));
+        QFile deltaFile(deltaPath);
+        REQUIRE(deltaFile.open(QIODevice::WriteOnly));
+        deltaFile.write(BackupDelta::create(base, target, QStringLiteral("checkpoint.kdenlive")));
+        deltaFile.close();
+
+        CHECK(BackupDelta::restore(deltaPath).isEmpty());
+        CHECK(BackupDelta::setCheckpoint(deltaPath, QStringLiteral("moved.checkpoint")));
+        CHECK(BackupDelta::checkpointFor(deltaPath) == QStringLiteral("moved.checkpoint"));
+        const QString restored = BackupDelta::restore(deltaPath);
+        REQUIRE_FALSE(restored.isEmpty());
+        QFile restoredFile(restored);
+        REQUIRE(restoredFile.open(QIODevice::ReadOnly));
+        CHECK(restoredFile.readAll() == target);
+        restoredFile.remove();
+        CHECK_FALSE(BackupDelta::setCheckpoint(checkpoint.fileName(), QStringLiteral("other.checkpoint")));
+    }
+
+    SECTION("Write a checkpoint and a delta, then restore them")
+    {
+        QTemporaryDir dir;
+        REQUIRE(dir.isValid());
+        const QString checkpoint = BackupDelta::save(base, QString(), dir.filePath(QStringLiteral("test-mix-2026-01-01-10-00.kdenlive")));
+        REQUIRE(checkpoint == dir.filePath(QStringLiteral("test-mix-2026-01-01-10-00.kdenlive")));
+        CHECK(BackupDelta::checkpointFor(checkpoint).isEmpty());
+        CHECK(BackupDelta::restore(checkpoint) == checkpoint);
+
+        QByteArray target = base;
+        target.replace("<track ", "<track  ");
+        const QString delta = BackupDelta::save(target, checkpoint, dir.filePath(QStringLiteral("test-mix-2026-01-01-10-05.kdenlive")));
+        // Deltas are not projects, they must not use the project extension
+        REQUIRE(delta == dir.filePath(QStringLiteral("test-mix-2026-01-01-10-05.kdenlivedelta")));
+        CHECK_FALSE(QFile::exists(dir.filePath(QStringLiteral("test-mix-2026-01-01-10-05.kdenlive"))));
+        CHECK(BackupDelta::checkpointFor(delta) == QFileInfo(checkpoint).fileName());
+        CHECK(QFileInfo(delta).size() < base.size() / 2);
+
+        const QString restored = BackupDelta::restore(delta);
+        REQUIRE(restored.endsWith(QStringLiteral("test-mix-2026-01-01-10-05.kdenlive")));
+        QFile restoredFile(restored);
+        REQUIRE(restoredFile.open(QIODevice::ReadOnly));
+        CHECK(restoredFile.readAll() == target);
+        restoredFile.remove();
+
+        // Large changes are stored as a full backup
+        const QByteArray other(base.size(), 'x');
+        const QString full = BackupDelta::save(other, checkpoint, dir.filePath(QStringLiteral("test-mix-2026-01-01-10-06.kdenlive")));
+        CHECK(full == dir.filePath(QStringLiteral("test-mix-2026-01-01-10-06.kdenlive")));
+        CHECK(BackupDelta::restore(full) == full);
+    }
+}
+
+TEST_CASE("Missing media search index", "[DocumentChecker]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    QDir root(dir.path());
+    REQUIRE(root.mkpath(QStringLiteral("a/deep/folder")));
+    REQUIRE(root.mkpath(QStringLiteral("b")));
+    auto writeFile = [&root](const QString &path, const QByteArray &data) {
+        QFile file(root.absoluteFilePath(path));
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    };
+    writeFile(QStringLiteral("a/deep/folder/clip.mp4"), QByteArray(500, 'x'));
+    writeFile(QStringLiteral("b/clip.mp4"), QByteArray(500, 'y'));
+    writeFile(QStringLiteral("b/other.mp4"), QByteArray(300, 'z'));
+    writeFile(QStringLiteral("title.png"), QByteArray(10, 't'));
+
+    MediaSearchIndex index(root.absolutePath());
+    std::atomic<bool> abort(false);
+    REQUIRE(index.build(abort));
+    CHECK(index.fileCount() == 4);
+    CHECK(index.folders().first() == root.absolutePath());
+    CHECK(index.folders().size() == 5);
+
+    SECTION("Find by size and hash")
+    {
+        const QString hash = QString::fromLatin1(QCryptographicHash::hash(QByteArray(500, 'x'), QCryptographicHash::Md5).toHex());
+        index.prefetchHashes({500, 300});
+        CHECK(index.findFile(500, hash) == root.absoluteFilePath(QStringLiteral("a/deep/folder/clip.mp4")));
+        CHECK(index.findFile(300, hash).isEmpty());
+        CHECK(index.findFile(42, hash).isEmpty());
+    }
+
+    SECTION("Find by name, closest to the root first")
+    {
+        CHECK(index.findByName(QStringLiteral("clip.mp4")) == root.absoluteFilePath(QStringLiteral("b/clip.mp4")));
+        CHECK(index.findByName(QStringLiteral("title.png")) == root.absoluteFilePath(QStringLiteral("title.png")));
+        CHECK(index.findByName(QStringLiteral("missing.png")).isEmpty());
+    }
+
+    SECTION("Abort")
+    {
+        MediaSearchIndex aborted(root.absolutePath());
+        abort = true;
+        CHECK_FALSE(aborted.build(abort));
+    }
+
+    SECTION("Detect changed folders")
+    {
+        CHECK_FALSE(index.isStale());
+        // Make sure the folder modification time changes
+        QThread::msleep(20);
+        writeFile(QStringLiteral("a/deep/folder/moved.mp4"), QByteArray(10, 'm'));
+        CHECK(index.isStale());
+        REQUIRE(index.build(abort));
+        CHECK_FALSE(index.isStale());
+        CHECK(index.findByName(QStringLiteral("moved.mp4")) == root.absoluteFilePath(QStringLiteral("a/deep/folder/moved.mp4")));
+        REQUIRE(QDir(root.absoluteFilePath(QStringLiteral("b"))).removeRecursively());
+        CHECK(index.isStale());
+    }
+}
@@ -12,6 +12,7 @@
 #include <tuple>
 #include <unordered_set>
 
+#include "assets/assetcache.h"
 #include "core.h"
 #include "definitions.h"
 #include "effects/effectsrepository.hpp"
@@ -109,3 +110,60 @@ TEST_CASE("Effects stack", "[Effects]")
     clip.reset();
     pCore->projectManager()->closeCurrentDocument(false, false);
 }
+
+static bool sameXml(const QDomElement &a, const QDomElement &b)
+{
+    if (a.tagName() != b.tagName() || a.attributes().count() != b.attributes().count() || a.childNodes().count() != b.childNodes().count()) {
+        return false;
+    }
+    const QDomNamedNodeMap attributes = a.attributes();
+    for (int i = 0; i < attributes.count(); ++i) {
+        const QDomAttr attribute = attributes.item(i).toAttr();
+        if (b.attribute(attribute.name()) != attribute.value()) {
+            return false;
+        }
+    }
+    for (int i = 0; i < a.childNodes().count(); ++i) {
+        const QDomNode childA = a.childNodes().at(i);
+        const QDomNode childB = b.childNodes().at(i);
+        if (childA.isElement() ? !sameXml(childA.toElement(), childB.toElement()) : childA.nodeValue() != childB.nodeValue()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("Effects startup cache", "[Effects]")
+{
+    AssetCache::remove(QStringLiteral("effects"));
+    std::unique_ptr<EffectsRepository> parsed(new EffectsRepository());
+    CHECK_FALSE(parsed->loadStats().fromCache);
+    REQUIRE(parsed->loadStats().count > 0);
+
+    // The second repository is restored from the snapshot written by the first one
+    std::unique_ptr<EffectsRepository> restored(new EffectsRepository());
+    CHECK(restored->loadStats().fromCache);
+    CHECK(restored->loadStats().count == parsed->loadStats().count);
+    CHECK(restored->getNames() == parsed->getNames());
+    for (const auto &asset : parsed->m_assets) {
+        const QString &id = asset.first;
+        REQUIRE(restored->exists(id));
+        // Descriptions are only parsed when requested
+        CHECK(restored->m_assets.at(id).xml.isNull());
+        CHECK(restored->getType(id) == parsed->getType(id));
+        CHECK(restored->getDescription(id) == parsed->getDescription(id));
+        CHECK(restored->getVersion(id) == parsed->getVersion(id));
+        CHECK(restored->isUnique(id) == parsed->isUnique(id));
+        CHECK(restored->isGroup(id) == parsed->isGroup(id));
+        CHECK(sameXml(restored->getXml(id), parsed->getXml(id)));
+    }
+
+    // A snapshot written with another key is ignored
+    auto snapshot = AssetCache::take(QStringLiteral("effects"));
+    REQUIRE(!snapshot.entries.isEmpty());
+    snapshot.key = QByteArrayLiteral("outdated");
+    REQUIRE(AssetCache::save(QStringLiteral("effects"), snapshot));
+    std::unique_ptr<EffectsRepository> rebuilt(new EffectsRepository());
+    CHECK_FALSE(rebuilt->loadStats().fromCache);
+    CHECK(rebuilt->getNames() == parsed->getNames());
+}
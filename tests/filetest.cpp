@@ -6,12 +6,15 @@
 #include "test_utils.hpp"
 // test specific headers
 #include "bin/binplaylist.hpp"
+#include "bin/filewatcher.hpp"
 #include "doc/kdenlivedoc.h"
 #include "timeline2/model/builders/meltBuilder.hpp"
 #include "xml/xml.hpp"
 
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QUndoGroup>
+#include <mlt++/MltPlaylist.h>
 
 using namespace fakeit;
 
@@ -434,6 +437,65 @@ TEST_CASE("Opening Mix", "[OPENMIX]")
         auto producers = newDoc->elementsByTagName(QStringLiteral("producer"));
         pCore->projectManager()->closeCurrentDocument(false, false);
     }
+
+    SECTION("Clips loaded from all tracks at once keep their playlist position")
+    {
+        QUrl openURL = QUrl::fromLocalFile(sourcesPath + "/dataset/test-mix.kdenlive");
+
+        QUndoGroup *undoGroup = new QUndoGroup();
+        undoGroup->addStack(undoStack.get());
+        DocOpenResult openResults = KdenliveDoc::Open(openURL, QDir::temp().path(), undoGroup, false, nullptr);
+        REQUIRE(openResults.isSuccessful() == true);
+        std::unique_ptr<KdenliveDoc> openedDoc = openResults.getDocument();
+
+        pCore->projectManager()->m_project = openedDoc.get();
+        const QUuid uuid = openedDoc->uuid();
+        QDateTime documentDate = QFileInfo(openURL.toLocalFile()).lastModified();
+        pCore->projectManager()->updateTimeline(0, false, QString(), QString(), documentDate, 0);
+        std::shared_ptr<Mlt::Tractor> tc = binModel->getExtraTimeline(uuid.toString());
+        std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(uuid, undoStack);
+        openedDoc->addTimeline(uuid, timeline);
+        REQUIRE(constructTimelineFromTractor(timeline, nullptr, *tc.get(), nullptr, openedDoc->modifiedDecimalPoint(), QString(), QString()));
+        pCore->projectManager()->testSetActiveDocument(openedDoc.get(), timeline);
+        REQUIRE(timeline->checkConsistency());
+        // The bin id and url indexes match the loaded bin playlist
+        REQUIRE(binModel->checkIndexes());
+
+        // Walk the playlists one after the other and compare with the clips of the model
+        const QStringList reserved{QStringLiteral("playlistmain"), QStringLiteral("timeline_preview"), QStringLiteral("timeline_overlay"),
+                                   QStringLiteral("black_track"), QStringLiteral("overlay_track")};
+        int trackPosition = 0;
+        int clipsCount = 0;
+        for (int i = 0; i < tc->count(); i++) {
+            std::unique_ptr<Mlt::Producer> track(tc->track(i));
+            const QString name = track->property_exists("kdenlive:playlistid") ? track->get("kdenlive:playlistid") : track->get("id");
+            if (reserved.contains(name) || track->type() != mlt_service_tractor_type) {
+                continue;
+            }
+            int tid = timeline->getTrackIndexFromPosition(trackPosition++);
+            CHECK(timeline->isAudioTrack(tid) == (track->get_int("kdenlive:audio_track") == 1));
+            Mlt::Tractor local_tractor(*track.get());
+            int trackClips = 0;
+            for (int j = 0; j < local_tractor.count(); j++) {
+                std::unique_ptr<Mlt::Producer> sub_track(local_tractor.track(j));
+                Mlt::Playlist playlist(*sub_track);
+                for (int k = 0; k < playlist.count(); k++) {
+                    if (playlist.is_blank(k)) {
+                        continue;
+                    }
+                    int cid = timeline->getClipByStartPosition(tid, playlist.clip_start(k));
+                    REQUIRE(cid > -1);
+                    CHECK(timeline->getClipPlaytime(cid) == playlist.clip_length(k));
+                    trackClips++;
+                }
+            }
+            CHECK(timeline->getTrackClipsCount(tid) == trackClips);
+            clipsCount += trackClips;
+        }
+        CHECK(trackPosition == timeline->getTracksCount());
+        CHECK(clipsCount > 0);
+        pCore->projectManager()->closeCurrentDocument(false, false);
+    }
 }
 
 TEST_CASE("Opening File With Keyframes", "[OPENKFRS]")
@@ -486,3 +548,70 @@ TEST_CASE("Opening File With Keyframes", "[OPENKFRS]")
         pCore->projectManager()->closeCurrentDocument(false, false);
     }
 }
+
+TEST_CASE("File watcher", "[FileWatcher]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    QDir root(dir.path());
+    REQUIRE(root.mkpath(QStringLiteral("cards")));
+    QStringList files = {root.absoluteFilePath(QStringLiteral("a.mp4")), root.absoluteFilePath(QStringLiteral("b.mp4")),
+                         root.absoluteFilePath(QStringLiteral("cards/c.mp4"))};
+    for (const QString &path : qAsConst(files)) {
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write("data");
+        file.setFileTime(QDateTime::currentDateTime().addSecs(-60), QFileDevice::FileModificationTime);
+    }
+
+    FileWatcher watcher;
+    QStringList reloaded;
+    int batches = 0;
+    QObject::connect(&watcher, &FileWatcher::binClipsModified, [&](const QStringList &ids) {
+        reloaded << ids;
+        batches++;
+    });
+    watcher.addFile(QStringLiteral("1"), files.at(0));
+    watcher.addFile(QStringLiteral("2"), files.at(1));
+    watcher.addFile(QStringLiteral("3"), files.at(2));
+    // Files are registered together
+    CHECK(watcher.contains(files.at(0)));
+    CHECK(watcher.stats().pending == 3);
+    CHECK(watcher.stats().folders == 0);
+    watcher.slotProcessQueue();
+    FileWatcher::Stats stats = watcher.stats();
+    CHECK(stats.pending == 0);
+    CHECK(stats.files == 3);
+    // Only the folders are watched
+    CHECK(stats.folders == 2);
+
+    SECTION("Events are sent in one batch")
+    {
+        watcher.slotUrlModified(files.at(0));
+        watcher.slotUrlModified(files.at(0));
+        watcher.slotUrlModified(files.at(2));
+        watcher.slotUrlModified(root.absoluteFilePath(QStringLiteral("other.txt")));
+        CHECK(watcher.stats().received == 4);
+        CHECK(watcher.stats().pending == 2);
+        watcher.slotProcessModifiedUrls();
+        CHECK(batches == 1);
+        reloaded.sort();
+        CHECK(reloaded == QStringList({QStringLiteral("1"), QStringLiteral("3")}));
+        stats = watcher.stats();
+        CHECK(stats.processed == 2);
+        CHECK(stats.batches == 1);
+        CHECK(stats.pending == 0);
+    }
+
+    SECTION("Removing the last file of a folder stops watching it")
+    {
+        watcher.removeFile(QStringLiteral("3"));
+        CHECK_FALSE(watcher.contains(files.at(2)));
+        CHECK(watcher.stats().folders == 1);
+        watcher.removeFile(QStringLiteral("1"));
+        CHECK(watcher.stats().folders == 1);
+        watcher.clear();
+        CHECK(watcher.stats().files == 0);
+        CHECK(watcher.stats().folders == 0);
+    }
+}
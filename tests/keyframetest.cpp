@@ -268,6 +268,39 @@ TEST_CASE("Keyframe model", "[KeyframeModel]")
         undoStack->undo();
         state1(6.1);
     }
+
+    SECTION("Interpolation from the parsed animation")
+    {
+        REQUIRE(model->addKeyframe(GenTime(1.), KeyframeType::Linear, 0.8));
+        REQUIRE(model->addKeyframe(GenTime(2.), KeyframeType::Discrete, 0.2));
+        REQUIRE(model->addKeyframe(GenTime(3.), KeyframeType::Curve, 0.6));
+        REQUIRE(model->addKeyframe(GenTime(3.5), KeyframeType::Linear, 0.1));
+
+        auto checkValues = [&]() {
+            Mlt::Properties reference;
+            reference.set("key", model->getAnimProperty().toUtf8().constData());
+            (void)reference.anim_get_double("key", 0, 100);
+            const QVector<double> values = model->getInterpolatedValues(0, 100);
+            REQUIRE(values.size() == 101);
+            for (int frame = 0; frame <= 100; ++frame) {
+                const double expected = reference.anim_get_double("key", frame);
+                CHECK(qAbs(values.at(frame) - expected) < 1e-9);
+                CHECK(qAbs(model->getInterpolatedValue(frame).toDouble() - expected) < 1e-9);
+            }
+        };
+        checkValues();
+        auto compiled = model->m_compiled;
+        // Querying again does not parse the animation
+        model->getInterpolatedValue(30);
+        CHECK(model->m_compiled == compiled);
+
+        // Modifications rebuild it
+        REQUIRE(model->updateKeyframe(GenTime(2.), QVariant(0.9)));
+        checkValues();
+        CHECK(model->m_compiled != compiled);
+        undoStack->undo();
+        checkValues();
+    }
     clip.reset();
     timeline.reset();
     pCore->projectManager()->closeCurrentDocument(false, false);
@@ -1103,6 +1103,50 @@ TEST_CASE("Clip manipulation", "[ClipModel]")
         state(1);
     }
 
+    SECTION("Position queries")
+    {
+        int l1 = timeline->getClipPlaytime(cid1);
+        int l2 = timeline->getClipPlaytime(cid2);
+        REQUIRE(l1 < 100);
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 0));
+        REQUIRE(timeline->requestClipMove(cid2, tid1, 100));
+        auto track = timeline->getTrackById(tid1);
+        auto state = [&](int start2) {
+            REQUIRE(timeline->checkConsistency());
+            REQUIRE(timeline->getClipByStartPosition(tid1, 0) == cid1);
+            REQUIRE(timeline->getClipByStartPosition(tid1, start2) == cid2);
+            REQUIRE(timeline->getClipByStartPosition(tid1, 1) == -1);
+            REQUIRE(timeline->getClipByPosition(tid1, l1 - 1) == cid1);
+            REQUIRE(timeline->getClipByPosition(tid1, l1) == -1);
+            REQUIRE(timeline->getClipByPosition(tid1, start2) == cid2);
+            REQUIRE(timeline->getClipByPosition(tid1, start2 - 1) == -1);
+            REQUIRE(track->getClipsInRange(0, -1) == std::unordered_set<int>{cid1, cid2});
+            REQUIRE(track->getClipsInRange(l1 - 1, start2).size() == 1);
+            REQUIRE(track->getClipsInRange(l1, start2).empty());
+            REQUIRE(track->getClipsInRange(l1, start2 + 1) == std::unordered_set<int>{cid2});
+            REQUIRE(track->getNextBlankStart(0) == l1);
+            REQUIRE(track->getNextBlankStart(start2) == timeline->getClipEnd(cid2));
+        };
+        state(100);
+
+        // Resizing from the left moves the clip start
+        REQUIRE(timeline->requestItemResize(cid2, l2 - 5, false) == l2 - 5);
+        state(105);
+        REQUIRE(timeline->getClipByStartPosition(tid1, 100) == -1);
+        undoStack->undo();
+        state(100);
+        undoStack->redo();
+        state(105);
+
+        // Moved clips are removed from the index of their previous track
+        REQUIRE(timeline->requestClipMove(cid2, tid2, 200));
+        REQUIRE(timeline->getClipByStartPosition(tid1, 105) == -1);
+        REQUIRE(timeline->getClipByStartPosition(tid2, 200) == cid2);
+        REQUIRE(track->getClipsInRange(0, -1) == std::unordered_set<int>{cid1});
+        undoStack->undo();
+        state(105);
+    }
+
     SECTION("Clip clone")
     {
         int cid6 = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
@@ -2147,15 +2191,130 @@ TEST_CASE("Operations under locked tracks", "[Locked]")
         // unlock track, bin clip deletion should work now
         timeline->setTrackLockedState(tid1, false);
         REQUIRE_FALSE(timeline->getTrackById(tid1)->isLocked());
+        REQUIRE(binModel->checkIndexes());
+        REQUIRE(binModel->getItemByBinId(binId) != nullptr);
         REQUIRE(binModel->requestBinClipDeletion(binModel->getClipByBinID(binId), undo, redo));
         REQUIRE(timeline->checkConsistency());
         REQUIRE(timeline->getClipsCount() == 0);
+        REQUIRE(binModel->getClipByBinID(binId) == nullptr);
+        REQUIRE(binModel->isIdFree(binId));
+        REQUIRE(binModel->checkIndexes());
         REQUIRE(timeline->checkConsistency());
     }
 
     pCore->projectManager()->closeCurrentDocument(false, false);
 }
 
+TEST_CASE("Clip role snapshots and coalesced changes", "[ClipModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    KdenliveDoc document(undoStack);
+    pCore->projectManager()->m_project = &document;
+    TimelineItemModel tim(document.uuid(), undoStack);
+    Mock<TimelineItemModel> timMock(tim);
+    auto timeline = std::shared_ptr<TimelineItemModel>(&timMock.get(), [](...) {});
+    TimelineItemModel::finishConstruct(timeline);
+    pCore->projectManager()->testSetActiveDocument(&document, timeline);
+
+    QString binId = createProducer(pCore->getProjectProfile(), "red", binModel);
+    int tid1;
+    REQUIRE(timeline->requestTrackInsertion(-1, tid1));
+    int cid1 = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+    int cid2 = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+    int cid3 = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+    REQUIRE(timeline->requestClipMove(cid1, tid1, 0));
+    REQUIRE(timeline->requestClipMove(cid2, tid1, 20));
+    REQUIRE(timeline->requestClipMove(cid3, tid1, 40));
+    timeline->flushChanges();
+
+    std::vector<std::pair<int, int>> ranges;
+    QVector<int> sentRoles;
+    QObject::connect(timeline.get(), &TimelineItemModel::dataChanged,
+                     [&](const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles) {
+                         ranges.emplace_back(topleft.row(), bottomright.row());
+                         sentRoles = roles;
+                     });
+
+    SECTION("Snapshot is kept while unrelated roles change")
+    {
+        QModelIndex ix = timeline->makeClipIndexFromID(cid1);
+        QString name = timeline->data(ix, TimelineModel::NameRole).toString();
+        REQUIRE(timeline->m_snapshots.count(cid1) == 1);
+        REQUIRE(timeline->data(ix, TimelineModel::NameRole).toString() == name);
+        REQUIRE(timeline->data(ix, TimelineModel::BinIdRole).toString() == binId);
+
+        timeline->notifyChange(ix, ix, TimelineModel::StartRole);
+        REQUIRE(timeline->m_snapshots.count(cid1) == 1);
+        timeline->notifyChange(ix, ix, TimelineModel::NameRole);
+        REQUIRE(timeline->m_snapshots.count(cid1) == 0);
+        timeline->data(ix, TimelineModel::ResourceRole);
+        timeline->notifyChange(ix, ix, QVector<int>());
+        REQUIRE(timeline->m_snapshots.count(cid1) == 0);
+    }
+
+    SECTION("Changes of consecutive rows are sent together")
+    {
+        QModelIndex ix1 = timeline->makeClipIndexFromID(cid1);
+        QModelIndex ix2 = timeline->makeClipIndexFromID(cid2);
+        QModelIndex ix3 = timeline->makeClipIndexFromID(cid3);
+        timeline->notifyChange(ix3, ix3, TimelineModel::StartRole);
+        timeline->notifyChange(ix1, ix1, TimelineModel::StartRole);
+        timeline->notifyChange(ix2, ix2, TimelineModel::DurationRole);
+        timeline->notifyChange(ix1, ix1, TimelineModel::StartRole);
+        // Nothing is sent before the event loop runs
+        REQUIRE(ranges.empty());
+        timeline->flushChanges();
+        REQUIRE(ranges.size() == 1);
+        REQUIRE(ranges.front().first == 0);
+        REQUIRE(ranges.front().second == 2);
+        REQUIRE(sentRoles.size() == 2);
+        REQUIRE(sentRoles.contains(TimelineModel::StartRole));
+        REQUIRE(sentRoles.contains(TimelineModel::DurationRole));
+    }
+
+    SECTION("Changes of separate rows are sent separately")
+    {
+        QModelIndex ix1 = timeline->makeClipIndexFromID(cid1);
+        QModelIndex ix3 = timeline->makeClipIndexFromID(cid3);
+        timeline->notifyChange(ix1, ix1, TimelineModel::StartRole);
+        timeline->notifyChange(ix3, ix3, QVector<int>());
+        timeline->flushChanges();
+        REQUIRE(ranges.size() == 2);
+        // An empty list means that all roles changed
+        REQUIRE(sentRoles.isEmpty());
+    }
+
+    SECTION("Snapshot is dropped when the producer is reloaded")
+    {
+        QModelIndex ix = timeline->makeClipIndexFromID(cid1);
+        timeline->data(ix, TimelineModel::ResourceRole);
+        REQUIRE(timeline->m_snapshots.count(cid1) == 1);
+        timeline->requestClipReload(cid1);
+        REQUIRE(timeline->m_snapshots.count(cid1) == 0);
+        timeline->data(ix, TimelineModel::ResourceRole);
+        REQUIRE(timeline->m_snapshots.count(cid1) == 1);
+        timeline->m_allClips[cid1]->refreshProducerFromBin(-1);
+        REQUIRE(timeline->m_snapshots.count(cid1) == 0);
+    }
+
+    SECTION("Changes of removed items are skipped")
+    {
+        QModelIndex ix3 = timeline->makeClipIndexFromID(cid3);
+        timeline->notifyChange(ix3, ix3, TimelineModel::StartRole);
+        REQUIRE(timeline->requestItemDeletion(cid3));
+        timeline->flushChanges();
+        REQUIRE(timeline->getTrackClipsCount(tid1) == 2);
+        for (const auto &range : ranges) {
+            REQUIRE(range.second < 2);
+        }
+    }
+
+    pCore->projectManager()->closeCurrentDocument(false, false);
+}
+
 TEST_CASE("New KdenliveDoc activeTrack", "KdenliveDoc")
 {
     auto binModel = pCore->projectItemModel();
@@ -200,6 +200,34 @@ TEST_CASE("Basic tests of the render preset model", "[RenderPresets]")
         // we set x265 codec again so the params should be back
         CHECK(params.contains(QStringLiteral("x265-params")));
     }
+
+    SECTION("Test encoding cost")
+    {
+        const QSize hd(1920, 1080);
+        RenderPresetParams params;
+        params.insert(QStringLiteral("vcodec"), QStringLiteral("libx264"));
+        CHECK(params.encodingCost(hd, 32) == 4);
+        CHECK(params.encodingCost(QSize(3840, 2160), 32) == 16);
+        CHECK(params.encodingCost(QSize(3840, 2160), 8) == 8);
+
+        params.insert(QStringLiteral("scale"), QStringLiteral("0.5"));
+        CHECK(params.encodingCost(QSize(3840, 2160), 32) == 4);
+        params.remove(QStringLiteral("scale"));
+
+        params.insert(QStringLiteral("vcodec"), QStringLiteral("libx265"));
+        CHECK(params.encodingCost(hd, 32) == 8);
+        params.insert(QStringLiteral("threads"), QStringLiteral("2"));
+        CHECK(params.encodingCost(hd, 32) == 3);
+        params.remove(QStringLiteral("threads"));
+
+        params.insert(QStringLiteral("vcodec"), QStringLiteral("h264_nvenc"));
+        CHECK(params.encodingCost(hd, 32) == 1);
+
+        // Audio only jobs are cheap whatever the video settings are
+        params.insert(QStringLiteral("vcodec"), QStringLiteral("libx265"));
+        params.insert(QStringLiteral("vn"), QStringLiteral("1"));
+        CHECK(params.encodingCost(QSize(3840, 2160), 32) == 1);
+    }
 }
 
 TEST_CASE("Tests of the render functions to use guides for sections", "[RenderRequestGuides]")
@@ -292,4 +320,28 @@ TEST_CASE("Tests of the render functions to use guides for sections", "[RenderRe
         CHECK(sections.at(2).in == 51);
         CHECK(sections.at(2).out == out);
     }
+
+    SECTION("Segments for parallel encoding")
+    {
+        r->setGuideParams(markerModel, false, -1);
+        // Range too short to be split
+        r->setSegmentedRendering(60);
+        CHECK(r->getSegments(in, out).empty());
+
+        // Segments end on guides if they are long enough, the last frames are appended to the previous segment
+        r->setSegmentedRendering(30);
+        sections = r->getSegments(in, out);
+        REQUIRE(sections.size() == 4);
+        CHECK(sections.at(0).in == 0);
+        CHECK(sections.at(0).out == 24);
+        CHECK(sections.at(1).in == 25);
+        CHECK(sections.at(1).out == 54);
+        CHECK(sections.at(2).in == 55);
+        CHECK(sections.at(2).out == 69);
+        CHECK(sections.at(3).in == 70);
+        CHECK(sections.at(3).out == out);
+
+        r->setSegmentedRendering(0);
+        CHECK(r->getSegments(in, out).empty());
+    }
 }
@@ -6,7 +6,9 @@
 #include "catch.hpp"
 #include "test_utils.hpp"
 // test specific headers
+#include <QProcess>
 #include <QString>
+#include <QTemporaryDir>
 #include <cmath>
 #include <iostream>
 #include <tuple>
@@ -116,3 +118,47 @@ TEST_CASE("Timeline preview insert-remove", "[TimelinePreview]")
     binModel->clean();
     pCore->m_projectManager = nullptr;
 }
+
+TEST_CASE("Timeline preview chunks read from stdin", "[TimelinePreview]")
+{
+    // Same lookup as PreviewManager
+    QString renderer = QCoreApplication::applicationDirPath() + QStringLiteral("/kdenlive_render");
+    if (!QFile::exists(renderer)) {
+        renderer = QStandardPaths::findExecutable(QStringLiteral("kdenlive_render"));
+    }
+    REQUIRE_FALSE(renderer.isEmpty());
+    pCore->setCurrentProfile("atsc_1080p_25");
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString scene = dir.filePath(QStringLiteral("preview.mlt"));
+    QFile file(scene);
+    REQUIRE(file.open(QIODevice::WriteOnly));
+    file.write("<?xml version=\"1.0\"?>\n<mlt LC_NUMERIC=\"C\"><producer id=\"color\" in=\"0\" out=\"99\">"
+               "<property name=\"length\">100</property><property name=\"mlt_service\">color</property>"
+               "<property name=\"resource\">red</property></producer></mlt>\n");
+    file.close();
+    QDir output(dir.path());
+
+    // Chunks are rendered in the order they are received, an empty line ends the job
+    QProcess process;
+    process.start(renderer, {QStringLiteral("preview-chunks"), scene, output.absolutePath(), QStringLiteral("-"), QStringLiteral("24"),
+                             pCore->getCurrentProfilePath(), QStringLiteral("avi"), QStringLiteral("vcodec=mjpeg progressive=1 qscale=10")});
+    REQUIRE(process.waitForStarted());
+    process.write("50\n0\n\n25\n");
+    process.closeWriteChannel();
+    REQUIRE(process.waitForFinished(60000));
+    CHECK(process.exitStatus() == QProcess::NormalExit);
+    CHECK(process.exitCode() == 0);
+    QStringList reported;
+    const QStringList lines = QString::fromLocal8Bit(process.readAllStandardError()).split(QLatin1Char('\n'));
+    for (const QString &line : lines) {
+        if (line.startsWith(QLatin1String("START:")) || line.startsWith(QLatin1String("DONE:"))) {
+            reported << line.simplified();
+        }
+    }
+    CHECK(reported == QStringList({QStringLiteral("START:50"), QStringLiteral("DONE:50"), QStringLiteral("START:0"), QStringLiteral("DONE:0")}));
+    CHECK(output.exists(QStringLiteral("50.avi")));
+    CHECK(output.exists(QStringLiteral("0.avi")));
+    CHECK_FALSE(output.exists(QStringLiteral("25.avi")));
+}
@@ -6,8 +6,12 @@
 #include "catch.hpp"
 #include "test_utils.hpp"
 // test specific headers
+#include "utils/filehashcache.h"
 #include "utils/qstringutils.h"
 
+#include <QCryptographicHash>
+#include <QTemporaryDir>
+
 TEST_CASE("Testing for different utils", "[Utils]")
 {
 
@@ -29,4 +33,48 @@ TEST_CASE("Testing for different utils", "[Utils]")
 
         REQUIRE(names.removeDuplicates() == 0);
     }
+
+    SECTION("File hashes are cached until the file changes")
+    {
+        QTemporaryDir dir;
+        REQUIRE(dir.isValid());
+        const QString smallPath = dir.filePath(QStringLiteral("small.bin"));
+        const QString largePath = dir.filePath(QStringLiteral("large.bin"));
+        QByteArray small(1000, 'a');
+        QByteArray large;
+        for (int i = 0; i < 3000000; ++i) {
+            large.append(char(i % 251));
+        }
+        QFile file(smallPath);
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write(small);
+        file.close();
+        file.setFileName(largePath);
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write(large);
+        file.close();
+
+        // The hash of large files only covers the first and last megabyte
+        const QByteArray largeHash = QCryptographicHash::hash(large.left(1000000) + large.right(1000000), QCryptographicHash::Md5);
+        auto &cache = FileHashCache::get();
+        cache->clear();
+        const auto hashes = cache->hashFiles({smallPath, largePath});
+        CHECK(hashes.value(smallPath).first == QCryptographicHash::hash(small, QCryptographicHash::Md5));
+        CHECK(hashes.value(smallPath).second == 1000);
+        CHECK(hashes.value(largePath).first == largeHash);
+        CHECK(hashes.value(largePath).second == 3000000);
+
+        const auto stats = cache->stats();
+        CHECK(cache->hash(largePath).first == largeHash);
+        CHECK(cache->stats().hits == stats.hits + 1);
+
+        // A modified file is hashed again
+        REQUIRE(file.open(QIODevice::WriteOnly | QIODevice::Append));
+        file.write("b");
+        file.close();
+        CHECK(cache->hash(largePath).first != largeHash);
+        CHECK(cache->hash(largePath).second == 3000001);
+        CHECK(cache->stats().misses == stats.misses + 1);
+        CHECK(cache->hash(dir.filePath(QStringLiteral("missing.bin"))).first.isEmpty());
+    }
 }